@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "inference.h"
+
+// Offline processing of an image directory or a video file
+struct BatchConfig {
+    std::string source;                                   // Directory of images or a video file
+    std::string jsonl_path = "/tmp/batch_results.jsonl";  // One JSON line per image/frame
+    std::string coco_path;                                // COCO results array (optional)
+    int workers = 0;                                      // Decode/post-process threads (0: CPU count)
+};
+
+// Streams a corpus through the resident model. Images are decoded in
+// parallel (turbojpeg for JPEG) by a worker pool that keeps every NPU context
+// busy; detections are formatted on the same workers and written in input
+// order as they complete. Throughput is reported as sustained images/sec.
+class BatchProcessor {
+public:
+    BatchProcessor(MLInferenceThread& inference, const BatchConfig& config, std::atomic<bool>& isRunning);
+
+    // Returns 0 when the whole source was processed
+    int run();
+
+private:
+    struct Item {
+        std::string source;   // Image path, or the video path for frames
+        int frame = -1;       // Frame index for videos, -1 for image files
+        bool ok = false;
+        int detection_count = 0;
+        std::string line;     // JSONL record
+        nlohmann::json coco;  // COCO result entries
+    };
+
+    Item process(std::string source, int index, int frame, cv::Mat img);
+    void write(Item& item);
+    void report(bool final);
+
+    MLInferenceThread& inference;
+    BatchConfig config;
+    std::atomic<bool>& running;
+
+    FILE* jsonl = nullptr;
+    FILE* coco = nullptr;
+    bool first_coco_entry = true;
+
+    long images = 0;
+    long failures = 0;
+    long detections = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last_report;
+    long images_at_last_report = 0;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame_writer.h"
+#include "yolox.h"
+
+// A condition on the number of detections of a selected class in a frame,
+// such as person>0. The class "any" counts every selected class.
+struct ClipTrigger {
+    enum class Op { Greater, AtLeast, Less, AtMost, Equal };
+
+    std::string class_name;
+    Op op = Op::Greater;
+    int value = 0;
+
+    bool holds(int count) const;
+};
+
+// Parse a comma-separated list such as "person>0,car>=2" (operators >, >=,
+// <, <=, ==). Prints the problem and returns false on an invalid list.
+bool parseClipTriggers(const std::string& text, std::vector<ClipTrigger>& triggers);
+
+enum class ClipFormat {
+    AVI,    // Motion JPEG in an AVI file: clip-<time>.avi
+    Frames  // One JPEG per frame in a directory: clip-<time>/000001.jpg, ...
+};
+
+// Parse "avi" or "frames"
+bool parseClipFormat(const std::string& text, ClipFormat& format);
+
+struct ClipConfig {
+    std::string directory;
+    std::string trigger_text = "person>0";     // As given, for the sidecar
+    std::vector<ClipTrigger> triggers = {{"person", ClipTrigger::Op::Greater, 0}};
+    double pre_seconds = 5.0;                  // Kept from before the trigger
+    double post_seconds = 5.0;                 // Kept after the triggers last held
+    double max_seconds = 60.0;                 // Longest clip
+    size_t memory_bytes = 64 * 1024 * 1024;    // Most held in the pre-roll ring
+    uint64_t budget_bytes = 1024ull << 20;     // Most disk used by clips; the oldest are deleted
+    ClipFormat format = ClipFormat::AVI;
+    int jpeg_quality = 80;                     // For frames no other sink has encoded
+};
+
+// Records clips of the decorated frames around detection events.
+//
+// Every frame is kept, JPEG-encoded with its detections, in a ring holding
+// the last pre_seconds within memory_bytes. When a trigger starts to hold
+// (person count going from 0 to more, say), the ring is written out as the
+// start of a clip, followed by the frames until the triggers have not held
+// for post_seconds. Each clip gets a JSON sidecar, <clip>.json, with the
+// detections of every frame; it is written last, so its appearance means
+// the clip is complete.
+//
+// publish() only copies the frame (the JPEG if a sink already made it, else
+// the pixels) and hands it to the recording thread, which encodes, keeps
+// the ring and writes clips. If that thread falls behind, frames are
+// skipped rather than the pipeline held up.
+class ClipRecorder : public FrameSink {
+public:
+    ClipRecorder(const ClipConfig& config, std::atomic<bool>& isRunning);
+    ~ClipRecorder() override;
+
+    ClipRecorder(const ClipRecorder&) = delete;
+    ClipRecorder& operator=(const ClipRecorder&) = delete;
+
+    // Called by the frame writer for every decorated frame
+    void publish(DecoratedFrame& frame) override;
+
+    // Record a frame that is already JPEG-encoded
+    void record(const std::vector<uchar>& jpeg, const InferenceResult& result);
+
+    // Record until the pipeline stops, then finish any open clip
+    void operator()();
+
+    struct Stats {
+        long frames;   // Frames recorded into the ring
+        long skipped;  // Frames replaced before the recording thread took them
+        long clips;    // Clips finished
+    };
+    Stats stats() const;
+
+private:
+    // A frame on its way to the recording thread or in the ring
+    struct Frame {
+        std::vector<uchar> jpeg;
+        cv::Mat bgr;  // Pixels still to encode when there is no JPEG
+        uint64_t frame_id = 0;
+        uint64_t timestamp_ms = 0;
+        bool triggered = false;  // Some trigger holds
+        std::vector<object_detect_result_t> detections;  // Selected, at or above the threshold
+
+        size_t bytes() const { return jpeg.size() + detections.size() * sizeof(object_detect_result_t); }
+    };
+
+    class Writer;
+
+    // Fill `incoming` from the result and hand it over
+    void offer(const InferenceResult& result, const std::vector<uchar>* jpeg, const cv::Mat* bgr);
+    // On the recording thread
+    void process(Frame& frame);
+    void startClip(const Frame& frame);
+    void addToClip(const Frame& frame);
+    void finishClip();
+    void enforceBudget();
+
+    ClipConfig config;
+    std::atomic<bool>& running;
+
+    // Hand-over of the newest frame
+    std::mutex mutex;
+    std::condition_variable ready;
+    Frame incoming;  // Frame writer's thread only
+    Frame pending;
+    bool has_pending = false;
+
+    // Recording thread only
+    std::deque<Frame> ring;
+    size_t ring_bytes = 0;
+    bool last_triggered = false;
+    uint64_t last_timestamp_ms = 0;
+    std::unique_ptr<Writer> writer;  // Open clip, if any
+    uint64_t clip_start_ms = 0;
+    uint64_t clip_end_ms = 0;        // Extended while the triggers hold
+    std::chrono::steady_clock::time_point last_frame_time;
+
+    std::atomic<long> frames_recorded{0};
+    std::atomic<long> frames_skipped{0};
+    std::atomic<long> clips_finished{0};
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+#include "ThreadPool.hpp"
+#include "frame_writer.h"
+#include "transport.h"
+#include "yolox.h"
+
+struct CropConfig {
+    std::string directory;          // Write crops here as JPEG files, or
+    std::string shm_name;           // publish them into this shared memory ring
+    float padding = 0.15f;          // Added on each side, as a fraction of the box size
+    int max_edge = 192;             // Crops are downsized to fit this many pixels
+    double rate_per_class = 2.0;    // Crops per second for each class
+    double burst = 4.0;             // Crops a class may save up when quiet
+    size_t max_files = 2000;        // Most crops kept in the directory; the oldest are deleted
+    int jpeg_quality = 85;
+    int threads = 2;                // Encoding workers
+    int max_pending = 8;            // Crops queued for the workers before more are dropped
+};
+
+// Ahead of each crop in the shared memory ring, followed by the JPEG
+struct CropHeader {
+    uint32_t magic;         // CROP_HEADER_MAGIC
+    uint32_t jpeg_size;
+    uint64_t frame_id;
+    uint64_t timestamp_ms;  // Unix time of the frame
+    int32_t cls_id;
+    float confidence;
+    int32_t left, top, right, bottom;  // Detection box in the frame
+    char class_name[32];               // NUL-terminated
+};
+
+static const uint32_t CROP_HEADER_MAGIC = 0x5243444f;  // "ODCR"
+
+// Per-class token buckets: each class earns rate crops per second, up to
+// burst saved
+class CropRateLimiter {
+public:
+    CropRateLimiter(double rate, double burst) : rate(rate), burst(burst) {}
+
+    // Spend a token for cls_id at now_ms; false if it has none
+    bool take(int cls_id, uint64_t now_ms);
+
+private:
+    struct Bucket {
+        double tokens;
+        uint64_t updated_ms;
+    };
+
+    double rate;
+    double burst;
+    std::map<int, Bucket> buckets;
+};
+
+// Saves crops of the detections of selected classes, cut from the frame
+// before any drawing.
+//
+// The frame writer's thread only picks the detections, subject to the
+// per-class rate limit, and copies the padded regions. Downsizing, colour
+// conversion and JPEG encoding happen on a small worker pool; when
+// max_pending crops are already waiting, further ones are dropped, so a
+// crowded frame never holds up the pipeline.
+//
+// In a directory each crop is one file,
+// crop-YYYYMMDD-HHMMSS-mmm-<frame>-<index>-<class>.jpg (UTC), replaced
+// atomically, with at most max_files kept. In shared memory each message is
+// a CropHeader followed by the JPEG.
+class CropSink : public RawFrameSink {
+public:
+    explicit CropSink(const CropConfig& config);
+    ~CropSink() override;
+
+    CropSink(const CropSink&) = delete;
+    CropSink& operator=(const CropSink&) = delete;
+
+    void publishRaw(const cv::Mat& rgb, const InferenceResult& result) override;
+
+    // Wait until every queued crop is written
+    void drain();
+
+    // The box grown by padding on each side and clipped to the frame;
+    // empty if nothing of it is in the frame
+    static cv::Rect cropRect(const box_rect_t& box, float padding, int width, int height);
+
+    struct Stats {
+        long written;      // Crops written or published
+        long limited;      // Skipped by the per-class rate limit
+        long dropped;      // Skipped because the workers were busy
+        long failed;       // Failed to encode or write
+    };
+    Stats stats() const;
+
+private:
+    struct Crop {
+        cv::Mat rgb;
+        CropHeader header;
+        int index;  // Detection index in the frame
+    };
+
+    // On a worker
+    void encode(Crop& crop);
+    void write(const Crop& crop, const std::vector<uchar>& jpeg);
+    void finished();
+
+    CropConfig config;
+    CropRateLimiter limiter;  // Frame writer's thread only
+
+    // Output, shared by the workers
+    std::mutex output_mutex;
+    std::unique_ptr<ShmRingTransport> ring;
+    std::deque<std::string> files;  // Oldest first
+    std::string message;
+
+    std::mutex pending_mutex;
+    std::condition_variable idle;
+    int pending = 0;
+
+    std::atomic<long> crops_written{0};
+    std::atomic<long> crops_limited{0};
+    std::atomic<long> crops_dropped{0};
+    std::atomic<long> crops_failed{0};
+
+    // Last, so the workers finish before anything they use is destroyed
+    dpool::ThreadPool workers;
+};
@@ -0,0 +1,125 @@
+#ifndef _DETECTION_WIRE_H_
+#define _DETECTION_WIRE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact binary detection messages (version 1), for streaming every box at
+ * camera rate. All fields are little-endian.
+ *
+ * Header, 32 bytes:
+ *   0  char[2]  magic "OD"
+ *   2  u8       version (1)
+ *   3  u8       flags (WIRE_FLAG_DELTA)
+ *   4  u32      model id (generation: 0 at startup, +1 per live model swap)
+ *   8  u64      frame sequence number
+ *   16 u64      timestamp, microseconds since the Unix epoch
+ *   24 u32      delta base: sequence - base sequence (0 for key frames)
+ *   28 u16      box count
+ *   30 u16      reserved (0)
+ *
+ * Key frame box, 12 bytes:
+ *   i16 left, top, right, bottom; u16 confidence * 65535; u16 class id
+ *
+ * Delta frame box, 4-16 bytes:
+ *   u16 class id; u16 confidence * 65535; then left, top, right, bottom as
+ *   zigzag varints of the difference from the box at the same index in the
+ *   base frame (from 0 when the base frame has fewer boxes)
+ *
+ * A delta frame can only be decoded when its base frame was the last one
+ * decoded. Receivers that lose a message wait for the next key frame.
+ */
+
+#define WIRE_VERSION 1
+#define WIRE_HEADER_SIZE 32
+#define WIRE_KEY_BOX_SIZE 12
+#define WIRE_MAX_DELTA_BOX_SIZE 16
+#define WIRE_MAX_BOXES 128
+#define WIRE_MAX_MESSAGE_SIZE (WIRE_HEADER_SIZE + WIRE_MAX_BOXES * WIRE_MAX_DELTA_BOX_SIZE)
+
+#define WIRE_FLAG_DELTA 0x01
+
+#define WIRE_ERR_TRUNCATED -1  // Message shorter than its header says
+#define WIRE_ERR_MAGIC -2      // Not a detection message
+#define WIRE_ERR_VERSION -3    // Newer format version
+#define WIRE_ERR_NO_BASE -4    // Delta frame whose base frame was not the last one decoded
+#define WIRE_ERR_TOO_MANY -5   // More than WIRE_MAX_BOXES boxes
+
+typedef struct {
+    int left;
+    int top;
+    int right;
+    int bottom;
+    float confidence;
+    int class_id;
+} wire_box_t;
+
+typedef struct {
+    uint32_t model_id;
+    uint64_t sequence;
+    uint64_t timestamp_us;
+    int is_delta;  // Set by wire_decode()
+    int box_count;
+    wire_box_t boxes[WIRE_MAX_BOXES];
+} wire_frame_t;
+
+typedef struct {
+    wire_frame_t last;  // Last frame encoded, as the receiver will decode it
+    int has_last;
+    int keyframe_interval;
+    int since_keyframe;
+} wire_encoder_t;
+
+typedef struct {
+    wire_frame_t last;  // Last frame decoded, the base for the next delta
+    int has_last;
+} wire_decoder_t;
+
+/**
+ * @brief Initialize an encoder
+ *
+ * @param encoder [out] Encoder state
+ * @param keyframe_interval [in] Send a key frame every this many messages and
+ *        delta frames in between; 0 or 1 sends only key frames
+ */
+void wire_encoder_init(wire_encoder_t* encoder, int keyframe_interval);
+
+/**
+ * @brief Encode one frame of detections
+ *
+ * @param encoder [in/out] Encoder state
+ * @param frame [in] Frame to encode; coordinates are clamped to 16 bits
+ * @param out [out] Message buffer, at least WIRE_MAX_MESSAGE_SIZE bytes
+ * @param capacity [in] Size of out
+ * @return int -1: error; > 0: message size
+ */
+int wire_encode(wire_encoder_t* encoder, const wire_frame_t* frame, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Initialize a decoder
+ *
+ * @param decoder [out] Decoder state
+ */
+void wire_decoder_init(wire_decoder_t* decoder);
+
+/**
+ * @brief Decode one message
+ *
+ * @param decoder [in/out] Decoder state
+ * @param data [in] Message
+ * @param size [in] Message size
+ * @param frame [out] Decoded frame (not decoder->last)
+ * @return int 0: success; < 0: WIRE_ERR_* code
+ */
+int wire_decode(wire_decoder_t* decoder, const uint8_t* data, size_t size, wire_frame_t* frame);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif //_DETECTION_WIRE_H_
@@ -1,8 +1,14 @@
 #ifndef FRAME_WRITER_H
 #define FRAME_WRITER_H
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
+#include "overlay.h"
+#include "redaction.h"
+#include "shm_ring.h"
 #include "yolox.h"
 
 // Forward declaration for InferenceResult
@@ -15,16 +21,143 @@ public:
     virtual void writeFrame(cv::Mat& frame, const InferenceResult& result) = 0;
 };
 
-// Concrete implementation that decorates frames with bounding boxes and writes to file
+// JPEG chroma subsampling: 4:2:0 is smallest and fastest, 4:4:4 keeps
+// thin coloured lines such as box outlines sharp
+enum class JpegSubsampling {
+    S420,
+    S422,
+    S444
+};
+
+// Parse "420", "422" or "444"
+bool parseJpegSubsampling(const std::string& text, JpegSubsampling& subsampling);
+
+// Encode a BGR frame as baseline JPEG with turbojpeg; false on failure
+bool encodeJpeg(const cv::Mat& bgr, int quality, std::vector<uchar>& jpeg,
+                JpegSubsampling subsampling = JpegSubsampling::S420);
+
+// The size of frame scaled down to fit within max_width x max_height with
+// its aspect ratio kept; false if it already fits (frames are never scaled up)
+bool fitWithin(const cv::Mat& frame, int max_width, int max_height, cv::Size& size);
+
+// Size and encoding of the decorated frames handed to the file and sinks
+struct FrameOutputConfig {
+    int width = 0;                                        // Fit within width x height; 0: capture size
+    int height = 0;
+    int jpeg_quality = 95;                                // Same as cv::imwrite() used to write
+    JpegSubsampling subsampling = JpegSubsampling::S420;
+};
+
+// A decorated BGR frame on its way to the sinks. The JPEG encoding is made
+// on first use and shared by every sink that needs it.
+class DecoratedFrame {
+public:
+    explicit DecoratedFrame(const cv::Mat& bgr, const InferenceResult* result = nullptr,
+                            const FrameOutputConfig& output = FrameOutputConfig())
+        : bgr_frame(bgr), frame_result(result), jpeg_quality(output.jpeg_quality), subsampling(output.subsampling) {}
+
+    const cv::Mat& bgr() const { return bgr_frame; }
+    const std::vector<uchar>& jpeg();
+    // Whether a sink has already made the JPEG encoding
+    bool hasJpeg() const { return !jpeg_data.empty(); }
+    // The result drawn on the frame, if known, with boxes in this frame's
+    // pixels (scaled when the writer has a smaller output size)
+    const InferenceResult* result() const { return frame_result; }
+
+private:
+    const cv::Mat& bgr_frame;
+    const InferenceResult* frame_result;
+    int jpeg_quality;
+    JpegSubsampling subsampling;
+    std::vector<uchar> jpeg_data;
+};
+
+// Abstract interface for destinations of decorated frames
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+    virtual void publish(DecoratedFrame& frame) = 0;
+};
+
+// Abstract interface for destinations of the undecorated frames, called
+// before anything is drawn on them
+class RawFrameSink {
+public:
+    virtual ~RawFrameSink() = default;
+    // The frame is RGB and only valid for the duration of the call
+    virtual void publishRaw(const cv::Mat& rgb, const InferenceResult& result) = 0;
+};
+
+enum class ShmFrameFormat {
+    RGB24,
+    NV12,
+    JPEG
+};
+
+// Parse "rgb", "nv12" or "jpeg"
+bool parseShmFrameFormat(const std::string& text, ShmFrameFormat& format);
+
+// Publishes frames into a shared memory triple buffer (see shm_frame.h).
+// Raw frames are converted straight into the shared slot.
+class ShmFrameSink : public FrameSink {
+public:
+    ShmFrameSink(const std::string& name, ShmFrameFormat format);
+    ~ShmFrameSink() override;
+    void publish(DecoratedFrame& frame) override;
+
+    // JPEG frames dropped so far because they did not fit a slot
+    long dropped() const { return too_large_drops; }
+
+private:
+    // Create the ring for frames of this size; false on failure
+    bool resize(int width, int height);
+
+    std::string name;
+    ShmFrameFormat format;
+    shm_ring_t ring;
+    bool open;
+    int width;
+    int height;
+    cv::Mat i420;  // NV12 conversion scratch
+    std::atomic<long> too_large_drops{0};
+};
+
+// Concrete implementation that redacts and decorates frames with bounding
+// boxes, writes them to a file and hands them to any sinks. With a smaller
+// output size the frame is scaled down once, after the raw sinks, keeping
+// its aspect ratio; boxes are scaled with it and the frame is drawn,
+// converted and encoded at that size.
 class DecoratedFrameWriter : public FrameWriter {
 private:
     std::string output_path;
     bool suppress_empty;
-    
+    std::vector<std::shared_ptr<FrameSink>> sinks;
+    std::vector<std::shared_ptr<RawFrameSink>> raw_sinks;
+    Redactor redactor{RedactionConfig()};
+    OverlayRenderer label_renderer{20};
+    OverlayRenderer banner_renderer{64};  // For "none"
+    FrameOutputConfig output;
+    bool warned_output_size = false;
+    cv::Mat scaled;                                  // The frame at the output size
+    std::shared_ptr<InferenceResult> scaled_result;  // Its result, boxes scaled
+
+    // The size to scale this frame down to; false to keep it
+    bool outputSize(const cv::Mat& frame, cv::Size& size);
+    void decorate(cv::Mat& canvas, const InferenceResult& result);
+    void writeFile(DecoratedFrame& frame);
+
 public:
-    explicit DecoratedFrameWriter(const std::string& path, bool suppress_empty = false) 
+    // An empty path skips the file
+    explicit DecoratedFrameWriter(const std::string& path, bool suppress_empty = false)
         : output_path(path), suppress_empty(suppress_empty) {}
+    // Add before the first frame
+    void addSink(std::shared_ptr<FrameSink> sink) { sinks.push_back(std::move(sink)); }
+    void addRawSink(std::shared_ptr<RawFrameSink> sink) { raw_sinks.push_back(std::move(sink)); }
+    // Redact these classes in every frame before any sink sees it
+    void setRedaction(const RedactionConfig& config) { redactor = Redactor(config); }
+    // Decorated frame size and JPEG encoding; frames are never scaled up
+    void setOutput(const FrameOutputConfig& config) { output = config; }
     void writeFrame(cv::Mat& frame, const InferenceResult& result) override;
 };
 
-#endif // FRAME_WRITER_H
\ No newline at end of file
+#endif // FRAME_WRITER_H
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "yolox.h"
+
+// What each detection adds to the heatmap
+enum class HeatmapFootprint {
+    Box,    // 1 to every cell the box covers
+    Center  // 1 to the cell under the box center
+};
+
+enum class HeatmapFormat {
+    PNG,  // 8-bit grayscale, scaled so the hottest cell is 255
+    Raw   // HeatmapRawHeader, then cols x rows little-endian floats, row by row
+};
+
+struct HeatmapConfig {
+    int cols = 96;               // Grid size
+    int rows = 54;
+    int frame_width = 1920;      // Frame the detection boxes are in, until setFrameSize()
+    int frame_height = 1080;
+    HeatmapFootprint footprint = HeatmapFootprint::Box;
+    double half_life_seconds = 0.0;  // Exponential decay; 0 keeps everything
+};
+
+// Header of a raw export. The values are detection-frames: a person standing
+// in a cell for 30 frames adds 30, less any decay since.
+struct HeatmapRawHeader {
+    uint32_t magic;         // HEATMAP_RAW_MAGIC
+    uint16_t cols;
+    uint16_t rows;
+    uint64_t timestamp_ms;  // Time the values are decayed to
+};
+
+static const uint32_t HEATMAP_RAW_MAGIC = 0x4d48444f;  // "ODHM"
+
+// Parse "png" or "raw"
+bool parseHeatmapFormat(const std::string& text, HeatmapFormat& format);
+
+// Parse "box" or "center"
+bool parseHeatmapFootprint(const std::string& text, HeatmapFootprint& footprint);
+
+// Accumulates detection footprints into a low-resolution float grid.
+//
+// Box footprints are marked at their four corners in a difference grid and
+// integrated into the heatmap in one pass per frame, so a frame costs one
+// pass over the grid however many boxes it has and however large they are.
+// Decay is applied lazily: new footprints are weighted up by the growth
+// since the last rescale instead of every cell being scaled down each frame.
+class Heatmap {
+public:
+    explicit Heatmap(const HeatmapConfig& config);
+
+    int cols() const { return config.cols; }
+    int rows() const { return config.rows; }
+
+    // The size of the frames boxes are added from. Cells cover the same part
+    // of the frame at any size, so the grid carries over a size change.
+    void setFrameSize(int width, int height);
+
+    // Add one frame's boxes, seen at timestamp_ms
+    void add(uint64_t timestamp_ms, const box_rect_t* boxes, size_t count);
+
+    // Values decayed to the latest frame, row by row
+    void values(std::vector<float>& out) const;
+    uint64_t timestamp() const { return latest_ms; }
+
+    // Replace out with the heatmap as a PNG or raw file
+    void encode(HeatmapFormat format, std::string& out) const;
+
+private:
+    // Rescale the stored values so new footprints weigh 1 again
+    void rescale();
+
+    HeatmapConfig config;
+    double decay_per_ms;            // ln 2 / half-life
+    std::vector<float> cells;       // Stored values; value = cell / weight
+    std::vector<float> corners;     // (rows + 1) x (cols + 1) difference grid
+    std::vector<float> column_sum;  // Scratch for integrating corners
+    uint64_t weight_ms = 0;         // Time of the last rescale
+    uint64_t latest_ms = 0;
+    double weight = 1.0;            // Weight of a footprint at latest_ms
+    bool started = false;
+};
@@ -0,0 +1,152 @@
+#ifndef _HISTORY_LOG_H_
+#define _HISTORY_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Detection history segments (version 1), appended to by the history sink
+ * and read in place by history_query. All fields are little-endian.
+ *
+ * A segment file is a header followed by fixed-size records, so record i is
+ * at header_size + i * record_size and a reader maps the file and indexes
+ * it directly. Records are in time order within a segment: a writer whose
+ * clock steps back starts a new segment, so segment names
+ * (history-YYYYMMDD-HHMMSS-mmm.odh, UTC creation time) sort in time order
+ * except across such a step, and readers take each segment on its own. A
+ * writer only ever appends to a segment it created; a partial record at the
+ * end, from a crash, is ignored by readers.
+ *
+ * Header, header_size bytes:
+ *   history_header_t, then class_count names of HISTORY_CLASS_NAME_SIZE
+ *   bytes (NUL-padded), then padding to a multiple of 8
+ *
+ * Record, record_size bytes (a multiple of 8):
+ *   history_record_t
+ *   u16 counts[class_count]      detections per class, in header order
+ *   history_box_t boxes[box_capacity], of which box_count are used
+ *   padding
+ */
+
+#define HISTORY_MAGIC 0x4c48444fu  // "ODHL"
+#define HISTORY_VERSION 1
+#define HISTORY_CLASS_NAME_SIZE 32
+#define HISTORY_MAX_CLASSES 256
+#define HISTORY_MAX_BOXES 128
+
+#define HISTORY_ERR_SYSTEM -1  // See errno
+#define HISTORY_ERR_FORMAT -2  // Not a history segment, or a newer version
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;   // Bytes before the first record
+    uint32_t record_size;
+    uint16_t class_count;
+    uint16_t box_capacity;  // Boxes kept per record; 0 for counts only
+    uint64_t created_ms;    // Unix time the segment was started
+    uint8_t reserved[40];
+} history_header_t;
+
+typedef struct {
+    uint64_t timestamp_ms;  // Unix time of the frame
+    uint32_t frame_id;      // Low 32 bits of the frame sequence number
+    uint16_t detections;    // Detections counted in the frame
+    uint16_t box_count;     // Boxes kept, at most box_capacity
+} history_record_t;
+
+typedef struct {
+    int16_t left;
+    int16_t top;
+    int16_t right;
+    int16_t bottom;
+    uint16_t confidence;    // Confidence * 65535
+    uint16_t class_index;   // Into the header's class names
+} history_box_t;
+
+typedef struct {
+    const uint8_t* base;
+    size_t size;            // Of the mapping
+    const history_header_t* header;
+    uint64_t record_count;  // Whole records in the file
+} history_segment_t;
+
+/**
+ * @brief Bytes before the first record of a segment
+ */
+static inline size_t history_header_size(uint16_t class_count)
+{
+    return (sizeof(history_header_t) + (size_t)class_count * HISTORY_CLASS_NAME_SIZE + 7) & ~(size_t)7;
+}
+
+/**
+ * @brief Bytes of every record of a segment
+ */
+static inline size_t history_record_size(uint16_t class_count, uint16_t box_capacity)
+{
+    return (sizeof(history_record_t) + (size_t)class_count * sizeof(uint16_t) +
+            (size_t)box_capacity * sizeof(history_box_t) + 7) & ~(size_t)7;
+}
+
+/**
+ * @brief Fill in a segment header, class names included
+ *
+ * @param buffer [out] At least history_header_size(class_count) bytes
+ * @param class_names [in] class_count names; longer names are truncated
+ * @param class_count [in] At most HISTORY_MAX_CLASSES
+ * @param box_capacity [in] At most HISTORY_MAX_BOXES
+ * @param created_ms [in] Unix time in milliseconds
+ * @return size_t Header size
+ */
+size_t history_header_init(void* buffer, const char* const* class_names, uint16_t class_count,
+                           uint16_t box_capacity, uint64_t created_ms);
+
+/**
+ * @brief Map a segment for reading
+ *
+ * @param segment [out] Segment
+ * @param path [in] Segment file
+ * @return int 0: success; HISTORY_ERR_*: error
+ */
+int history_segment_map(history_segment_t* segment, const char* path);
+
+/**
+ * @brief Unmap a segment
+ */
+void history_segment_unmap(history_segment_t* segment);
+
+/**
+ * @brief Name of class i of a segment, NUL-terminated within HISTORY_CLASS_NAME_SIZE bytes
+ */
+const char* history_class_name(const history_segment_t* segment, uint16_t index);
+
+/**
+ * @brief Index of the first record at or after timestamp_ms (record_count if none)
+ */
+uint64_t history_segment_find(const history_segment_t* segment, uint64_t timestamp_ms);
+
+static inline const history_record_t* history_segment_record(const history_segment_t* segment, uint64_t index)
+{
+    return (const history_record_t*)(segment->base + segment->header->header_size +
+                                     index * segment->header->record_size);
+}
+
+static inline const uint16_t* history_record_counts(const history_record_t* record)
+{
+    return (const uint16_t*)(record + 1);
+}
+
+static inline const history_box_t* history_record_boxes(const history_record_t* record, uint16_t class_count)
+{
+    return (const history_box_t*)(history_record_counts(record) + class_count);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif //_HISTORY_LOG_H_
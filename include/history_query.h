@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "history_log.h"
+
+// What to aggregate from the detection history (see history_log.h)
+struct HistoryQuery {
+    uint64_t from_ms = 0;            // First record time included (Unix ms)
+    uint64_t to_ms = UINT64_MAX;     // First record time excluded
+    uint64_t bucket_ms = 3600000;    // Aggregation period
+    int64_t utc_offset_ms = 0;       // Buckets start on multiples of the period in this time zone
+};
+
+// One class over one bucket
+struct HistoryClassTotals {
+    uint64_t sum = 0;       // Of the per-record counts, for the mean
+    uint32_t max = 0;
+    uint64_t occupied = 0;  // Records with at least one detection
+};
+
+struct HistoryBucket {
+    uint64_t start_ms = 0;
+    uint64_t records = 0;
+    std::vector<HistoryClassTotals> classes;  // By HistoryResult::class_names
+};
+
+struct HistoryResult {
+    std::vector<std::string> class_names;  // Every class in the segments read, first seen first
+    std::vector<HistoryBucket> buckets;    // In time order, only those with records
+    uint64_t records = 0;
+    size_t segments = 0;                   // Segments read
+};
+
+// Segment files in directory, oldest first
+std::vector<std::string> listHistorySegments(const std::string& directory);
+
+// Aggregate the records of segments in place in their mappings. Segments
+// that cannot be read are reported and skipped; returns false if none could
+// be read.
+bool queryHistory(const std::vector<std::string>& segments, const HistoryQuery& query, HistoryResult& result);
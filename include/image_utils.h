@@ -26,6 +26,15 @@ typedef struct {
  */
 int read_image(const char* path, image_buffer_t* image);
 
+/**
+ * @brief List the image files (jpg/png/data) in a directory, sorted by name
+ * 
+ * @param dir [in] Directory path
+ * @param out_paths [out] Paths of the images, remember call free_lines() to release after used
+ * @return int -1: error; >= 0: Number of images
+ */
+int list_image_files(const char* dir, char*** out_paths);
+
 /**
  * @brief Write image file (support jpg/png)
  * 
@@ -58,6 +67,18 @@ int convert_image(image_buffer_t* src_image, image_buffer_t* dst_image, image_re
  */
 int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color);
 
+/**
+ * @brief Convert a region of the source image with letterbox
+ * 
+ * @param src_image [in] Source Image
+ * @param roi [in] Region of the source image to convert (NULL for the whole image)
+ * @param dst_image [out] Target Image
+ * @param letterbox [out] Letterbox, relative to the region's top-left corner
+ * @param color [in] Fill color on target image
+ * @return int 
+ */
+int convert_image_with_letterbox_roi(image_buffer_t* src_image, image_rect_t* roi, image_buffer_t* dst_image, letterbox_t* letterbox, char color);
+
 /**
  * @brief Get the image size
  * 
@@ -3,7 +3,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -19,6 +23,9 @@
 #include "queue.h"
 #include "yolox.h"
 #include "frame_writer.h"
+#include "npu_pool.h"
+#include "result_view.h"
+#include "tiling.h"
 
 // Struct to hold ML inference results
 struct InferenceResult {
@@ -27,6 +34,28 @@ struct InferenceResult {
     std::vector<int> selected_classes;  // Selected class IDs for filtering
     std::unordered_map<std::string, int> class_mapping;  // Class name to ID mapping
     float confidence_threshold;  // Confidence threshold used for this inference
+    uint64_t frame_id = 0;  // Sequence number of the inferred frame, from 1
+    uint32_t model_id = 0;  // Model generation: 0 for the startup model, +1 per live swap
+    int frame_width = 0;    // Size of the inferred frame, as the source delivered it; 0 if unknown
+    int frame_height = 0;
+
+    // Shared by copies of this result. Set by shareView() once the detections
+    // are final; results without one compute a per-thread view on each call.
+    std::shared_ptr<ResultViewCache> view_cache;
+
+    void shareView() { view_cache = std::make_shared<ResultViewCache>(); }
+
+    // Aggregates over the detections, computed on first access. Without a
+    // shared cache the reference is valid until this thread's next view() call.
+    const ResultView& view() const;
+};
+
+// Pipeline settings beyond the model and source
+struct InferenceConfig {
+    int npu_contexts = 1;       // RKNN contexts to run in parallel (one per NPU core on RK3588)
+    int capture_width = 640;    // Resolution requested from the V4L device
+    int capture_height = 640;
+    TileConfig tiling;          // Tiled high-resolution inference (disabled by default)
 };
 
 
@@ -35,9 +64,22 @@ private:
     ThreadSafeQueue<InferenceResult>& resultQueue;
     std::atomic<bool>& running;
     int target_fps;
-    int frames{0};
+    std::atomic<int> frames{0};
     const char* source_name;
-    std::unique_ptr<rknn_app_context_t> rknn_app_ctx;
+    InferenceConfig config;
+    std::shared_ptr<NpuContextPool> npu_pool;  // Replaced by swapModel(); guarded by pool_mutex
+    std::future<std::shared_ptr<NpuContextPool>> pending_pool;  // Initial load, running in the background
+    std::once_flag model_ready_once;
+    bool model_ready = false;
+    std::mutex pool_mutex;
+    std::mutex swap_mutex;
+    std::atomic<int> failed_frames{0};
+    std::atomic<uint64_t> frame_sequence{0};
+    uint32_t model_generation = 0;  // Guarded by pool_mutex, changes with npu_pool
+    int pool_users = 0;     // Frames running on npu_pool; guarded by pool_mutex
+    int retired_users = 0;  // Frames still running on the pool swapModel() replaced; guarded by pool_mutex
+    std::condition_variable pool_drained;  // Signalled when retired_users reaches 0
+    std::unique_ptr<TiledInference> tiled_inference;
     std::shared_ptr<FrameWriter> frameWriter;
     std::vector<int> selected_classes;  // Selected class IDs for filtering
     std::unordered_map<std::string, int> class_mapping;  // Class name to ID mapping
@@ -46,7 +88,12 @@ private:
     // Simulated ML model inference
     InferenceResult runInference(cv::Mat& img);
 
+    // Block until the background model load and warm-up have finished
+    bool waitForModel();
+
 public:
+    // The model is loaded and warmed up in the background, so the caller
+    // (and the camera open in operator()) proceed in parallel with it
     MLInferenceThread(
         const char* model_path,
         const char* source_name,
@@ -56,10 +103,23 @@ public:
         std::shared_ptr<FrameWriter> writer = nullptr,
         const std::vector<int>& selected_classes = {},
         const std::unordered_map<std::string, int>& class_mapping = {},
-        float confidence_threshold = 0.3f);
+        float confidence_threshold = 0.3f,
+        const InferenceConfig& config = {});
     ~MLInferenceThread(); // Destructor declaration
     void operator()();
     void runSingleInference(); // Single-shot inference for file input
+
+    // Outcome of inferFrame(); result is only meaningful for Ok
+    enum class FrameStatus { Ok, ModelNotLoaded, Failed };
+
+    // Run one frame outside the capture loop (e.g. for the inference server).
+    // Safe to call from several threads; frames share the NPU context pool.
+    FrameStatus inferFrame(cv::Mat& img, InferenceResult& result);
+
+    // Load and warm up a new model in the calling thread, then switch to it
+    // between frames and release the previous one once its frames drain.
+    // Returns false (keeping the current model) if the new one fails to load.
+    bool swapModel(const std::string& model_path);
 };
 
 #endif // INFERENCE_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "inference.h"
+#include "publisher.h"
+
+// Serves on-demand inference over a Unix domain socket while the model stays
+// resident. Each connection carries any number of requests, one per line:
+//
+//   PATH <image path>\n          infer an image file on the player
+//   JPEG <length>\n<bytes>       infer an in-memory JPEG (or any format OpenCV decodes)
+//
+// Every request is answered on the same connection with one line holding the
+// formatter's output, or {"error":"..."} on failure. Connections are served
+// concurrently; the NPU context pool bounds how many frames run at once.
+class InferenceServer {
+public:
+    InferenceServer(
+        const std::string& socket_path,
+        MLInferenceThread& inference,
+        std::shared_ptr<MessageFormatter> formatter,
+        std::atomic<bool>& isRunning);
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    void operator()();
+
+private:
+    struct Connection {
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    bool listen();
+    void serve(int fd, Connection* connection);
+    // Returns false when the connection can no longer be used
+    bool handleRequest(int fd, const std::string& request, std::string& buffered, std::string& response);
+    void reapConnections(bool wait_all);
+
+    std::string socket_path;
+    MLInferenceThread& inference;
+    std::shared_ptr<MessageFormatter> formatter;
+    std::atomic<bool>& running;
+    int listen_fd{-1};
+
+    std::mutex connections_mutex;
+    std::list<std::unique_ptr<Connection>> connections;
+    std::atomic<long> requests_served{0};
+};
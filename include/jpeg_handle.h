@@ -0,0 +1,46 @@
+#pragma once
+
+#include "turbojpeg.h"
+
+// A turbojpeg handle owned by one thread and destroyed when the thread
+// exits. A failed init is retried on the next get().
+class ThreadJpegHandle {
+public:
+    enum class Kind {
+        Compress,
+        Decompress
+    };
+
+    explicit ThreadJpegHandle(Kind kind) : kind(kind) {}
+    ~ThreadJpegHandle() {
+        if (handle) {
+            tjDestroy(handle);
+        }
+    }
+
+    ThreadJpegHandle(const ThreadJpegHandle&) = delete;
+    ThreadJpegHandle& operator=(const ThreadJpegHandle&) = delete;
+
+    // Null while turbojpeg cannot make one
+    tjhandle get() {
+        if (!handle) {
+            handle = kind == Kind::Compress ? tjInitCompress() : tjInitDecompress();
+        }
+        return handle;
+    }
+
+private:
+    Kind kind;
+    tjhandle handle = nullptr;
+};
+
+// This thread's compressor and decompressor
+inline tjhandle threadJpegCompressor() {
+    thread_local ThreadJpegHandle compressor(ThreadJpegHandle::Kind::Compress);
+    return compressor.get();
+}
+
+inline tjhandle threadJpegDecompressor() {
+    thread_local ThreadJpegHandle decompressor(ThreadJpegHandle::Kind::Decompress);
+    return decompressor.get();
+}
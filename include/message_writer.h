@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Serializes JSON / BrightScript message text straight into a caller-owned
+// buffer. Publishers keep one buffer each and reuse it for every message, so
+// once its capacity has grown to the largest message, formatting allocates
+// nothing. Output matches nlohmann::json::dump() byte for byte: integers
+// are written with std::to_chars, floats with the same shortest round-trip
+// digits dump() uses, and strings with the same escaping.
+class MessageWriter {
+public:
+    explicit MessageWriter(std::string& out) : out(out) {}
+
+    // Literal text, e.g. a precomputed key fragment such as "{\"timestamp\":"
+    void raw(std::string_view text) { out.append(text); }
+    void raw(char c) { out.push_back(c); }
+
+    void integer(long long value);
+    void number(double value);
+
+    // Quoted, escaped JSON string
+    void string(std::string_view text);
+
+private:
+    std::string& out;
+};
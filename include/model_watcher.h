@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+// Watches for requests to replace the running model without restarting the
+// pipeline. A swap is requested when:
+//  - the model file is rewritten or replaced in place (inotify)
+//  - a new model path is written to the control file
+//  - requestReload() is called (e.g. from the SIGHUP handler)
+// The callback runs on the watcher thread, so loading the new model never
+// stalls inference.
+class ModelWatcher {
+public:
+    using SwapCallback = std::function<bool(const std::string& model_path)>;
+
+    ModelWatcher(
+        const std::string& model_path,
+        const std::string& control_path,
+        bool watch_model_file,
+        std::atomic<bool>& isRunning,
+        SwapCallback callback);
+    ~ModelWatcher();
+
+    ModelWatcher(const ModelWatcher&) = delete;
+    ModelWatcher& operator=(const ModelWatcher&) = delete;
+
+    // Async-signal-safe: reload the current model path
+    void requestReload();
+
+    void operator()();
+
+private:
+    bool addWatches();
+    std::string readControlFile() const;
+
+    std::string model_path;
+    std::string control_path;
+    bool watch_model_file;
+    std::atomic<bool>& running;
+    SwapCallback callback;
+
+    int inotify_fd{-1};
+    int wake_fd{-1};
+    int model_dir_wd{-1};
+    int control_dir_wd{-1};
+};
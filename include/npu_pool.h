@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "yolox.h"
+
+// Set of RKNN contexts sharing one loaded model. A context runs one inference
+// at a time, so N contexts allow N frames or tiles in flight on the NPU
+// (contexts are pinned round-robin to the cores of RK3588/RK3576).
+class NpuContextPool {
+public:
+    NpuContextPool(const char* model_path, int num_contexts = 1);
+    ~NpuContextPool();
+
+    NpuContextPool(const NpuContextPool&) = delete;
+    NpuContextPool& operator=(const NpuContextPool&) = delete;
+
+    bool isValid() const { return !contexts.empty(); }
+    int size() const { return static_cast<int>(contexts.size()); }
+    int modelWidth() const;
+    int modelHeight() const;
+
+    // Run one inference on a synthetic frame per context so the NPU's lazy
+    // initialization is paid before the first real frame. Call before the
+    // pool is handed to other threads.
+    int warmUp();
+
+    // Run inference on the next free context, blocking until one is available
+    int infer(image_buffer_t* img, object_detect_result_list* results, float conf_threshold,
+              image_rect_t* src_box = nullptr);
+
+private:
+    rknn_app_context_t* acquire();
+    void release(rknn_app_context_t* ctx);
+
+    std::vector<std::unique_ptr<rknn_app_context_t>> contexts;
+    std::vector<rknn_app_context_t*> idle;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "yolox.h"
+
+enum class OverlayFormat {
+    RGB24,  // 3 bytes per pixel, in the order the colours are given
+    NV12    // height rows of Y, then height / 2 rows of interleaved U V, same stride
+};
+
+// An image to draw on, owned by the caller
+struct OverlayImage {
+    uint8_t* data;
+    int width;
+    int height;
+    size_t stride;  // Bytes per row
+    OverlayFormat format;
+};
+
+// A colour as the three bytes of an RGB24 pixel. For NV12 targets they are
+// taken as R, G, B and converted (BT.601, full range).
+struct OverlayColor {
+    uint8_t c0, c1, c2;
+};
+
+// Draws detection boxes and labels without rasterizing any text per frame.
+//
+// The bitmap font of font.h is resampled once, at construction, into a
+// glyph atlas at the requested height. Each class name's "name: " prefix is
+// composed from it into a strip the first time the class is drawn; the
+// confidence is blitted from the digit glyphs, so a label costs one alpha
+// blit for the prefix and one per character of "0.87", with no formatting
+// or allocation. Boxes are drawn as spans of rows.
+class OverlayRenderer {
+public:
+    explicit OverlayRenderer(int font_height = 20);
+
+    int glyphWidth() const { return glyph_width; }
+    int glyphHeight() const { return glyph_height; }
+    // Width of a text of this many characters
+    int textWidth(size_t length) const { return static_cast<int>(length) * glyph_width; }
+    // Width of the label drawLabel() draws for this name
+    int labelWidth(const char* name) const;
+
+    // Outline the box, thickness pixels wide inside its edges
+    void drawBox(OverlayImage& image, const box_rect_t& box, OverlayColor color, int thickness) const;
+
+    // Printable ASCII text with its top left corner at (x, y)
+    void drawText(OverlayImage& image, const char* text, int x, int y, OverlayColor color) const;
+
+    // "name: 0.87" with its top left corner at (x, y)
+    void drawLabel(OverlayImage& image, const char* name, float confidence, int x, int y, OverlayColor color);
+
+private:
+    // Coverage of some text, one byte per pixel
+    struct Strip {
+        int width = 0;
+        std::vector<uint8_t> alpha;
+    };
+
+    // Most class prefixes kept; a model has far fewer classes
+    static const size_t MAX_STRIPS = 1024;
+
+    const uint8_t* glyph(char ch) const;
+    const Strip& prefix(const char* name);
+    // Blend colour into the image through a coverage mask
+    void blend(OverlayImage& image, const uint8_t* alpha, size_t alpha_stride, int w, int x, int y,
+               OverlayColor color) const;
+
+    int glyph_width;
+    int glyph_height;
+    size_t atlas_stride;          // Glyphs side by side in one row of the atlas
+    std::vector<uint8_t> atlas;
+    std::unordered_map<std::string, Strip> prefixes;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "frame_writer.h"
+
+struct PreviewConfig {
+    std::string address = "127.0.0.1";  // Loopback only unless set otherwise
+    int port = 8080;                     // 0: any free port (see PreviewServer::port())
+    double fps = 10.0;                   // Most frames encoded per second
+    int width = 0;                       // Largest preview size, aspect kept; 0 keeps the frame size
+    int height = 0;
+};
+
+// Parse "port" or "ip:port" into config
+bool parsePreviewAddress(const std::string& text, PreviewConfig& config);
+
+// Serves decorated frames to browsers over HTTP:
+//
+//   GET /              MJPEG stream (multipart/x-mixed-replace)
+//   GET /snapshot.jpg  the newest frame
+//
+// Each frame is encoded once, and only while clients are connected; every
+// client is sent the same buffer. One thread serves all clients with
+// non-blocking sockets. A client that cannot keep up finishes the frame it
+// is receiving and then jumps to the newest, so it holds back neither the
+// other clients nor the pipeline.
+class PreviewServer : public FrameSink {
+public:
+    PreviewServer(const PreviewConfig& config, std::atomic<bool>& isRunning);
+    ~PreviewServer() override;
+
+    PreviewServer(const PreviewServer&) = delete;
+    PreviewServer& operator=(const PreviewServer&) = delete;
+
+    // Called by the frame writer for every decorated frame
+    void publish(DecoratedFrame& frame) override;
+
+    // Serve clients until the pipeline stops
+    void operator()();
+
+    // Bound port once listening, else 0
+    int port() const { return bound_port; }
+
+    struct Stats {
+        long frames_encoded;
+        long frames_sent;     // Counting each client separately
+        long frames_skipped;  // Newer frames that replaced ones a slow client never got
+        long clients;         // Connected now
+    };
+    Stats stats() const;
+
+private:
+    // An encoded frame with its multipart header, shared by all clients
+    struct Frame {
+        std::string part;  // Part header, JPEG, CRLF
+        size_t jpeg_offset;
+        size_t jpeg_size;
+        uint64_t version;
+    };
+
+    struct Client {
+        int fd;
+        std::string request;
+        bool streaming = false;              // GET /
+        bool waiting = false;                // GET /snapshot.jpg, until the next frame
+        bool counted = false;                // In client_count
+        bool close_when_sent = false;
+        bool want_write = false;             // EPOLLOUT registered
+        bool dead = false;
+        std::string head;                    // Response header, sent before any frame data
+        size_t head_sent = 0;
+        std::shared_ptr<const Frame> frame;  // Frame being sent
+        size_t offset = 0;                   // Into frame->part
+        size_t end = 0;
+        uint64_t version = 0;                // Newest frame started
+        std::chrono::steady_clock::time_point last_progress;
+    };
+
+    bool listen();
+    void acceptClients();
+    // Returns false when the client should be dropped
+    bool readRequest(Client& client);
+    bool sendPending(Client& client);
+    void startFrame(Client& client, const std::shared_ptr<const Frame>& frame);
+    void updateEvents(Client& client, bool want_write);
+    std::shared_ptr<const Frame> latestFrame();
+
+    PreviewConfig config;
+    std::atomic<bool>& running;
+    int listen_fd{-1};
+    int epoll_fd{-1};
+    int frame_event_fd{-1};
+    std::atomic<int> bound_port{0};
+
+    std::list<Client> clients;
+    std::atomic<long> client_count{0};
+
+    // Written by publish() on the frame writer's thread
+    std::mutex frame_mutex;
+    std::shared_ptr<const Frame> latest;
+    uint64_t frame_version{0};
+    std::chrono::steady_clock::time_point next_frame_due;
+    cv::Mat scaled;
+    std::vector<uchar> jpeg;
+
+    std::atomic<long> frames_encoded{0};
+    std::atomic<long> frames_sent{0};
+    std::atomic<long> frames_skipped{0};
+};
@@ -1,32 +1,73 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <vector>
 #include <nlohmann/json.hpp>
 
+#include "detection_wire.h"
+#include "heatmap.h"
 #include "inference.h"
+#include "message_writer.h"
+#include "rolling_stats.h"
+#include "zones.h"
 #include "transport.h"
 
 using json = nlohmann::json;
 
-// Abstract message formatter interface
+// Abstract message formatter interface. Implementations override at least
+// one of the two methods; each defaults to the other.
 class MessageFormatter {
 public:
     virtual ~MessageFormatter() = default;
-    virtual std::string formatMessage(const InferenceResult& result) = 0;
+    virtual std::string formatMessage(const InferenceResult& result) {
+        std::string message;
+        formatInto(result, message);
+        return message;
+    }
+
+    // Replace the contents of out with the message. Publishers pass the same
+    // buffer for every message, so streaming formatters allocate nothing once
+    // it has grown to size.
+    virtual void formatInto(const InferenceResult& result, std::string& out) {
+        out = formatMessage(result);
+    }
+
+    // Hash of what the message reports, ignoring the timestamp; publishing on
+    // change sends when it differs from the last message sent. By default the
+    // set of selected boxes, by class and position on a coarse grid so
+    // sub-pixel jitter does not count as a change.
+    virtual uint64_t changeKey(const InferenceResult& result);
+
+    // Called with every result the sink is offered, whether or not a message
+    // is sent for it, for formatters that report on more than the latest one
+    virtual void observe(const InferenceResult& result) {}
+};
+
+// Count for one class name while a message is being formatted
+struct ClassCount {
+    std::string_view name;  // Points into the class mapping or a literal
+    int count;
 };
 
 // Abstract base class for formatters with optional class name mapping
 class MappedMessageFormatter : public MessageFormatter {
 protected:
     std::unordered_map<std::string, std::string> class_mapping;
-    
-    // Extract only detections that match selected classes
-    std::vector<object_detect_result> extractSelectedClasses(const InferenceResult& result) const;
+
+    // Scratch state reused across messages (formatters are not shared between publishers)
+    std::vector<ClassCount> class_counts;
+
+    // Fold the result view's class counts into class_counts by mapped class
+    // name, in selected class order
+    void countSelectedClasses(const InferenceResult& result);
     
     // Apply class name mapping if configured
-    std::string mapClassName(const std::string& original_name) const;
+    std::string_view mapClassName(std::string_view original_name) const;
     
 public:
     // Constructor with optional class name mapping
@@ -34,23 +75,29 @@ public:
         : class_mapping(mapping) {}
     
     virtual ~MappedMessageFormatter() = default;
+
+    // The mapped class counts
+    uint64_t changeKey(const InferenceResult& result) override;
 };
 
 // Concrete implementation of MessageFormatter for JSON format
 class JsonMessageFormatter : public MessageFormatter {
 private:
     bool suppress_empty;
+    std::vector<ClassCount> class_counts;
     
 public:
     explicit JsonMessageFormatter(bool suppress_empty = false) : suppress_empty(suppress_empty) {}
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+    uint64_t changeKey(const InferenceResult& result) override;
 };
 
 // Concrete implementation of MessageFormatter for BrightScript variable format
 //  e.g. "faces_attending:0!!faces_in_frame_total:0!!timestamp:1746732409"
 class BSVariableMessageFormatter : public MessageFormatter {
 public:
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+    uint64_t changeKey(const InferenceResult& result) override;
 };
 
 // Concrete implementation for faces JSON format (UDP port 5002)
@@ -58,7 +105,8 @@ public:
 class FacesJsonMessageFormatter : public MappedMessageFormatter {
 public:
     FacesJsonMessageFormatter();
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+    uint64_t changeKey(const InferenceResult& result) override;
 };
 
 // Concrete implementation for faces BrightScript format (UDP port 5000)  
@@ -66,7 +114,8 @@ public:
 class FacesBSMessageFormatter : public MappedMessageFormatter {
 public:
     FacesBSMessageFormatter();
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+    uint64_t changeKey(const InferenceResult& result) override;
 };
 
 // Concrete implementation for selective JSON format
@@ -75,7 +124,7 @@ class SelectiveJsonMessageFormatter : public MappedMessageFormatter {
 public:
     SelectiveJsonMessageFormatter(const std::unordered_map<std::string, std::string>& mapping = {})
         : MappedMessageFormatter(mapping) {}
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
 };
 
 // Concrete implementation for selective BrightScript format
@@ -84,7 +133,7 @@ class SelectiveBSMessageFormatter : public MappedMessageFormatter {
 public:
     SelectiveBSMessageFormatter(const std::unordered_map<std::string, std::string>& mapping = {})
         : MappedMessageFormatter(mapping) {}
-    std::string formatMessage(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
 };
 
 // Concrete implementation for full JSON format
@@ -95,11 +144,210 @@ private:
     
 public:
     explicit FullJsonMessageFormatter(bool suppress_empty = false) : suppress_empty(suppress_empty) {}
-    std::string formatMessage(const InferenceResult& result) override;
+    // Stateless, so safe to share between threads (e.g. the inference server)
+    void formatInto(const InferenceResult& result, std::string& out) override;
+};
+
+// Concrete implementation for the binary wire format (see detection_wire.h)
+// Every valid, selected box with a microsecond timestamp, frame sequence and
+// model id, for receivers that need full box data at camera rate. With a
+// keyframe interval above 1, messages between key frames carry only the
+// change in each box from the previous message.
+class BinaryMessageFormatter : public MessageFormatter {
+private:
+    wire_encoder_t encoder;
+    wire_frame_t frame;
+    
+public:
+    explicit BinaryMessageFormatter(int keyframe_interval = 0);
+    void formatInto(const InferenceResult& result, std::string& out) override;
+};
+
+// One fixed-size history record per message, for HistoryTransport (see
+// history_log.h): the timestamp, the count of each layout class and
+// optionally the first boxes, all at or above the threshold
+class HistoryRecordFormatter : public MessageFormatter {
+private:
+    HistoryLayout layout;
+    size_t record_size;
+
+public:
+    explicit HistoryRecordFormatter(const HistoryLayout& layout);
+    void formatInto(const InferenceResult& result, std::string& out) override;
+};
+
+
+// Rolling statistics of the selected classes' counts over every result the
+// sink is offered, not only those it sends (see rolling_stats.h):
+//   {"person":{"10s":{"frames":300,"mean":1.2,"max":3,"p50":1,"p95":3,"occupancy":0.82},"1m":{...}},
+//    ...,"timestamp":1746732409}
+// The statistics belong to one stream of results, so each sink needs a
+// formatter of its own.
+class AnalyticsMessageFormatter : public MessageFormatter {
+private:
+    std::vector<double> window_seconds;
+    std::vector<std::string> window_names;
+    std::vector<RollingWindow> windows;    // Set up by the first result
+    std::vector<std::string> class_names;  // The selected classes, in selected order
+    std::vector<uint16_t> counts;          // Scratch for one frame
+    uint64_t last_frame_id = 0;
+
+public:
+    explicit AnalyticsMessageFormatter(const std::vector<double>& window_seconds = {10, 60, 900, 3600});
+    void observe(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+};
+
+// Counts of the selected classes in each zone (see zones.h), by the anchor
+// point of each box at or above the threshold:
+//   {"zones":{"screen_a":{"person":2},"screen_b":{"person":0}},"timestamp":1746732409}
+class ZoneMessageFormatter : public MessageFormatter {
+private:
+    std::shared_ptr<const ZoneMap> zones;
+    std::vector<int> counts;  // Zone-major, one per selected class
+
+    // Fill counts for result; returns the number of selected classes
+    size_t countZones(const InferenceResult& result);
+
+public:
+    explicit ZoneMessageFormatter(std::shared_ptr<const ZoneMap> zones) : zones(std::move(zones)) {}
+    void formatInto(const InferenceResult& result, std::string& out) override;
+    uint64_t changeKey(const InferenceResult& result) override;
+};
+
+// Heatmap of where the selected detections above the threshold have been
+// (see heatmap.h), as a PNG or raw file. Every result the sink is offered is
+// added, not only those it sends, so a sink that writes the file every few
+// minutes still covers every frame.
+class HeatmapFormatter : public MessageFormatter {
+private:
+    Heatmap heatmap;
+    HeatmapFormat format;
+    std::vector<box_rect_t> boxes;  // Scratch for one frame
+    uint64_t last_frame_id = 0;
+
+public:
+    HeatmapFormatter(const HeatmapConfig& config, HeatmapFormat format) : heatmap(config), format(format) {}
+    void observe(const InferenceResult& result) override;
+    void formatInto(const InferenceResult& result, std::string& out) override;
+};
+
+// Delivery statistics for one publisher
+struct PublishStats {
+    long sent = 0;                  // Messages sent
+    long stale = 0;                 // Deadlines with no result newer than the last one sent
+    long missed = 0;                // Deadlines that passed while the previous message was sent
+    double rate = 0.0;              // Achieved messages per second
+    double lateness_mean_ms = 0.0;  // How far past its deadline each send started (jitter)
+    double lateness_max_ms = 0.0;
+    double age_mean_ms = 0.0;       // Age of the result when sent
+    double age_max_ms = 0.0;
+    long avoided = 0;               // Sends saved by publishing on change, against the periodic rate
+    long failed = 0;                // Sends the transport reported as failed
+    long dropped = 0;               // Dropped by the transport without an error (see Transport::dropped())
 };
 
+// Publishing on change instead of every period. Sends go out as soon as the
+// formatter's changeKey() differs from the last one sent, but no closer
+// together than the publisher's period; otherwise only a heartbeat is sent.
+struct ChangePolicy {
+    bool enabled = false;
+    double heartbeat_seconds = 30.0;  // Longest gap between messages
+    int hysteresis = 1;               // Consecutive results a new state must last before it is sent
+};
+
+// One destination: a formatter, a transport and when to send to it. Sends
+// run on absolute deadlines, so formatting and send time do not stretch the
+// period, and each send takes the freshest result rather than one that
+// waited in the queue. A sink has no thread of its own: a Publisher or a
+// PublisherHub hands it each new result with offer() and calls poll() by
+// nextWake().
+class PublishSink {
+public:
+    using clock = std::chrono::steady_clock;
+
+    PublishSink(
+        std::shared_ptr<Transport> transport,
+        std::shared_ptr<MessageFormatter> formatter,
+        double messages_per_second = 1,
+        const std::string& name = "publisher");
+
+    // Publish on change rather than every period (call before start())
+    void setChangePolicy(const ChangePolicy& policy) { change_policy = policy; }
+    const ChangePolicy& changePolicy() const { return change_policy; }
+    const std::string& name() const { return sink_name; }
+
+    void start(clock::time_point now);
+
+    // A result newer than any offered before
+    void offer(std::shared_ptr<const InferenceResult> result, clock::time_point now);
+
+    // Send whatever is due by now, and log statistics when they are due
+    void poll(clock::time_point now);
+
+    // When poll() next has something to do
+    clock::time_point nextWake() const;
+
+    // Log the final statistics
+    void finish(clock::time_point now);
 
-// Generic publisher class using transport injection
+    // Totals since the sink started
+    PublishStats stats() const;
+
+private:
+    // Accumulated between log reports
+    struct StatsWindow {
+        clock::time_point start;
+        long sent = 0;
+        long stale = 0;
+        long missed = 0;
+        long failed = 0;
+        double lateness_sum_ms = 0.0;
+        double lateness_max_ms = 0.0;
+        double age_sum_ms = 0.0;
+        double age_max_ms = 0.0;
+
+        void add(const StatsWindow& other);
+        PublishStats summarize(clock::time_point now, double periodic_rate) const;
+    };
+
+    clock::time_point changeDue() const;
+    void send(const InferenceResult& result, double lateness_ms, long missed);
+    void report(clock::time_point now);
+
+    std::shared_ptr<Transport> transport;
+    std::shared_ptr<MessageFormatter> formatter;
+    double target_mps;
+    clock::duration period;
+    std::string sink_name;
+    std::string message_buffer;  // Reused for every message
+    ChangePolicy change_policy;
+    clock::time_point last_report;
+    long dropped_at_start = 0;   // Transport drop counts at start() and at the last report
+    long dropped_at_report = 0;
+
+    // Periodic: the next deadline and the newest result not yet sent
+    clock::time_point deadline;
+    std::shared_ptr<const InferenceResult> pending;
+
+    // On change
+    uint64_t candidate_key = 0;  // Key of the latest results, and how many in a row had it
+    int candidate_count = 0;
+    uint64_t stable_key = 0;  // State that lasted long enough to report
+    std::shared_ptr<const InferenceResult> stable_result;  // Newest result in that state
+    clock::time_point changed_at;
+    uint64_t sent_key = 0;
+    bool has_sent = false;
+    clock::time_point last_send;
+
+    mutable std::mutex stats_mutex;
+    StatsWindow window;
+    StatsWindow totals;  // Excluding the current window
+};
+
+// Generic publisher class using transport injection: one sink on a thread
+// of its own. Every publisher sees every result. PublisherHub serves many
+// sinks from one thread instead.
 class Publisher {
 public:
     Publisher(
@@ -107,18 +355,23 @@ public:
         ThreadSafeQueue<InferenceResult>& queue,
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
-        int messages_per_second = 1);
+        double messages_per_second = 1,
+        const std::string& name = "publisher");
     
     ~Publisher() = default;
     
     void operator()();
 
+    // Publish on change rather than every period (call before starting)
+    void setChangePolicy(const ChangePolicy& policy) { sink.setChangePolicy(policy); }
+
+    // Totals since the publisher started
+    PublishStats stats() const { return sink.stats(); }
+
 private:
-    std::shared_ptr<Transport> transport;
     ThreadSafeQueue<InferenceResult>& resultQueue;
     std::atomic<bool>& running;
-    int target_mps;
-    std::shared_ptr<MessageFormatter> formatter;
+    PublishSink sink;
 };
 
 // Backward compatibility: UDPPublisher using transport injection
@@ -130,5 +383,5 @@ public:
         ThreadSafeQueue<InferenceResult>& queue,
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
-        int messages_per_second = 1);
+        double messages_per_second = 1);
 };
\ No newline at end of file
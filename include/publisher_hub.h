@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "inference.h"
+#include "publisher.h"
+#include "transport.h"
+
+// Serves any number of publish sinks from one thread, instead of a
+// Publisher thread per sink. The thread sleeps in epoll on the result
+// queue's eventfd and a timerfd armed for the earliest sink deadline; each
+// new result is read from the queue once and offered to every sink, and
+// each sink formats and sends on its own schedule. Sends should not block:
+// one slow transport delays every sink behind it.
+class PublisherHub {
+public:
+    PublisherHub(ThreadSafeQueue<InferenceResult>& queue, std::atomic<bool>& isRunning);
+    ~PublisherHub();
+
+    PublisherHub(const PublisherHub&) = delete;
+    PublisherHub& operator=(const PublisherHub&) = delete;
+
+    // Add a sink (before starting). The reference stays valid for the life
+    // of the hub, e.g. to set a change policy or read statistics.
+    PublishSink& addSink(
+        std::shared_ptr<Transport> transport,
+        std::shared_ptr<MessageFormatter> formatter,
+        double messages_per_second = 1,
+        const std::string& name = "publisher");
+
+    size_t size() const { return sinks.size(); }
+
+    void operator()();
+
+private:
+    bool setupEvents();
+    // Sleep until a new result, shutdown or wake; returns false on shutdown
+    bool waitEvents(PublishSink::clock::time_point wake);
+
+    ThreadSafeQueue<InferenceResult>& resultQueue;
+    std::atomic<bool>& running;
+    std::vector<std::unique_ptr<PublishSink>> sinks;
+
+    int epoll_fd{-1};
+    int timer_fd{-1};
+    int result_fd{-1};  // Owned by the queue
+};
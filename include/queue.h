@@ -5,6 +5,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 
 template<typename T>
 class ThreadSafeQueue {
@@ -12,14 +15,40 @@ private:
     std::queue<T> queue;
     mutable std::mutex mutex;
     std::condition_variable cond;
+    std::condition_variable latest_cond;  // waitUntil()/waitNewer() sleepers, kept apart from pop() waiters
     std::atomic<bool> shutdown{false};
     size_t max_depth;
+    std::shared_ptr<const T> newest;  // Most recent push, for latest()
+    uint64_t newest_version = 0;
+    std::atomic<int> notify_fd{-1};  // eventfd written on push and shutdown, once requested
 
 public:
     ThreadSafeQueue(size_t max_depth) : max_depth(max_depth) {}
+    ~ThreadSafeQueue();
+    ThreadSafeQueue(const ThreadSafeQueue&) = delete;
+    ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
+
     void push(T value);
     bool pop(T& value);
     void signalShutdown();
+    bool isShutdown() const { return shutdown; }
+
+    // An eventfd that becomes readable on every push and on shutdown, for
+    // readers that wait in poll()/epoll alongside other descriptors. Created
+    // on first call; owned by the queue. Returns -1 if it cannot be created.
+    int notifyFd();
+
+    // The most recent value pushed, without consuming it, so every reader
+    // sees it. Returns nullptr unless it is newer than version, which is
+    // then updated.
+    std::shared_ptr<const T> latest(uint64_t& version) const;
+
+    // Sleep until deadline; returns false as soon as shutdown is signalled
+    bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+    // Sleep until a value newer than version is pushed, or until deadline;
+    // returns false as soon as shutdown is signalled
+    bool waitNewer(uint64_t version, std::chrono::steady_clock::time_point deadline);
 };
 
 #include "queue.tpp"
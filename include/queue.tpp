@@ -1,13 +1,37 @@
 #include "queue.h"
 
+#include <cstdio>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+template<typename T>
+ThreadSafeQueue<T>::~ThreadSafeQueue() {
+    if (notify_fd >= 0) {
+        close(notify_fd);
+    }
+}
+
+// write() is async-signal-safe, so this is usable from signalShutdown()
+static inline void notifyEventFd(int fd) {
+    if (fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
 template<typename T>
 void ThreadSafeQueue<T>::push(T value) {
     std::lock_guard<std::mutex> lock(mutex);
     if (queue.size() >= max_depth) {
         queue.pop();
     }
+    newest = std::make_shared<const T>(value);
+    newest_version++;
     queue.push(std::move(value));
     cond.notify_one();
+    latest_cond.notify_all();
+    notifyEventFd(notify_fd);
 }
 
 template<typename T>
@@ -30,4 +54,46 @@ template<typename T>
 void ThreadSafeQueue<T>::signalShutdown() {
     shutdown = true;
     cond.notify_all();
+    latest_cond.notify_all();
+    notifyEventFd(notify_fd);
+}
+
+template<typename T>
+int ThreadSafeQueue<T>::notifyFd() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (notify_fd < 0) {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            perror("eventfd");
+            return -1;
+        }
+        notify_fd = fd;
+        if (shutdown) {
+            notifyEventFd(fd);
+        }
+    }
+    return notify_fd;
+}
+
+template<typename T>
+std::shared_ptr<const T> ThreadSafeQueue<T>::latest(uint64_t& version) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (newest_version <= version) {
+        return nullptr;
+    }
+    version = newest_version;
+    return newest;
+}
+
+template<typename T>
+bool ThreadSafeQueue<T>::waitUntil(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !latest_cond.wait_until(lock, deadline, [this] { return shutdown.load(); });
+}
+
+template<typename T>
+bool ThreadSafeQueue<T>::waitNewer(uint64_t version, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex);
+    latest_cond.wait_until(lock, deadline, [this, version] { return shutdown || newest_version > version; });
+    return !shutdown;
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "yolox.h"
+
+struct InferenceResult;
+
+enum class RedactionMode {
+    Pixelate,  // Each block replaced by its mean colour
+    Blur       // Box blur
+};
+
+// Parse "pixelate" or "blur"
+bool parseRedactionMode(const std::string& text, RedactionMode& mode);
+
+struct RedactionConfig {
+    std::vector<int> class_ids;  // Classes to redact; none disables redaction
+    RedactionMode mode = RedactionMode::Pixelate;
+    int strength = 0;            // Block size or blur radius in pixels; 0 scales with each box
+    float padding = 0.1f;        // Added on each side, as a fraction of the box size
+};
+
+// Pixelate the w x h region at (x, y) of an 8-bit interleaved image in
+// blocks of block x block pixels (smaller at the region's right and bottom
+// edges). The region must lie within the image.
+void pixelateRegion(uint8_t* pixels, size_t step, int channels, int x, int y, int w, int h, int block);
+
+// Box-blur the w x h region at (x, y) of an 8-bit interleaved image with a
+// (2 * radius + 1) square window, repeating the region's edge pixels beyond
+// it, so nothing outside the region is read. Scratch is reused between calls.
+void blurRegion(uint8_t* pixels, size_t step, int channels, int x, int y, int w, int h, int radius,
+                std::vector<uint32_t>& scratch);
+
+// Hides the detections of the configured classes in a frame, before it is
+// drawn on or handed to any sink. Every valid detection of those classes is
+// redacted, whatever its confidence and whether or not its class is selected
+// for output, so a person just below the threshold is hidden too.
+//
+// Both modes cost time in proportion to the area redacted, not the frame:
+// pixelation averages each block once, and the blur is separable, with
+// running sums along each row and then down the columns, so the cost per
+// pixel does not depend on the radius.
+class Redactor {
+public:
+    explicit Redactor(const RedactionConfig& config) : config(config) {}
+
+    bool enabled() const { return !config.class_ids.empty(); }
+
+    // Redact in place; the frame is 8-bit with 1 to 4 channels
+    void apply(cv::Mat& frame, const InferenceResult& result);
+
+    // The box grown by the padding and clipped to the frame; false if
+    // nothing of it is in the frame
+    static bool regionOf(const box_rect_t& box, float padding, int width, int height,
+                         int& x, int& y, int& w, int& h);
+
+private:
+    RedactionConfig config;
+    std::vector<uint32_t> scratch;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct InferenceResult;
+
+// Per-frame aggregates shared by every formatter. Each formatter used to
+// re-walk the detections, re-apply the threshold and class selection and
+// rebuild its own class counts; with several sinks that was one full pass per
+// sink for the same frame. The view is computed once, on first access, and
+// shared by every copy of the InferenceResult it belongs to.
+struct ResultView {
+    // Detection indices: valid, selected class, at or above the threshold
+    std::vector<int> selected;
+    // Detection indices: valid and selected class, at any confidence
+    std::vector<int> listed;
+    // Valid detections at or above the threshold, regardless of selection
+    int above_threshold = 0;
+    // Class 0 ("person") at or above the threshold, regardless of selection
+    int people = 0;
+
+    // Counts of `selected` by detection name. The first selected_names
+    // entries are the names of the selected classes, in selected order
+    // ("person" when none are selected) and including zero counts; any other
+    // names seen follow, so a formatter's class name mapping can fold them in.
+    std::vector<std::string> class_names;
+    std::vector<int> class_counts;
+    size_t selected_names = 0;
+
+    // Recompute from result, reusing this view's storage
+    void build(const InferenceResult& result);
+};
+
+// Storage for a view shared between copies of one InferenceResult
+struct ResultViewCache {
+    std::once_flag once;
+    ResultView view;
+};
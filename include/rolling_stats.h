@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-class count statistics over a sliding time window, updated once per
+// frame. The window is split into a ring of sub-buckets; each frame updates
+// the newest bucket and the running window totals, and a bucket leaving the
+// window is subtracted from the totals as a whole, so an update costs the
+// same at any frame rate and window length and never allocates. Percentiles
+// come from a small histogram of the counts, exact up to 15 and within a
+// few counts above.
+class RollingWindow {
+public:
+    static const int BUCKETS = 60;  // Window resolution: a window ends within 1/60 of its length
+    static const int BINS = 29;     // Histogram bins
+
+    struct ClassStats {
+        double mean = 0.0;       // Detections per frame
+        int max = 0;
+        int p50 = 0;             // Median count per frame
+        int p95 = 0;
+        double occupancy = 0.0;  // Share of frames with at least one detection
+    };
+
+    RollingWindow(double seconds, size_t class_count);
+
+    // One frame's count for each class
+    void add(uint64_t timestamp_ms, const uint16_t* counts);
+
+    // Frames in the window, up to the last add()
+    uint64_t frames() const { return total_frames; }
+    ClassStats stats(size_t class_index) const;
+
+    double seconds() const { return bucket_ms * BUCKETS / 1000.0; }
+
+    // Histogram bin of a count, and the smallest count in a bin
+    static int bin(unsigned count);
+    static int binStart(int bin);
+
+private:
+    struct Cell {
+        uint32_t sum = 0;
+        uint32_t occupied = 0;
+        uint16_t max = 0;
+        uint32_t histogram[BINS] = {};
+    };
+    struct Totals {
+        uint64_t sum = 0;
+        uint64_t occupied = 0;
+        uint64_t histogram[BINS] = {};
+    };
+
+    // Move the newest bucket up to bucket, expiring the ones it passes
+    void advance(uint64_t bucket);
+
+    uint64_t bucket_ms;
+    size_t class_count;
+    uint64_t newest = 0;                  // Absolute bucket number (timestamp / bucket_ms)
+    bool started = false;
+    std::vector<Cell> cells;              // BUCKETS x class_count
+    std::vector<uint32_t> bucket_frames;  // BUCKETS
+    std::vector<Totals> totals;           // class_count
+    uint64_t total_frames = 0;
+};
+
+// Parse a comma-separated list of window lengths such as "10s,1m,15m,1h"
+bool parseRollingWindows(const std::string& text, std::vector<double>& seconds);
+
+// Short name of a window length: "10s", "1m", "15m", "1h"
+std::string rollingWindowName(double seconds);
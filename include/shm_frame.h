@@ -0,0 +1,48 @@
+#ifndef _SHM_FRAME_H_
+#define _SHM_FRAME_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decorated frames in shared memory (version 1).
+ * Frames are published into a shm_ring (see shm_ring.h) of three slots: the
+ * newest frame, the one before it, and the one being written. Every message
+ * is a shm_frame_info_t followed by the image:
+ *
+ *   SHM_FRAME_RGB24   height rows of stride bytes, 3 bytes per pixel, R G B
+ *   SHM_FRAME_NV12    height rows of Y, then height / 2 rows of interleaved
+ *                     U V, both stride bytes per row
+ *   SHM_FRAME_JPEG    data_size bytes of baseline JPEG
+ *
+ * The ring's sequence number counts frames and its timestamp is the publish
+ * time. A reader that uses frames in place with shm_ring_peek_latest() has
+ * about two frame intervals before the writer reuses the slot; slower
+ * readers copy with shm_ring_read_latest(), or see shm_ring_peek_valid()
+ * fail and skip to the next frame. When the dimensions or format change the
+ * ring is recreated, so readers see SHM_RING_ERR_CLOSED and reopen it.
+ */
+
+#define SHM_FRAME_SLOTS 3
+
+#define SHM_FRAME_RGB24 1
+#define SHM_FRAME_NV12 2
+#define SHM_FRAME_JPEG 3
+
+typedef struct {
+    uint32_t format;        // SHM_FRAME_*
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;        // Bytes per row; 0 for JPEG
+    uint32_t data_size;     // Bytes of image after this header
+    uint8_t reserved[44];   // Keeps the image 64-byte aligned
+} shm_frame_info_t;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif //_SHM_FRAME_H_
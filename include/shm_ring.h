@@ -0,0 +1,195 @@
+#ifndef _SHM_RING_H_
+#define _SHM_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared-memory message ring (version 1), for consumers on the same device.
+ * One writer publishes messages into a POSIX shared-memory segment
+ * (/dev/shm/<name>); any number of readers map it and read without system
+ * calls. Readers only block, on a futex in the segment, when they choose to
+ * wait for the next message.
+ *
+ * Segment layout (native byte order, 64-byte aligned):
+ *   header    shm_ring_header_t
+ *   slots     slot_count x (shm_ring_slot_t + slot_size bytes of message)
+ *
+ * Message n (counting from 1) goes into slot (n - 1) % slot_count, so the
+ * newest message is always the latest slot and the slot_count - 1 before it
+ * are history. Each slot is guarded by a seqlock: its lock count is odd
+ * while the writer fills it, and a reader's copy is only valid if the count
+ * was even and unchanged across the copy.
+ *
+ * A writer that exits sets the closed flag; readers then reopen by name to
+ * follow a restarted writer.
+ */
+
+#define SHM_RING_MAGIC 0x5253444fu  // "ODSR"
+#define SHM_RING_VERSION 1
+
+#define SHM_RING_ERR_SYSTEM -1      // See errno
+#define SHM_RING_ERR_FORMAT -2      // Not a ring segment, or a newer version
+#define SHM_RING_ERR_TOO_LARGE -3   // Message larger than a slot or the reader's buffer
+#define SHM_RING_ERR_OVERRUN -4     // Messages were overwritten before being read; reading resumes at the oldest
+#define SHM_RING_ERR_BUSY -5        // The writer kept overwriting the message being read (a one-slot ring, or a dead writer)
+#define SHM_RING_ERR_CLOSED -6      // The writer exited; reopen to follow a new one
+#define SHM_RING_ERR_TIMEOUT -7     // No new message before the timeout
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;     // Largest message
+    uint32_t slot_count;
+    uint64_t write_count;   // Messages published; the newest is message write_count
+    uint32_t futex;         // Incremented after every publish, for waiting readers
+    uint32_t closed;
+    uint32_t writer_pid;
+    uint8_t reserved[28];
+} shm_ring_header_t;
+
+typedef struct {
+    uint64_t lock;          // Seqlock count, odd while being written
+    uint64_t sequence;      // Message number
+    uint64_t timestamp_ns;  // CLOCK_REALTIME when published
+    uint32_t length;
+    uint8_t reserved[36];
+} shm_ring_slot_t;
+
+typedef struct {
+    shm_ring_header_t* header;
+    size_t size;            // Of the mapping
+    int writable;
+    uint64_t next;          // Readers: the next message shm_ring_read_next() returns
+    const shm_ring_slot_t* peek_slot;  // Readers: the message of the last shm_ring_peek_latest()
+    uint64_t peek_lock;
+} shm_ring_t;
+
+/**
+ * @brief Create (or replace) a ring and map it for writing
+ *
+ * @param ring [out] Ring
+ * @param name [in] Shared memory name, e.g. "/objdet-results"
+ * @param slot_size [in] Largest message in bytes
+ * @param slot_count [in] Messages kept, the newest included
+ * @return int 0: success; SHM_RING_ERR_*: error
+ */
+int shm_ring_create(shm_ring_t* ring, const char* name, uint32_t slot_size, uint32_t slot_count);
+
+/**
+ * @brief Publish one message and wake waiting readers
+ *
+ * @param ring [in] Ring created with shm_ring_create()
+ * @param data [in] Message
+ * @param length [in] Message size, at most slot_size
+ * @return int 0: success; SHM_RING_ERR_*: error
+ */
+int shm_ring_publish(shm_ring_t* ring, const void* data, size_t length);
+
+/**
+ * @brief Lock the next slot for filling in place
+ *
+ * For large messages (frames) that can be produced straight into shared
+ * memory instead of being copied by shm_ring_publish(). Readers never see
+ * the slot until shm_ring_commit().
+ *
+ * @param ring [in] Ring created with shm_ring_create()
+ * @return void* slot_size bytes to fill; NULL: not a writer
+ */
+void* shm_ring_begin(shm_ring_t* ring);
+
+/**
+ * @brief Publish the slot filled after shm_ring_begin() and wake waiting readers
+ *
+ * @param ring [in] Ring
+ * @param length [in] Bytes filled, at most slot_size
+ * @return int 0: success; SHM_RING_ERR_*: error
+ */
+int shm_ring_commit(shm_ring_t* ring, size_t length);
+
+/**
+ * @brief Open an existing ring for reading
+ *
+ * Reading starts with the next message published after this call.
+ *
+ * @param ring [out] Ring
+ * @param name [in] Shared memory name
+ * @return int 0: success; SHM_RING_ERR_*: error
+ */
+int shm_ring_open(shm_ring_t* ring, const char* name);
+
+/**
+ * @brief Unmap a ring; a writer also marks it closed
+ *
+ * @param ring [in] Ring
+ */
+void shm_ring_close(shm_ring_t* ring);
+
+/**
+ * @brief Copy the newest message
+ *
+ * @param ring [in] Ring
+ * @param buffer [out] Message
+ * @param capacity [in] Size of buffer
+ * @param sequence [out] Message number (optional)
+ * @return int >= 0: message size (0 when nothing was published yet);
+ *         SHM_RING_ERR_*: error
+ */
+int shm_ring_read_latest(shm_ring_t* ring, void* buffer, size_t capacity, uint64_t* sequence);
+
+/**
+ * @brief Point at the newest message in place, without copying it
+ *
+ * The writer overwrites the message slot_count - 1 publishes later, so
+ * large messages can be used in place by readers that keep up. Check
+ * shm_ring_peek_valid() after using the data and discard the result if it
+ * fails.
+ *
+ * @param ring [in/out] Ring
+ * @param data [out] Message
+ * @param sequence [out] Message number (optional)
+ * @return int >= 0: message size (0 when nothing was published yet);
+ *         SHM_RING_ERR_*: error
+ */
+int shm_ring_peek_latest(shm_ring_t* ring, const void** data, uint64_t* sequence);
+
+/**
+ * @brief Whether the message of the last shm_ring_peek_latest() is still intact
+ *
+ * @param ring [in] Ring
+ * @return int 1: intact; 0: being overwritten, the data read may be torn
+ */
+int shm_ring_peek_valid(const shm_ring_t* ring);
+
+/**
+ * @brief Copy the next message in order
+ *
+ * @param ring [in/out] Ring
+ * @param buffer [out] Message
+ * @param capacity [in] Size of buffer
+ * @param sequence [out] Message number (optional)
+ * @return int > 0: message size; 0: no new message;
+ *         SHM_RING_ERR_OVERRUN: messages were lost, call again for the oldest kept;
+ *         SHM_RING_ERR_*: error
+ */
+int shm_ring_read_next(shm_ring_t* ring, void* buffer, size_t capacity, uint64_t* sequence);
+
+/**
+ * @brief Sleep until a message after sequence is published
+ *
+ * @param ring [in] Ring
+ * @param sequence [in] Last message seen
+ * @param timeout_ms [in] Longest wait; negative waits forever
+ * @return int 0: a newer message exists; SHM_RING_ERR_*: error or timeout
+ */
+int shm_ring_wait(shm_ring_t* ring, uint64_t sequence, int timeout_ms);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif //_SHM_RING_H_
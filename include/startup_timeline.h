@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records how long each startup step takes, relative to the start of main().
+// Every mark is logged as it happens; report() prints the whole timeline once,
+// together with how long after boot the process was started, so slow starts
+// after a player reboot can be traced to a step.
+class StartupTimeline {
+public:
+    static StartupTimeline& instance();
+
+    // Thread-safe; steps running in parallel may mark concurrently
+    void mark(const std::string& event);
+
+    // Milliseconds since the timeline started
+    double elapsedMs() const;
+
+    // Print the full timeline (first call only)
+    void report();
+
+private:
+    StartupTimeline();
+
+    std::chrono::steady_clock::time_point origin;
+    double process_start_since_boot_ms;  // -1 when /proc is unavailable
+    double origin_since_boot_ms;
+    std::mutex mutex;
+    std::vector<std::pair<std::string, double>> events;
+    bool reported = false;
+};
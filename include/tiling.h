@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "common.h"
+#include "npu_pool.h"
+#include "yolox.h"
+
+// Grid of overlapping tiles covering the capture frame. Small or distant
+// objects that vanish when a 1080p/4K frame is letterboxed into the model
+// input survive when each tile is letterboxed on its own.
+struct TileConfig {
+    int cols = 1;
+    int rows = 1;
+    float overlap = 0.2f;          // Fraction of a tile shared with its neighbour
+    bool full_frame_pass = false;  // Also run the letterboxed full frame (catches objects larger than a tile)
+
+    bool enabled() const { return cols * rows > 1; }
+};
+
+// Parse a "<cols>x<rows>" grid specification such as "3x2"
+bool parseTileGrid(const std::string& spec, TileConfig& config);
+
+// Tile rectangles (inclusive corners) spread evenly so the last row/column ends on the frame edge
+std::vector<image_rect_t> computeTiles(int width, int height, const TileConfig& config);
+
+// Class-wise NMS across detections from several passes. Besides plain IoU,
+// a box mostly contained in a higher-scoring box of the same class is dropped,
+// which removes the partial boxes left where an object straddles a tile seam.
+void mergeDetections(const std::vector<object_detect_result_list>& parts, float nms_threshold,
+                     object_detect_result_list* merged);
+
+// Runs the tile grid (plus optional full-frame pass) across the NPU contexts
+// and periodically logs the throughput cost against the full-frame pass.
+class TiledInference {
+public:
+    TiledInference(const TileConfig& config, int max_parallel);
+
+    int run(NpuContextPool& pool, image_buffer_t* img, object_detect_result_list* results, float conf_threshold);
+
+private:
+    void report();
+
+    TileConfig config;
+    dpool::ThreadPool workers;
+
+    // Statistics since the last report; run() may be called from several threads
+    std::mutex stats_mutex;
+    int frames{0};
+    int tiles_per_frame{0};
+    double tiled_ms{0.0};
+    double full_frame_ms{0.0};
+    long full_frame_detections{0};
+    long merged_detections{0};
+    std::chrono::steady_clock::time_point last_report;
+};
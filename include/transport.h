@@ -1,46 +1,239 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#include "history_log.h"
+#include "shm_ring.h"
+
 // Abstract transport interface for sending data
 class Transport {
 public:
     virtual ~Transport() = default;
     virtual bool send(const std::string& data) = 0;
     virtual bool isConnected() const = 0;
+
+    // Messages or datagrams dropped so far without an error, e.g. for a
+    // full socket buffer or a message larger than a shared memory slot
+    virtual long dropped() const { return 0; }
+};
+
+// One UDP destination, unicast or multicast
+struct UDPDestination {
+    std::string ip;
+    int port;
+};
+
+// Parse "ip:port[,ip:port...]"; prints the first bad entry and returns false
+bool parseUDPDestinations(const std::string& list, std::vector<UDPDestination>& destinations);
+
+// Totals for one UDP transport
+struct UDPTransportStats {
+    long messages = 0;      // send() calls
+    long datagrams = 0;     // Datagrams sent, over all fragments and destinations
+    long bytes = 0;         // Including fragment headers
+    long eagain_drops = 0;  // Datagrams dropped because the socket buffer was full
+    long errors = 0;        // Datagrams that failed for any other reason
 };
 
 // UDP transport implementation
+// Sends each message to every destination from one non-blocking socket, in
+// a single sendmmsg() call. By default each message is one plain datagram,
+// as the JSON and BrightScript receivers expect. With a fragment size, every
+// datagram carries a fragment header and messages longer than one fragment
+// are split; receivers reassemble them (see udp_fragment.h). Sends never
+// block: when the socket buffer is full the datagrams are dropped and
+// counted, and send() still succeeds.
 class UDPTransport : public Transport {
 public:
+    static constexpr size_t MAX_DATAGRAM = 65507;          // Largest IPv4 UDP payload
+    static constexpr size_t DEFAULT_FRAGMENT_SIZE = 1400; // Fits an Ethernet MTU with room for tunnels
+
     UDPTransport(const std::string& ip, int port);
+    // fragment_size 0: unfragmented, no header
+    explicit UDPTransport(
+        const std::vector<UDPDestination>& destinations,
+        size_t fragment_size = 0,
+        int multicast_ttl = 1);
     ~UDPTransport();
+
+    UDPTransport(const UDPTransport&) = delete;
+    UDPTransport& operator=(const UDPTransport&) = delete;
     
     bool send(const std::string& data) override;
     bool isConnected() const override;
+    long dropped() const override { return eagain_drops; }
+
+    UDPTransportStats stats() const;
 
 private:
-    void setupSocket(const std::string& ip, int port);
+    void setupSocket(const std::vector<UDPDestination>& destinations, int multicast_ttl);
     
     int sockfd;
-    struct sockaddr_in servaddr;
+    std::vector<struct sockaddr_in> addresses;
+    size_t fragment_size;  // 0: unfragmented
     bool connected;
+    uint32_t next_message_id;
+
+    // Reused for every send
+    std::vector<struct mmsghdr> datagrams;
+    std::vector<struct iovec> iovecs;
+    std::vector<uint8_t> headers;
+
+    std::atomic<long> messages_sent{0};
+    std::atomic<long> datagrams_sent{0};
+    std::atomic<long> bytes_sent{0};
+    std::atomic<long> eagain_drops{0};
+    std::atomic<long> errors{0};
 };
 
 // File transport implementation - writes to specified file path
+// How FileTransport makes each message durable
+enum class FileDurability {
+    Auto,      // None on tmpfs/ramfs, OnRename elsewhere
+    None,      // Never fsync
+    OnRename,  // fsync every message before it replaces the file
+    Periodic   // fsync at most once per sync interval, plus the directory
+};
+
+// Parse "auto", "none", "rename" or "periodic"
+bool parseFileDurability(const std::string& text, FileDurability& durability);
+
+const char* fileDurabilityName(FileDurability durability);
+
+// Replaces a file atomically with each message. On tmpfs the message is
+// written to a named temp file and renamed over the file. On persistent
+// storage it is written to an unnamed O_TMPFILE, linked in and renamed, so
+// a crash never leaves a partial temp file behind.
 class FileTransport : public Transport {
 public:
-    explicit FileTransport(const std::string& filepath);
-    ~FileTransport() = default;
-    
+    explicit FileTransport(const std::string& filepath,
+                           FileDurability durability = FileDurability::Auto,
+                           double sync_interval_seconds = 5.0);
+    ~FileTransport();
+
+    FileTransport(const FileTransport&) = delete;
+    FileTransport& operator=(const FileTransport&) = delete;
+
     bool send(const std::string& data) override;
     bool isConnected() const override;
 
+    // The policy in effect, Auto resolved
+    FileDurability durability() const { return durability_mode; }
+    bool usesTmpfile() const { return use_tmpfile; }
+
 private:
+    // Open the file to write the next message into; -1 on failure
+    int openTemp();
+
     std::string filepath;
+    std::string name;       // File name within the directory
+    std::string temp_name;  // name + ".tmp"
+    int dir_fd;
+    FileDurability durability_mode;
+    std::chrono::steady_clock::duration sync_interval;
+    std::chrono::steady_clock::time_point last_sync;
+    bool use_tmpfile;
+    bool enabled;
+};
+
+// Shared-memory transport for consumers on the same device (see shm_ring.h)
+// Each message goes into the newest slot of a ring in /dev/shm; readers map
+// it and read the latest message, or every message in order, without system
+// calls, and can sleep on a futex until the next one.
+class ShmRingTransport : public Transport {
+public:
+    static const uint32_t DEFAULT_SLOT_SIZE = 64 * 1024;
+    static const uint32_t DEFAULT_SLOT_COUNT = 16;
+
+    explicit ShmRingTransport(
+        const std::string& name,
+        uint32_t slot_size = DEFAULT_SLOT_SIZE,
+        uint32_t slot_count = DEFAULT_SLOT_COUNT);
+    ~ShmRingTransport();
+
+    ShmRingTransport(const ShmRingTransport&) = delete;
+    ShmRingTransport& operator=(const ShmRingTransport&) = delete;
+
+    // A message larger than a slot is dropped and counted, not an error
+    bool send(const std::string& data) override;
+    bool isConnected() const override;
+    long dropped() const override { return too_large_drops; }
+
+private:
+    std::string name;
+    shm_ring_t ring;
+    bool open;
+    std::atomic<long> too_large_drops{0};
+};
+
+// What the history log records, shared by HistoryRecordFormatter and
+// HistoryTransport so every record matches the segment header
+struct HistoryLayout {
+    std::vector<int> class_ids;            // Classes counted, in record order
+    std::vector<std::string> class_names;  // Names of class_ids, for readers
+    int box_capacity = 0;                  // Boxes kept per record; 0 for counts only
+};
+
+struct HistoryConfig {
+    size_t budget_bytes = 256ull << 20;    // Most disk used by all segments together
+    size_t segment_bytes = 16ull << 20;    // Largest segment; at most a quarter of the budget
+    double segment_seconds = 3600.0;       // Segments start on multiples of this wall clock period
+    double commit_seconds = 5.0;           // Longest a record waits in memory
+    size_t commit_bytes = 64 * 1024;       // Records buffered before they are written regardless
+};
+
+// Appends fixed-size history records (see history_log.h) to segment files
+// in a directory. Records are collected in memory and written and synced as
+// one group, at most every commit interval, so a crash loses at most that
+// much history. A new segment starts at startup, on every wall clock period
+// boundary, when one grows past its size limit and when the clock steps
+// back; the oldest segments are deleted to keep the directory within its
+// budget.
+class HistoryTransport : public Transport {
+public:
+    HistoryTransport(const std::string& directory, const HistoryLayout& layout, const HistoryConfig& config = {});
+    ~HistoryTransport();
+
+    HistoryTransport(const HistoryTransport&) = delete;
+    HistoryTransport& operator=(const HistoryTransport&) = delete;
+
+    // data is one record of recordSize() bytes
+    bool send(const std::string& data) override;
+    bool isConnected() const override;
+
+    // Write and sync buffered records now
+    bool commit();
+
+    size_t recordSize() const { return record_size; }
+    const std::string& segmentPath() const { return segment_path; }
+
+private:
+    bool startSegment(uint64_t timestamp_ms);
+    void closeSegment();
+    // Delete the oldest segments while the directory is over budget
+    void enforceBudget();
+
+    std::string directory;
+    HistoryConfig config;
+    std::vector<const char*> class_names;  // Into layout_names
+    std::vector<std::string> layout_names;
+    uint16_t box_capacity;
+    size_t record_size;
+    uint64_t period_ms;
+
+    int fd;
+    std::string segment_path;
+    size_t segment_size;     // Bytes in the segment, buffered records included
+    uint64_t segment_period; // Wall clock period the segment belongs to
+    uint64_t last_timestamp_ms; // Of the last record appended to the segment
+    std::string pending;     // Records not yet written
+    std::chrono::steady_clock::time_point last_commit;
     bool enabled;
-};
\ No newline at end of file
+};
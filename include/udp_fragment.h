@@ -0,0 +1,102 @@
+#ifndef _UDP_FRAGMENT_H_
+#define _UDP_FRAGMENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Application-level fragmentation for UDP messages larger than a datagram
+ * (version 1). On a fragmenting stream every datagram carries this header
+ * before its part of the message, a message that fits being one fragment of
+ * one, so no payload can be mistaken for a header. All fields are
+ * little-endian.
+ *
+ * Header, 20 bytes:
+ *   0  char[2]  magic "UF"
+ *   2  u8       version (1)
+ *   3  u8       reserved (0)
+ *   4  u32      message id, the same for every fragment of a message
+ *   8  u16      fragment index
+ *   10 u16      fragment count
+ *   12 u32      offset of this fragment's data in the message
+ *   16 u32      message size
+ *
+ * Fragments may arrive in any order. A fragment of a new message abandons
+ * the one being reassembled, so a message that lost a fragment is dropped
+ * and never delivered partially.
+ */
+
+#define UDP_FRAG_VERSION 1
+#define UDP_FRAG_HEADER_SIZE 20
+#define UDP_FRAG_MAX_FRAGMENTS 1024
+
+#define UDP_FRAG_ERR_NOT_FRAGMENT -1  // No fragment header: not from a fragmenting stream
+#define UDP_FRAG_ERR_MALFORMED -2     // Header fields inconsistent with each other or the datagram
+#define UDP_FRAG_ERR_TOO_LARGE -3     // Message larger than the reassembly buffer
+
+typedef struct {
+    uint32_t message_id;
+    uint16_t index;
+    uint16_t count;
+    uint32_t offset;
+    uint32_t total_size;
+} udp_frag_header_t;
+
+typedef struct {
+    uint8_t* buffer;  // Supplied by the caller
+    size_t capacity;
+    int active;
+    uint32_t message_id;
+    uint32_t total_size;
+    uint16_t count;
+    uint16_t received;
+    uint8_t have[UDP_FRAG_MAX_FRAGMENTS / 8];
+} udp_reassembler_t;
+
+/**
+ * @brief Write a fragment header
+ *
+ * @param out [out] At least UDP_FRAG_HEADER_SIZE bytes
+ * @param header [in] Header fields
+ */
+void udp_frag_write_header(uint8_t* out, const udp_frag_header_t* header);
+
+/**
+ * @brief Read and check a fragment header
+ *
+ * @param data [in] Datagram
+ * @param size [in] Datagram size
+ * @param header [out] Header fields
+ * @return int 0: success; UDP_FRAG_ERR_*: error
+ */
+int udp_frag_read_header(const uint8_t* data, size_t size, udp_frag_header_t* header);
+
+/**
+ * @brief Initialize a reassembler
+ *
+ * @param reassembler [out] Reassembler state
+ * @param buffer [in] Where messages are reassembled
+ * @param capacity [in] Size of buffer, the largest message accepted
+ */
+void udp_reassembler_init(udp_reassembler_t* reassembler, uint8_t* buffer, size_t capacity);
+
+/**
+ * @brief Add one received datagram
+ *
+ * @param reassembler [in/out] Reassembler state
+ * @param data [in] Datagram
+ * @param size [in] Datagram size
+ * @return int > 0: the last fragment arrived and the message of this size is
+ *         in the buffer; 0: fragments still missing; UDP_FRAG_ERR_*: error
+ */
+int udp_reassemble(udp_reassembler_t* reassembler, const uint8_t* data, size_t size);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif //_UDP_FRAGMENT_H_
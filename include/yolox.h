@@ -44,8 +44,12 @@ typedef struct object_detect_result_list {
 } object_detect_result_list;
 
 int init_yolox_model(const char *model_path, rknn_app_context_t *app_ctx);
+// Create a second context sharing the weights of an initialized one, optionally pinned to NPU cores
+int dup_yolox_model(rknn_app_context_t *src_ctx, rknn_app_context_t *dst_ctx, rknn_core_mask core_mask = RKNN_NPU_CORE_AUTO);
 int release_yolox_model(rknn_app_context_t *app_ctx);
-int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results, float conf_threshold = BOX_THRESH);
+// src_box restricts inference to a region of img; boxes are still reported in img coordinates
+int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results, float conf_threshold = BOX_THRESH,
+                          image_rect_t *src_box = NULL);
 
 
 #endif //_RKNN_DEMO_YOLOX_H_
\ No newline at end of file
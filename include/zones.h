@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "yolox.h"
+
+// A named polygon in frame coordinates (pixels of the captured frame, as
+// the detection boxes are)
+struct Zone {
+    std::string name;
+    std::vector<std::pair<float, float>> points;  // At least 3, in order around the polygon
+};
+
+// The point of a box that decides which zones it is in
+enum class ZoneAnchor {
+    BottomCenter,  // Where a standing person's feet are
+    Center
+};
+
+struct ZoneConfig {
+    std::vector<Zone> zones;
+    ZoneAnchor anchor = ZoneAnchor::BottomCenter;
+};
+
+// Load zones from a JSON file:
+//   {"anchor": "bottom-center", "zones": [{"name": "screen_a", "points": [[0,400],[640,400],[640,1080]]}, ...]}
+// Prints the problem and returns false on an invalid file.
+bool loadZones(const std::string& path, ZoneConfig& config);
+
+// Assigns points to zones with a lookup mask. The bounding box of all zones
+// is divided into cells; each cell holds a bit per zone for the zones that
+// contain it entirely and a bit per zone whose edge crosses it. A point in a
+// cell with no crossing edges is assigned with one lookup; only edge cells
+// fall back to an exact test against the crossing polygons, so the cost per
+// box barely depends on the number or complexity of the zones. Zones may
+// overlap: a point can be in several.
+class ZoneMap {
+public:
+    static const size_t MAX_ZONES = 64;        // One bit each
+    static const size_t MAX_CELLS = 1 << 16;   // Mask size limit; sets the cell size
+
+    explicit ZoneMap(const ZoneConfig& config);
+
+    size_t size() const { return zones.size(); }
+    const std::string& name(size_t zone) const { return zones[zone].name; }
+
+    // Bit z set for each zone z that contains the point
+    uint64_t zonesAt(float x, float y) const;
+
+    // Zones containing the box's anchor point
+    uint64_t zonesOf(const box_rect_t& box) const;
+
+    // Exact even-odd test, for reference and for edge cells
+    static bool contains(const Zone& zone, float x, float y);
+
+private:
+    struct Cell {
+        uint64_t inside = 0;  // Zones containing the whole cell
+        uint64_t edge = 0;    // Zones with an edge through the cell
+    };
+
+    void rasterize(size_t zone_index);
+
+    std::vector<Zone> zones;
+    ZoneAnchor anchor;
+    float origin_x = 0.0f;  // Bounding box of all zones
+    float origin_y = 0.0f;
+    float cell_size = 1.0f;
+    int cols = 0;
+    int rows = 0;
+    std::vector<Cell> cells;
+};
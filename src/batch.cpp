@@ -0,0 +1,263 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include "ThreadPool.hpp"
+#include "file_utils.h"
+#include "image_utils.h"
+#include "jpeg_handle.h"
+#include "utils.h"
+
+using json = nlohmann::json;
+
+static const int REPORT_INTERVAL_SECONDS = 5;
+
+// COCO result files use the 91 original category ids, not the 80 contiguous model classes
+static const int COCO_CATEGORY_IDS[80] = {
+    1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 13, 14, 15, 16, 17, 18, 19, 20, 21,
+    22, 23, 24, 25, 27, 28, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+    46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65,
+    67, 70, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 84, 85, 86, 87, 88, 89, 90};
+
+static bool isJpeg(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg";
+}
+
+// Decode straight to BGR so the frame matches what the camera path produces.
+// Each worker keeps its own decompressor.
+static cv::Mat decodeJpeg(const std::string& path) {
+    tjhandle handle = threadJpegDecompressor();
+    if (!handle) {
+        printf("Batch: cannot create a JPEG decompressor: %s\n", tjGetErrorStr2(nullptr));
+        return cv::Mat();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    int width, height, subsample, colorspace;
+    if (data.empty() || tjDecompressHeader3(handle, data.data(), data.size(), &width, &height, &subsample,
+                                            &colorspace) < 0) {
+        return cv::Mat();
+    }
+
+    cv::Mat img(height, width, CV_8UC3);
+    if (tjDecompress2(handle, data.data(), data.size(), img.data, width, 0, height, TJPF_BGR, 0) < 0 &&
+        tjGetErrorCode(handle) != TJERR_WARNING) {
+        printf("Batch: cannot decode %s: %s\n", path.c_str(), tjGetErrorStr2(handle));
+        return cv::Mat();
+    }
+    return img;
+}
+
+static cv::Mat decodeImage(const std::string& path) {
+    if (isJpeg(path)) {
+        return decodeJpeg(path);
+    }
+    return cv::imread(path);
+}
+
+// COCO image ids are the numeric file names (000000000139.jpg -> 139)
+static long cocoImageId(const std::string& path, int index) {
+    std::string stem = std::filesystem::path(path).stem();
+    if (!stem.empty() && stem.size() < 18 && std::all_of(stem.begin(), stem.end(), ::isdigit)) {
+        return std::stol(stem);
+    }
+    return index + 1;
+}
+
+BatchProcessor::BatchProcessor(MLInferenceThread& inference, const BatchConfig& config, std::atomic<bool>& isRunning)
+    : inference(inference), config(config), running(isRunning) {
+}
+
+BatchProcessor::Item BatchProcessor::process(std::string source, int index, int frame, cv::Mat img) {
+    Item item;
+    item.source = source;
+    item.frame = frame;
+    if (img.empty()) {
+        printf("Batch: cannot read %s\n", source.c_str());
+        return item;
+    }
+    int width = img.cols;
+    int height = img.rows;
+
+    InferenceResult result;
+    MLInferenceThread::FrameStatus status = inference.inferFrame(img, result);
+    if (status != MLInferenceThread::FrameStatus::Ok) {
+        printf("Batch: %s on %s\n",
+               status == MLInferenceThread::FrameStatus::ModelNotLoaded ? "model not loaded" : "inference failed",
+               source.c_str());
+        return item;
+    }
+
+    json record;
+    record["image"] = source;
+    if (frame >= 0) {
+        record["frame"] = frame;
+    }
+    record["width"] = width;
+    record["height"] = height;
+
+    json detections = json::array();
+    long image_id = frame >= 0 ? frame + 1 : cocoImageId(source, index);
+    item.coco = json::array();
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if (detection.prop <= 0.0f || detection.cls_id < 0 ||
+            !isClassSelected(detection.cls_id, result.selected_classes)) {
+            continue;
+        }
+        const auto& box = detection.box;
+        detections.push_back({
+            {"class_id", detection.cls_id},
+            {"class_name", std::string(detection.name)},
+            {"confidence", detection.prop},
+            {"bbox", {{"left", box.left}, {"top", box.top}, {"right", box.right}, {"bottom", box.bottom}}}});
+        if (detection.cls_id < 80) {
+            item.coco.push_back({
+                {"image_id", image_id},
+                {"category_id", COCO_CATEGORY_IDS[detection.cls_id]},
+                {"bbox", {box.left, box.top, box.right - box.left, box.bottom - box.top}},
+                {"score", detection.prop}});
+        }
+    }
+    item.detection_count = detections.size();
+    record["detection_count"] = detections.size();
+    record["detections"] = std::move(detections);
+
+    item.line = record.dump();
+    item.ok = true;
+    return item;
+}
+
+void BatchProcessor::write(Item& item) {
+    images++;
+    if (!item.ok) {
+        failures++;
+        return;
+    }
+
+    fputs(item.line.c_str(), jsonl);
+    fputc('\n', jsonl);
+    if (coco) {
+        for (const auto& entry : item.coco) {
+            fputs(first_coco_entry ? "\n" : ",\n", coco);
+            fputs(entry.dump().c_str(), coco);
+            first_coco_entry = false;
+        }
+    }
+    detections += item.detection_count;
+
+    if (std::chrono::steady_clock::now() - last_report >= std::chrono::seconds(REPORT_INTERVAL_SECONDS)) {
+        report(false);
+    }
+}
+
+void BatchProcessor::report(bool final) {
+    auto now = std::chrono::steady_clock::now();
+    double total_s = std::chrono::duration<double>(now - start).count();
+    double window_s = std::chrono::duration<double>(now - last_report).count();
+    if (final) {
+        printf("Batch complete: %ld images (%ld failed), %ld detections in %.1f s, %.1f images/sec sustained\n",
+               images, failures, detections, total_s, total_s > 0 ? images / total_s : 0.0);
+    } else {
+        printf("Batch progress: %ld images, %.1f images/sec (last %d s), %.1f images/sec overall\n", images,
+               window_s > 0 ? (images - images_at_last_report) / window_s : 0.0, REPORT_INTERVAL_SECONDS,
+               total_s > 0 ? images / total_s : 0.0);
+    }
+    last_report = now;
+    images_at_last_report = images;
+}
+
+int BatchProcessor::run() {
+    bool is_directory = std::filesystem::is_directory(config.source);
+
+    jsonl = fopen(config.jsonl_path.c_str(), "w");
+    if (jsonl == NULL) {
+        printf("Batch: cannot open %s\n", config.jsonl_path.c_str());
+        return -1;
+    }
+    if (!config.coco_path.empty()) {
+        coco = fopen(config.coco_path.c_str(), "w");
+        if (coco == NULL) {
+            printf("Batch: cannot open %s\n", config.coco_path.c_str());
+            fclose(jsonl);
+            return -1;
+        }
+        fputs("[", coco);
+    }
+
+    // Enough workers to decode ahead of, and format behind, every NPU context
+    int num_workers = config.workers > 0 ? config.workers : std::max(2u, std::thread::hardware_concurrency());
+    dpool::ThreadPool workers(num_workers);
+    std::deque<std::future<Item>> pending;
+    const size_t window = num_workers * 2;
+
+    // Results are written in input order, bounding how far decode runs ahead
+    auto drain = [&](size_t keep) {
+        while (pending.size() > keep) {
+            Item item = pending.front().get();
+            pending.pop_front();
+            write(item);
+        }
+    };
+
+    start = last_report = std::chrono::steady_clock::now();
+    int ret = 0;
+
+    if (is_directory) {
+        char** paths = NULL;
+        int count = list_image_files(config.source.c_str(), &paths);
+        if (count < 0) {
+            ret = -1;
+        } else {
+            printf("Batch: %d images in %s using %d workers\n", count, config.source.c_str(), num_workers);
+            for (int i = 0; i < count && running; i++) {
+                std::string path = paths[i];
+                pending.push_back(workers.submit([this, path, i]() {
+                    return process(path, i, -1, decodeImage(path));
+                }));
+                drain(window);
+            }
+            free_lines(paths, count);
+        }
+    } else {
+        // Video decode is sequential; inference and formatting still run in parallel
+        cv::VideoCapture capture;
+        capture.open(config.source);
+        if (!capture.isOpened()) {
+            printf("Batch: cannot open video %s\n", config.source.c_str());
+            ret = -1;
+        } else {
+            printf("Batch: video %s using %d workers\n", config.source.c_str(), num_workers);
+            for (int frame = 0; running; frame++) {
+                cv::Mat img;
+                if (!capture.read(img) || img.empty()) {
+                    break;
+                }
+                std::string source = config.source;
+                pending.push_back(workers.submit([this, source, frame, img]() {
+                    return process(source, frame, frame, img);
+                }));
+                drain(window);
+            }
+        }
+    }
+
+    drain(0);
+    report(true);
+
+    fclose(jsonl);
+    if (coco) {
+        fputs("\n]\n", coco);
+        fclose(coco);
+    }
+    return ret;
+}
@@ -0,0 +1,616 @@
+#include "clip_recorder.h"
+#include "inference.h"
+#include "message_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Clip names sort in time order: clip-YYYYMMDD-HHMMSS-mmm (UTC)
+static const char CLIP_PREFIX[] = "clip-";
+
+// AVI files stay below the 1 GB limit of the original (non-OpenDML) format
+static const uint64_t AVI_MAX_BYTES = 1000ull << 20;
+
+bool ClipTrigger::holds(int count) const {
+    switch (op) {
+    case Op::Greater:
+        return count > value;
+    case Op::AtLeast:
+        return count >= value;
+    case Op::Less:
+        return count < value;
+    case Op::AtMost:
+        return count <= value;
+    case Op::Equal:
+        return count == value;
+    }
+    return false;
+}
+
+bool parseClipTriggers(const std::string& text, std::vector<ClipTrigger>& triggers) {
+    // Longer operators first, so ">=" is not read as ">"
+    static const std::pair<const char*, ClipTrigger::Op> operators[] = {
+        {">=", ClipTrigger::Op::AtLeast}, {"<=", ClipTrigger::Op::AtMost}, {"==", ClipTrigger::Op::Equal},
+        {">", ClipTrigger::Op::Greater},  {"<", ClipTrigger::Op::Less}};
+
+    std::vector<ClipTrigger> parsed;
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        ClipTrigger trigger;
+        size_t position = std::string::npos;
+        size_t length = 0;
+        for (const auto& [symbol, op] : operators) {
+            position = item.find(symbol);
+            if (position != std::string::npos) {
+                trigger.op = op;
+                length = strlen(symbol);
+                break;
+            }
+        }
+        char* end = nullptr;
+        if (position != std::string::npos) {
+            trigger.class_name = item.substr(0, position);
+            trigger.value = static_cast<int>(strtol(item.c_str() + position + length, &end, 10));
+        }
+        if (position == std::string::npos || trigger.class_name.empty() || end == item.c_str() + position + length ||
+            *end != '\0') {
+            std::cerr << "Invalid trigger '" << item << "' (expected e.g. person>0 or car>=2)" << std::endl;
+            return false;
+        }
+        parsed.push_back(trigger);
+    }
+    if (parsed.empty()) {
+        std::cerr << "No triggers in '" << text << "'" << std::endl;
+        return false;
+    }
+    triggers = parsed;
+    return true;
+}
+
+bool parseClipFormat(const std::string& text, ClipFormat& format) {
+    if (text == "avi") {
+        format = ClipFormat::AVI;
+    } else if (text == "frames") {
+        format = ClipFormat::Frames;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static std::string clipName(uint64_t timestamp_ms) {
+    time_t seconds = static_cast<time_t>(timestamp_ms / 1000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char name[64];
+    size_t length = strftime(name, sizeof(name), "clip-%Y%m%d-%H%M%S", &utc);
+    snprintf(name + length, sizeof(name) - length, "-%03d", static_cast<int>(timestamp_ms % 1000));
+    return name;
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Frame size from the JPEG's start-of-frame marker; false if there is none
+static bool jpegSize(const std::vector<uchar>& jpeg, int& width, int& height) {
+    size_t i = 2;
+    while (i + 9 < jpeg.size()) {
+        if (jpeg[i] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = jpeg[i + 1];
+        size_t length = (jpeg[i + 2] << 8) | jpeg[i + 3];
+        // SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            height = (jpeg[i + 5] << 8) | jpeg[i + 6];
+            width = (jpeg[i + 7] << 8) | jpeg[i + 8];
+            return width > 0 && height > 0;
+        }
+        i += 2 + length;
+    }
+    return false;
+}
+
+static void appendU32(std::string& out, uint32_t value) {
+    char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16),
+                     static_cast<char>(value >> 24)};
+    out.append(bytes, 4);
+}
+
+static void appendU16(std::string& out, uint16_t value) {
+    char bytes[2] = {static_cast<char>(value), static_cast<char>(value >> 8)};
+    out.append(bytes, 2);
+}
+
+// Headers of a Motion JPEG AVI with one video stream. Always the same size,
+// so the final values can be written over the placeholders at the end.
+static std::string aviHeader(int width, int height, double fps, uint32_t frames, uint32_t largest_frame,
+                             uint32_t movi_bytes) {
+    uint32_t rate = static_cast<uint32_t>(std::lround(fps * 1000.0));
+    std::string out;
+    out.append("RIFF");
+    appendU32(out, 4 + (8 + 192) + (8 + movi_bytes) + (8 + 16 * frames));
+    out.append("AVI ");
+
+    out.append("LIST");
+    appendU32(out, 192);
+    out.append("hdrl");
+    out.append("avih");
+    appendU32(out, 56);
+    appendU32(out, static_cast<uint32_t>(std::lround(1e6 / fps)));           // Microseconds per frame
+    appendU32(out, static_cast<uint32_t>(largest_frame * std::ceil(fps)));   // Max bytes per second
+    appendU32(out, 0);                                                       // Padding granularity
+    appendU32(out, 0x10);                                                    // AVIF_HASINDEX
+    appendU32(out, frames);
+    appendU32(out, 0);                                                       // Initial frames
+    appendU32(out, 1);                                                       // Streams
+    appendU32(out, largest_frame);                                           // Suggested buffer size
+    appendU32(out, width);
+    appendU32(out, height);
+    out.append(16, '\0');
+
+    out.append("LIST");
+    appendU32(out, 116);
+    out.append("strl");
+    out.append("strh");
+    appendU32(out, 56);
+    out.append("vidsMJPG");
+    appendU32(out, 0);       // Flags
+    appendU32(out, 0);       // Priority, language
+    appendU32(out, 0);       // Initial frames
+    appendU32(out, 1000);    // Scale
+    appendU32(out, rate);    // Rate: frames per 1000 s
+    appendU32(out, 0);       // Start
+    appendU32(out, frames);  // Length
+    appendU32(out, largest_frame);
+    appendU32(out, 0xFFFFFFFF);  // Default quality
+    appendU32(out, 0);           // Sample size: varies
+    appendU16(out, 0);
+    appendU16(out, 0);
+    appendU16(out, static_cast<uint16_t>(width));
+    appendU16(out, static_cast<uint16_t>(height));
+    out.append("strf");
+    appendU32(out, 40);
+    appendU32(out, 40);  // BITMAPINFOHEADER
+    appendU32(out, width);
+    appendU32(out, height);
+    appendU16(out, 1);   // Planes
+    appendU16(out, 24);  // Bits per pixel
+    out.append("MJPG");
+    appendU32(out, static_cast<uint32_t>(width) * height * 3);
+    out.append(16, '\0');
+
+    out.append("LIST");
+    appendU32(out, movi_bytes);
+    out.append("movi");
+    return out;
+}
+
+// One clip being written: the video (or frame directory) and its sidecar
+class ClipRecorder::Writer {
+public:
+    Writer(const ClipConfig& config, const std::string& base, uint64_t start_ms)
+        : config(config), base(base), start_ms(start_ms) {
+        MessageWriter json(sidecar);
+        json.raw("{\"trigger\":");
+        json.string(config.trigger_text);
+        json.raw(",\"started\":");
+        json.integer(static_cast<long long>(start_ms));
+        json.raw(",\"results\":[");
+
+        if (config.format == ClipFormat::Frames) {
+            std::error_code error;
+            failed = !fs::create_directories(base, error);
+        } else {
+            fd = ::open((base + ".avi").c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            failed = fd < 0;
+        }
+        if (failed) {
+            std::cerr << "Failed to create clip " << base << ": " << strerror(errno) << std::endl;
+        }
+    }
+
+    ~Writer() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    // False once the clip cannot take more frames
+    bool add(const Frame& frame) {
+        if (failed) {
+            return false;
+        }
+        if (config.format == ClipFormat::Frames) {
+            char name[32];
+            snprintf(name, sizeof(name), "/%06u.jpg", frame_count + 1);
+            int frame_fd = ::open((base + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            bool written = frame_fd >= 0 && writeAll(frame_fd, frame.jpeg.data(), frame.jpeg.size());
+            if (frame_fd >= 0) {
+                ::close(frame_fd);
+            }
+            if (!written) {
+                return fail("write a frame of");
+            }
+        } else {
+            if (frame_count == 0) {
+                if (!jpegSize(frame.jpeg, width, height)) {
+                    return fail("read the frame size for");
+                }
+                std::string header = aviHeader(width, height, 1.0, 0, 0, 4);
+                if (!writeAll(fd, header.data(), header.size())) {
+                    return fail("write");
+                }
+            }
+            uint32_t size = static_cast<uint32_t>(frame.jpeg.size());
+            uint32_t padded = size + (size & 1);
+            if (movi_bytes + 8 + padded + 16ull * (frame_count + 1) > AVI_MAX_BYTES) {
+                return false;
+            }
+            std::string chunk = "00dc";
+            appendU32(chunk, size);
+            index.append("00dc");
+            appendU32(index, 0x10);  // AVIIF_KEYFRAME
+            appendU32(index, 4 + movi_bytes);  // From the "movi" fourcc
+            appendU32(index, size);
+            if (!writeAll(fd, chunk.data(), chunk.size()) || !writeAll(fd, frame.jpeg.data(), size) ||
+                (padded != size && !writeAll(fd, "", 1))) {
+                return fail("write");
+            }
+            movi_bytes += 8 + padded;
+            largest_frame = std::max(largest_frame, size);
+        }
+
+        MessageWriter json(sidecar);
+        json.raw(frame_count ? ",{\"frame\":" : "{\"frame\":");
+        json.integer(static_cast<long long>(frame.frame_id));
+        json.raw(",\"timestamp\":");
+        json.integer(static_cast<long long>(frame.timestamp_ms));
+        json.raw(",\"detections\":[");
+        for (size_t i = 0; i < frame.detections.size(); i++) {
+            const auto& detection = frame.detections[i];
+            json.raw(i ? ",{\"class\":" : "{\"class\":");
+            json.string(detection.name);
+            json.raw(",\"confidence\":");
+            json.number(std::round(detection.prop * 1000.0) / 1000.0);
+            json.raw(",\"box\":[");
+            json.integer(detection.box.left);
+            json.raw(',');
+            json.integer(detection.box.top);
+            json.raw(',');
+            json.integer(detection.box.right);
+            json.raw(',');
+            json.integer(detection.box.bottom);
+            json.raw("]}");
+        }
+        json.raw("]}");
+
+        if (frame_count == 0) {
+            first_ms = frame.timestamp_ms;
+        }
+        last_ms = frame.timestamp_ms;
+        frame_count++;
+        return true;
+    }
+
+    // Complete the video and write the sidecar; false if the clip is unusable
+    bool finish() {
+        if (failed || frame_count == 0) {
+            return false;
+        }
+        double fps = frame_count > 1 && last_ms > first_ms ? (frame_count - 1) * 1000.0 / (last_ms - first_ms) : 1.0;
+
+        if (config.format == ClipFormat::AVI) {
+            std::string header = aviHeader(width, height, fps, frame_count, largest_frame, 4 + movi_bytes);
+            std::string index_header = "idx1";
+            appendU32(index_header, static_cast<uint32_t>(index.size()));
+            bool written = writeAll(fd, index_header.data(), index_header.size()) &&
+                           writeAll(fd, index.data(), index.size()) &&
+                           pwrite(fd, header.data(), header.size(), 0) == static_cast<ssize_t>(header.size());
+            if (::close(fd) != 0 || !written) {
+                fd = -1;
+                return fail("finish");
+            }
+            fd = -1;
+        }
+
+        MessageWriter json(sidecar);
+        json.raw("],\"ended\":");
+        json.integer(static_cast<long long>(last_ms));
+        json.raw(",\"frames\":");
+        json.integer(frame_count);
+        json.raw(",\"fps\":");
+        json.number(std::round(fps * 100.0) / 100.0);
+        json.raw(",\"video\":");
+        json.string(fs::path(base).filename().string() + (config.format == ClipFormat::AVI ? ".avi" : "/"));
+        json.raw('}');
+
+        // Renamed into place, so a sidecar is only ever seen complete
+        std::string temp_path = base + ".json.tmp";
+        int json_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        bool written = json_fd >= 0 && writeAll(json_fd, sidecar.data(), sidecar.size());
+        if (json_fd >= 0) {
+            written = ::close(json_fd) == 0 && written;
+        }
+        if (!written || rename(temp_path.c_str(), (base + ".json").c_str()) != 0) {
+            unlink(temp_path.c_str());
+            return fail("write the sidecar of");
+        }
+        std::cout << "Recorded clip " << base << ": " << frame_count << " frames" << std::endl;
+        return true;
+    }
+
+private:
+    bool fail(const char* what) {
+        std::cerr << "Failed to " << what << " clip " << base << ": " << strerror(errno) << std::endl;
+        failed = true;
+        return false;
+    }
+
+    const ClipConfig& config;
+    std::string base;  // Path without extension
+    uint64_t start_ms;
+    int fd = -1;
+    bool failed = false;
+    int width = 0;
+    int height = 0;
+    uint32_t frame_count = 0;
+    uint32_t largest_frame = 0;
+    uint64_t movi_bytes = 0;  // Chunks written after the "movi" fourcc
+    uint64_t first_ms = 0;
+    uint64_t last_ms = 0;
+    std::string index;    // idx1 entries
+    std::string sidecar;  // JSON so far
+};
+
+ClipRecorder::ClipRecorder(const ClipConfig& config, std::atomic<bool>& isRunning)
+    : config(config), running(isRunning) {
+    std::error_code error;
+    fs::create_directories(config.directory, error);
+    if (error) {
+        std::cerr << "Failed to create clip directory " << config.directory << ": " << error.message() << std::endl;
+    }
+}
+
+ClipRecorder::~ClipRecorder() = default;
+
+void ClipRecorder::publish(DecoratedFrame& frame) {
+    if (!frame.result()) {
+        return;
+    }
+    // Reuse an encoding another sink made; otherwise encode on the recording thread
+    if (frame.hasJpeg()) {
+        offer(*frame.result(), &frame.jpeg(), nullptr);
+    } else {
+        offer(*frame.result(), nullptr, &frame.bgr());
+    }
+}
+
+void ClipRecorder::record(const std::vector<uchar>& jpeg, const InferenceResult& result) {
+    offer(result, &jpeg, nullptr);
+}
+
+void ClipRecorder::offer(const InferenceResult& result, const std::vector<uchar>* jpeg, const cv::Mat* bgr) {
+    const ResultView& view = result.view();
+    incoming.frame_id = result.frame_id;
+    incoming.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        result.timestamp.time_since_epoch()).count();
+    incoming.detections.clear();
+    for (int index : view.selected) {
+        incoming.detections.push_back(result.detections.results[index]);
+    }
+
+    incoming.triggered = false;
+    for (const auto& trigger : config.triggers) {
+        int count = 0;
+        if (trigger.class_name == "any") {
+            count = static_cast<int>(view.selected.size());
+        } else {
+            for (size_t i = 0; i < view.class_names.size(); i++) {
+                if (view.class_names[i] == trigger.class_name) {
+                    count = view.class_counts[i];
+                    break;
+                }
+            }
+        }
+        if (trigger.holds(count)) {
+            incoming.triggered = true;
+            break;
+        }
+    }
+
+    if (jpeg) {
+        incoming.jpeg.assign(jpeg->begin(), jpeg->end());
+        incoming.bgr.release();
+    } else {
+        incoming.jpeg.clear();
+        bgr->copyTo(incoming.bgr);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (has_pending) {
+            frames_skipped++;
+        }
+        std::swap(pending, incoming);
+        has_pending = true;
+    }
+    ready.notify_one();
+}
+
+void ClipRecorder::operator()() {
+    Frame frame;
+    last_frame_time = std::chrono::steady_clock::now();
+    while (running) {
+        bool has_frame = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait_for(lock, std::chrono::milliseconds(200), [this] { return has_pending || !running; });
+            if (has_pending) {
+                std::swap(frame, pending);
+                has_pending = false;
+                has_frame = true;
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (has_frame) {
+            last_frame_time = now;
+            process(frame);
+        } else if (writer && now - last_frame_time > std::chrono::duration<double>(config.post_seconds)) {
+            // The source stopped: end the clip rather than wait for the next frame
+            finishClip();
+        }
+    }
+    if (writer) {
+        finishClip();
+    }
+}
+
+void ClipRecorder::process(Frame& frame) {
+    if (frame.jpeg.empty()) {
+        if (!encodeJpeg(frame.bgr, config.jpeg_quality, frame.jpeg)) {
+            return;
+        }
+        frame.bgr.release();
+    }
+    frames_recorded++;
+
+    // The wall clock stepped back (e.g. NTP at boot): durations against
+    // earlier frames mean nothing, so close the clip and restart the ring
+    if (frame.timestamp_ms < last_timestamp_ms) {
+        if (writer) {
+            finishClip();
+        }
+        ring.clear();
+        ring_bytes = 0;
+        last_triggered = false;
+    }
+    last_timestamp_ms = frame.timestamp_ms;
+
+    bool started = frame.triggered && !last_triggered;
+    last_triggered = frame.triggered;
+
+    bool capped = false;
+    if (writer) {
+        if (frame.triggered) {
+            clip_end_ms = std::max(clip_end_ms, frame.timestamp_ms + static_cast<uint64_t>(config.post_seconds * 1000));
+        }
+        capped = frame.timestamp_ms - clip_start_ms > static_cast<uint64_t>(config.max_seconds * 1000);
+        if (frame.timestamp_ms > clip_end_ms || capped) {
+            finishClip();
+        } else {
+            addToClip(frame);
+        }
+    }
+    // A clip cut at the longest length while the triggers still hold
+    // continues in the next one, with the ring as its pre-roll
+    if (!writer && (started || (capped && frame.triggered))) {
+        startClip(frame);
+    }
+
+    // Into the ring, dropping what is too old or over the memory limit
+    ring_bytes += frame.bytes();
+    ring.push_back(std::move(frame));
+    uint64_t oldest_ms = ring.back().timestamp_ms - std::min<uint64_t>(
+        ring.back().timestamp_ms, static_cast<uint64_t>(config.pre_seconds * 1000));
+    while (!ring.empty() && (ring_bytes > config.memory_bytes || ring.front().timestamp_ms < oldest_ms)) {
+        ring_bytes -= ring.front().bytes();
+        ring.pop_front();
+    }
+    frame = Frame();
+}
+
+void ClipRecorder::startClip(const Frame& frame) {
+    clip_start_ms = frame.timestamp_ms;
+    clip_end_ms = frame.timestamp_ms + static_cast<uint64_t>(config.post_seconds * 1000);
+
+    std::string base = (fs::path(config.directory) / clipName(frame.timestamp_ms)).string();
+    writer = std::make_unique<Writer>(config, base, frame.timestamp_ms);
+
+    // The pre-roll, then the frame that fired
+    uint64_t pre_roll_ms = static_cast<uint64_t>(config.pre_seconds * 1000);
+    for (const Frame& earlier : ring) {
+        if (earlier.timestamp_ms + pre_roll_ms >= frame.timestamp_ms) {
+            addToClip(earlier);
+        }
+    }
+    addToClip(frame);
+}
+
+void ClipRecorder::addToClip(const Frame& frame) {
+    if (writer && !writer->add(frame)) {
+        // Full or failing: end it here
+        finishClip();
+    }
+}
+
+void ClipRecorder::finishClip() {
+    if (writer->finish()) {
+        clips_finished++;
+    }
+    writer.reset();
+    enforceBudget();
+}
+
+void ClipRecorder::enforceBudget() {
+    // Sizes by clip name; the video, frame directory and sidecar share it
+    std::map<std::string, uint64_t> clips;
+    uint64_t total = 0;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(config.directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, sizeof(CLIP_PREFIX) - 1, CLIP_PREFIX) != 0) {
+            continue;
+        }
+        uint64_t size = 0;
+        if (entry.is_directory(error)) {
+            for (const auto& file : fs::directory_iterator(entry.path(), error)) {
+                size += file.file_size(error);
+            }
+        } else {
+            size = entry.file_size(error);
+        }
+        clips[name.substr(0, name.find('.'))] += size;
+        total += size;
+    }
+
+    // Oldest first, never the newest
+    for (auto it = clips.begin(); total > config.budget_bytes && std::next(it) != clips.end(); ++it) {
+        fs::path base = fs::path(config.directory) / it->first;
+        fs::remove_all(base, error);
+        fs::remove(base.string() + ".avi", error);
+        fs::remove(base.string() + ".json", error);
+        total -= it->second;
+        std::cout << "Deleted clip " << base.string() << " to stay within the clip budget" << std::endl;
+    }
+}
+
+ClipRecorder::Stats ClipRecorder::stats() const {
+    return {frames_recorded.load(), frames_skipped.load(), clips_finished.load()};
+}
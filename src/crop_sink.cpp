@@ -0,0 +1,220 @@
+#include "crop_sink.h"
+#include "inference.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+// Crop names sort in time order: crop-YYYYMMDD-HHMMSS-mmm-... (UTC)
+static const char CROP_PREFIX[] = "crop-";
+
+static const uint32_t CROP_SLOT_COUNT = 16;
+
+bool CropRateLimiter::take(int cls_id, uint64_t now_ms) {
+    auto [it, added] = buckets.try_emplace(cls_id, Bucket{burst, now_ms});
+    Bucket& bucket = it->second;
+    if (!added && now_ms > bucket.updated_ms) {
+        bucket.tokens = std::min(burst, bucket.tokens + rate * (now_ms - bucket.updated_ms) / 1000.0);
+        bucket.updated_ms = now_ms;
+    }
+    if (bucket.tokens < 1.0) {
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+static std::string cropName(const CropHeader& header, int index) {
+    time_t seconds = static_cast<time_t>(header.timestamp_ms / 1000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char name[128];
+    size_t length = strftime(name, sizeof(name), "crop-%Y%m%d-%H%M%S", &utc);
+    snprintf(name + length, sizeof(name) - length, "-%03d-%llu-%d-%s.jpg",
+             static_cast<int>(header.timestamp_ms % 1000), static_cast<unsigned long long>(header.frame_id), index,
+             header.class_name);
+    // Class names such as "traffic light" keep to one word
+    std::replace(name, name + strlen(name), ' ', '_');
+    return name;
+}
+
+CropSink::CropSink(const CropConfig& crop_config)
+    : config(crop_config),
+      limiter(crop_config.rate_per_class, std::max(crop_config.burst, 1.0)),
+      workers(std::max(crop_config.threads, 1)) {
+    config.max_edge = std::max(config.max_edge, 16);
+    config.max_pending = std::max(config.max_pending, 1);
+
+    if (!config.shm_name.empty()) {
+        // Room for the largest crop at its worst case encoding
+        uint32_t slot_size = sizeof(CropHeader) + config.max_edge * config.max_edge * 3 + 2048;
+        ring = std::make_unique<ShmRingTransport>(config.shm_name, slot_size, CROP_SLOT_COUNT);
+        return;
+    }
+
+    std::error_code error;
+    fs::create_directories(config.directory, error);
+    if (error) {
+        std::cerr << "Failed to create crop directory " << config.directory << ": " << error.message() << std::endl;
+        return;
+    }
+    // Crops from earlier runs count towards max_files
+    for (const auto& entry : fs::directory_iterator(config.directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, sizeof(CROP_PREFIX) - 1, CROP_PREFIX) == 0 && entry.path().extension() == ".jpg") {
+            files.push_back(name);
+        }
+    }
+    std::sort(files.begin(), files.end());
+}
+
+CropSink::~CropSink() {
+    drain();
+}
+
+cv::Rect CropSink::cropRect(const box_rect_t& box, float padding, int width, int height) {
+    int pad_x = static_cast<int>(std::lround((box.right - box.left) * padding));
+    int pad_y = static_cast<int>(std::lround((box.bottom - box.top) * padding));
+    int left = std::max(box.left - pad_x, 0);
+    int top = std::max(box.top - pad_y, 0);
+    int right = std::min(box.right + pad_x, width);
+    int bottom = std::min(box.bottom + pad_y, height);
+    if (right <= left || bottom <= top) {
+        return cv::Rect();
+    }
+    return cv::Rect(left, top, right - left, bottom - top);
+}
+
+void CropSink::publishRaw(const cv::Mat& rgb, const InferenceResult& result) {
+    const ResultView& view = result.view();
+    if (view.selected.empty() || rgb.empty()) {
+        return;
+    }
+    uint64_t timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                result.timestamp.time_since_epoch()).count();
+
+    for (int i : view.selected) {
+        const object_detect_result_t& detection = result.detections.results[i];
+        cv::Rect rect = cropRect(detection.box, config.padding, rgb.cols, rgb.rows);
+        if (rect.area() == 0) {
+            continue;
+        }
+        if (!limiter.take(detection.cls_id, timestamp_ms)) {
+            crops_limited++;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            if (pending >= config.max_pending) {
+                crops_dropped++;
+                continue;
+            }
+            pending++;
+        }
+
+        // Only the copy happens here; the frame is drawn on after this call
+        auto crop = std::make_shared<Crop>();
+        crop->rgb = rgb(rect).clone();
+        crop->index = i;
+        CropHeader& header = crop->header;
+        memset(&header, 0, sizeof(header));
+        header.magic = CROP_HEADER_MAGIC;
+        header.frame_id = result.frame_id;
+        header.timestamp_ms = timestamp_ms;
+        header.cls_id = detection.cls_id;
+        header.confidence = detection.prop;
+        header.left = detection.box.left;
+        header.top = detection.box.top;
+        header.right = detection.box.right;
+        header.bottom = detection.box.bottom;
+        snprintf(header.class_name, sizeof(header.class_name), "%s", detection.name);
+
+        workers.submit([this, crop]() { encode(*crop); });
+    }
+}
+
+void CropSink::encode(Crop& crop) {
+    cv::Mat bgr;
+    int longest = std::max(crop.rgb.cols, crop.rgb.rows);
+    if (longest > config.max_edge) {
+        double scale = static_cast<double>(config.max_edge) / longest;
+        cv::Size size(std::max(1, static_cast<int>(std::lround(crop.rgb.cols * scale))),
+                      std::max(1, static_cast<int>(std::lround(crop.rgb.rows * scale))));
+        cv::Mat small;
+        cv::resize(crop.rgb, small, size, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(small, bgr, cv::COLOR_RGB2BGR);
+    } else {
+        cv::cvtColor(crop.rgb, bgr, cv::COLOR_RGB2BGR);
+    }
+
+    std::vector<uchar> jpeg;
+    if (encodeJpeg(bgr, config.jpeg_quality, jpeg)) {
+        write(crop, jpeg);
+    } else {
+        crops_failed++;
+    }
+    finished();
+}
+
+void CropSink::write(const Crop& crop, const std::vector<uchar>& jpeg) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+
+    if (ring) {
+        CropHeader header = crop.header;
+        header.jpeg_size = static_cast<uint32_t>(jpeg.size());
+        message.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+        message.append(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+        if (ring->send(message)) {
+            crops_written++;
+        } else {
+            crops_failed++;
+        }
+        return;
+    }
+
+    std::string name = cropName(crop.header, crop.index);
+    std::string path = (fs::path(config.directory) / name).string();
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        perror("Failed to open crop file");
+        crops_failed++;
+        return;
+    }
+    bool written = fwrite(jpeg.data(), 1, jpeg.size(), file) == jpeg.size();
+    if (fclose(file) != 0 || !written || rename(temp_path.c_str(), path.c_str()) != 0) {
+        printf("Failed to write crop file %s\n", path.c_str());
+        remove(temp_path.c_str());
+        crops_failed++;
+        return;
+    }
+    crops_written++;
+
+    // Workers finish out of order; keep the list sorted by name
+    files.insert(std::upper_bound(files.begin(), files.end(), name), name);
+    while (files.size() > config.max_files) {
+        remove((fs::path(config.directory) / files.front()).c_str());
+        files.pop_front();
+    }
+}
+
+void CropSink::finished() {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    if (--pending == 0) {
+        idle.notify_all();
+    }
+}
+
+void CropSink::drain() {
+    std::unique_lock<std::mutex> lock(pending_mutex);
+    idle.wait(lock, [this]() { return pending == 0; });
+}
+
+CropSink::Stats CropSink::stats() const {
+    return {crops_written.load(), crops_limited.load(), crops_dropped.load(), crops_failed.load()};
+}
@@ -0,0 +1,259 @@
+#include <string.h>
+
+#include "detection_wire.h"
+
+static void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_u64(uint8_t* p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t* p)
+{
+    return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static int put_varint(uint8_t* p, int32_t v)
+{
+    uint32_t zigzag = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    int n = 0;
+    while (zigzag >= 0x80) {
+        p[n++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    p[n++] = (uint8_t)zigzag;
+    return n;
+}
+
+// Returns bytes read, or 0 when the varint runs past end
+static int get_varint(const uint8_t* p, const uint8_t* end, int32_t* v)
+{
+    uint32_t zigzag = 0;
+    int n = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (p + n >= end) {
+            return 0;
+        }
+        uint8_t byte = p[n++];
+        zigzag |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *v = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return n;
+        }
+    }
+    return 0;
+}
+
+static int clamp16(int v)
+{
+    return v < INT16_MIN ? INT16_MIN : v > INT16_MAX ? INT16_MAX : v;
+}
+
+static uint16_t quantize_confidence(float confidence)
+{
+    if (!(confidence > 0.0f)) {
+        return 0;
+    }
+    if (confidence >= 1.0f) {
+        return 65535;
+    }
+    return (uint16_t)(confidence * 65535.0f + 0.5f);
+}
+
+void wire_encoder_init(wire_encoder_t* encoder, int keyframe_interval)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->keyframe_interval = keyframe_interval;
+}
+
+int wire_encode(wire_encoder_t* encoder, const wire_frame_t* frame, uint8_t* out, size_t capacity)
+{
+    if (frame->box_count < 0 || frame->box_count > WIRE_MAX_BOXES || capacity < WIRE_MAX_MESSAGE_SIZE) {
+        return -1;
+    }
+
+    const wire_frame_t* base = &encoder->last;
+    uint64_t base_offset = frame->sequence - base->sequence;
+    int delta = encoder->has_last && encoder->keyframe_interval > 1 &&
+                encoder->since_keyframe < encoder->keyframe_interval &&
+                frame->model_id == base->model_id && frame->sequence > base->sequence && base_offset <= UINT32_MAX;
+    if (!delta) {
+        encoder->since_keyframe = 0;
+        base_offset = 0;
+    }
+
+    out[0] = 'O';
+    out[1] = 'D';
+    out[2] = WIRE_VERSION;
+    out[3] = delta ? WIRE_FLAG_DELTA : 0;
+    put_u32(out + 4, frame->model_id);
+    put_u64(out + 8, frame->sequence);
+    put_u64(out + 16, frame->timestamp_us);
+    put_u32(out + 24, (uint32_t)base_offset);
+    put_u16(out + 28, (uint16_t)frame->box_count);
+    put_u16(out + 30, 0);
+
+    // What the receiver will decode becomes the base for the next delta
+    wire_frame_t* sent = &encoder->last;
+    int base_count = sent->box_count;
+    uint8_t* p = out + WIRE_HEADER_SIZE;
+    for (int i = 0; i < frame->box_count; i++) {
+        const wire_box_t* box = &frame->boxes[i];
+        int coords[4] = {clamp16(box->left), clamp16(box->top), clamp16(box->right), clamp16(box->bottom)};
+        uint16_t confidence = quantize_confidence(box->confidence);
+        uint16_t class_id = (uint16_t)box->class_id;
+
+        if (delta) {
+            const wire_box_t* prev = &sent->boxes[i];
+            int prev_coords[4] = {0, 0, 0, 0};
+            if (i < base_count) {
+                prev_coords[0] = prev->left;
+                prev_coords[1] = prev->top;
+                prev_coords[2] = prev->right;
+                prev_coords[3] = prev->bottom;
+            }
+            put_u16(p, class_id);
+            put_u16(p + 2, confidence);
+            p += 4;
+            for (int c = 0; c < 4; c++) {
+                p += put_varint(p, coords[c] - prev_coords[c]);
+            }
+        } else {
+            for (int c = 0; c < 4; c++) {
+                put_u16(p + c * 2, (uint16_t)(int16_t)coords[c]);
+            }
+            put_u16(p + 8, confidence);
+            put_u16(p + 10, class_id);
+            p += WIRE_KEY_BOX_SIZE;
+        }
+
+        sent->boxes[i].left = coords[0];
+        sent->boxes[i].top = coords[1];
+        sent->boxes[i].right = coords[2];
+        sent->boxes[i].bottom = coords[3];
+        sent->boxes[i].confidence = confidence / 65535.0f;
+        sent->boxes[i].class_id = class_id;
+    }
+
+    sent->model_id = frame->model_id;
+    sent->sequence = frame->sequence;
+    sent->timestamp_us = frame->timestamp_us;
+    sent->is_delta = delta;
+    sent->box_count = frame->box_count;
+    encoder->has_last = 1;
+    encoder->since_keyframe++;
+    return (int)(p - out);
+}
+
+void wire_decoder_init(wire_decoder_t* decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+int wire_decode(wire_decoder_t* decoder, const uint8_t* data, size_t size, wire_frame_t* frame)
+{
+    if (size < WIRE_HEADER_SIZE) {
+        return WIRE_ERR_TRUNCATED;
+    }
+    if (data[0] != 'O' || data[1] != 'D') {
+        return WIRE_ERR_MAGIC;
+    }
+    if (data[2] > WIRE_VERSION) {
+        return WIRE_ERR_VERSION;
+    }
+
+    int delta = (data[3] & WIRE_FLAG_DELTA) != 0;
+    uint64_t sequence = get_u64(data + 8);
+    int box_count = get_u16(data + 28);
+    if (box_count > WIRE_MAX_BOXES) {
+        return WIRE_ERR_TOO_MANY;
+    }
+
+    const wire_frame_t* base = &decoder->last;
+    if (delta && (!decoder->has_last || base->sequence != sequence - get_u32(data + 24))) {
+        return WIRE_ERR_NO_BASE;
+    }
+    if (!delta && size < WIRE_HEADER_SIZE + (size_t)box_count * WIRE_KEY_BOX_SIZE) {
+        return WIRE_ERR_TRUNCATED;
+    }
+
+    const uint8_t* p = data + WIRE_HEADER_SIZE;
+    const uint8_t* end = data + size;
+    for (int i = 0; i < box_count; i++) {
+        wire_box_t* box = &frame->boxes[i];
+        int coords[4];
+        if (delta) {
+            if (end - p < 4) {
+                return WIRE_ERR_TRUNCATED;
+            }
+            box->class_id = get_u16(p);
+            box->confidence = get_u16(p + 2) / 65535.0f;
+            p += 4;
+            const wire_box_t* prev = &base->boxes[i];
+            int prev_coords[4] = {0, 0, 0, 0};
+            if (i < base->box_count) {
+                prev_coords[0] = prev->left;
+                prev_coords[1] = prev->top;
+                prev_coords[2] = prev->right;
+                prev_coords[3] = prev->bottom;
+            }
+            for (int c = 0; c < 4; c++) {
+                int32_t diff;
+                int n = get_varint(p, end, &diff);
+                if (n == 0) {
+                    return WIRE_ERR_TRUNCATED;
+                }
+                coords[c] = prev_coords[c] + diff;
+                p += n;
+            }
+        } else {
+            for (int c = 0; c < 4; c++) {
+                coords[c] = (int16_t)get_u16(p + c * 2);
+            }
+            box->confidence = get_u16(p + 8) / 65535.0f;
+            box->class_id = get_u16(p + 10);
+            p += WIRE_KEY_BOX_SIZE;
+        }
+        box->left = coords[0];
+        box->top = coords[1];
+        box->right = coords[2];
+        box->bottom = coords[3];
+    }
+
+    frame->model_id = get_u32(data + 4);
+    frame->sequence = sequence;
+    frame->timestamp_us = get_u64(data + 16);
+    frame->is_delta = delta;
+    frame->box_count = box_count;
+
+    decoder->last.model_id = frame->model_id;
+    decoder->last.sequence = frame->sequence;
+    decoder->last.timestamp_us = frame->timestamp_us;
+    decoder->last.is_delta = frame->is_delta;
+    decoder->last.box_count = box_count;
+    memcpy(decoder->last.boxes, frame->boxes, box_count * sizeof(wire_box_t));
+    decoder->has_last = 1;
+    return 0;
+}
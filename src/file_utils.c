@@ -1,6 +1,11 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define MAX_TEXT_LINE_LENGTH 1024
 
@@ -51,6 +56,44 @@ int read_data_from_file(const char *path, char **out_data)
     return file_size;
 }
 
+int map_data_from_file(const char *path, void **out_data)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("open %s fail!\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        printf("fstat %s fail!\n", path);
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("mmap %s fail!\n", path);
+        return -1;
+    }
+    // The whole file is consumed front to back, so ask for aggressive readahead.
+    // Advice values are not flags: each needs its own call. Both are hints only.
+    if (madvise(data, st.st_size, MADV_SEQUENTIAL) != 0) {
+        printf("madvise sequential %s fail: %s\n", path, strerror(errno));
+    }
+    if (madvise(data, st.st_size, MADV_WILLNEED) != 0) {
+        printf("madvise willneed %s fail: %s\n", path, strerror(errno));
+    }
+    *out_data = data;
+    return (int)st.st_size;
+}
+
+void unmap_data(void *data, int size)
+{
+    if (data != NULL && size > 0) {
+        munmap(data, size);
+    }
+}
+
 int write_data_to_file(const char *path, const char *data, unsigned int size)
 {
     FILE *fp;
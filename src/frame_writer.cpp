@@ -1,10 +1,86 @@
 #include "frame_writer.h"
 #include "inference.h"
 #include "utils.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <strings.h>
+#include "jpeg_handle.h"
 
 void DecoratedFrameWriter::writeFrame(cv::Mat& frame, const InferenceResult& result) {
+    // Nothing unredacted reaches any sink, raw or decorated
+    redactor.apply(frame, result);
+
+    // Raw sinks see the frame before any drawing
+    for (auto& sink : raw_sinks) {
+        sink->publishRaw(frame, result);
+    }
+
+    // Scale down once: drawing, conversion and every encoding then work on
+    // the smaller frame, and the sinks get the boxes in its pixels
+    cv::Mat* canvas = &frame;
+    const InferenceResult* decorated_result = &result;
+    cv::Size size;
+    if (outputSize(frame, size)) {
+        cv::resize(frame, scaled, size, 0, 0, cv::INTER_AREA);
+        canvas = &scaled;
+        if (!scaled_result) {
+            scaled_result = std::make_shared<InferenceResult>();
+        }
+        *scaled_result = result;
+        const double scale_x = static_cast<double>(size.width) / frame.cols;
+        const double scale_y = static_cast<double>(size.height) / frame.rows;
+        for (int i = 0; i < scaled_result->detections.count; i++) {
+            box_rect_t& box = scaled_result->detections.results[i].box;
+            box = {static_cast<int>(box.left * scale_x), static_cast<int>(box.top * scale_y),
+                   static_cast<int>(box.right * scale_x), static_cast<int>(box.bottom * scale_y)};
+        }
+        decorated_result = scaled_result.get();
+    }
+    decorate(*canvas, *decorated_result);
+
+    // Convert back to BGR for OpenCV image writing
+    cv::cvtColor(*canvas, *canvas, cv::COLOR_RGB2BGR);
+
+    DecoratedFrame decorated(*canvas, decorated_result, output);
+    if (!output_path.empty()) {
+        writeFile(decorated);
+    }
+    for (auto& sink : sinks) {
+        sink->publish(decorated);
+    }
+}
+
+bool fitWithin(const cv::Mat& frame, int max_width, int max_height, cv::Size& size) {
+    if (max_width <= 0 || max_height <= 0 || frame.empty()) {
+        return false;
+    }
+    double scale = std::min(static_cast<double>(max_width) / frame.cols,
+                            static_cast<double>(max_height) / frame.rows);
+    if (scale >= 1.0) {
+        return false;
+    }
+    size = cv::Size(std::max(static_cast<int>(frame.cols * scale + 0.5), 1),
+                    std::max(static_cast<int>(frame.rows * scale + 0.5), 1));
+    return true;
+}
+
+bool DecoratedFrameWriter::outputSize(const cv::Mat& frame, cv::Size& size) {
+    if (output.width <= 0 || output.height <= 0 || frame.empty()) {
+        return false;
+    }
+    if (!fitWithin(frame, output.width, output.height, size)) {
+        if (!warned_output_size) {
+            printf("Warning: frame size %dx%d is not smaller than the %dx%d frames; decorating at full size\n",
+                   output.width, output.height, frame.cols, frame.rows);
+            warned_output_size = true;
+        }
+        return false;
+    }
+    return true;
+}
+
+void DecoratedFrameWriter::decorate(cv::Mat& canvas, const InferenceResult& result) {
     // Use confidence threshold from the result
     float threshold = result.confidence_threshold;
     
@@ -18,98 +94,148 @@ void DecoratedFrameWriter::writeFrame(cv::Mat& frame, const InferenceResult& res
         }
     }
     
-    // If suppress_empty is enabled and no valid detections, draw "none" text
+    // Colours are RGB: the frame is converted to BGR after drawing
+    static const OverlayColor RED = {255, 0, 0};
+    static const OverlayColor GREEN = {0, 255, 0};
+    static const OverlayColor GRAY = {128, 128, 128};  // 50% gray for low confidence
+
+    if (canvas.empty() || canvas.type() != CV_8UC3) {
+        printf("Warning: Cannot draw on a frame that is not 8-bit RGB\n");
+        return;
+    }
+    OverlayImage image = {canvas.data, canvas.cols, canvas.rows, canvas.step[0], OverlayFormat::RGB24};
     if (suppress_empty && valid_detections == 0) {
-        std::string none_text = "none";
-        cv::Scalar red_color(0, 0, 255);  // Red color in RGB
-        
-        // Get text size to center it
-        int baseline = 0;
-        cv::Size text_size = cv::getTextSize(none_text, cv::FONT_HERSHEY_SIMPLEX, 2.0, 3, &baseline);
-        
-        // Calculate center position
-        cv::Point text_pos;
-        text_pos.x = (frame.cols - text_size.width) / 2;
-        text_pos.y = (frame.rows + text_size.height) / 2;
-        
-        // Draw "none" text in red
-        cv::putText(frame, none_text, text_pos, cv::FONT_HERSHEY_SIMPLEX, 2.0, red_color, 3);
-    } else {
-        // Draw boxes on the image for detected objects
-        for (int i = 0; i < result.detections.count; i++) {
-            try {
-                const auto& detection = result.detections.results[i];
-                
-                // Skip detections with invalid scores or class_ids
-                if (detection.prop <= 0.0f || detection.cls_id < 0) {
-                    printf("Skipping invalid detection: prop=%.2f, cls_id=%d\n", detection.prop, detection.cls_id);
-                    continue;
-                }
-                
-                // Skip detections that are not in the selected classes
-                if (!isClassSelected(detection.cls_id, result.selected_classes)) {
-                    printf("Skipping unselected class: cls_id=%d\n", detection.cls_id);
-                    continue;
-                }
-                
-                // Choose color based on confidence threshold
-                cv::Scalar color;
-                if (detection.prop >= threshold) {
-                    color = cv::Scalar(0, 255, 0);  // Green for high confidence
-                } else {
-                    color = cv::Scalar(128, 128, 128);  // 50% gray for low confidence
-                }
-                auto& box = detection.box;
-                
-                // Validate box coordinates
-                if (box.left < 0 || box.top < 0 || box.right >= frame.cols || box.bottom >= frame.rows ||
-                    box.left >= box.right || box.top >= box.bottom) {
-                    printf("Warning: Invalid bounding box coordinates: left=%d, top=%d, right=%d, bottom=%d\n",
-                           box.left, box.top, box.right, box.bottom);
-                    continue;  // Skip this detection
-                }
-                
-                printf("Drawing detection %d: prop=%.2f, cls_id=%d, box=[%d,%d,%d,%d]\n", 
-                       i, detection.prop, detection.cls_id, box.left, box.top, box.right, box.bottom);
-                
-                // Draw bounding box
-                cv::rectangle(frame, cv::Point(box.left, box.top), cv::Point(box.right, box.bottom), color, 2);
-                
-                // Validate name pointer before using
-                const char* name_ptr = detection.name;
-                std::string obj_name = (name_ptr && strlen(name_ptr) > 0 && strlen(name_ptr) < 100) ? name_ptr : "unknown";
-                
-                // Draw label with confidence score
-                char text[256];
-                snprintf(text, sizeof(text), "%.2f", detection.prop);
-                std::string label_text = obj_name + ": " + text;
-                
-                // Make sure label is drawn inside the image
-                int baseline = 0;
-                cv::Size text_size = cv::getTextSize(label_text, cv::FONT_HERSHEY_SIMPLEX, 0.5, 2, &baseline);
-                int y_pos = std::max(box.top - 10, text_size.height);
-                
-                cv::putText(frame, label_text, cv::Point(box.left, y_pos), 
-                            cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
-            } catch (const std::exception& e) {
-                printf("Exception while drawing box %d: %s\n", i, e.what());
-            }
+        // If suppress_empty is enabled and no valid detections, draw "none" in the centre
+        static const char NONE_TEXT[] = "none";
+        int x = (canvas.cols - banner_renderer.textWidth(sizeof(NONE_TEXT) - 1)) / 2;
+        int y = (canvas.rows - banner_renderer.glyphHeight()) / 2;
+        banner_renderer.drawText(image, NONE_TEXT, x, y, RED);
+        return;
+    }
+
+    // Draw boxes on the image for detected objects
+    for (int i = 0; i < result.detections.count; i++) {
+        const auto& detection = result.detections.results[i];
+
+        // Skip detections with invalid scores or class_ids
+        if (detection.prop <= 0.0f || detection.cls_id < 0) {
+            printf("Skipping invalid detection: prop=%.2f, cls_id=%d\n", detection.prop, detection.cls_id);
+            continue;
         }
+
+        // Skip detections that are not in the selected classes
+        if (!isClassSelected(detection.cls_id, result.selected_classes)) {
+            printf("Skipping unselected class: cls_id=%d\n", detection.cls_id);
+            continue;
+        }
+
+        // Choose color based on confidence threshold
+        OverlayColor color = detection.prop >= threshold ? GREEN : GRAY;
+        const auto& box = detection.box;
+
+        // Validate box coordinates
+        if (box.left < 0 || box.top < 0 || box.right >= canvas.cols || box.bottom >= canvas.rows ||
+            box.left >= box.right || box.top >= box.bottom) {
+            printf("Warning: Invalid bounding box coordinates: left=%d, top=%d, right=%d, bottom=%d\n",
+                   box.left, box.top, box.right, box.bottom);
+            continue;  // Skip this detection
+        }
+
+        printf("Drawing detection %d: prop=%.2f, cls_id=%d, box=[%d,%d,%d,%d]\n",
+               i, detection.prop, detection.cls_id, box.left, box.top, box.right, box.bottom);
+
+        label_renderer.drawBox(image, box, color, 2);
+
+        // Validate name pointer before using
+        size_t name_length = strnlen(detection.name, sizeof(detection.name));
+        const char* name = name_length > 0 && name_length < sizeof(detection.name) ? detection.name : "unknown";
+
+        // Label with confidence score above the box, inside the image;
+        // labels keep their size on a scaled frame
+        int y = std::max(box.top - 4 - label_renderer.glyphHeight(), 0);
+        label_renderer.drawLabel(image, name, detection.prop, box.left, y, color);
     }
+}
 
-    // Convert back to BGR for OpenCV image writing
-    cv::cvtColor(frame, frame, cv::COLOR_RGB2BGR);
-    
+bool parseJpegSubsampling(const std::string& text, JpegSubsampling& subsampling) {
+    if (text == "420") {
+        subsampling = JpegSubsampling::S420;
+    } else if (text == "422") {
+        subsampling = JpegSubsampling::S422;
+    } else if (text == "444") {
+        subsampling = JpegSubsampling::S444;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool encodeJpeg(const cv::Mat& bgr, int quality, std::vector<uchar>& jpeg, JpegSubsampling subsampling) {
+    // Each thread that encodes keeps its own compressor
+    tjhandle handle = threadJpegCompressor();
+    if (!handle || bgr.empty() || bgr.type() != CV_8UC3) {
+        jpeg.clear();
+        return false;
+    }
+
+    int samp = subsampling == JpegSubsampling::S444 ? TJSAMP_444
+               : subsampling == JpegSubsampling::S422 ? TJSAMP_422
+                                                      : TJSAMP_420;
+
+    // Encode straight into the output, sized for the worst case
+    jpeg.resize(tjBufSize(bgr.cols, bgr.rows, samp));
+    unsigned char* buffer = jpeg.data();
+    unsigned long size = jpeg.size();
+    if (tjCompress2(handle, bgr.data, bgr.cols, static_cast<int>(bgr.step[0]), bgr.rows, TJPF_BGR, &buffer, &size,
+                    samp, quality, TJFLAG_NOREALLOC) < 0) {
+        printf("Failed to encode frame: %s\n", tjGetErrorStr2(handle));
+        jpeg.clear();
+        return false;
+    }
+    jpeg.resize(size);
+    return true;
+}
+
+const std::vector<uchar>& DecoratedFrame::jpeg() {
+    if (jpeg_data.empty()) {
+        encodeJpeg(bgr_frame, jpeg_quality, jpeg_data, subsampling);
+    }
+    return jpeg_data;
+}
+
+void DecoratedFrameWriter::writeFile(DecoratedFrame& frame) {
     // Write processed image to temporary file then rename atomically
     // Preserve extension for OpenCV codec detection by inserting .tmp before extension
     size_t last_dot = output_path.find_last_of('.');
     std::string temp_path;
+    std::string extension;
     if (last_dot != std::string::npos) {
-        temp_path = output_path.substr(0, last_dot) + ".tmp" + output_path.substr(last_dot);
+        extension = output_path.substr(last_dot);
+        temp_path = output_path.substr(0, last_dot) + ".tmp" + extension;
     } else {
         // No extension found, assume .jpg
+        extension = ".jpg";
         temp_path = output_path + ".tmp.jpg";
     }
-    cv::imwrite(temp_path, frame);
+
+    // JPEG files reuse the encoding shared with the sinks
+    if (strcasecmp(extension.c_str(), ".jpg") == 0 || strcasecmp(extension.c_str(), ".jpeg") == 0) {
+        const std::vector<uchar>& jpeg = frame.jpeg();
+        if (jpeg.empty()) {
+            return;
+        }
+        FILE* file = fopen(temp_path.c_str(), "wb");
+        if (!file) {
+            perror("Failed to open frame file");
+            return;
+        }
+        bool written = fwrite(jpeg.data(), 1, jpeg.size(), file) == jpeg.size();
+        if (fclose(file) != 0 || !written) {
+            printf("Failed to write frame file %s\n", temp_path.c_str());
+            return;
+        }
+    } else {
+        cv::imwrite(temp_path, frame.bgr());
+    }
     std::rename(temp_path.c_str(), output_path.c_str());
-}
\ No newline at end of file
+}
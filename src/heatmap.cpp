@@ -0,0 +1,171 @@
+#include "heatmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// A private copy of the PNG writer, so the heatmap does not depend on the
+// image utilities (and through them on RGA and turbojpeg)
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include "stb_image_write.h"
+
+// Rescale once new footprints would weigh this much more than stored ones
+static const double MAX_WEIGHT = 1e6;
+
+bool parseHeatmapFormat(const std::string& text, HeatmapFormat& format) {
+    if (text == "png") {
+        format = HeatmapFormat::PNG;
+    } else if (text == "raw") {
+        format = HeatmapFormat::Raw;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseHeatmapFootprint(const std::string& text, HeatmapFootprint& footprint) {
+    if (text == "box") {
+        footprint = HeatmapFootprint::Box;
+    } else if (text == "center") {
+        footprint = HeatmapFootprint::Center;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Heatmap::Heatmap(const HeatmapConfig& heatmap_config)
+    : config(heatmap_config),
+      decay_per_ms(heatmap_config.half_life_seconds > 0 ? std::log(2.0) / (heatmap_config.half_life_seconds * 1000.0)
+                                                        : 0.0) {
+    config.cols = std::clamp(config.cols, 1, 4096);
+    config.rows = std::clamp(config.rows, 1, 4096);
+    config.frame_width = std::max(config.frame_width, 1);
+    config.frame_height = std::max(config.frame_height, 1);
+    cells.assign(static_cast<size_t>(config.cols) * config.rows, 0.0f);
+    corners.assign(static_cast<size_t>(config.cols + 1) * (config.rows + 1), 0.0f);
+    column_sum.assign(config.cols, 0.0f);
+}
+
+void Heatmap::setFrameSize(int width, int height) {
+    config.frame_width = std::max(width, 1);
+    config.frame_height = std::max(height, 1);
+}
+
+void Heatmap::rescale() {
+    float scale = static_cast<float>(1.0 / weight);
+    for (float& cell : cells) {
+        cell *= scale;
+    }
+    weight_ms = latest_ms;
+    weight = 1.0;
+}
+
+void Heatmap::add(uint64_t timestamp_ms, const box_rect_t* boxes, size_t count) {
+    if (!started) {
+        weight_ms = latest_ms = timestamp_ms;
+        started = true;
+    }
+    // Late frames (a clock stepped back) count at the latest time
+    latest_ms = std::max(latest_ms, timestamp_ms);
+    if (decay_per_ms > 0) {
+        weight = std::exp(decay_per_ms * static_cast<double>(latest_ms - weight_ms));
+        if (weight > MAX_WEIGHT) {
+            rescale();
+        }
+    }
+    if (count == 0) {
+        return;
+    }
+
+    const int cols = config.cols;
+    const int rows = config.rows;
+    const int width = config.frame_width;
+    const int height = config.frame_height;
+    const float w = static_cast<float>(weight);
+
+    // Grid positions in integers, so box edges on cell edges land exactly
+    auto column = [&](int x, int round_up) {
+        return static_cast<int>((static_cast<int64_t>(std::clamp(x, 0, width)) * cols + round_up * (width - 1)) / width);
+    };
+    auto row = [&](int y, int round_up) {
+        return static_cast<int>((static_cast<int64_t>(std::clamp(y, 0, height)) * rows + round_up * (height - 1)) / height);
+    };
+
+    if (config.footprint == HeatmapFootprint::Center) {
+        for (size_t i = 0; i < count; i++) {
+            const box_rect_t& box = boxes[i];
+            int c = std::min(column((box.left + box.right) / 2, 0), cols - 1);
+            int r = std::min(row((box.top + box.bottom) / 2, 0), rows - 1);
+            cells[static_cast<size_t>(r) * cols + c] += w;
+        }
+        return;
+    }
+
+    // Mark each box's cells [c0, c1) x [r0, r1) at their corners
+    const size_t stride = cols + 1;
+    for (size_t i = 0; i < count; i++) {
+        const box_rect_t& box = boxes[i];
+        int c0 = std::min(column(box.left, 0), cols - 1);
+        int c1 = std::max(column(box.right, 1), c0 + 1);
+        int r0 = std::min(row(box.top, 0), rows - 1);
+        int r1 = std::max(row(box.bottom, 1), r0 + 1);
+        corners[r0 * stride + c0] += w;
+        corners[r0 * stride + c1] -= w;
+        corners[r1 * stride + c0] -= w;
+        corners[r1 * stride + c1] += w;
+    }
+
+    // Integrate: the prefix sum of the corners along each row, summed down
+    // the columns, is what each cell gained. Clears the corners on the way.
+    std::fill(column_sum.begin(), column_sum.end(), 0.0f);
+    for (int r = 0; r < rows; r++) {
+        float* corner = &corners[r * stride];
+        float* cell = &cells[static_cast<size_t>(r) * cols];
+        float across = 0.0f;
+        for (int c = 0; c < cols; c++) {
+            across += corner[c];
+            corner[c] = 0.0f;
+            column_sum[c] += across;
+            cell[c] += column_sum[c];
+        }
+        corner[cols] = 0.0f;
+    }
+    std::fill(corners.begin() + rows * stride, corners.end(), 0.0f);
+}
+
+void Heatmap::values(std::vector<float>& out) const {
+    out.resize(cells.size());
+    float scale = static_cast<float>(1.0 / weight);
+    for (size_t i = 0; i < cells.size(); i++) {
+        out[i] = cells[i] * scale;
+    }
+}
+
+static void appendToString(void* context, void* data, int size) {
+    static_cast<std::string*>(context)->append(static_cast<const char*>(data), size);
+}
+
+void Heatmap::encode(HeatmapFormat format, std::string& out) const {
+    std::vector<float> decayed;
+    values(decayed);
+    out.clear();
+
+    if (format == HeatmapFormat::Raw) {
+        HeatmapRawHeader header = {HEATMAP_RAW_MAGIC, static_cast<uint16_t>(config.cols),
+                                   static_cast<uint16_t>(config.rows), latest_ms};
+        out.resize(sizeof(header) + decayed.size() * sizeof(float));
+        memcpy(&out[0], &header, sizeof(header));
+        memcpy(&out[sizeof(header)], decayed.data(), decayed.size() * sizeof(float));
+        return;
+    }
+
+    float hottest = *std::max_element(decayed.begin(), decayed.end());
+    float scale = hottest > 0.0f ? 255.0f / hottest : 0.0f;
+    std::vector<unsigned char> gray(decayed.size());
+    for (size_t i = 0; i < decayed.size(); i++) {
+        gray[i] = static_cast<unsigned char>(std::lround(std::min(decayed[i] * scale, 255.0f)));
+    }
+    stbi_write_png_to_func(appendToString, &out, config.cols, config.rows, 1, gray.data(), config.cols);
+}
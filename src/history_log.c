@@ -0,0 +1,99 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "history_log.h"
+
+size_t history_header_init(void* buffer, const char* const* class_names, uint16_t class_count,
+                           uint16_t box_capacity, uint64_t created_ms)
+{
+    size_t size = history_header_size(class_count);
+    memset(buffer, 0, size);
+
+    history_header_t* header = (history_header_t*)buffer;
+    header->magic = HISTORY_MAGIC;
+    header->version = HISTORY_VERSION;
+    header->header_size = (uint16_t)size;
+    header->record_size = (uint32_t)history_record_size(class_count, box_capacity);
+    header->class_count = class_count;
+    header->box_capacity = box_capacity;
+    header->created_ms = created_ms;
+
+    char* names = (char*)(header + 1);
+    for (uint16_t i = 0; i < class_count; i++) {
+        strncpy(names + (size_t)i * HISTORY_CLASS_NAME_SIZE, class_names[i], HISTORY_CLASS_NAME_SIZE - 1);
+    }
+    return size;
+}
+
+int history_segment_map(history_segment_t* segment, const char* path)
+{
+    memset(segment, 0, sizeof(*segment));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return HISTORY_ERR_SYSTEM;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return HISTORY_ERR_SYSTEM;
+    }
+    if ((size_t)st.st_size < sizeof(history_header_t)) {
+        close(fd);
+        return HISTORY_ERR_FORMAT;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return HISTORY_ERR_SYSTEM;
+    }
+    // Queries scan segments front to back; start reading ahead now
+    madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+    madvise(base, (size_t)st.st_size, MADV_WILLNEED);
+
+    segment->base = (const uint8_t*)base;
+    segment->size = (size_t)st.st_size;
+    segment->header = (const history_header_t*)base;
+
+    const history_header_t* header = segment->header;
+    if (header->magic != HISTORY_MAGIC || header->version > HISTORY_VERSION ||
+        header->class_count > HISTORY_MAX_CLASSES || header->box_capacity > HISTORY_MAX_BOXES ||
+        header->header_size < history_header_size(header->class_count) || header->header_size > segment->size ||
+        header->record_size < history_record_size(header->class_count, header->box_capacity)) {
+        history_segment_unmap(segment);
+        return HISTORY_ERR_FORMAT;
+    }
+    segment->record_count = (segment->size - header->header_size) / header->record_size;
+    return 0;
+}
+
+void history_segment_unmap(history_segment_t* segment)
+{
+    if (segment->base) {
+        munmap((void*)segment->base, segment->size);
+    }
+    memset(segment, 0, sizeof(*segment));
+}
+
+const char* history_class_name(const history_segment_t* segment, uint16_t index)
+{
+    return (const char*)(segment->header + 1) + (size_t)index * HISTORY_CLASS_NAME_SIZE;
+}
+
+uint64_t history_segment_find(const history_segment_t* segment, uint64_t timestamp_ms)
+{
+    uint64_t low = 0;
+    uint64_t high = segment->record_count;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (history_segment_record(segment, middle)->timestamp_ms < timestamp_ms) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
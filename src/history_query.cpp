@@ -0,0 +1,111 @@
+#include "history_query.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+std::vector<std::string> listHistorySegments(const std::string& directory) {
+    std::vector<std::string> segments;
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.compare(0, 8, "history-") == 0 && it->path().extension() == ".odh") {
+            segments.push_back(it->path().string());
+        }
+    }
+    if (ec) {
+        std::cerr << "Failed to read history directory " << directory << ": " << ec.message() << std::endl;
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// Index of name in the result's classes, adding it if new
+static size_t classIndex(HistoryResult& result, const char* name) {
+    std::string_view class_name(name, strnlen(name, HISTORY_CLASS_NAME_SIZE));
+    for (size_t i = 0; i < result.class_names.size(); i++) {
+        if (result.class_names[i] == class_name) {
+            return i;
+        }
+    }
+    result.class_names.emplace_back(class_name);
+    for (auto& bucket : result.buckets) {
+        bucket.classes.resize(result.class_names.size());
+    }
+    return result.class_names.size() - 1;
+}
+
+bool queryHistory(const std::vector<std::string>& segments, const HistoryQuery& query, HistoryResult& result) {
+    result = HistoryResult();
+    uint64_t bucket_ms = std::max<uint64_t>(query.bucket_ms, 1);
+
+    // Records are in time order, so the bucket rarely changes between records
+    std::unordered_map<uint64_t, size_t> bucket_index;
+    uint64_t current_key = UINT64_MAX;
+    HistoryBucket* bucket = nullptr;
+
+    std::vector<size_t> class_map;
+    for (const auto& path : segments) {
+        history_segment_t segment;
+        int ret = history_segment_map(&segment, path.c_str());
+        if (ret != 0) {
+            std::cerr << "Skipping history segment " << path << ": "
+                      << (ret == HISTORY_ERR_SYSTEM ? strerror(errno) : "not a history segment") << std::endl;
+            continue;
+        }
+        result.segments++;
+        const history_header_t* header = segment.header;
+        if (header->created_ms >= query.to_ms) {
+            history_segment_unmap(&segment);
+            continue;
+        }
+
+        class_map.resize(header->class_count);
+        for (uint16_t i = 0; i < header->class_count; i++) {
+            class_map[i] = classIndex(result, history_class_name(&segment, i));
+        }
+        current_key = UINT64_MAX;  // Buckets may have been resized
+
+        for (uint64_t i = history_segment_find(&segment, query.from_ms); i < segment.record_count; i++) {
+            const history_record_t* record = history_segment_record(&segment, i);
+            if (record->timestamp_ms >= query.to_ms) {
+                break;
+            }
+
+            uint64_t key = static_cast<uint64_t>(static_cast<int64_t>(record->timestamp_ms) + query.utc_offset_ms) /
+                           bucket_ms;
+            if (key != current_key) {
+                auto [it, added] = bucket_index.emplace(key, result.buckets.size());
+                if (added) {
+                    result.buckets.emplace_back();
+                    result.buckets.back().start_ms = key * bucket_ms - query.utc_offset_ms;
+                    result.buckets.back().classes.resize(result.class_names.size());
+                }
+                bucket = &result.buckets[it->second];
+                current_key = key;
+            }
+
+            bucket->records++;
+            const uint16_t* counts = history_record_counts(record);
+            for (uint16_t c = 0; c < header->class_count; c++) {
+                HistoryClassTotals& totals = bucket->classes[class_map[c]];
+                uint16_t count = counts[c];
+                totals.sum += count;
+                totals.max = std::max<uint32_t>(totals.max, count);
+                totals.occupied += count > 0;
+            }
+        }
+        history_segment_unmap(&segment);
+    }
+
+    for (const auto& bucket_entry : result.buckets) {
+        result.records += bucket_entry.records;
+    }
+    std::sort(result.buckets.begin(), result.buckets.end(),
+              [](const HistoryBucket& a, const HistoryBucket& b) { return a.start_ms < b.start_ms; });
+    return result.segments > 0;
+}
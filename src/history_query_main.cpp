@@ -0,0 +1,155 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "history_query.h"
+
+// Command line reader for the detection history written by --history:
+// per-minute, per-hour or per-day class counts over any time range.
+
+static void usage(const char* program) {
+    printf("Usage: %s <history directory | segment files...> [--bucket minute|hour|day|<seconds>]\n", program);
+    printf("       [--from time] [--to time] [--csv]\n");
+    printf("  time: Unix seconds, or local YYYY-MM-DD[THH:MM[:SS]]\n");
+    printf("  For each bucket and class: mean detections per record, the most in one record, and\n");
+    printf("  the share of records with at least one (occupied)\n");
+}
+
+// Unix seconds or local date/time, as Unix milliseconds
+static bool parseTime(const char* text, uint64_t& ms) {
+    char* end;
+    unsigned long long seconds = strtoull(text, &end, 10);
+    if (*text && !*end) {
+        ms = seconds * 1000;
+        return true;
+    }
+    for (const char* format : {"%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d %H:%M",
+                               "%Y-%m-%d"}) {
+        struct tm local;
+        memset(&local, 0, sizeof(local));
+        const char* rest = strptime(text, format, &local);
+        if (rest && !*rest) {
+            local.tm_isdst = -1;
+            time_t t = mktime(&local);
+            if (t < 0) {
+                return false;
+            }
+            ms = static_cast<uint64_t>(t) * 1000;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseBucket(const char* text, uint64_t& ms) {
+    if (strcmp(text, "minute") == 0) {
+        ms = 60 * 1000;
+    } else if (strcmp(text, "hour") == 0) {
+        ms = 3600 * 1000;
+    } else if (strcmp(text, "day") == 0) {
+        ms = 86400 * 1000;
+    } else {
+        double seconds = atof(text);
+        if (seconds < 1.0) {
+            return false;
+        }
+        ms = static_cast<uint64_t>(seconds * 1000.0);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    HistoryQuery query;
+    bool csv = false;
+    std::vector<std::string> segments;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bucket") == 0) {
+            if (i + 1 < argc && parseBucket(argv[i + 1], query.bucket_ms)) {
+                i++;
+            } else {
+                printf("Error: --bucket flag requires minute, hour, day or a number of seconds\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) {
+            uint64_t& ms = argv[i][2] == 'f' ? query.from_ms : query.to_ms;
+            if (i + 1 < argc && parseTime(argv[i + 1], ms)) {
+                i++;
+            } else {
+                printf("Error: %s flag requires Unix seconds or YYYY-MM-DD[THH:MM[:SS]]\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            printf("Error: unknown flag %s\n", argv[i]);
+            usage(argv[0]);
+            return -1;
+        } else if (std::filesystem::is_directory(argv[i])) {
+            auto found = listHistorySegments(argv[i]);
+            segments.insert(segments.end(), found.begin(), found.end());
+        } else {
+            segments.push_back(argv[i]);
+        }
+    }
+
+    // Buckets start on local minutes, hours and days
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    query.utc_offset_ms = static_cast<int64_t>(local.tm_gmtoff) * 1000;
+
+    auto start = std::chrono::steady_clock::now();
+    HistoryResult result;
+    if (!queryHistory(segments, query, result)) {
+        fprintf(stderr, "No history segments to read\n");
+        return 1;
+    }
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const char* time_format = query.bucket_ms % 86400000 == 0 ? "%Y-%m-%d"
+                              : query.bucket_ms % 60000 == 0 ? "%Y-%m-%d %H:%M"
+                                                             : "%Y-%m-%d %H:%M:%S";
+    if (csv) {
+        printf("bucket,records");
+        for (const auto& name : result.class_names) {
+            printf(",%s_mean,%s_max,%s_occupied", name.c_str(), name.c_str(), name.c_str());
+        }
+        printf("\n");
+    } else {
+        printf("%-19s %8s", "bucket", "records");
+        for (const auto& name : result.class_names) {
+            printf("  %14.14s mean   max occupied", name.c_str());
+        }
+        printf("\n");
+    }
+
+    for (const auto& bucket : result.buckets) {
+        time_t bucket_start = static_cast<time_t>(bucket.start_ms / 1000);
+        struct tm bucket_time;
+        localtime_r(&bucket_start, &bucket_time);
+        char label[32];
+        strftime(label, sizeof(label), time_format, &bucket_time);
+
+        printf(csv ? "%s,%llu" : "%-19s %8llu", label, static_cast<unsigned long long>(bucket.records));
+        for (const auto& totals : bucket.classes) {
+            double mean = bucket.records ? static_cast<double>(totals.sum) / bucket.records : 0.0;
+            double occupied = bucket.records ? 100.0 * totals.occupied / bucket.records : 0.0;
+            printf(csv ? ",%.3f,%u,%.1f" : "  %19.2f %5u %7.1f%%", mean, totals.max, occupied);
+        }
+        printf("\n");
+    }
+
+    fprintf(stderr, "%llu records from %zu segments in %.1f ms\n", static_cast<unsigned long long>(result.records),
+            result.segments, elapsed_ms);
+    return 0;
+}
@@ -48,6 +48,28 @@ static int image_file_filter(const struct dirent *entry)
     return 0;
 }
 
+int list_image_files(const char* dir, char*** out_paths)
+{
+    struct dirent** entries = NULL;
+    int count = scandir(dir, &entries, image_file_filter, alphasort);
+    if (count < 0) {
+        printf("scandir %s fail!\n", dir);
+        return -1;
+    }
+
+    char** paths = (char**)malloc((count > 0 ? count : 1) * sizeof(char*));
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(dir) + strlen(entries[i]->d_name) + 2;
+        paths[i] = (char*)malloc(len);
+        snprintf(paths[i], len, "%s/%s", dir, entries[i]->d_name);
+        free(entries[i]);
+    }
+    free(entries);
+
+    *out_paths = paths;
+    return count;
+}
+
 static int read_image_jpeg(const char* path, image_buffer_t* image)
 {
     FILE* jpegFile = NULL;
@@ -690,11 +712,20 @@ int convert_image(image_buffer_t* src_img, image_buffer_t* dst_img, image_rect_t
 }
 
 int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_image, letterbox_t* letterbox, char color)
+{
+    return convert_image_with_letterbox_roi(src_image, NULL, dst_image, letterbox, color);
+}
+
+int convert_image_with_letterbox_roi(image_buffer_t* src_image, image_rect_t* roi, image_buffer_t* dst_image, letterbox_t* letterbox, char color)
 {
     int ret = 0;
     int allow_slight_change = 1;
     int src_w = src_image->width;
     int src_h = src_image->height;
+    if (roi != NULL) {
+        src_w = roi->right - roi->left + 1;
+        src_h = roi->bottom - roi->top + 1;
+    }
     int dst_w = dst_image->width;
     int dst_h = dst_image->height;
     int resize_w = dst_w;
@@ -712,6 +743,9 @@ int convert_image_with_letterbox(image_buffer_t* src_image, image_buffer_t* dst_
     src_box.top = 0;
     src_box.right = src_image->width - 1;
     src_box.bottom = src_image->height - 1;
+    if (roi != NULL) {
+        src_box = *roi;
+    }
 
     image_rect_t dst_box;
     dst_box.left = 0;
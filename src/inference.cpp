@@ -3,6 +3,7 @@
 #include <thread>
 
 #include "inference.h"
+#include "startup_timeline.h"
 #include "yolox.h"
 #include "postprocess.h"
 
@@ -64,8 +65,37 @@ InferenceResult MLInferenceThread::runInference(cv::Mat& cap) {
     object_detect_result_list results;
     memset(&results, 0, sizeof(results));  // Initialize results to avoid uninitialized data
     
-    int ret = inference_yolox_model(rknn_app_ctx.get(), &image, &results, confidence_threshold);
+    // Hold a reference for the whole frame, and count it as a user, so a
+    // concurrent swapModel() cannot release the contexts underneath us
+    std::shared_ptr<NpuContextPool> pool;
+    uint32_t model_id;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        pool = npu_pool;
+        model_id = model_generation;
+        pool_users++;
+    }
+
+    int ret;
+    if (tiled_inference) {
+        ret = tiled_inference->run(*pool, &image, &results, confidence_threshold);
+    } else {
+        ret = pool->infer(&image, &results, confidence_threshold);
+    }
+
+    // Drop the reference before counting out, so a replaced pool is released
+    // by swapModel() rather than on this thread
+    pool.reset();
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (model_id == model_generation) {
+            pool_users--;
+        } else if (--retired_users == 0) {
+            pool_drained.notify_all();
+        }
+    }
     if (ret != 0) {
+        failed_frames++;
         printf("inference_yolox_model fail! ret=%d\n", ret);
         return final_result;
     }
@@ -76,10 +106,15 @@ InferenceResult MLInferenceThread::runInference(cv::Mat& cap) {
     final_result.selected_classes = selected_classes;  // Pass selected classes along
     final_result.class_mapping = class_mapping;  // Pass class mapping along
     final_result.confidence_threshold = confidence_threshold;  // Pass confidence threshold along
+    final_result.frame_id = ++frame_sequence;
+    final_result.model_id = model_id;
+    final_result.frame_width = cap.cols;
+    final_result.frame_height = cap.rows;
+    final_result.shareView();  // Formatters downstream share one pass over the detections
     printf("inference_yolox_model success! count=%d\n", results.count);
 
     frames++;
-    printf("Processed frame %d\n", frames);
+    printf("Processed frame %d\n", frames.load());
     return final_result;
 }
 
@@ -92,42 +127,129 @@ MLInferenceThread::MLInferenceThread(
         std::shared_ptr<FrameWriter> writer,
         const std::vector<int>& selected_classes,
         const std::unordered_map<std::string, int>& class_mapping,
-        float confidence_threshold)
-    : resultQueue(queue), running(isRunning), target_fps(target_fps), frameWriter(writer), 
+        float confidence_threshold,
+        const InferenceConfig& config)
+    : resultQueue(queue), running(isRunning), target_fps(target_fps), config(config), frameWriter(writer), 
       selected_classes(selected_classes), class_mapping(class_mapping), confidence_threshold(confidence_threshold) {
     
     // Store pointer to source name (argv remains valid)
     this->source_name = source_name;
 
-    // Initialize post-processing
+    // Load the model off this thread: the .rknn file is large and the NPU
+    // pays its lazy initialization on the first inference, so both are done
+    // while the caller builds the rest of the pipeline and the camera opens
+    std::string path = model_path;
+    int num_contexts = config.npu_contexts;
+    pending_pool = std::async(std::launch::async, [path, num_contexts]() {
+        auto& timeline = StartupTimeline::instance();
+        timeline.mark("model load started");
+        auto pool = std::make_shared<NpuContextPool>(path.c_str(), num_contexts);
+        if (!pool->isValid()) {
+            printf("Failed to initialize model from %s\n", path.c_str());
+            return pool;
+        }
+        timeline.mark("model loaded");
+        if (pool->warmUp() != 0) {
+            printf("Warning: warm-up inference failed, first frame will be slower\n");
+        }
+        timeline.mark("model warmed up");
+        return pool;
+    });
+
+    // Initialize post-processing (labels) alongside the model load
     init_post_process();
-    
-    // Create and initialize the model with dynamic allocation
-    rknn_app_ctx = std::make_unique<rknn_app_context_t>();
-    memset(rknn_app_ctx.get(), 0, sizeof(rknn_app_context_t));
-    auto ret = init_yolox_model(model_path, rknn_app_ctx.get());
-       if (ret != 0) {
-        printf("init_yolox_model fail! ret=%d model_path=%s\n", ret, model_path);
-        // return -1;
-    }
+    StartupTimeline::instance().mark("labels loaded");
 
     printf("done initializing MLInferenceThread\n");
 }
 
+bool MLInferenceThread::waitForModel() {
+    std::call_once(model_ready_once, [this] {
+        auto pool = pending_pool.get();
+        model_ready = pool->isValid();
+        if (model_ready && config.tiling.enabled()) {
+            tiled_inference = std::make_unique<TiledInference>(config.tiling, pool->size());
+        }
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        npu_pool = std::move(pool);
+    });
+    return model_ready;
+}
+
 MLInferenceThread::~MLInferenceThread() {
-    if (rknn_app_ctx) {
-        auto ret = release_yolox_model(rknn_app_ctx.get());
-        if (ret != 0) {
-            printf("release_yolox_model fail! ret=%d\n", ret);
-        }  
-    }
+    // Never leave the background load running past the destructor
+    waitForModel();
+
+    // Tiles may still be queued on the pool's contexts
+    tiled_inference.reset();
+    npu_pool.reset();
 
     running = false;
     resultQueue.signalShutdown();
 }
 
+bool MLInferenceThread::swapModel(const std::string& model_path) {
+    std::lock_guard<std::mutex> swap_lock(swap_mutex);
+    // Otherwise the initial load could land after, and override, the swap
+    waitForModel();
+    auto start = std::chrono::steady_clock::now();
+    int frames_at_start = frames;
+    int failed_at_start = failed_frames;
+
+    printf("Loading replacement model %s\n", model_path.c_str());
+    auto candidate = std::make_shared<NpuContextPool>(model_path.c_str(), config.npu_contexts);
+    if (!candidate->isValid()) {
+        printf("Model swap failed: could not load %s, keeping current model\n", model_path.c_str());
+        return false;
+    }
+    if (candidate->warmUp() != 0) {
+        printf("Model swap failed: warm-up inference on %s failed, keeping current model\n", model_path.c_str());
+        return false;
+    }
+    auto loaded = std::chrono::steady_clock::now();
+
+    std::shared_ptr<NpuContextPool> previous;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        previous = std::move(npu_pool);
+        npu_pool = candidate;
+        model_generation++;
+        retired_users = pool_users;
+        pool_users = 0;
+    }
+    auto switched = std::chrono::steady_clock::now();
+
+    // Let the frames still running on the old contexts finish, then release
+    // them here rather than on the inference thread
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex);
+        pool_drained.wait(lock, [this] { return retired_users == 0; });
+    }
+    previous.reset();
+    auto drained = std::chrono::steady_clock::now();
+
+    auto ms = [](auto from, auto to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+    printf("Model swap complete: %s (load+warm-up %.0f ms, switch %.2f ms, drain+release %.0f ms); "
+           "%d frames served by previous model meanwhile, %d dropped\n",
+           model_path.c_str(), ms(start, loaded), ms(loaded, switched), ms(switched, drained),
+           frames - frames_at_start, failed_frames - failed_at_start);
+    return true;
+}
+
+MLInferenceThread::FrameStatus MLInferenceThread::inferFrame(cv::Mat& img, InferenceResult& result) {
+    if (!waitForModel()) {
+        return FrameStatus::ModelNotLoaded;
+    }
+    result = runInference(img);
+    // Only frames that were inferred get a sequence number
+    return result.frame_id != 0 ? FrameStatus::Ok : FrameStatus::Failed;
+}
+
 void MLInferenceThread::runSingleInference() {
     printf("Running single inference on file: %s\n", source_name);
+    auto& timeline = StartupTimeline::instance();
     
     // Load image from file
     cv::Mat img = cv::imread(source_name);
@@ -138,9 +260,18 @@ void MLInferenceThread::runSingleInference() {
     }
     
     printf("Loaded image %dx%d from file: %s\n", img.cols, img.rows, source_name);
+    timeline.mark("image loaded");
+
+    if (!waitForModel()) {
+        running = false;
+        return;
+    }
+    timeline.mark("pipeline ready");
     
     // Run inference on the loaded image
     InferenceResult result = runInference(img);
+    timeline.mark(result.detections.count > 0 ? "first detection" : "first frame inferred (no detections)");
+    timeline.report();
     
     // Push result to queue for publisher to process
     resultQueue.push(result);
@@ -154,7 +285,11 @@ void MLInferenceThread::runSingleInference() {
 }
 
 void MLInferenceThread::operator()() {
+    auto& timeline = StartupTimeline::instance();
+
     // Create local capture object, just like in do_test()
+    // (the model is still loading in the background at this point)
+    timeline.mark("camera open started");
     cv::VideoCapture capture;
     capture.open(source_name, cv::CAP_V4L2);
 
@@ -165,11 +300,21 @@ void MLInferenceThread::operator()() {
     }
     
     // Set camera properties
-    printf("Setting camera resolution to 640x640...\n");
-    capture.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-    capture.set(cv::CAP_PROP_FRAME_HEIGHT, 640);
+    printf("Setting camera resolution to %dx%d...\n", config.capture_width, config.capture_height);
+    capture.set(cv::CAP_PROP_FRAME_WIDTH, config.capture_width);
+    capture.set(cv::CAP_PROP_FRAME_HEIGHT, config.capture_height);
     
     printf("Camera initialized successfully\n");
+    timeline.mark("camera opened");
+
+    // Only start producing results once the model is loaded and warm
+    if (!waitForModel()) {
+        running = false;
+        return;
+    }
+    timeline.mark("pipeline ready");
+    bool first_frame = true;
+    bool first_detection = true;
     
     while (running) {
         if (!capture.isOpened()) {
@@ -225,6 +370,15 @@ void MLInferenceThread::operator()() {
             
             // Run inference on the copied frame
             result = runInference(frame_copy);
+            if (first_frame) {
+                timeline.mark("first frame inferred");
+                first_frame = false;
+            }
+            if (first_detection && result.detections.count > 0) {
+                timeline.mark("first detection");
+                timeline.report();
+                first_detection = false;
+            }
             
             // Optionally write decorated frame using injected FrameWriter
             if (frameWriter) {
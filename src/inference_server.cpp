@@ -0,0 +1,252 @@
+#include "inference_server.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+static const int POLL_INTERVAL_MS = 500;
+static const size_t MAX_CONNECTIONS = 16;
+static const size_t MAX_REQUEST_LINE = 4096;
+static const long MAX_IMAGE_BYTES = 32 * 1024 * 1024;
+
+// Wait for fd to become readable, giving up when the pipeline shuts down
+static bool waitReadable(int fd, std::atomic<bool>& running) {
+    while (running) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready > 0) {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Append whatever is available on fd to buffered; false on EOF or error
+static bool fill(int fd, std::string& buffered, std::atomic<bool>& running) {
+    if (!waitReadable(fd, running)) {
+        return false;
+    }
+    char chunk[16384];
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+        return false;
+    }
+    buffered.append(chunk, n);
+    return true;
+}
+
+static bool readLine(int fd, std::string& buffered, std::string& line, std::atomic<bool>& running) {
+    size_t end;
+    while ((end = buffered.find('\n')) == std::string::npos) {
+        if (buffered.size() > MAX_REQUEST_LINE || !fill(fd, buffered, running)) {
+            return false;
+        }
+    }
+    line = buffered.substr(0, end);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    buffered.erase(0, end + 1);
+    return true;
+}
+
+static bool readExact(int fd, std::string& buffered, size_t length, std::vector<unsigned char>& out,
+                      std::atomic<bool>& running) {
+    out.reserve(length);
+    while (buffered.size() < length) {
+        if (!fill(fd, buffered, running)) {
+            return false;
+        }
+    }
+    out.assign(buffered.begin(), buffered.begin() + length);
+    buffered.erase(0, length);
+    return true;
+}
+
+static bool writeAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+static std::string errorMessage(const std::string& message) {
+    json j;
+    j["error"] = message;
+    return j.dump();
+}
+
+InferenceServer::InferenceServer(
+        const std::string& socket_path,
+        MLInferenceThread& inference,
+        std::shared_ptr<MessageFormatter> formatter,
+        std::atomic<bool>& isRunning)
+    : socket_path(socket_path), inference(inference), formatter(formatter), running(isRunning) {
+}
+
+InferenceServer::~InferenceServer() {
+    reapConnections(true);
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+bool InferenceServer::listen() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        printf("Inference socket path too long: %s\n", socket_path.c_str());
+        return false;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return false;
+    }
+
+    // A stale socket left by a previous run would make bind() fail
+    unlink(socket_path.c_str());
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, static_cast<int>(MAX_CONNECTIONS)) < 0) {
+        perror("bind/listen");
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void InferenceServer::reapConnections(bool wait_all) {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (wait_all || (*it)->done) {
+            (*it)->thread.join();
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void InferenceServer::operator()() {
+    if (!listen()) {
+        printf("Inference server disabled\n");
+        return;
+    }
+    printf("Inference server listening on %s\n", socket_path.c_str());
+
+    while (running) {
+        reapConnections(false);
+        if (!waitReadable(listen_fd, running)) {
+            continue;
+        }
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                perror("accept");
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        if (connections.size() >= MAX_CONNECTIONS) {
+            writeAll(fd, errorMessage("too many connections") + "\n");
+            close(fd);
+            continue;
+        }
+        auto connection = std::make_unique<Connection>();
+        Connection* raw = connection.get();
+        connection->thread = std::thread(&InferenceServer::serve, this, fd, raw);
+        connections.push_back(std::move(connection));
+    }
+
+    reapConnections(true);
+    printf("Inference server stopped after %ld requests\n", requests_served.load());
+}
+
+void InferenceServer::serve(int fd, Connection* connection) {
+    std::string buffered;
+    std::string request;
+    while (running && readLine(fd, buffered, request, running)) {
+        if (request.empty()) {
+            continue;
+        }
+        std::string response;
+        if (!handleRequest(fd, request, buffered, response) || !writeAll(fd, response + "\n")) {
+            break;
+        }
+    }
+    close(fd);
+    connection->done = true;
+}
+
+bool InferenceServer::handleRequest(int fd, const std::string& request, std::string& buffered,
+                                    std::string& response) {
+    auto start = std::chrono::steady_clock::now();
+    cv::Mat img;
+
+    if (request.compare(0, 5, "PATH ") == 0) {
+        std::string path = request.substr(5);
+        img = cv::imread(path);
+        if (img.empty()) {
+            response = errorMessage("cannot read image " + path);
+            return true;
+        }
+    } else if (request.compare(0, 5, "JPEG ") == 0) {
+        long length = atol(request.c_str() + 5);
+        if (length <= 0 || length > MAX_IMAGE_BYTES) {
+            // The payload cannot be skipped reliably, so drop the connection
+            printf("Inference server: invalid image length in '%s'\n", request.c_str());
+            return false;
+        }
+        std::vector<unsigned char> data;
+        if (!readExact(fd, buffered, length, data, running)) {
+            return false;
+        }
+        img = cv::imdecode(data, cv::IMREAD_COLOR);
+        if (img.empty()) {
+            response = errorMessage("cannot decode image");
+            return true;
+        }
+    } else {
+        response = errorMessage("unknown request, expected PATH <path> or JPEG <length>");
+        return true;
+    }
+
+    InferenceResult result;
+    MLInferenceThread::FrameStatus status = inference.inferFrame(img, result);
+    if (status != MLInferenceThread::FrameStatus::Ok) {
+        // Not an empty result: the client must be able to tell a failure from no detections
+        response = errorMessage(status == MLInferenceThread::FrameStatus::ModelNotLoaded ? "model not loaded"
+                                                                                          : "inference failed");
+        return true;
+    }
+    response = formatter->formatMessage(result);
+    requests_served++;
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Inference server: %dx%d image, %d detections in %.1f ms\n", img.cols, img.rows,
+           result.detections.count, ms);
+    return true;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <sys/time.h>
@@ -10,10 +11,20 @@
 #include <cstring>
 #include <signal.h>
 
+#include "batch.h"
+#include "clip_recorder.h"
+#include "crop_sink.h"
+#include "frame_writer.h"
 #include "image_utils.h"
 #include "inference.h"
+#include "inference_server.h"
+#include "model_watcher.h"
+#include "preview_server.h"
 #include "publisher.h"
+#include "publisher_hub.h"
 #include "queue.h"
+#include "redaction.h"
+#include "startup_timeline.h"
 #include "transport.h"
 #include "utils.h"
 #include "yolox.h"
@@ -25,6 +36,13 @@
 
 std::atomic<bool> running{true};
 ThreadSafeQueue<InferenceResult> resultQueue(1);
+ModelWatcher* modelWatcher = nullptr;
+
+void reloadSignalHandler(int signum) {
+    if (modelWatcher) {
+        modelWatcher->requestReload();
+    }
+}
 
 void signalHandler(int signum) {
     std::cout << "Interrupt signal (" << signum << ") received.\n";
@@ -35,12 +53,51 @@ void signalHandler(int signum) {
 }
 
 int main(int argc, char **argv) {
+    // Start the clock for the startup timeline
+    auto& timeline = StartupTimeline::instance();
+
     char *model_name = NULL;
     char *source_name = NULL;
     bool suppress_empty = false;
     bool is_file_input = false;
     std::string classes_str;
     float confidence_threshold = 0.3f; // Default confidence threshold
+    InferenceConfig inference_config;
+    bool npu_contexts_set = false;
+    bool capture_size_set = false;
+    bool watch_model = false;
+    std::string model_control_path;
+    std::string serve_socket_path;
+    bool batch_mode = false;
+    double publish_rate = 1.0;
+    ChangePolicy change_policy;
+    int binary_udp_port = 0;
+    std::vector<UDPDestination> binary_udp_destinations;
+    int binary_keyframe_interval = 30;
+    std::string shm_ring_name;
+    std::string frame_shm_name;
+    ShmFrameFormat frame_shm_format = ShmFrameFormat::JPEG;
+    bool frame_file = true;
+    FrameOutputConfig frame_output;
+    FileDurability results_durability = FileDurability::Auto;
+    bool preview_enabled = false;
+    PreviewConfig preview_config;
+    std::string history_dir;
+    double history_rate = 1.0;
+    int history_boxes = 0;
+    HistoryConfig history_config;
+    int analytics_udp_port = 0;
+    std::vector<double> analytics_windows = {10, 60, 900, 3600};
+    std::string zones_path;
+    int zones_udp_port = 0;
+    std::string heatmap_path;
+    double heatmap_interval = 60.0;
+    HeatmapConfig heatmap_config;
+    ClipConfig clip_config;
+    CropConfig crop_config;
+    std::string redact_classes_str;
+    RedactionConfig redaction_config;
+    BatchConfig batch_config;
     
     if (argc < 3) {
         printf("Usage: %s <rknn model> <source> [--suppress-empty] [--classes class1,class2,...] [--confidence-threshold value]\n", argv[0]);
@@ -48,15 +105,84 @@ int main(int argc, char **argv) {
         printf("  --suppress-empty: suppress output when no detections (optional)\n");
         printf("  --classes: comma-separated list of class names to detect (optional)\n");
         printf("  --confidence-threshold: confidence threshold for detections (0.0-1.0, default: 0.3)\n");
+        printf("  --npu-contexts: number of parallel NPU contexts (default: 1, or 3 when tiling)\n");
+        printf("  --capture-size: camera resolution WxH (default: 640x640, or 1920x1080 when tiling)\n");
+        printf("  --tile-grid: split frames into a CxR grid of overlapping tiles, e.g. 3x2 (optional)\n");
+        printf("  --tile-overlap: fraction of each tile shared with its neighbour (default: 0.2)\n");
+        printf("  --tile-full-frame: also run the full frame alongside the tiles (optional)\n");
+        printf("  --watch-model: swap in the model live when the model file changes (optional)\n");
+        printf("  --model-control: file to which a new model path can be written to swap models live (optional)\n");
+        printf("  SIGHUP reloads the current model without restarting the pipeline\n");
+        printf("  --serve: answer inference requests on a Unix socket, e.g. /tmp/objdet.sock (optional;\n");
+        printf("           <source> may then be omitted to run only the server)\n");
+        printf("  --batch: process every image in the <source> directory, or every frame of a video file\n");
+        printf("  --batch-output: JSONL results file for --batch (default: /tmp/batch_results.jsonl)\n");
+        printf("  --coco: also write detections for --batch as a COCO results file (optional)\n");
+        printf("  --batch-workers: decode/post-process threads for --batch (default: CPU count)\n");
+        printf("  --publish-rate: messages per second on /tmp/results.json and UDP ports 5000/5002, e.g. 0.5 or 10 (default: 1)\n");
+        printf("  --on-change: send only when counts or boxes change (at most --publish-rate), plus heartbeats (optional)\n");
+        printf("  --heartbeat: longest gap between --on-change messages in seconds (default: 30)\n");
+        printf("  --change-hysteresis: consecutive frames a change must last before it is sent (default: 1)\n");
+        printf("  --binary-udp: also stream every box in the binary wire format to this UDP port (optional)\n");
+        printf("  --binary-udp-dest: binary stream destinations, ip:port[,ip:port...]; multicast groups allowed (optional)\n");
+        printf("  --binary-keyframe-interval: binary messages per key frame, delta frames between (default: 30, 1: no deltas)\n");
+        printf("  --shm-ring: also publish full JSON results at camera rate to this shared memory ring, e.g. /objdet-results (optional)\n");
+        printf("  --frame-shm: also publish decorated frames to this shared memory triple buffer, e.g. /objdet-frames (optional)\n");
+        printf("  --frame-shm-format: rgb, nv12 or jpeg (default: jpeg)\n");
+        printf("  --file-durability: fsync policy for /tmp/results.json: auto, none, rename or periodic (default: auto,\n");
+        printf("                     none on tmpfs and rename elsewhere)\n");
+        printf("  --no-frame-file: do not write decorated frames to /tmp/output.jpg (optional)\n");
+        printf("  --frame-size: draw and encode decorated frames scaled down to fit WxH, keeping the aspect ratio, e.g. 640x360\n");
+        printf("                (default: capture size)\n");
+        printf("  --frame-quality: JPEG quality of decorated frames, 1-100 (default: 95)\n");
+        printf("  --frame-subsampling: JPEG chroma subsampling of decorated frames: 420, 422 or 444 (default: 420)\n");
+        printf("  --preview-http: serve an MJPEG preview of decorated frames on [ip:]port, e.g. 8080 (optional; default ip 127.0.0.1)\n");
+        printf("  --preview-fps: most preview frames per second (default: 10)\n");
+        printf("  --preview-size: largest preview resolution WxH, e.g. 640x360; frames keep their aspect ratio and are never scaled up (default: frame size)\n");
+        printf("  --history: keep a history of class counts in this directory, e.g. /storage/sd/objdet-history (optional;\n");
+        printf("             read it with history_query)\n");
+        printf("  --history-rate: history records per second (default: 1)\n");
+        printf("  --history-boxes: also keep up to this many boxes per record (default: 0)\n");
+        printf("  --history-budget: most disk used by the history in MB; the oldest is deleted (default: 256)\n");
+        printf("  --analytics-udp: also send rolling per-class statistics as JSON to this UDP port, at --publish-rate (optional)\n");
+        printf("  --analytics-windows: statistics windows, e.g. 10s,1m,15m,1h (default: 10s,1m,15m,1h)\n");
+        printf("  --zones: JSON file of named polygons to count detections in (optional)\n");
+        printf("  --zones-udp: send per-zone counts as JSON to this UDP port, at --publish-rate (default: 5012 with --zones)\n");
+        printf("  --heatmap: write a heatmap of where detections have been to this file, .png or raw floats (optional)\n");
+        printf("  --heatmap-interval: seconds between heatmap writes (default: 60)\n");
+        printf("  --heatmap-grid: heatmap size in cells, e.g. 96x54 (default: 96x54)\n");
+        printf("  --heatmap-half-life: seconds for old detections to fade to half; 0 never fades (default: 0)\n");
+        printf("  --heatmap-footprint: box (every cell a box covers) or center (default: box)\n");
+        printf("  --clips: record clips of the decorated frames around detection events into this directory (optional)\n");
+        printf("  --clip-trigger: rules that start a clip, e.g. person>0,car>=2 (default: person>0)\n");
+        printf("  --clip-pre: seconds kept from before the trigger (default: 5)\n");
+        printf("  --clip-post: seconds kept after the triggers last held (default: 5)\n");
+        printf("  --clip-format: avi (Motion JPEG) or frames (a directory of JPEGs) (default: avi)\n");
+        printf("  --clip-budget: most disk used by clips in MB; the oldest are deleted (default: 1024)\n");
+        printf("  --crops: write JPEG crops of the detected objects into this directory (optional)\n");
+        printf("  --crops-shm: publish the crops into this shared memory ring instead, e.g. /objdet-crops (optional)\n");
+        printf("  --crop-rate: most crops per second for each class (default: 2)\n");
+        printf("  --crop-size: longest side of a crop in pixels (default: 192)\n");
+        printf("  --crop-padding: added on each side of a box, as a fraction of its size (default: 0.15)\n");
+        printf("  --crop-limit: most crops kept in the directory; the oldest are deleted (default: 2000)\n");
+        printf("  --redact: comma-separated classes to hide in every exported frame, e.g. person (optional)\n");
+        printf("  --redact-mode: pixelate or blur (default: pixelate)\n");
+        printf("  --redact-strength: block size or blur radius in pixels; 0 scales with each box (default: 0)\n");
+        printf("  --redact-padding: added on each side of a box, as a fraction of its size (default: 0.1)\n");
         return -1;
     }
 
     // The path where the model is located
     model_name = (char *)argv[1];
-    source_name = argv[2];
+    // The source is optional when serving requests only
+    int first_flag = 2;
+    if (strncmp(argv[2], "--", 2) != 0) {
+        source_name = argv[2];
+        first_flag = 3;
+    }
     
     // Parse optional flags
-    for (int i = 3; i < argc; i++) {
+    for (int i = first_flag; i < argc; i++) {
         if (strcmp(argv[i], "--suppress-empty") == 0) {
             suppress_empty = true;
             printf("Suppress-empty mode enabled\n");
@@ -88,10 +214,597 @@ int main(int argc, char **argv) {
                 printf("Error: --confidence-threshold flag requires a value\n");
                 return -1;
             }
+        } else if (strcmp(argv[i], "--npu-contexts") == 0) {
+            if (i + 1 < argc) {
+                inference_config.npu_contexts = atoi(argv[i + 1]);
+                if (inference_config.npu_contexts < 1) {
+                    printf("Error: --npu-contexts must be at least 1\n");
+                    return -1;
+                }
+                npu_contexts_set = true;
+                i++;
+            } else {
+                printf("Error: --npu-contexts flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--capture-size") == 0) {
+            if (i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &inference_config.capture_width,
+                                       &inference_config.capture_height) == 2 &&
+                inference_config.capture_width > 0 && inference_config.capture_height > 0) {
+                capture_size_set = true;
+                i++;
+            } else {
+                printf("Error: --capture-size flag requires a value like 1920x1080\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--tile-grid") == 0) {
+            if (i + 1 < argc && parseTileGrid(argv[i + 1], inference_config.tiling)) {
+                printf("Tile grid set to: %dx%d\n", inference_config.tiling.cols, inference_config.tiling.rows);
+                i++;
+            } else {
+                printf("Error: --tile-grid flag requires a value like 3x2\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--tile-overlap") == 0) {
+            if (i + 1 < argc) {
+                inference_config.tiling.overlap = atof(argv[i + 1]);
+                if (inference_config.tiling.overlap < 0.0f || inference_config.tiling.overlap >= 0.9f) {
+                    printf("Error: tile overlap must be between 0.0 and 0.9\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --tile-overlap flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--tile-full-frame") == 0) {
+            inference_config.tiling.full_frame_pass = true;
+        } else if (strcmp(argv[i], "--watch-model") == 0) {
+            watch_model = true;
+        } else if (strcmp(argv[i], "--model-control") == 0) {
+            if (i + 1 < argc) {
+                model_control_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --model-control flag requires a file path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            if (i + 1 < argc) {
+                serve_socket_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --serve flag requires a socket path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--publish-rate") == 0) {
+            if (i + 1 < argc) {
+                publish_rate = atof(argv[i + 1]);
+                if (publish_rate <= 0.0 || publish_rate > 1000.0) {
+                    printf("Error: --publish-rate must be between 0 and 1000 messages per second\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --publish-rate flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--on-change") == 0) {
+            change_policy.enabled = true;
+        } else if (strcmp(argv[i], "--heartbeat") == 0) {
+            if (i + 1 < argc) {
+                change_policy.heartbeat_seconds = atof(argv[i + 1]);
+                if (change_policy.heartbeat_seconds <= 0.0) {
+                    printf("Error: --heartbeat must be a positive number of seconds\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --heartbeat flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--change-hysteresis") == 0) {
+            if (i + 1 < argc) {
+                change_policy.hysteresis = atoi(argv[i + 1]);
+                if (change_policy.hysteresis < 1) {
+                    printf("Error: --change-hysteresis must be at least 1\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --change-hysteresis flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--binary-udp") == 0) {
+            if (i + 1 < argc) {
+                binary_udp_port = atoi(argv[i + 1]);
+                if (binary_udp_port < 1 || binary_udp_port > 65535) {
+                    printf("Error: --binary-udp must be a port number\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --binary-udp flag requires a port\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--binary-udp-dest") == 0) {
+            if (i + 1 < argc) {
+                if (!parseUDPDestinations(argv[i + 1], binary_udp_destinations)) {
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --binary-udp-dest flag requires a destination list\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--shm-ring") == 0) {
+            if (i + 1 < argc) {
+                shm_ring_name = argv[i + 1];
+                if (shm_ring_name.size() < 2 || shm_ring_name[0] != '/' ||
+                    shm_ring_name.find('/', 1) != std::string::npos) {
+                    printf("Error: --shm-ring name must be a single '/'-prefixed name, e.g. /objdet-results\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --shm-ring flag requires a name\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--frame-shm") == 0) {
+            if (i + 1 < argc) {
+                frame_shm_name = argv[i + 1];
+                if (frame_shm_name.size() < 2 || frame_shm_name[0] != '/' ||
+                    frame_shm_name.find('/', 1) != std::string::npos) {
+                    printf("Error: --frame-shm name must be a single '/'-prefixed name, e.g. /objdet-frames\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --frame-shm flag requires a name\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--frame-shm-format") == 0) {
+            if (i + 1 < argc) {
+                if (!parseShmFrameFormat(argv[i + 1], frame_shm_format)) {
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --frame-shm-format flag requires rgb, nv12 or jpeg\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--file-durability") == 0) {
+            if (i + 1 < argc) {
+                if (!parseFileDurability(argv[i + 1], results_durability)) {
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --file-durability flag requires auto, none, rename or periodic\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--no-frame-file") == 0) {
+            frame_file = false;
+        } else if (strcmp(argv[i], "--frame-size") == 0) {
+            if (i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &frame_output.width, &frame_output.height) == 2 &&
+                frame_output.width > 0 && frame_output.height > 0) {
+                i++;
+            } else {
+                printf("Error: --frame-size flag requires a value like 640x360\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--frame-quality") == 0) {
+            if (i + 1 < argc) {
+                frame_output.jpeg_quality = atoi(argv[i + 1]);
+                if (frame_output.jpeg_quality < 1 || frame_output.jpeg_quality > 100) {
+                    printf("Error: --frame-quality must be between 1 and 100\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --frame-quality flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--frame-subsampling") == 0) {
+            if (i + 1 < argc && parseJpegSubsampling(argv[i + 1], frame_output.subsampling)) {
+                i++;
+            } else {
+                printf("Error: --frame-subsampling flag requires 420, 422 or 444\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--preview-http") == 0) {
+            if (i + 1 < argc && parsePreviewAddress(argv[i + 1], preview_config)) {
+                preview_enabled = true;
+                i++;
+            } else {
+                printf("Error: --preview-http flag requires a port or ip:port\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--preview-fps") == 0) {
+            if (i + 1 < argc) {
+                preview_config.fps = atof(argv[i + 1]);
+                if (preview_config.fps <= 0.0 || preview_config.fps > 60.0) {
+                    printf("Error: --preview-fps must be greater than 0 and at most 60\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --preview-fps flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--preview-size") == 0) {
+            if (i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &preview_config.width, &preview_config.height) == 2 &&
+                preview_config.width > 0 && preview_config.height > 0) {
+                i++;
+            } else {
+                printf("Error: --preview-size flag requires a value like 640x360\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--history") == 0) {
+            if (i + 1 < argc) {
+                history_dir = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --history flag requires a directory\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--history-rate") == 0) {
+            if (i + 1 < argc) {
+                history_rate = atof(argv[i + 1]);
+                if (history_rate <= 0.0 || history_rate > 30.0) {
+                    printf("Error: --history-rate must be greater than 0 and at most 30\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --history-rate flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--history-boxes") == 0) {
+            if (i + 1 < argc) {
+                history_boxes = atoi(argv[i + 1]);
+                if (history_boxes < 0 || history_boxes > HISTORY_MAX_BOXES) {
+                    printf("Error: --history-boxes must be between 0 and %d\n", HISTORY_MAX_BOXES);
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --history-boxes flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--history-budget") == 0) {
+            if (i + 1 < argc) {
+                int budget_mb = atoi(argv[i + 1]);
+                if (budget_mb < 1) {
+                    printf("Error: --history-budget must be at least 1 MB\n");
+                    return -1;
+                }
+                history_config.budget_bytes = static_cast<size_t>(budget_mb) << 20;
+                i++;
+            } else {
+                printf("Error: --history-budget flag requires a size in MB\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--analytics-udp") == 0) {
+            if (i + 1 < argc) {
+                analytics_udp_port = atoi(argv[i + 1]);
+                if (analytics_udp_port < 1 || analytics_udp_port > 65535) {
+                    printf("Error: --analytics-udp port must be between 1 and 65535\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --analytics-udp flag requires a port\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--analytics-windows") == 0) {
+            if (i + 1 < argc) {
+                if (!parseRollingWindows(argv[i + 1], analytics_windows)) {
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --analytics-windows flag requires a list such as 10s,1m,15m,1h\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--zones") == 0) {
+            if (i + 1 < argc) {
+                zones_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --zones flag requires a file path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--zones-udp") == 0) {
+            if (i + 1 < argc) {
+                zones_udp_port = atoi(argv[i + 1]);
+                if (zones_udp_port < 1 || zones_udp_port > 65535) {
+                    printf("Error: --zones-udp port must be between 1 and 65535\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --zones-udp flag requires a port\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            if (i + 1 < argc) {
+                heatmap_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --heatmap flag requires a file path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--heatmap-interval") == 0) {
+            if (i + 1 < argc) {
+                heatmap_interval = atof(argv[i + 1]);
+                if (heatmap_interval <= 0.0) {
+                    printf("Error: --heatmap-interval must be positive\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --heatmap-interval flag requires a value in seconds\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--heatmap-grid") == 0) {
+            if (i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &heatmap_config.cols, &heatmap_config.rows) == 2 &&
+                heatmap_config.cols > 0 && heatmap_config.rows > 0 &&
+                heatmap_config.cols <= 4096 && heatmap_config.rows <= 4096) {
+                i++;
+            } else {
+                printf("Error: --heatmap-grid flag requires a value like 96x54\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--heatmap-half-life") == 0) {
+            if (i + 1 < argc) {
+                heatmap_config.half_life_seconds = atof(argv[i + 1]);
+                if (heatmap_config.half_life_seconds < 0.0) {
+                    printf("Error: --heatmap-half-life cannot be negative\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --heatmap-half-life flag requires a value in seconds\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--heatmap-footprint") == 0) {
+            if (i + 1 < argc && parseHeatmapFootprint(argv[i + 1], heatmap_config.footprint)) {
+                i++;
+            } else {
+                printf("Error: --heatmap-footprint flag requires box or center\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clips") == 0) {
+            if (i + 1 < argc) {
+                clip_config.directory = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --clips flag requires a directory\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clip-trigger") == 0) {
+            if (i + 1 < argc) {
+                if (!parseClipTriggers(argv[i + 1], clip_config.triggers)) {
+                    return -1;
+                }
+                clip_config.trigger_text = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --clip-trigger flag requires rules such as person>0\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clip-pre") == 0) {
+            if (i + 1 < argc) {
+                clip_config.pre_seconds = atof(argv[i + 1]);
+                if (clip_config.pre_seconds < 0.0 || clip_config.pre_seconds > 60.0) {
+                    printf("Error: --clip-pre must be between 0 and 60 seconds\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --clip-pre flag requires a value in seconds\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clip-post") == 0) {
+            if (i + 1 < argc) {
+                clip_config.post_seconds = atof(argv[i + 1]);
+                if (clip_config.post_seconds < 0.0 || clip_config.post_seconds > 60.0) {
+                    printf("Error: --clip-post must be between 0 and 60 seconds\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --clip-post flag requires a value in seconds\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clip-format") == 0) {
+            if (i + 1 < argc && parseClipFormat(argv[i + 1], clip_config.format)) {
+                i++;
+            } else {
+                printf("Error: --clip-format flag requires avi or frames\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--clip-budget") == 0) {
+            if (i + 1 < argc) {
+                long megabytes = atol(argv[i + 1]);
+                if (megabytes < 1) {
+                    printf("Error: --clip-budget must be at least 1 MB\n");
+                    return -1;
+                }
+                clip_config.budget_bytes = static_cast<uint64_t>(megabytes) << 20;
+                i++;
+            } else {
+                printf("Error: --clip-budget flag requires a size in MB\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crops") == 0) {
+            if (i + 1 < argc) {
+                crop_config.directory = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --crops flag requires a directory\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crops-shm") == 0) {
+            if (i + 1 < argc) {
+                crop_config.shm_name = argv[i + 1];
+                if (crop_config.shm_name.size() < 2 || crop_config.shm_name[0] != '/' ||
+                    crop_config.shm_name.find('/', 1) != std::string::npos) {
+                    printf("Error: --crops-shm name must be a single '/'-prefixed name, e.g. /objdet-crops\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --crops-shm flag requires a name\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crop-rate") == 0) {
+            if (i + 1 < argc) {
+                crop_config.rate_per_class = atof(argv[i + 1]);
+                if (crop_config.rate_per_class <= 0.0 || crop_config.rate_per_class > 100.0) {
+                    printf("Error: --crop-rate must be above 0 and at most 100 crops per second\n");
+                    return -1;
+                }
+                crop_config.burst = std::max(2.0 * crop_config.rate_per_class, 1.0);
+                i++;
+            } else {
+                printf("Error: --crop-rate flag requires crops per second\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crop-size") == 0) {
+            if (i + 1 < argc) {
+                crop_config.max_edge = atoi(argv[i + 1]);
+                if (crop_config.max_edge < 16 || crop_config.max_edge > 1024) {
+                    printf("Error: --crop-size must be between 16 and 1024 pixels\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --crop-size flag requires a size in pixels\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crop-padding") == 0) {
+            if (i + 1 < argc) {
+                crop_config.padding = static_cast<float>(atof(argv[i + 1]));
+                if (crop_config.padding < 0.0f || crop_config.padding > 1.0f) {
+                    printf("Error: --crop-padding must be between 0.0 and 1.0\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --crop-padding flag requires a fraction\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--crop-limit") == 0) {
+            if (i + 1 < argc) {
+                long limit = atol(argv[i + 1]);
+                if (limit < 1) {
+                    printf("Error: --crop-limit must be at least 1\n");
+                    return -1;
+                }
+                crop_config.max_files = static_cast<size_t>(limit);
+                i++;
+            } else {
+                printf("Error: --crop-limit flag requires a number of crops\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--redact") == 0) {
+            if (i + 1 < argc) {
+                redact_classes_str = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --redact flag requires class names\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--redact-mode") == 0) {
+            if (i + 1 < argc && parseRedactionMode(argv[i + 1], redaction_config.mode)) {
+                i++;
+            } else {
+                printf("Error: --redact-mode flag requires pixelate or blur\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--redact-strength") == 0) {
+            if (i + 1 < argc) {
+                redaction_config.strength = atoi(argv[i + 1]);
+                if (redaction_config.strength < 0 || redaction_config.strength > 255) {
+                    printf("Error: --redact-strength must be between 0 and 255 pixels\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --redact-strength flag requires a size in pixels\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--redact-padding") == 0) {
+            if (i + 1 < argc) {
+                redaction_config.padding = static_cast<float>(atof(argv[i + 1]));
+                if (redaction_config.padding < 0.0f || redaction_config.padding > 1.0f) {
+                    printf("Error: --redact-padding must be between 0.0 and 1.0\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --redact-padding flag requires a fraction\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--binary-keyframe-interval") == 0) {
+            if (i + 1 < argc) {
+                binary_keyframe_interval = atoi(argv[i + 1]);
+                if (binary_keyframe_interval < 1) {
+                    printf("Error: --binary-keyframe-interval must be at least 1\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --binary-keyframe-interval flag requires a value\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch_mode = true;
+        } else if (strcmp(argv[i], "--batch-output") == 0) {
+            if (i + 1 < argc) {
+                batch_config.jsonl_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --batch-output flag requires a file path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--coco") == 0) {
+            if (i + 1 < argc) {
+                batch_config.coco_path = argv[i + 1];
+                i++;
+            } else {
+                printf("Error: --coco flag requires a file path\n");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--batch-workers") == 0) {
+            if (i + 1 < argc) {
+                batch_config.workers = atoi(argv[i + 1]);
+                if (batch_config.workers < 1) {
+                    printf("Error: --batch-workers must be at least 1\n");
+                    return -1;
+                }
+                i++;
+            } else {
+                printf("Error: --batch-workers flag requires a value\n");
+                return -1;
+            }
         } else {
             printf("Warning: Unknown flag '%s'\n", argv[i]);
         }
     }
+
+    // Tiling only pays off on high-resolution frames spread across all NPU cores
+    if (inference_config.tiling.enabled()) {
+        if (!npu_contexts_set) {
+            inference_config.npu_contexts = 3;
+        }
+        if (!capture_size_set) {
+            inference_config.capture_width = 1920;
+            inference_config.capture_height = 1080;
+        }
+    }
     
     // Set up signal handler
     signal(SIGINT, signalHandler);
@@ -122,6 +835,7 @@ int main(int argc, char **argv) {
         printf("Error: Could not load COCO class mapping from %s\n", labels_path.c_str());
         return -1;
     }
+    timeline.mark("class mapping loaded");
 
     if (!classes_str.empty()) {
         selected_classes = parseClassNames(classes_str, class_mapping);
@@ -129,27 +843,131 @@ int main(int argc, char **argv) {
             printf("Warning: No valid classes found in '%s', using all classes\n", classes_str.c_str());
         }
     }
+    if (!redact_classes_str.empty()) {
+        // Unlike --classes, no valid names is an error: frames must not go out unredacted
+        redaction_config.class_ids = parseClassNames(redact_classes_str, class_mapping);
+        if (redaction_config.class_ids.empty()) {
+            printf("Error: No valid classes to redact in '%s'\n", redact_classes_str.c_str());
+            return -1;
+        }
+    }
     // ensure selected_classes always has class 0
     if (std::find(selected_classes.begin(), selected_classes.end(), 0) == selected_classes.end()) {
         selected_classes.push_back(0);
     }
+
+    std::shared_ptr<const ZoneMap> zone_map;
+    if (!zones_path.empty()) {
+        ZoneConfig zone_config;
+        if (!loadZones(zones_path, zone_config)) {
+            return -1;
+        }
+        zone_map = std::make_shared<ZoneMap>(zone_config);
+        if (zones_udp_port == 0) {
+            zones_udp_port = 5012;
+        }
+        printf("Counting detections in %zu zones from %s\n", zone_map->size(), zones_path.c_str());
+    }
     
     // Determine if source is a file or device
-    if (strstr(source_name, "/dev/video") == source_name) {
+    if (batch_mode) {
+        if (source_name == NULL || !std::filesystem::exists(source_name)) {
+            printf("Error: --batch requires an image directory or video file as the source\n");
+            return -1;
+        }
+        batch_config.source = source_name;
+        printf("Batch processing: %s\n", source_name);
+    } else if (source_name == NULL) {
+        if (serve_socket_path.empty()) {
+            printf("Error: a source is required unless --serve is given\n");
+            return -1;
+        }
+        printf("No source, serving inference requests only\n");
+    } else if (strstr(source_name, "/dev/video") == source_name) {
         is_file_input = false;
         printf("Using V4L device: %s\n", source_name);
     } else if (std::filesystem::exists(source_name)) {
         is_file_input = true;
         printf("Using image file: %s\n", source_name);
+        if (!serve_socket_path.empty()) {
+            printf("Error: --serve cannot be combined with an image file source\n");
+            return -1;
+        }
     } else {
         printf("Error: Source '%s' is neither a valid V4L device nor an existing file\n", source_name);
         return -1;
     }
 
     // Create frame writer for decorated output
-    auto frameWriter = std::make_shared<DecoratedFrameWriter>("/tmp/output.jpg", suppress_empty);
+    auto frameWriter = std::make_shared<DecoratedFrameWriter>(frame_file ? "/tmp/output.jpg" : "", suppress_empty);
+    frameWriter->setRedaction(redaction_config);
+    frameWriter->setOutput(frame_output);
+    if (!frame_shm_name.empty()) {
+        frameWriter->addSink(std::make_shared<ShmFrameSink>(frame_shm_name, frame_shm_format));
+    }
+    if (!crop_config.directory.empty() || !crop_config.shm_name.empty()) {
+        frameWriter->addRawSink(std::make_shared<CropSink>(crop_config));
+    }
     
-    if (is_file_input) {
+    if (batch_mode) {
+        // Offline batch mode: results go to files rather than the publishers
+        MLInferenceThread mlThread(
+            model_name,
+            source_name,
+            resultQueue,
+            running,
+            1,
+            nullptr,
+            selected_classes,
+            class_mapping,
+            confidence_threshold,
+            inference_config);
+
+        BatchProcessor batch(mlThread, batch_config, running);
+        return batch.run();
+
+    } else if (source_name == NULL) {
+        // Server-only mode: keep the model resident and answer requests
+        MLInferenceThread mlThread(
+            model_name,
+            "",
+            resultQueue,
+            running,
+            1,
+            nullptr,
+            selected_classes,
+            class_mapping,
+            confidence_threshold,
+            inference_config);
+
+        InferenceServer inference_server(
+            serve_socket_path,
+            mlThread,
+            std::make_shared<FullJsonMessageFormatter>(),
+            running);
+
+        ModelWatcher model_watcher(
+            model_name,
+            model_control_path,
+            watch_model,
+            running,
+            [&mlThread](const std::string& path) { return mlThread.swapModel(path); });
+        modelWatcher = &model_watcher;
+        signal(SIGHUP, reloadSignalHandler);
+
+        std::thread inference_serverThread(std::ref(inference_server));
+        std::thread model_watcherThread(std::ref(model_watcher));
+
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+
+        inference_serverThread.join();
+        model_watcherThread.join();
+        signal(SIGHUP, SIG_DFL);
+        modelWatcher = nullptr;
+
+    } else if (is_file_input) {
         // Single-shot inference mode for file input
         MLInferenceThread mlThread(
             model_name,
@@ -160,19 +978,21 @@ int main(int argc, char **argv) {
             frameWriter,
             selected_classes,
             class_mapping,
-            confidence_threshold);
+            confidence_threshold,
+            inference_config);
         
         // Create formatters
         auto full_json_formatter = std::make_shared<FullJsonMessageFormatter>(suppress_empty);
         
         // Create file publisher using transport injection
-        auto file_transport = std::make_shared<FileTransport>("/tmp/results.json");
+        auto file_transport = std::make_shared<FileTransport>("/tmp/results.json", results_durability);
         Publisher file_publisher(
             file_transport,
             resultQueue,
             running,
             full_json_formatter,
-            1);
+            1,
+            "file /tmp/results.json");
         
         // Run single inference and exit
         mlThread.runSingleInference();
@@ -195,41 +1015,157 @@ int main(int argc, char **argv) {
             frameWriter,
             selected_classes,
             class_mapping,
-            confidence_threshold);
+            confidence_threshold,
+            inference_config);
 
         // Create formatters
         auto full_json_formatter = std::make_shared<FullJsonMessageFormatter>(suppress_empty);
         auto selective_json_formatter = std::make_shared<SelectiveJsonMessageFormatter>();
         auto selective_bs_formatter = std::make_shared<SelectiveBSMessageFormatter>();
         
-        // Create file publisher using transport injection
-        auto file_transport = std::make_shared<FileTransport>("/tmp/results.json");
-        Publisher file_publisher(
-            file_transport,
-            resultQueue,
-            running,
+        // All sinks share one publishing thread
+        PublisherHub publisher_hub(resultQueue, running);
+
+        // File sink using transport injection; written once per second by default
+        publisher_hub.addSink(
+            std::make_shared<FileTransport>("/tmp/results.json", results_durability),
             full_json_formatter,
-            1); // Write to file once per second
+            publish_rate,
+            "file /tmp/results.json").setChangePolicy(change_policy);
 
-        // Create UDP publishers for selective class data
-        UDPPublisher udp_json_publisher(
-            "127.0.0.1", 5002,
-            resultQueue,
-            running,
+        // UDP sinks for selective class data
+        publisher_hub.addSink(
+            std::make_shared<UDPTransport>("127.0.0.1", 5002),
             selective_json_formatter,
-            1); // Send JSON to port 5002
+            publish_rate,
+            "udp 127.0.0.1:5002").setChangePolicy(change_policy);  // JSON to port 5002
 
-        UDPPublisher udp_bs_publisher(
-            "127.0.0.1", 5000,
-            resultQueue,
-            running,
+        publisher_hub.addSink(
+            std::make_shared<UDPTransport>("127.0.0.1", 5000),
             selective_bs_formatter,
-            1); // Send BrightScript to port 5000
+            publish_rate,
+            "udp 127.0.0.1:5000").setChangePolicy(change_policy);  // BrightScript to port 5000
+
+        // Optional binary stream with every box, at camera rate, to every
+        // destination from one socket
+        if (binary_udp_port > 0) {
+            binary_udp_destinations.insert(binary_udp_destinations.begin(), {"127.0.0.1", binary_udp_port});
+        }
+        if (!binary_udp_destinations.empty()) {
+            std::string name = "udp";
+            for (const auto& destination : binary_udp_destinations) {
+                name += (name == "udp" ? " " : ",") + destination.ip + ":" + std::to_string(destination.port);
+            }
+            publisher_hub.addSink(
+                std::make_shared<UDPTransport>(binary_udp_destinations, UDPTransport::DEFAULT_FRAGMENT_SIZE),
+                std::make_shared<BinaryMessageFormatter>(binary_keyframe_interval),
+                30,
+                name);
+        }
+
+        // Optional shared memory ring for readers on this device, at camera rate
+        if (!shm_ring_name.empty()) {
+            publisher_hub.addSink(
+                std::make_shared<ShmRingTransport>(shm_ring_name),
+                full_json_formatter,
+                30,
+                "shm " + shm_ring_name);
+        }
+
+        // Optional on-disk history of the selected classes' counts
+        if (!history_dir.empty()) {
+            HistoryLayout history_layout;
+            history_layout.box_capacity = history_boxes;
+            for (int class_id : selected_classes) {
+                for (const auto& [name, id] : class_mapping) {
+                    if (id == class_id) {
+                        history_layout.class_ids.push_back(class_id);
+                        history_layout.class_names.push_back(name);
+                        break;
+                    }
+                }
+            }
+            publisher_hub.addSink(
+                std::make_shared<HistoryTransport>(history_dir, history_layout, history_config),
+                std::make_shared<HistoryRecordFormatter>(history_layout),
+                history_rate,
+                "history " + history_dir);
+        }
+
+        // Optional rolling statistics, updated with every result
+        if (analytics_udp_port > 0) {
+            publisher_hub.addSink(
+                std::make_shared<UDPTransport>("127.0.0.1", analytics_udp_port),
+                std::make_shared<AnalyticsMessageFormatter>(analytics_windows),
+                publish_rate,
+                "analytics udp 127.0.0.1:" + std::to_string(analytics_udp_port));
+        }
+
+        // Optional per-zone counts
+        if (zone_map) {
+            publisher_hub.addSink(
+                std::make_shared<UDPTransport>("127.0.0.1", zones_udp_port),
+                std::make_shared<ZoneMessageFormatter>(zone_map),
+                publish_rate,
+                "zones udp 127.0.0.1:" + std::to_string(zones_udp_port)).setChangePolicy(change_policy);
+        }
+
+        // Optional heatmap, rewritten in place every interval
+        if (!heatmap_path.empty()) {
+            HeatmapFormat heatmap_format = std::filesystem::path(heatmap_path).extension() == ".png"
+                                               ? HeatmapFormat::PNG
+                                               : HeatmapFormat::Raw;
+            publisher_hub.addSink(
+                std::make_shared<FileTransport>(heatmap_path),
+                std::make_shared<HeatmapFormatter>(heatmap_config, heatmap_format),
+                1.0 / heatmap_interval,
+                "heatmap " + heatmap_path);
+        }
+
+        // Live model replacement on file change, control file or SIGHUP
+        ModelWatcher model_watcher(
+            model_name,
+            model_control_path,
+            watch_model,
+            running,
+            [&mlThread](const std::string& path) { return mlThread.swapModel(path); });
+        modelWatcher = &model_watcher;
+        signal(SIGHUP, reloadSignalHandler);
+
+        // On-demand requests share the model (and NPU contexts) with the camera
+        std::unique_ptr<InferenceServer> inference_server;
+        std::thread inference_serverThread;
+        if (!serve_socket_path.empty()) {
+            inference_server = std::make_unique<InferenceServer>(
+                serve_socket_path,
+                mlThread,
+                std::make_shared<FullJsonMessageFormatter>(),
+                running);
+            inference_serverThread = std::thread(std::ref(*inference_server));
+        }
+
+        // Browser preview of the decorated frames
+        std::shared_ptr<PreviewServer> preview_server;
+        std::thread preview_serverThread;
+        if (preview_enabled) {
+            preview_server = std::make_shared<PreviewServer>(preview_config, running);
+            frameWriter->addSink(preview_server);
+            preview_serverThread = std::thread(std::ref(*preview_server));
+        }
+
+        // Clips around detection events
+        std::shared_ptr<ClipRecorder> clip_recorder;
+        std::thread clip_recorderThread;
+        if (!clip_config.directory.empty()) {
+            clip_recorder = std::make_shared<ClipRecorder>(clip_config, running);
+            frameWriter->addSink(clip_recorder);
+            clip_recorderThread = std::thread(std::ref(*clip_recorder));
+        }
 
         std::thread inferenceThread(std::ref(mlThread));
-        std::thread file_publisherThread(std::ref(file_publisher));
-        std::thread udp_json_publisherThread(std::ref(udp_json_publisher));
-        std::thread udp_bs_publisherThread(std::ref(udp_bs_publisher));
+        std::thread model_watcherThread(std::ref(model_watcher));
+        std::thread publisher_hubThread(std::ref(publisher_hub));
+        timeline.mark("pipeline threads started");
 
         while (running) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -240,9 +1176,19 @@ int main(int argc, char **argv) {
         resultQueue.signalShutdown();
 
         inferenceThread.join();
-        file_publisherThread.join();
-        udp_json_publisherThread.join();
-        udp_bs_publisherThread.join();
+        if (inference_serverThread.joinable()) {
+            inference_serverThread.join();
+        }
+        if (preview_serverThread.joinable()) {
+            preview_serverThread.join();
+        }
+        if (clip_recorderThread.joinable()) {
+            clip_recorderThread.join();
+        }
+        model_watcherThread.join();
+        signal(SIGHUP, SIG_DFL);
+        modelWatcher = nullptr;
+        publisher_hubThread.join();
     }
 
     return 0;
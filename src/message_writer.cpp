@@ -0,0 +1,54 @@
+#include "message_writer.h"
+
+#include <charconv>
+#include <cmath>
+
+#include <nlohmann/json.hpp>
+
+void MessageWriter::integer(long long value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end - digits);
+}
+
+void MessageWriter::number(double value) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    // std::to_chars picks different (equally short) digits than json::dump()
+    // for some values, so use the Grisu2 routine dump() itself is built on
+    char digits[64];
+    auto end = nlohmann::detail::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, end - digits);
+}
+
+void MessageWriter::string(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    size_t run = 0;  // Start of the current run of characters needing no escape
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(text.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                out.append("\\u00");
+                out.push_back(hex[c >> 4]);
+                out.push_back(hex[c & 0xf]);
+                break;
+        }
+    }
+    out.append(text.data() + run, text.size() - run);
+    out.push_back('"');
+}
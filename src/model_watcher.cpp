@@ -0,0 +1,165 @@
+#include "model_watcher.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Writers usually produce several events per update (truncate, write, close
+// or a rename); act once they have been quiet for this long
+static const auto DEBOUNCE = std::chrono::milliseconds(500);
+static const int POLL_INTERVAL_MS = 500;
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+static std::string parentDir(const std::string& path) {
+    std::string dir = std::filesystem::path(path).parent_path();
+    return dir.empty() ? "." : dir;
+}
+
+static std::string fileName(const std::string& path) {
+    return std::filesystem::path(path).filename();
+}
+
+ModelWatcher::ModelWatcher(
+        const std::string& model_path,
+        const std::string& control_path,
+        bool watch_model_file,
+        std::atomic<bool>& isRunning,
+        SwapCallback callback)
+    : model_path(model_path),
+      control_path(control_path),
+      watch_model_file(watch_model_file),
+      running(isRunning),
+      callback(callback) {
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        perror("inotify_init1");
+        return;
+    }
+    addWatches();
+}
+
+ModelWatcher::~ModelWatcher() {
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+    if (wake_fd >= 0) {
+        close(wake_fd);
+    }
+}
+
+bool ModelWatcher::addWatches() {
+    if (inotify_fd < 0) {
+        return false;
+    }
+
+    if (watch_model_file) {
+        int wd = inotify_add_watch(inotify_fd, parentDir(model_path).c_str(), WATCH_MASK);
+        if (wd < 0) {
+            perror("inotify_add_watch (model)");
+        } else if (model_dir_wd >= 0 && model_dir_wd != wd && model_dir_wd != control_dir_wd) {
+            inotify_rm_watch(inotify_fd, model_dir_wd);
+        }
+        model_dir_wd = wd;
+    }
+
+    if (!control_path.empty() && control_dir_wd < 0) {
+        control_dir_wd = inotify_add_watch(inotify_fd, parentDir(control_path).c_str(), WATCH_MASK);
+        if (control_dir_wd < 0) {
+            perror("inotify_add_watch (control)");
+        }
+    }
+    return true;
+}
+
+void ModelWatcher::requestReload() {
+    uint64_t one = 1;
+    if (wake_fd >= 0) {
+        // write() is async-signal-safe; nothing useful to do if it fails
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+std::string ModelWatcher::readControlFile() const {
+    std::ifstream file(control_path);
+    std::string path;
+    std::getline(file, path);
+    // Trim whitespace left by `echo` and friends
+    path.erase(0, path.find_first_not_of(" \t\r\n"));
+    path.erase(path.find_last_not_of(" \t\r\n") + 1);
+    return path;
+}
+
+void ModelWatcher::operator()() {
+    if (inotify_fd < 0 && wake_fd < 0) {
+        return;
+    }
+
+    std::string pending;
+    auto last_event = std::chrono::steady_clock::now();
+    alignas(struct inotify_event) char buffer[4096];
+
+    while (running) {
+        struct pollfd fds[2] = {
+            {inotify_fd, POLLIN, 0},
+            {wake_fd, POLLIN, 0},
+        };
+        int ready = poll(fds, 2, POLL_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            if (read(wake_fd, &count, sizeof(count)) > 0) {
+                printf("Model reload requested\n");
+                pending = model_path;
+                last_event = std::chrono::steady_clock::now();
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t len;
+            while ((len = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + len;) {
+                    auto* event = reinterpret_cast<struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + event->len;
+                    if (event->len == 0) {
+                        continue;
+                    }
+
+                    if (event->wd == control_dir_wd && fileName(control_path) == event->name) {
+                        std::string requested = readControlFile();
+                        if (!requested.empty()) {
+                            printf("Model swap requested via %s: %s\n", control_path.c_str(), requested.c_str());
+                            pending = requested;
+                            last_event = std::chrono::steady_clock::now();
+                        }
+                    } else if (watch_model_file && event->wd == model_dir_wd && fileName(model_path) == event->name) {
+                        printf("Model file changed: %s\n", model_path.c_str());
+                        pending = model_path;
+                        last_event = std::chrono::steady_clock::now();
+                    }
+                }
+            }
+        }
+
+        if (!pending.empty() && std::chrono::steady_clock::now() - last_event >= DEBOUNCE) {
+            if (!std::filesystem::exists(pending)) {
+                printf("Model file %s does not exist, keeping current model\n", pending.c_str());
+            } else if (callback(pending) && pending != model_path) {
+                model_path = pending;
+                addWatches();
+            }
+            pending.clear();
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "npu_pool.h"
+
+#include <cstdio>
+#include <cstring>
+
+// NPU cores available for pinning on the largest supported SoC (RK3588)
+static const int MAX_NPU_CORES = 3;
+
+static rknn_core_mask coreMaskFor(int index) {
+    return static_cast<rknn_core_mask>(RKNN_NPU_CORE_0 << (index % MAX_NPU_CORES));
+}
+
+NpuContextPool::NpuContextPool(const char* model_path, int num_contexts) {
+    if (num_contexts < 1) {
+        num_contexts = 1;
+    }
+
+    auto primary = std::make_unique<rknn_app_context_t>();
+    memset(primary.get(), 0, sizeof(rknn_app_context_t));
+    int ret = init_yolox_model(model_path, primary.get());
+    if (ret != 0) {
+        printf("init_yolox_model fail! ret=%d model_path=%s\n", ret, model_path);
+        release_yolox_model(primary.get());
+        return;
+    }
+
+    // A single context is left on auto scheduling, as before pooling existed
+    if (num_contexts > 1 && rknn_set_core_mask(primary->rknn_ctx, coreMaskFor(0)) < 0) {
+        printf("rknn_set_core_mask not supported, contexts will share the NPU\n");
+    }
+    contexts.push_back(std::move(primary));
+
+    for (int i = 1; i < num_contexts; i++) {
+        auto ctx = std::make_unique<rknn_app_context_t>();
+        memset(ctx.get(), 0, sizeof(rknn_app_context_t));
+        if (dup_yolox_model(contexts[0].get(), ctx.get(), coreMaskFor(i)) != 0) {
+            printf("Failed to create NPU context %d, continuing with %zu\n", i, contexts.size());
+            break;
+        }
+        contexts.push_back(std::move(ctx));
+    }
+
+    for (auto& ctx : contexts) {
+        idle.push_back(ctx.get());
+    }
+    printf("NPU context pool ready with %zu context(s)\n", contexts.size());
+}
+
+NpuContextPool::~NpuContextPool() {
+    // Wait for in-flight inferences before tearing the contexts down
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return idle.size() == contexts.size(); });
+
+    for (auto& ctx : contexts) {
+        int ret = release_yolox_model(ctx.get());
+        if (ret != 0) {
+            printf("release_yolox_model fail! ret=%d\n", ret);
+        }
+    }
+}
+
+int NpuContextPool::modelWidth() const {
+    return contexts.empty() ? 0 : contexts[0]->model_width;
+}
+
+int NpuContextPool::modelHeight() const {
+    return contexts.empty() ? 0 : contexts[0]->model_height;
+}
+
+int NpuContextPool::warmUp() {
+    if (contexts.empty()) {
+        return -1;
+    }
+
+    // Mid-gray, the same value the letterbox pads with
+    image_buffer_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.width = modelWidth();
+    frame.height = modelHeight();
+    frame.width_stride = frame.width;
+    frame.height_stride = frame.height;
+    frame.format = IMAGE_FORMAT_RGB888;
+    frame.size = frame.width * frame.height * 3;
+    frame.fd = -1;
+    std::vector<unsigned char> pixels(frame.size, 114);
+    frame.virt_addr = pixels.data();
+
+    int ret = 0;
+    object_detect_result_list results;
+    for (auto& ctx : contexts) {
+        int r = inference_yolox_model(ctx.get(), &frame, &results, BOX_THRESH);
+        if (r != 0) {
+            printf("Warm-up inference fail! ret=%d\n", r);
+            ret = r;
+        }
+    }
+    return ret;
+}
+
+rknn_app_context_t* NpuContextPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !idle.empty(); });
+    rknn_app_context_t* ctx = idle.back();
+    idle.pop_back();
+    return ctx;
+}
+
+void NpuContextPool::release(rknn_app_context_t* ctx) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(ctx);
+    }
+    cond.notify_all();
+}
+
+int NpuContextPool::infer(image_buffer_t* img, object_detect_result_list* results, float conf_threshold,
+                          image_rect_t* src_box) {
+    if (contexts.empty()) {
+        return -1;
+    }
+
+    rknn_app_context_t* ctx = acquire();
+    int ret = inference_yolox_model(ctx, img, results, conf_threshold, src_box);
+    release(ctx);
+    return ret;
+}
@@ -0,0 +1,241 @@
+#include "overlay.h"
+#include <algorithm>
+#include <cstring>
+
+#include "font.h"
+
+// font.h: one 20 x 40 coverage bitmap for each printable ASCII character
+static const int FONT_GLYPHS = 95;
+static const int FONT_WIDTH = 20;
+static const int FONT_HEIGHT = 40;
+
+namespace {
+
+// A colour as written to the target: three bytes for RGB24, Y U V for NV12
+struct Pen {
+    uint8_t v[3];
+};
+
+Pen penFor(const OverlayImage& image, OverlayColor color) {
+    if (image.format == OverlayFormat::RGB24) {
+        return {{color.c0, color.c1, color.c2}};
+    }
+    int r = color.c0, g = color.c1, b = color.c2;
+    auto clamp = [](int value) { return static_cast<uint8_t>(std::clamp(value, 0, 255)); };
+    return {{clamp((77 * r + 150 * g + 29 * b + 128) >> 8),
+             clamp(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128),
+             clamp(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128)}};
+}
+
+inline uint8_t mix(uint8_t under, uint8_t over, int alpha) {
+    return static_cast<uint8_t>((under * (255 - alpha) + over * alpha + 127) / 255);
+}
+
+// Fill [x0, x1) x [y0, y1), already clipped to the image, a row at a time
+void fillRect(OverlayImage& image, const Pen& pen, int x0, int y0, int x1, int y1) {
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    if (image.format == OverlayFormat::RGB24) {
+        uint8_t* first = image.data + y0 * image.stride + x0 * 3;
+        for (int x = 0; x < x1 - x0; x++) {
+            memcpy(first + x * 3, pen.v, 3);
+        }
+        for (int y = y0 + 1; y < y1; y++) {
+            memcpy(image.data + y * image.stride + x0 * 3, first, (x1 - x0) * 3);
+        }
+        return;
+    }
+
+    for (int y = y0; y < y1; y++) {
+        memset(image.data + y * image.stride + x0, pen.v[0], x1 - x0);
+    }
+    // Every chroma sample the rectangle touches
+    uint8_t* uv_plane = image.data + image.height * image.stride;
+    int cx0 = x0 / 2, cx1 = (x1 + 1) / 2;
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2; cy++) {
+        uint8_t* uv = uv_plane + cy * image.stride;
+        for (int cx = cx0; cx < cx1; cx++) {
+            uv[cx * 2] = pen.v[1];
+            uv[cx * 2 + 1] = pen.v[2];
+        }
+    }
+}
+
+}  // namespace
+
+OverlayRenderer::OverlayRenderer(int font_height)
+    : glyph_width(std::max(std::clamp(font_height, 6, 160) / 2, 3)),
+      glyph_height(std::clamp(font_height, 6, 160)),
+      atlas_stride(static_cast<size_t>(FONT_GLYPHS) * glyph_width),
+      atlas(atlas_stride * glyph_height) {
+    // Area-average each font bitmap down (or repeat it up) to the glyph size
+    for (int g = 0; g < FONT_GLYPHS; g++) {
+        const unsigned char* source = mono_font_data[g];
+        for (int y = 0; y < glyph_height; y++) {
+            int sy0 = y * FONT_HEIGHT / glyph_height;
+            int sy1 = std::max((y + 1) * FONT_HEIGHT / glyph_height, sy0 + 1);
+            for (int x = 0; x < glyph_width; x++) {
+                int sx0 = x * FONT_WIDTH / glyph_width;
+                int sx1 = std::max((x + 1) * FONT_WIDTH / glyph_width, sx0 + 1);
+                int sum = 0;
+                for (int sy = sy0; sy < sy1; sy++) {
+                    for (int sx = sx0; sx < sx1; sx++) {
+                        sum += source[sy * FONT_WIDTH + sx];
+                    }
+                }
+                int count = (sy1 - sy0) * (sx1 - sx0);
+                atlas[y * atlas_stride + g * glyph_width + x] = static_cast<uint8_t>((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+const uint8_t* OverlayRenderer::glyph(char ch) const {
+    if (ch < ' ' || ch > '~') {
+        ch = ' ';
+    }
+    return atlas.data() + (ch - ' ') * glyph_width;
+}
+
+int OverlayRenderer::labelWidth(const char* name) const {
+    // "name: 0.87"
+    return textWidth(strlen(name) + 6);
+}
+
+const OverlayRenderer::Strip& OverlayRenderer::prefix(const char* name) {
+    auto it = prefixes.find(name);
+    if (it != prefixes.end()) {
+        return it->second;
+    }
+    if (prefixes.size() >= MAX_STRIPS) {
+        prefixes.clear();
+    }
+
+    std::string text = std::string(name) + ": ";
+    Strip& strip = prefixes[name];
+    strip.width = textWidth(text.size());
+    strip.alpha.resize(static_cast<size_t>(strip.width) * glyph_height);
+    for (size_t i = 0; i < text.size(); i++) {
+        const uint8_t* source = glyph(text[i]);
+        for (int y = 0; y < glyph_height; y++) {
+            memcpy(&strip.alpha[y * strip.width + i * glyph_width], source + y * atlas_stride, glyph_width);
+        }
+    }
+    return strip;
+}
+
+void OverlayRenderer::blend(OverlayImage& image, const uint8_t* alpha, size_t alpha_stride, int w, int x, int y,
+                            OverlayColor color) const {
+    const int h = glyph_height;
+    const Pen pen = penFor(image, color);
+    const int i0 = std::max(0, -x), i1 = std::min(w, image.width - x);
+    const int j0 = std::max(0, -y), j1 = std::min(h, image.height - y);
+    if (i0 >= i1 || j0 >= j1) {
+        return;
+    }
+
+    if (image.format == OverlayFormat::RGB24) {
+        for (int j = j0; j < j1; j++) {
+            const uint8_t* a = alpha + j * alpha_stride;
+            uint8_t* p = image.data + (y + j) * image.stride + x * 3;
+            for (int i = i0; i < i1; i++) {
+                int coverage = a[i];
+                if (coverage == 0) {
+                    continue;
+                }
+                uint8_t* pixel = p + i * 3;
+                if (coverage == 255) {
+                    memcpy(pixel, pen.v, 3);
+                } else {
+                    pixel[0] = mix(pixel[0], pen.v[0], coverage);
+                    pixel[1] = mix(pixel[1], pen.v[1], coverage);
+                    pixel[2] = mix(pixel[2], pen.v[2], coverage);
+                }
+            }
+        }
+        return;
+    }
+
+    for (int j = j0; j < j1; j++) {
+        const uint8_t* a = alpha + j * alpha_stride;
+        uint8_t* p = image.data + (y + j) * image.stride + x;
+        for (int i = i0; i < i1; i++) {
+            if (a[i] != 0) {
+                p[i] = mix(p[i], pen.v[0], a[i]);
+            }
+        }
+    }
+    // Each chroma sample takes the mean coverage of its 2 x 2 luma pixels
+    uint8_t* uv_plane = image.data + image.height * image.stride;
+    for (int cy = (y + j0) / 2; cy < (y + j1 + 1) / 2; cy++) {
+        uint8_t* uv = uv_plane + cy * image.stride;
+        for (int cx = (x + i0) / 2; cx < (x + i1 + 1) / 2; cx++) {
+            int sum = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                int j = cy * 2 + dy - y;
+                if (j < j0 || j >= j1) {
+                    continue;
+                }
+                for (int dx = 0; dx < 2; dx++) {
+                    int i = cx * 2 + dx - x;
+                    if (i >= i0 && i < i1) {
+                        sum += alpha[j * alpha_stride + i];
+                    }
+                }
+            }
+            int coverage = (sum + 2) / 4;
+            if (coverage != 0) {
+                uv[cx * 2] = mix(uv[cx * 2], pen.v[1], coverage);
+                uv[cx * 2 + 1] = mix(uv[cx * 2 + 1], pen.v[2], coverage);
+            }
+        }
+    }
+}
+
+void OverlayRenderer::drawBox(OverlayImage& image, const box_rect_t& box, OverlayColor color, int thickness) const {
+    // Corners inclusive, as cv::rectangle() takes them
+    const int left = box.left, top = box.top, right = box.right + 1, bottom = box.bottom + 1;
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    thickness = std::max(thickness, 1);
+    const Pen pen = penFor(image, color);
+
+    // Top, bottom, left and right bands, each clipped to the image
+    const int inner_top = std::min(top + thickness, bottom);
+    const int inner_bottom = std::max(bottom - thickness, inner_top);
+    const int inner_left = std::min(left + thickness, right);
+    const int inner_right = std::max(right - thickness, inner_left);
+    auto fill = [&](int x0, int y0, int x1, int y1) {
+        fillRect(image, pen, std::max(x0, 0), std::max(y0, 0), std::min(x1, image.width), std::min(y1, image.height));
+    };
+    fill(left, top, right, inner_top);
+    fill(left, inner_bottom, right, bottom);
+    fill(left, inner_top, inner_left, inner_bottom);
+    fill(inner_right, inner_top, right, inner_bottom);
+}
+
+void OverlayRenderer::drawText(OverlayImage& image, const char* text, int x, int y, OverlayColor color) const {
+    for (const char* ch = text; *ch; ch++, x += glyph_width) {
+        if (*ch != ' ') {
+            blend(image, glyph(*ch), atlas_stride, glyph_width, x, y, color);
+        }
+    }
+}
+
+void OverlayRenderer::drawLabel(OverlayImage& image, const char* name, float confidence, int x, int y,
+                                OverlayColor color) {
+    const Strip& strip = prefix(name);
+    blend(image, strip.alpha.data(), strip.width, strip.width, x, y, color);
+
+    // The confidence to two decimals, straight from the digit glyphs
+    int hundredths = std::clamp(static_cast<int>(confidence * 100.0f + 0.5f), 0, 100);
+    const char digits[4] = {static_cast<char>('0' + hundredths / 100), '.',
+                            static_cast<char>('0' + hundredths / 10 % 10), static_cast<char>('0' + hundredths % 10)};
+    x += strip.width;
+    for (char digit : digits) {
+        blend(image, glyph(digit), atlas_stride, glyph_width, x, y, color);
+        x += glyph_width;
+    }
+}
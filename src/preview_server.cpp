@@ -0,0 +1,415 @@
+#include "preview_server.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int POLL_INTERVAL_MS = 500;
+static const size_t MAX_CLIENTS = 8;
+static const size_t MAX_REQUEST = 4096;
+static const int MAX_EVENTS = 16;
+// Scaled previews are encoded separately, at a lower quality than the full frame
+static const int PREVIEW_JPEG_QUALITY = 80;
+// A client that accepts no data for this long is dropped
+static const std::chrono::seconds STALL_TIMEOUT(10);
+
+static const char STREAM_HEADER[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+    "Cache-Control: no-cache, no-store\r\n"
+    "Pragma: no-cache\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+bool parsePreviewAddress(const std::string& text, PreviewConfig& config) {
+    std::string address = config.address;
+    std::string port_text = text;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos) {
+        address = text.substr(0, colon);
+        port_text = text.substr(colon + 1);
+    }
+    struct in_addr addr;
+    char* end = nullptr;
+    long port = strtol(port_text.c_str(), &end, 10);
+    if (port_text.empty() || *end != '\0' || port < 0 || port > 65535 ||
+        inet_pton(AF_INET, address.c_str(), &addr) != 1) {
+        printf("Invalid preview address %s (expected port or ip:port)\n", text.c_str());
+        return false;
+    }
+    config.address = address;
+    config.port = static_cast<int>(port);
+    return true;
+}
+
+static std::string errorResponse(const char* status) {
+    std::string body = std::string(status) + "\n";
+    return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: text/plain\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+PreviewServer::PreviewServer(const PreviewConfig& config, std::atomic<bool>& isRunning)
+    : config(config), running(isRunning) {
+    frame_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+PreviewServer::~PreviewServer() {
+    for (auto& client : clients) {
+        close(client.fd);
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+    if (frame_event_fd >= 0) {
+        close(frame_event_fd);
+    }
+}
+
+PreviewServer::Stats PreviewServer::stats() const {
+    return {frames_encoded.load(), frames_sent.load(), frames_skipped.load(), client_count.load()};
+}
+
+void PreviewServer::publish(DecoratedFrame& frame) {
+    // Nothing is encoded while nobody watches
+    if (client_count == 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_frame_due) {
+        return;
+    }
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / config.fps));
+    next_frame_due += interval;
+    if (next_frame_due < now) {
+        next_frame_due = now + interval;
+    }
+
+    const cv::Mat& bgr = frame.bgr();
+    const std::vector<uchar>* encoded = &jpeg;
+    cv::Size size;
+    if (fitWithin(bgr, config.width, config.height, size)) {
+        cv::resize(bgr, scaled, size, 0, 0, cv::INTER_AREA);
+        if (!encodeJpeg(scaled, PREVIEW_JPEG_QUALITY, jpeg)) {
+            return;
+        }
+    } else {
+        // Full size: the encoding shared with /tmp/output.jpg and other sinks
+        encoded = &frame.jpeg();
+        if (encoded->empty()) {
+            return;
+        }
+    }
+
+    auto part = std::make_shared<Frame>();
+    std::string header = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: " + std::to_string(encoded->size()) +
+                         "\r\n\r\n";
+    part->part.reserve(header.size() + encoded->size() + 2);
+    part->part = header;
+    part->part.append(reinterpret_cast<const char*>(encoded->data()), encoded->size());
+    part->part += "\r\n";
+    part->jpeg_offset = header.size();
+    part->jpeg_size = encoded->size();
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        part->version = ++frame_version;
+        latest = part;
+    }
+    frames_encoded++;
+
+    uint64_t one = 1;
+    if (write(frame_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("Preview frame event");
+    }
+}
+
+std::shared_ptr<const PreviewServer::Frame> PreviewServer::latestFrame() {
+    std::lock_guard<std::mutex> lock(frame_mutex);
+    return latest;
+}
+
+bool PreviewServer::listen() {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.address.c_str(), &addr.sin_addr) != 1) {
+        printf("Invalid preview address %s\n", config.address.c_str());
+        return false;
+    }
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, static_cast<int>(MAX_CLIENTS)) < 0) {
+        perror("bind/listen");
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0 || frame_event_fd < 0) {
+        perror("epoll/eventfd");
+        return false;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &listen_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.ptr = &frame_event_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, frame_event_fd, &event);
+
+    bound_port = ntohs(addr.sin_port);
+    return true;
+}
+
+void PreviewServer::acceptClients() {
+    for (;;) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                perror("accept");
+            }
+            return;
+        }
+        if (clients.size() >= MAX_CLIENTS) {
+            std::string response = errorResponse("503 Service Unavailable");
+            send(fd, response.data(), response.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            close(fd);
+            continue;
+        }
+
+        clients.emplace_back();
+        Client& client = clients.back();
+        client.fd = fd;
+        client.last_progress = std::chrono::steady_clock::now();
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = &client;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+bool PreviewServer::readRequest(Client& client) {
+    char buffer[1024];
+    for (;;) {
+        ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        if (client.streaming || client.waiting) {
+            continue;  // Anything after the request is ignored
+        }
+        client.request.append(buffer, n);
+        if (client.request.find("\r\n\r\n") != std::string::npos) {
+            break;
+        }
+        if (client.request.size() > MAX_REQUEST) {
+            client.head = errorResponse("431 Request Header Fields Too Large");
+            client.close_when_sent = true;
+            return sendPending(client);
+        }
+    }
+
+    // Only the request line matters: GET <path> HTTP/1.x
+    char method[16] = "";
+    char path[1024] = "";
+    sscanf(client.request.c_str(), "%15s %1023s", method, path);
+    std::string target = path;
+    target = target.substr(0, target.find('?'));
+    client.request.clear();
+    client.close_when_sent = true;
+
+    if (strcmp(method, "GET") != 0) {
+        client.head = errorResponse("405 Method Not Allowed");
+    } else if (target == "/" || target == "/stream" || target == "/stream.mjpg") {
+        client.head = STREAM_HEADER;
+        client.streaming = true;
+        client.close_when_sent = false;
+    } else if (target == "/snapshot.jpg") {
+        client.waiting = true;  // The header goes out with the next frame
+        client.close_when_sent = false;
+    } else {
+        client.head = errorResponse("404 Not Found");
+    }
+
+    if (client.streaming || client.waiting) {
+        // Start from the next frame encoded; none are while nobody watches
+        std::lock_guard<std::mutex> lock(frame_mutex);
+        client.version = frame_version;
+        client_count++;
+        client.counted = true;
+    }
+    return sendPending(client);
+}
+
+void PreviewServer::startFrame(Client& client, const std::shared_ptr<const Frame>& frame) {
+    if (client.version > 0 && frame->version > client.version + 1) {
+        frames_skipped += frame->version - client.version - 1;
+    }
+    client.version = frame->version;
+    client.frame = frame;
+    if (client.waiting) {
+        // A snapshot: plain JPEG response
+        client.waiting = false;
+        client.close_when_sent = true;
+        client.head = "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: " +
+                      std::to_string(frame->jpeg_size) + "\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n";
+        client.head_sent = 0;
+        client.offset = frame->jpeg_offset;
+        client.end = frame->jpeg_offset + frame->jpeg_size;
+    } else {
+        client.offset = 0;
+        client.end = frame->part.size();
+    }
+}
+
+bool PreviewServer::sendPending(Client& client) {
+    for (;;) {
+        const char* data;
+        size_t size;
+        if (client.head_sent < client.head.size()) {
+            data = client.head.data() + client.head_sent;
+            size = client.head.size() - client.head_sent;
+        } else if (client.frame && client.offset < client.end) {
+            data = client.frame->part.data() + client.offset;
+            size = client.end - client.offset;
+        } else {
+            if (client.frame) {
+                client.frame.reset();
+                frames_sent++;
+            }
+            if (client.close_when_sent) {
+                return false;
+            }
+            // Jump straight to the newest frame if one came while sending
+            auto frame = client.streaming ? latestFrame() : nullptr;
+            if (frame && frame->version > client.version) {
+                startFrame(client, frame);
+                continue;
+            }
+            updateEvents(client, false);
+            return true;
+        }
+
+        ssize_t n = send(client.fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                updateEvents(client, true);
+                return true;
+            }
+            return false;
+        }
+        client.last_progress = std::chrono::steady_clock::now();
+        if (client.head_sent < client.head.size()) {
+            client.head_sent += n;
+        } else {
+            client.offset += n;
+        }
+    }
+}
+
+void PreviewServer::updateEvents(Client& client, bool want_write) {
+    if (client.want_write == want_write) {
+        return;
+    }
+    client.want_write = want_write;
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    event.data.ptr = &client;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client.fd, &event);
+}
+
+void PreviewServer::operator()() {
+    if (!listen()) {
+        printf("Preview server disabled\n");
+        return;
+    }
+    printf("Preview server on http://%s:%d/ (%.1f fps)\n", config.address.c_str(), port(), config.fps);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, POLL_INTERVAL_MS);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        bool new_frame = false;
+        for (int i = 0; i < n; i++) {
+            void* source = events[i].data.ptr;
+            if (source == &listen_fd) {
+                acceptClients();
+            } else if (source == &frame_event_fd) {
+                uint64_t count;
+                if (read(frame_event_fd, &count, sizeof(count)) > 0) {
+                    new_frame = true;
+                }
+            } else {
+                Client& client = *static_cast<Client*>(source);
+                if (client.dead) {
+                    continue;
+                }
+                if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !readRequest(client)) {
+                    client.dead = true;
+                } else if ((events[i].events & EPOLLOUT) && !sendPending(client)) {
+                    client.dead = true;
+                }
+            }
+        }
+
+        // Idle clients start the new frame; busy ones pick it up when done
+        auto now = std::chrono::steady_clock::now();
+        auto frame = new_frame ? latestFrame() : nullptr;
+        for (auto& client : clients) {
+            if (client.dead) {
+                continue;
+            }
+            bool busy = (client.frame && client.offset < client.end) || client.head_sent < client.head.size();
+            if (frame && !busy && (client.streaming || client.waiting) && frame->version > client.version) {
+                startFrame(client, frame);
+                client.dead = !sendPending(client);
+            } else if (busy && now - client.last_progress > STALL_TIMEOUT) {
+                printf("Preview server: dropping a client that stopped reading\n");
+                client.dead = true;
+            }
+        }
+
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (it->dead) {
+                if (it->counted) {
+                    client_count--;
+                }
+                close(it->fd);
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    Stats totals = stats();
+    printf("Preview server stopped: %ld frames encoded, %ld sent, %ld skipped for slow clients\n",
+           totals.frames_encoded, totals.frames_sent, totals.frames_skipped);
+}
@@ -1,99 +1,177 @@
 #include "publisher.h"
-#include "utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <thread>
 #include <unordered_map>
 
-// Implementation of the JsonMessageFormatter
-std::string JsonMessageFormatter::formatMessage(const InferenceResult& result) {
-    json j;
-    
-    // Add timestamp
-    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
-    
-    // Initialize counts for all selected classes to 0
-    std::unordered_map<std::string, int> class_counts;
-    if (result.selected_classes.empty()) {
-        // If no classes specified, initialize "person" as default
-        class_counts["person"] = 0;
-    } else {
-        // Initialize all selected classes with 0
-        for (int class_id : result.selected_classes) {
-            std::string class_name = getClassNameById(class_id, result.class_mapping);
-            class_counts[class_name] = 0;
+static ClassCount* findClassCount(std::vector<ClassCount>& counts, std::string_view name) {
+    for (auto& entry : counts) {
+        if (entry.name == name) {
+            return &entry;
         }
     }
-    
-    // Count detections by class name for selected classes only
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        
-        // Skip invalid detections, below threshold, or if not in selected classes
-        if ((detection.prop <= 0.0f ||  detection.cls_id < 0 || detection.prop < result.confidence_threshold) || 
-            !isClassSelected(detection.cls_id, result.selected_classes)) {
-            continue;
+    return nullptr;
+}
+
+// Add a class with a zero count, keeping the first position of duplicates
+static void addClassCount(std::vector<ClassCount>& counts, std::string_view name) {
+    if (!findClassCount(counts, name)) {
+        counts.push_back({name, 0});
+    }
+}
+
+// Write {"<class>":<count>,...,"timestamp":<t>} with keys in the sorted order
+// nlohmann::json objects use. A class named "timestamp" replaces the
+// timestamp, as assigning it after the timestamp did.
+static void writeClassCountsJson(MessageWriter& writer, std::vector<ClassCount>& counts, long long timestamp) {
+    std::sort(counts.begin(), counts.end(),
+              [](const ClassCount& a, const ClassCount& b) { return a.name < b.name; });
+    static constexpr std::string_view timestamp_key = "timestamp";
+    bool timestamp_pending = findClassCount(counts, timestamp_key) == nullptr;
+
+    writer.raw('{');
+    bool first = true;
+    for (const auto& entry : counts) {
+        if (timestamp_pending && timestamp_key < entry.name) {
+            writer.raw(first ? "\"timestamp\":" : ",\"timestamp\":");
+            writer.integer(timestamp);
+            timestamp_pending = false;
+            first = false;
         }
-        
-        std::string class_name = std::string(detection.name);
-        if (class_counts.find(class_name) != class_counts.end()) {
-            class_counts[class_name]++;
+        if (!first) {
+            writer.raw(',');
         }
+        writer.string(entry.name);
+        writer.raw(':');
+        writer.integer(entry.count);
+        first = false;
     }
-    
-    // Add class counts to JSON
-    for (const auto& [class_name, count] : class_counts) {
-        j[class_name] = count;
+    if (timestamp_pending) {
+        writer.raw(first ? "\"timestamp\":" : ",\"timestamp\":");
+        writer.integer(timestamp);
+    }
+    writer.raw('}');
+}
+
+static long long timestampOf(const InferenceResult& result) {
+    return std::chrono::system_clock::to_time_t(result.timestamp);
+}
+
+// FNV-1a over the raw bytes of a value
+static void hashValue(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+}
+
+static const uint64_t HASH_SEED = 14695981039346656037ULL;
+
+static uint64_t hashCounts(const std::vector<ClassCount>& counts) {
+    uint64_t hash = HASH_SEED;
+    for (const auto& entry : counts) {
+        hashValue(hash, entry.name.data(), entry.name.size());
+        hashValue(hash, &entry.count, sizeof(entry.count));
+    }
+    return hash;
+}
+
+// Positions are compared on this grid (pixels)
+static const int CHANGE_GRID = 16;
+
+uint64_t MessageFormatter::changeKey(const InferenceResult& result) {
+    uint64_t hash = HASH_SEED;
+    for (int i : result.view().listed) {
+        const auto& detection = result.detections.results[i];
+        int cell[5] = {detection.cls_id, detection.box.left / CHANGE_GRID, detection.box.top / CHANGE_GRID,
+                       detection.box.right / CHANGE_GRID, detection.box.bottom / CHANGE_GRID};
+        hashValue(hash, cell, sizeof(cell));
+    }
+    return hash;
+}
+
+// Implementation of the JsonMessageFormatter
+void JsonMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    // Counts for the selected classes only, including zeros
+    const ResultView& view = result.view();
+    class_counts.clear();
+    for (size_t i = 0; i < view.selected_names; i++) {
+        class_counts.push_back({view.class_names[i], view.class_counts[i]});
     }
     
-    return j.dump();
+    out.clear();
+    MessageWriter writer(out);
+    writeClassCountsJson(writer, class_counts, timestampOf(result));
+}
+
+uint64_t JsonMessageFormatter::changeKey(const InferenceResult& result) {
+    const ResultView& view = result.view();
+    uint64_t hash = HASH_SEED;
+    for (size_t i = 0; i < view.selected_names; i++) {
+        hashValue(hash, view.class_names[i].data(), view.class_names[i].size());
+        hashValue(hash, &view.class_counts[i], sizeof(int));
+    }
+    return hash;
 }
 
 // Implementation of MappedMessageFormatter helper functions
-std::vector<object_detect_result> MappedMessageFormatter::extractSelectedClasses(const InferenceResult& result) const {
-    std::vector<object_detect_result> selected_detections;
-    
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        
-        // Skip invalid detections or below threshold
-        if (detection.prop <= 0.0f || detection.cls_id < 0 || detection.prop < result.confidence_threshold) {
-            continue;
-        }
-        
-        // Only include selected classes
-        if (isClassSelected(detection.cls_id, result.selected_classes)) {
-            selected_detections.push_back(detection);
+void MappedMessageFormatter::countSelectedClasses(const InferenceResult& result) {
+    const ResultView& view = result.view();
+
+    // Initialize counts for all selected classes to 0
+    class_counts.clear();
+    if (result.selected_classes.empty()) {
+        // The default "person" entry is not mapped
+        addClassCount(class_counts, "person");
+    } else {
+        for (size_t i = 0; i < view.selected_names; i++) {
+            addClassCount(class_counts, mapClassName(view.class_names[i]));
         }
     }
     
-    return selected_detections;
+    // Several detected names may map onto one selected class name
+    for (size_t i = 0; i < view.class_names.size(); i++) {
+        if (ClassCount* entry = findClassCount(class_counts, mapClassName(view.class_names[i]))) {
+            entry->count += view.class_counts[i];
+        }
+    }
+}
+
+uint64_t MappedMessageFormatter::changeKey(const InferenceResult& result) {
+    countSelectedClasses(result);
+    return hashCounts(class_counts);
 }
 
-std::string MappedMessageFormatter::mapClassName(const std::string& original_name) const {
-    auto it = class_mapping.find(original_name);
-    if (it != class_mapping.end()) {
-        return it->second;
+std::string_view MappedMessageFormatter::mapClassName(std::string_view original_name) const {
+    // Mappings hold a handful of entries, so a scan beats hashing a temporary key
+    for (const auto& [from, to] : class_mapping) {
+        if (from == original_name) {
+            return to;
+        }
     }
     return original_name;
 }
 
 // Implementation of the BSVariableMessageFormatter
-std::string BSVariableMessageFormatter::formatMessage(const InferenceResult& result) {
+void BSVariableMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
     // Count high-confidence detections
-    int valid_count = 0;
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        if (detection.prop >= result.confidence_threshold && detection.prop > 0.0f && detection.cls_id >= 0) {
-            valid_count++;
-        }
-    }
+    int valid_count = result.view().above_threshold;
     
     // format the message as a string like detection_count:2!!timestamp:1746732409
-    std::string message = 
-        "detection_count:" + std::to_string(valid_count) + "!!" +
-        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
-    return message;
+    out.clear();
+    MessageWriter writer(out);
+    writer.raw("detection_count:");
+    writer.integer(valid_count);
+    writer.raw("!!timestamp:");
+    writer.integer(timestampOf(result));
+}
+
+uint64_t BSVariableMessageFormatter::changeKey(const InferenceResult& result) {
+    return result.view().above_threshold;
 }
 
 // Implementation of the FacesJsonMessageFormatter constructor
@@ -102,24 +180,23 @@ FacesJsonMessageFormatter::FacesJsonMessageFormatter() {
 }
 
 // Implementation of the FacesJsonMessageFormatter
-std::string FacesJsonMessageFormatter::formatMessage(const InferenceResult& result) {
-    json j;
-    
-    // Count people (class_id == 0)
-    int people_count = 0;
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        if (detection.cls_id == 0 && detection.prop >= result.confidence_threshold) { // "person" class above threshold
-            people_count++;
-        }
-    }
-    
-    // Map people count to faces properties (doubling up as requested)
-    j["faces_in_frame_total"] = people_count;
-    j["faces_attending"] = people_count;
-    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+void FacesJsonMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    int people_count = result.view().people;
     
-    return j.dump();
+    // Map people count to faces properties (doubling up as requested), keys in sorted order
+    out.clear();
+    MessageWriter writer(out);
+    writer.raw("{\"faces_attending\":");
+    writer.integer(people_count);
+    writer.raw(",\"faces_in_frame_total\":");
+    writer.integer(people_count);
+    writer.raw(",\"timestamp\":");
+    writer.integer(timestampOf(result));
+    writer.raw('}');
+}
+
+uint64_t FacesJsonMessageFormatter::changeKey(const InferenceResult& result) {
+    return result.view().people;
 }
 
 // Implementation of the FacesBSMessageFormatter constructor
@@ -128,112 +205,270 @@ FacesBSMessageFormatter::FacesBSMessageFormatter() {
 }
 
 // Implementation of the FacesBSMessageFormatter  
-std::string FacesBSMessageFormatter::formatMessage(const InferenceResult& result) {
-    // Count people (class_id == 0)
-    int people_count = 0;
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        if (detection.cls_id == 0 && detection.prop >= result.confidence_threshold) { // "person" class above threshold
-            people_count++;
-        }
-    }
+void FacesBSMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    int people_count = result.view().people;
     
     // Map people count to faces properties in BrightScript format
-    std::string message = 
-        "faces_in_frame_total:" + std::to_string(people_count) + "!!" +
-        "faces_attending:" + std::to_string(people_count) + "!!" +
-        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
-    return message;
+    out.clear();
+    MessageWriter writer(out);
+    writer.raw("faces_in_frame_total:");
+    writer.integer(people_count);
+    writer.raw("!!faces_attending:");
+    writer.integer(people_count);
+    writer.raw("!!timestamp:");
+    writer.integer(timestampOf(result));
+}
+
+uint64_t FacesBSMessageFormatter::changeKey(const InferenceResult& result) {
+    return result.view().people;
 }
 
 // Implementation of the SelectiveJsonMessageFormatter
-std::string SelectiveJsonMessageFormatter::formatMessage(const InferenceResult& result) {
-    json j;
-    
-    // Add timestamp
-    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+void SelectiveJsonMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    countSelectedClasses(result);
+
+    out.clear();
+    MessageWriter writer(out);
+    writeClassCountsJson(writer, class_counts, timestampOf(result));
+}
+
+// Implementation of the SelectiveBSMessageFormatter
+void SelectiveBSMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    countSelectedClasses(result);
     
-    // Extract only selected class detections
-    std::vector<object_detect_result> selected_detections = extractSelectedClasses(result);
+    // Build BrightScript format message, classes in selected order
+    out.clear();
+    MessageWriter writer(out);
+    for (const auto& entry : class_counts) {
+        writer.raw(entry.name);
+        writer.raw(':');
+        writer.integer(entry.count);
+        writer.raw("!!");
+    }
     
-    // Initialize counts for all selected classes to 0
-    std::unordered_map<std::string, int> class_counts;
-    if (result.selected_classes.empty()) {
-        // If no classes specified, initialize "person" as default
-        class_counts["person"] = 0;
+    // Add timestamp
+    writer.raw("timestamp:");
+    writer.integer(timestampOf(result));
+}
+
+// PublishSink implementation
+static const auto REPORT_INTERVAL = std::chrono::seconds(60);
+
+static PublishSink::clock::duration toDuration(double seconds) {
+    return std::chrono::duration_cast<PublishSink::clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+static double millisecondsBetween(PublishSink::clock::time_point from, PublishSink::clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+PublishSink::PublishSink(
+        std::shared_ptr<Transport> transport,
+        std::shared_ptr<MessageFormatter> formatter,
+        double messages_per_second,
+        const std::string& name)
+    : transport(transport),
+      formatter(formatter),
+      target_mps(messages_per_second > 0 ? messages_per_second : 1),
+      period(toDuration(1.0 / target_mps)),
+      sink_name(name) {
+}
+
+void PublishSink::start(clock::time_point now) {
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        window.start = now;
+        dropped_at_start = transport->dropped();
+    }
+    last_report = now;
+    dropped_at_report = dropped_at_start;
+    deadline = now;
+    last_send = now - std::max(toDuration(change_policy.heartbeat_seconds), period);
+}
+
+void PublishSink::offer(std::shared_ptr<const InferenceResult> result, clock::time_point now) {
+    formatter->observe(*result);
+    if (!change_policy.enabled) {
+        pending = std::move(result);
+        return;
+    }
+
+    uint64_t key = formatter->changeKey(*result);
+    if (candidate_count > 0 && key == candidate_key) {
+        candidate_count++;
     } else {
-        // Initialize all selected classes with 0
-        for (int class_id : result.selected_classes) {
-            std::string class_name = getClassNameById(class_id, result.class_mapping);
-            std::string mapped_name = mapClassName(class_name);
-            class_counts[mapped_name] = 0;
+        candidate_key = key;
+        candidate_count = 1;
+    }
+
+    // A new state counts once it has lasted `hysteresis` results in a row
+    if (candidate_count >= std::max(1, change_policy.hysteresis)) {
+        if (!stable_result || key != stable_key) {
+            stable_key = key;
+            changed_at = now;
         }
+        stable_result = std::move(result);
+    } else if (stable_result && key == stable_key) {
+        stable_result = std::move(result);
     }
-    
-    // Count detections by class name for selected classes only
-    for (const auto& detection : selected_detections) {
-        std::string class_name = std::string(detection.name);
-        std::string mapped_name = mapClassName(class_name);
-        if (class_counts.find(mapped_name) != class_counts.end()) {
-            class_counts[mapped_name]++;
+}
+
+PublishSink::clock::time_point PublishSink::changeDue() const {
+    bool changed = !has_sent || stable_key != sent_key;
+    return changed ? std::max(last_send + period, changed_at)
+                   : last_send + toDuration(change_policy.heartbeat_seconds);
+}
+
+void PublishSink::poll(clock::time_point now) {
+    if (!change_policy.enabled) {
+        if (now >= deadline) {
+            double lateness_ms = millisecondsBetween(deadline, now);
+
+            // Next deadline on the fixed grid, skipping any that already passed
+            long missed = 0;
+            deadline += period;
+            if (deadline <= now) {
+                missed = (now - deadline) / period + 1;
+                deadline += missed * period;
+            }
+
+            if (pending) {
+                send(*pending, lateness_ms, missed);
+                pending.reset();
+            } else {
+                std::lock_guard<std::mutex> lock(stats_mutex);
+                window.stale++;
+                window.missed += missed;
+            }
+        }
+    } else if (stable_result) {
+        auto due = changeDue();
+        if (now >= due) {
+            send(*stable_result, millisecondsBetween(due, now), 0);
+            sent_key = stable_key;
+            has_sent = true;
+            last_send = now;
         }
     }
-    
-    // Add class counts to JSON
-    for (const auto& [class_name, count] : class_counts) {
-        j[class_name] = count;
+
+    if (now - last_report >= REPORT_INTERVAL) {
+        report(now);
     }
-    
-    return j.dump();
 }
 
-// Implementation of the SelectiveBSMessageFormatter
-std::string SelectiveBSMessageFormatter::formatMessage(const InferenceResult& result) {
-    // Extract only selected class detections
-    std::vector<object_detect_result> selected_detections = extractSelectedClasses(result);
-    
-    // Initialize counts for all selected classes to 0
-    std::unordered_map<std::string, int> class_counts;
-    if (result.selected_classes.empty()) {
-        // If no classes specified, initialize "person" as default
-        class_counts["person"] = 0;
-    } else {
-        // Initialize all selected classes with 0
-        for (int class_id : result.selected_classes) {
-            std::string class_name = getClassNameById(class_id, result.class_mapping);
-            std::string mapped_name = mapClassName(class_name);
-            class_counts[mapped_name] = 0;
-        }
+PublishSink::clock::time_point PublishSink::nextWake() const {
+    auto wake = last_report + REPORT_INTERVAL;
+    if (!change_policy.enabled) {
+        wake = std::min(wake, deadline);
+    } else if (stable_result) {
+        wake = std::min(wake, changeDue());
     }
-    
-    // Count detections by class name for selected classes only
-    for (const auto& detection : selected_detections) {
-        std::string class_name = std::string(detection.name);
-        std::string mapped_name = mapClassName(class_name);
-        if (class_counts.find(mapped_name) != class_counts.end()) {
-            class_counts[mapped_name]++;
-        }
+    return wake;
+}
+
+void PublishSink::finish(clock::time_point now) {
+    report(now);
+}
+
+void PublishSink::send(const InferenceResult& result, double lateness_ms, long missed) {
+    if (!transport->isConnected()) {
+        std::cerr << "Transport not connected, skipping message" << std::endl;
+        return;
     }
     
-    // Build BrightScript format message
-    std::string message;
-    bool first = true;
-    
-    for (const auto& [class_name, count] : class_counts) {
-        if (!first) {
-            message += "!!";
+    formatter->formatInto(result, message_buffer);
+    bool ok = transport->send(message_buffer);
+
+    double age_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::system_clock::now() - result.timestamp).count();
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    if (!ok) {
+        // Once per report; the report has the count
+        if (window.failed++ == 0) {
+            std::cerr << "Failed to send message via transport (" << sink_name << ")" << std::endl;
         }
-        message += class_name + ":" + std::to_string(count);
-        first = false;
     }
-    
-    // Add timestamp
-    if (!message.empty()) {
-        message += "!!";
+    window.sent++;
+    window.missed += missed;
+    window.lateness_sum_ms += lateness_ms;
+    window.lateness_max_ms = std::max(window.lateness_max_ms, lateness_ms);
+    window.age_sum_ms += age_ms;
+    window.age_max_ms = std::max(window.age_max_ms, age_ms);
+}
+
+void PublishSink::report(clock::time_point now) {
+    PublishStats stats;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats = window.summarize(now, change_policy.enabled ? target_mps : 0.0);
+        totals.add(window);
+        window = StatsWindow();
+        window.start = now;
     }
-    message += "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
-    
-    return message;
+    long dropped = transport->dropped();
+    stats.dropped = dropped - dropped_at_report;
+    dropped_at_report = dropped;
+    last_report = now;
+    if (stats.sent == 0 && stats.stale == 0) {
+        return;
+    }
+    if (change_policy.enabled) {
+        printf("Publisher %s: %ld sent on change or heartbeat, %ld sends avoided against %.2f msg/s; "
+               "change delay mean %.2f ms max %.2f ms; result age mean %.1f ms max %.1f ms\n",
+               sink_name.c_str(), stats.sent, stats.avoided, target_mps, stats.lateness_mean_ms,
+               stats.lateness_max_ms, stats.age_mean_ms, stats.age_max_ms);
+    } else {
+        printf("Publisher %s: %.2f msg/s (target %.2f), %ld sent, %ld without a new result, %ld deadlines missed; "
+               "lateness mean %.2f ms max %.2f ms; result age mean %.1f ms max %.1f ms\n",
+               sink_name.c_str(), stats.rate, target_mps, stats.sent, stats.stale, stats.missed,
+               stats.lateness_mean_ms, stats.lateness_max_ms, stats.age_mean_ms, stats.age_max_ms);
+    }
+    if (stats.failed > 0 || stats.dropped > 0) {
+        printf("Publisher %s: %ld sends failed, %ld dropped by the transport\n",
+               sink_name.c_str(), stats.failed, stats.dropped);
+    }
+}
+
+PublishStats PublishSink::stats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    StatsWindow all = totals;
+    all.add(window);
+    PublishStats stats = all.summarize(clock::now(), change_policy.enabled ? target_mps : 0.0);
+    stats.dropped = transport->dropped() - dropped_at_start;
+    return stats;
+}
+
+void PublishSink::StatsWindow::add(const StatsWindow& other) {
+    if (sent == 0 && stale == 0 && missed == 0) {
+        start = other.start;
+    }
+    sent += other.sent;
+    stale += other.stale;
+    missed += other.missed;
+    failed += other.failed;
+    lateness_sum_ms += other.lateness_sum_ms;
+    lateness_max_ms = std::max(lateness_max_ms, other.lateness_max_ms);
+    age_sum_ms += other.age_sum_ms;
+    age_max_ms = std::max(age_max_ms, other.age_max_ms);
+}
+
+PublishStats PublishSink::StatsWindow::summarize(clock::time_point now, double periodic_rate) const {
+    PublishStats stats;
+    stats.sent = sent;
+    stats.stale = stale;
+    stats.missed = missed;
+    stats.failed = failed;
+    double seconds = std::chrono::duration<double>(now - start).count();
+    stats.rate = seconds > 0 ? sent / seconds : 0.0;
+    if (sent > 0) {
+        stats.lateness_mean_ms = lateness_sum_ms / sent;
+        stats.age_mean_ms = age_sum_ms / sent;
+    }
+    stats.lateness_max_ms = lateness_max_ms;
+    stats.age_max_ms = age_max_ms;
+    // Sends a periodic publisher would have made over the same time
+    stats.avoided = std::max(0L, static_cast<long>(seconds * periodic_rate) - sent);
+    return stats;
 }
 
 // Generic Publisher implementation
@@ -242,76 +477,293 @@ Publisher::Publisher(
         ThreadSafeQueue<InferenceResult>& queue, 
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
-        int messages_per_second)
-    : transport(transport),
-      resultQueue(queue), 
+        double messages_per_second,
+        const std::string& name)
+    : resultQueue(queue), 
       running(isRunning), 
-      target_mps(messages_per_second),
-      formatter(formatter) {
+      sink(transport, formatter, messages_per_second, name) {
 }
 
 void Publisher::operator()() {
-    InferenceResult result;
-    while (resultQueue.pop(result)) {
-        if (!transport->isConnected()) {
-            std::cerr << "Transport not connected, skipping message" << std::endl;
-            continue;
+    using clock = PublishSink::clock;
+    sink.start(clock::now());
+
+    // A periodic sink only needs the newest result at each deadline; one
+    // publishing on change looks at every result
+    bool on_change = sink.changePolicy().enabled;
+    uint64_t version = 0;
+    while (running) {
+        auto wake = sink.nextWake();
+        if (!(on_change ? resultQueue.waitNewer(version, wake) : resultQueue.waitUntil(wake))) {
+            break;
         }
-        
-        std::string message = formatter->formatMessage(result);
-        
-        if (!transport->send(message)) {
-            std::cerr << "Failed to send message via transport" << std::endl;
+        std::shared_ptr<const InferenceResult> result = resultQueue.latest(version);
+        auto now = clock::now();
+        if (result) {
+            sink.offer(std::move(result), now);
         }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / target_mps));
+        sink.poll(now);
     }
+
+    sink.finish(clock::now());
 }
 
 // Implementation of the FullJsonMessageFormatter
-std::string FullJsonMessageFormatter::formatMessage(const InferenceResult& result) {
-    json j;
-    
-    // Add timestamp
-    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
-    
-    // Create detections array
-    json detections = json::array();
+void FullJsonMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    out.clear();
+
+    // Valid detections of selected classes, at any confidence
+    const std::vector<int>& listed = result.view().listed;
+    int detection_count = static_cast<int>(listed.size());
     
-    for (int i = 0; i < result.detections.count; ++i) {
+    // Handle suppress_empty flag
+    if (suppress_empty && detection_count == 0) {
+        return;
+    }
+
+    // Keys in the sorted order nlohmann::json objects use
+    MessageWriter writer(out);
+    writer.raw("{\"detection_count\":");
+    writer.integer(detection_count);
+    writer.raw(",\"detections\":[");
+    bool first = true;
+    for (int i : listed) {
         const auto& detection = result.detections.results[i];
-        
-        // Skip invalid detections or if not in selected classes
-        if ((detection.prop <= 0.0f || detection.cls_id < 0) || 
-            !isClassSelected(detection.cls_id, result.selected_classes)) {
+        writer.raw(first ? "{\"bbox\":{\"bottom\":" : ",{\"bbox\":{\"bottom\":");
+        writer.integer(detection.box.bottom);
+        writer.raw(",\"left\":");
+        writer.integer(detection.box.left);
+        writer.raw(",\"right\":");
+        writer.integer(detection.box.right);
+        writer.raw(",\"top\":");
+        writer.integer(detection.box.top);
+        writer.raw("},\"class_id\":");
+        writer.integer(detection.cls_id);
+        writer.raw(",\"class_name\":");
+        writer.string(std::string_view(detection.name, strnlen(detection.name, sizeof(detection.name))));
+        writer.raw(",\"confidence\":");
+        writer.number(detection.prop);
+        writer.raw('}');
+        first = false;
+    }
+    writer.raw("],\"timestamp\":");
+    writer.integer(timestampOf(result));
+    writer.raw('}');
+}
+
+// Implementation of the BinaryMessageFormatter
+BinaryMessageFormatter::BinaryMessageFormatter(int keyframe_interval) {
+    wire_encoder_init(&encoder, keyframe_interval);
+    memset(&frame, 0, sizeof(frame));
+}
+
+void BinaryMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    const std::vector<int>& listed = result.view().listed;
+    frame.model_id = result.model_id;
+    frame.sequence = result.frame_id;
+    frame.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        result.timestamp.time_since_epoch()).count();
+    frame.box_count = std::min(static_cast<int>(listed.size()), WIRE_MAX_BOXES);
+    for (int i = 0; i < frame.box_count; i++) {
+        const auto& detection = result.detections.results[listed[i]];
+        frame.boxes[i] = {detection.box.left, detection.box.top, detection.box.right, detection.box.bottom,
+                          detection.prop, detection.cls_id};
+    }
+
+    out.resize(WIRE_MAX_MESSAGE_SIZE);
+    int size = wire_encode(&encoder, &frame, reinterpret_cast<uint8_t*>(out.data()), out.size());
+    out.resize(size > 0 ? size : 0);
+}
+
+// Implementation of the HistoryRecordFormatter
+HistoryRecordFormatter::HistoryRecordFormatter(const HistoryLayout& layout) : layout(layout) {
+    this->layout.box_capacity = std::clamp(layout.box_capacity, 0, HISTORY_MAX_BOXES);
+    record_size = history_record_size(static_cast<uint16_t>(layout.class_ids.size()),
+                                      static_cast<uint16_t>(this->layout.box_capacity));
+}
+
+void HistoryRecordFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    const std::vector<int>& selected = result.view().selected;
+    out.assign(record_size, '\0');
+
+    history_record_t* record = reinterpret_cast<history_record_t*>(out.data());
+    record->timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        result.timestamp.time_since_epoch()).count();
+    record->frame_id = static_cast<uint32_t>(result.frame_id);
+    record->detections = static_cast<uint16_t>(std::min<size_t>(selected.size(), UINT16_MAX));
+
+    uint16_t* counts = reinterpret_cast<uint16_t*>(record + 1);
+    history_box_t* boxes = reinterpret_cast<history_box_t*>(counts + layout.class_ids.size());
+    for (int index : selected) {
+        const auto& detection = result.detections.results[index];
+        auto it = std::find(layout.class_ids.begin(), layout.class_ids.end(), detection.cls_id);
+        if (it == layout.class_ids.end()) {
             continue;
         }
-        
-        // Create detection object with all details
-        json det;
-        det["class_id"] = detection.cls_id;
-        det["class_name"] = std::string(detection.name);
-        det["confidence"] = detection.prop;
-        det["bbox"] = {
-            {"left", detection.box.left},
-            {"top", detection.box.top},
-            {"right", detection.box.right},
-            {"bottom", detection.box.bottom}
-        };
-        
-        detections.push_back(det);
+        size_t class_index = it - layout.class_ids.begin();
+        if (counts[class_index] < UINT16_MAX) {
+            counts[class_index]++;
+        }
+        if (record->box_count < layout.box_capacity) {
+            auto coordinate = [](int value) {
+                return static_cast<int16_t>(std::clamp(value, INT16_MIN, INT16_MAX));
+            };
+            boxes[record->box_count++] = {
+                coordinate(detection.box.left), coordinate(detection.box.top),
+                coordinate(detection.box.right), coordinate(detection.box.bottom),
+                static_cast<uint16_t>(std::clamp(detection.prop, 0.0f, 1.0f) * 65535.0f + 0.5f),
+                static_cast<uint16_t>(class_index)};
+        }
     }
-    
-    // Add detections array to JSON
-    j["detections"] = detections;
-    j["detection_count"] = detections.size();
-    
-    // Handle suppress_empty flag
-    if (suppress_empty && detections.empty()) {
-        return "";
+}
+
+// Implementation of the AnalyticsMessageFormatter
+AnalyticsMessageFormatter::AnalyticsMessageFormatter(const std::vector<double>& window_seconds)
+    : window_seconds(window_seconds) {
+    for (double seconds : window_seconds) {
+        window_names.push_back(rollingWindowName(seconds));
     }
-    
-    return j.dump();
+}
+
+void AnalyticsMessageFormatter::observe(const InferenceResult& result) {
+    // Once per frame, even if the result is offered again
+    if (result.frame_id != 0 && result.frame_id <= last_frame_id) {
+        return;
+    }
+    last_frame_id = result.frame_id;
+
+    // The selected classes are the first names of every view, in the same order
+    const ResultView& view = result.view();
+    if (windows.empty()) {
+        class_names.assign(view.class_names.begin(), view.class_names.begin() + view.selected_names);
+        counts.resize(class_names.size());
+        for (double seconds : window_seconds) {
+            windows.emplace_back(seconds, class_names.size());
+        }
+    }
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = static_cast<uint16_t>(i < view.selected_names ? std::min(view.class_counts[i], 65535) : 0);
+    }
+
+    uint64_t timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        result.timestamp.time_since_epoch()).count();
+    for (auto& window : windows) {
+        window.add(timestamp_ms, counts.data());
+    }
+}
+
+void AnalyticsMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    auto rounded = [](double value) { return std::round(value * 1000.0) / 1000.0; };
+
+    out.clear();
+    MessageWriter writer(out);
+    writer.raw('{');
+    for (size_t c = 0; c < class_names.size(); c++) {
+        writer.string(class_names[c]);
+        writer.raw(":{");
+        for (size_t w = 0; w < windows.size(); w++) {
+            RollingWindow::ClassStats stats = windows[w].stats(c);
+            writer.raw(w ? "," : "");
+            writer.string(window_names[w]);
+            writer.raw(":{\"frames\":");
+            writer.integer(static_cast<long long>(windows[w].frames()));
+            writer.raw(",\"mean\":");
+            writer.number(rounded(stats.mean));
+            writer.raw(",\"max\":");
+            writer.integer(stats.max);
+            writer.raw(",\"p50\":");
+            writer.integer(stats.p50);
+            writer.raw(",\"p95\":");
+            writer.integer(stats.p95);
+            writer.raw(",\"occupancy\":");
+            writer.number(rounded(stats.occupancy));
+            writer.raw('}');
+        }
+        writer.raw("},");
+    }
+    writer.raw("\"timestamp\":");
+    writer.integer(timestampOf(result));
+    writer.raw('}');
+}
+
+// Implementation of the ZoneMessageFormatter
+size_t ZoneMessageFormatter::countZones(const InferenceResult& result) {
+    const ResultView& view = result.view();
+    size_t classes = view.selected_names;
+    counts.assign(zones->size() * classes, 0);
+
+    for (int index : view.selected) {
+        const auto& detection = result.detections.results[index];
+        // The first view names are the selected classes ("person" when none
+        // are), so with no selection every other class is left out
+        std::string_view name(detection.name, strnlen(detection.name, sizeof(detection.name)));
+        size_t class_index = std::find(view.class_names.begin(), view.class_names.begin() + classes, name) -
+                             view.class_names.begin();
+        if (class_index >= classes) {
+            continue;
+        }
+        for (uint64_t in = zones->zonesOf(detection.box); in; in &= in - 1) {
+            counts[__builtin_ctzll(in) * classes + class_index]++;
+        }
+    }
+    return classes;
+}
+
+void ZoneMessageFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    size_t classes = countZones(result);
+    const ResultView& view = result.view();
+
+    out.clear();
+    MessageWriter writer(out);
+    writer.raw("{\"zones\":{");
+    for (size_t z = 0; z < zones->size(); z++) {
+        writer.raw(z ? "," : "");
+        writer.string(zones->name(z));
+        writer.raw(":{");
+        for (size_t c = 0; c < classes; c++) {
+            writer.raw(c ? "," : "");
+            writer.string(view.class_names[c]);
+            writer.raw(':');
+            writer.integer(counts[z * classes + c]);
+        }
+        writer.raw('}');
+    }
+    writer.raw("},\"timestamp\":");
+    writer.integer(timestampOf(result));
+    writer.raw('}');
+}
+
+uint64_t ZoneMessageFormatter::changeKey(const InferenceResult& result) {
+    countZones(result);
+    uint64_t hash = HASH_SEED;
+    hashValue(hash, counts.data(), counts.size() * sizeof(int));
+    return hash;
+}
+
+// Implementation of the HeatmapFormatter
+void HeatmapFormatter::observe(const InferenceResult& result) {
+    // Once per frame, even if the result is offered again
+    if (result.frame_id != 0 && result.frame_id <= last_frame_id) {
+        return;
+    }
+    last_frame_id = result.frame_id;
+
+    // The size the source actually delivers, which may not be the one requested
+    if (result.frame_width > 0 && result.frame_height > 0) {
+        heatmap.setFrameSize(result.frame_width, result.frame_height);
+    }
+
+    boxes.clear();
+    for (int index : result.view().selected) {
+        boxes.push_back(result.detections.results[index].box);
+    }
+    uint64_t timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        result.timestamp.time_since_epoch()).count();
+    heatmap.add(timestamp_ms, boxes.data(), boxes.size());
+}
+
+void HeatmapFormatter::formatInto(const InferenceResult& result, std::string& out) {
+    heatmap.encode(format, out);
 }
 
 // UDPPublisher backward compatibility wrapper
@@ -321,6 +773,7 @@ UDPPublisher::UDPPublisher(
         ThreadSafeQueue<InferenceResult>& queue, 
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
-        int messages_per_second)
-    : Publisher(std::make_shared<UDPTransport>(ip, port), queue, isRunning, formatter, messages_per_second) {
+        double messages_per_second)
+    : Publisher(std::make_shared<UDPTransport>(ip, port), queue, isRunning, formatter, messages_per_second,
+                "udp " + ip + ":" + std::to_string(port)) {
 }
\ No newline at end of file
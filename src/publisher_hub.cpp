@@ -0,0 +1,127 @@
+#include "publisher_hub.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+PublisherHub::PublisherHub(ThreadSafeQueue<InferenceResult>& queue, std::atomic<bool>& isRunning)
+    : resultQueue(queue),
+      running(isRunning) {
+}
+
+PublisherHub::~PublisherHub() {
+    if (timer_fd >= 0) {
+        close(timer_fd);
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+}
+
+PublishSink& PublisherHub::addSink(
+        std::shared_ptr<Transport> transport,
+        std::shared_ptr<MessageFormatter> formatter,
+        double messages_per_second,
+        const std::string& name) {
+    sinks.push_back(std::make_unique<PublishSink>(transport, formatter, messages_per_second, name));
+    return *sinks.back();
+}
+
+bool PublisherHub::setupEvents() {
+    result_fd = resultQueue.notifyFd();
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (result_fd < 0 || epoll_fd < 0 || timer_fd < 0) {
+        perror("publisher hub: epoll_create1/timerfd_create");
+        return false;
+    }
+
+    struct epoll_event result_event = {};
+    result_event.events = EPOLLIN;
+    result_event.data.fd = result_fd;
+    struct epoll_event timer_event = {};
+    timer_event.events = EPOLLIN;
+    timer_event.data.fd = timer_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, result_fd, &result_event) < 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &timer_event) < 0) {
+        perror("publisher hub: epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+bool PublisherHub::waitEvents(PublishSink::clock::time_point wake) {
+    // steady_clock is CLOCK_MONOTONIC, so deadlines arm the timer directly.
+    // A deadline already passed still needs a non-zero time to fire at.
+    auto since_epoch = std::max(wake.time_since_epoch(), PublishSink::clock::duration(1));
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = seconds.count();
+    spec.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count();
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        perror("publisher hub: timerfd_settime");
+        return false;
+    }
+
+    struct epoll_event events[2];
+    int ready = epoll_wait(epoll_fd, events, 2, -1);
+    if (ready < 0 && errno != EINTR) {
+        perror("publisher hub: epoll_wait");
+        return false;
+    }
+
+    // Both descriptors are non-blocking; reading resets them
+    uint64_t count;
+    for (int i = 0; i < ready; i++) {
+        ssize_t ignored = read(events[i].data.fd, &count, sizeof(count));
+        (void)ignored;
+    }
+    return !resultQueue.isShutdown();
+}
+
+void PublisherHub::operator()() {
+    using clock = PublishSink::clock;
+    if (sinks.empty()) {
+        return;
+    }
+
+    bool have_events = setupEvents();
+    if (!have_events) {
+        printf("Publisher hub: falling back to condition variable waits\n");
+    }
+
+    auto now = clock::now();
+    for (auto& sink : sinks) {
+        sink->start(now);
+    }
+
+    uint64_t version = 0;
+    while (running) {
+        auto wake = clock::time_point::max();
+        for (auto& sink : sinks) {
+            wake = std::min(wake, sink->nextWake());
+        }
+        if (!(have_events ? waitEvents(wake) : resultQueue.waitNewer(version, wake))) {
+            break;
+        }
+
+        // One read of the queue, shared by every sink
+        std::shared_ptr<const InferenceResult> result = resultQueue.latest(version);
+        now = clock::now();
+        for (auto& sink : sinks) {
+            if (result) {
+                sink->offer(result, now);
+            }
+            sink->poll(now);
+        }
+    }
+
+    now = clock::now();
+    for (auto& sink : sinks) {
+        sink->finish(now);
+    }
+}
@@ -0,0 +1,189 @@
+#include "redaction.h"
+#include "inference.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Largest blur radius; keeps the column sums well within 32 bits
+static const int MAX_RADIUS = 255;
+
+bool parseRedactionMode(const std::string& text, RedactionMode& mode) {
+    if (text == "pixelate") {
+        mode = RedactionMode::Pixelate;
+    } else if (text == "blur") {
+        mode = RedactionMode::Blur;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The loops over channels unroll for each channel count
+template <int C>
+static void pixelateBlocks(uint8_t* pixels, size_t step, int x, int y, int w, int h, int block) {
+    for (int by = 0; by < h; by += block) {
+        int rows = std::min(block, h - by);
+        for (int bx = 0; bx < w; bx += block) {
+            int cols = std::min(block, w - bx);
+            uint32_t sums[C] = {};
+            for (int j = 0; j < rows; j++) {
+                const uint8_t* p = pixels + (y + by + j) * step + (x + bx) * C;
+                for (int i = 0; i < cols; i++, p += C) {
+                    for (int c = 0; c < C; c++) {
+                        sums[c] += p[c];
+                    }
+                }
+            }
+            uint32_t count = static_cast<uint32_t>(rows * cols);
+            uint8_t mean[C];
+            for (int c = 0; c < C; c++) {
+                mean[c] = static_cast<uint8_t>((sums[c] + count / 2) / count);
+            }
+            // Fill the block's first row, then copy it down
+            uint8_t* first = pixels + (y + by) * step + (x + bx) * C;
+            for (int i = 0; i < cols; i++) {
+                memcpy(first + i * C, mean, C);
+            }
+            for (int j = 1; j < rows; j++) {
+                memcpy(first + j * step, first, cols * C);
+            }
+        }
+    }
+}
+
+void pixelateRegion(uint8_t* pixels, size_t step, int channels, int x, int y, int w, int h, int block) {
+    block = std::max(block, 1);
+    switch (channels) {
+    case 1:
+        pixelateBlocks<1>(pixels, step, x, y, w, h, block);
+        break;
+    case 2:
+        pixelateBlocks<2>(pixels, step, x, y, w, h, block);
+        break;
+    case 3:
+        pixelateBlocks<3>(pixels, step, x, y, w, h, block);
+        break;
+    case 4:
+        pixelateBlocks<4>(pixels, step, x, y, w, h, block);
+        break;
+    }
+}
+
+// The running sum of the window at each pixel of one row
+template <int C>
+static void sumAcross(const uint8_t* src, uint32_t* out, int w, int radius) {
+    uint32_t sum[C];
+    for (int c = 0; c < C; c++) {
+        sum[c] = (radius + 1) * src[c];
+    }
+    for (int i = 1; i <= radius; i++) {
+        const uint8_t* p = src + std::min(i, w - 1) * C;
+        for (int c = 0; c < C; c++) {
+            sum[c] += p[c];
+        }
+    }
+    for (int i = 0; i < w; i++, out += C) {
+        const uint8_t* enter = src + std::min(i + radius + 1, w - 1) * C;
+        const uint8_t* leave = src + std::max(i - radius, 0) * C;
+        for (int c = 0; c < C; c++) {
+            out[c] = sum[c];
+            sum[c] += enter[c];
+            sum[c] -= leave[c];
+        }
+    }
+}
+
+void blurRegion(uint8_t* pixels, size_t step, int channels, int x, int y, int w, int h, int radius,
+                std::vector<uint32_t>& scratch) {
+    if (channels < 1 || channels > 4) {
+        return;
+    }
+    radius = std::clamp(radius, 1, MAX_RADIUS);
+    const size_t row_size = static_cast<size_t>(w) * channels;
+    scratch.resize(row_size * (h + 1));
+    uint32_t* across = scratch.data();               // Window sums along each row
+    uint32_t* down = scratch.data() + row_size * h;  // Window sums of those down each column
+
+    for (int j = 0; j < h; j++) {
+        const uint8_t* src = pixels + (y + j) * step + x * channels;
+        uint32_t* out = across + j * row_size;
+        switch (channels) {
+        case 1:
+            sumAcross<1>(src, out, w, radius);
+            break;
+        case 2:
+            sumAcross<2>(src, out, w, radius);
+            break;
+        case 3:
+            sumAcross<3>(src, out, w, radius);
+            break;
+        case 4:
+            sumAcross<4>(src, out, w, radius);
+            break;
+        }
+    }
+
+    // Down the columns, a whole row at a time so the loops vectorize
+    const float scale = 1.0f / static_cast<float>((2 * radius + 1) * (2 * radius + 1));
+    for (size_t k = 0; k < row_size; k++) {
+        down[k] = (radius + 1) * across[k];
+    }
+    for (int j = 1; j <= radius; j++) {
+        const uint32_t* row = across + std::min(j, h - 1) * row_size;
+        for (size_t k = 0; k < row_size; k++) {
+            down[k] += row[k];
+        }
+    }
+    for (int j = 0; j < h; j++) {
+        uint8_t* dst = pixels + (y + j) * step + x * channels;
+        for (size_t k = 0; k < row_size; k++) {
+            dst[k] = static_cast<uint8_t>(static_cast<float>(down[k]) * scale + 0.5f);
+        }
+        const uint32_t* enter = across + std::min(j + radius + 1, h - 1) * row_size;
+        const uint32_t* leave = across + std::max(j - radius, 0) * row_size;
+        for (size_t k = 0; k < row_size; k++) {
+            down[k] += enter[k] - leave[k];
+        }
+    }
+}
+
+bool Redactor::regionOf(const box_rect_t& box, float padding, int width, int height, int& x, int& y, int& w, int& h) {
+    int pad_x = static_cast<int>(std::lround((box.right - box.left) * padding));
+    int pad_y = static_cast<int>(std::lround((box.bottom - box.top) * padding));
+    int left = std::max(box.left - pad_x, 0);
+    int top = std::max(box.top - pad_y, 0);
+    int right = std::min(box.right + pad_x, width);
+    int bottom = std::min(box.bottom + pad_y, height);
+    if (right <= left || bottom <= top) {
+        return false;
+    }
+    x = left;
+    y = top;
+    w = right - left;
+    h = bottom - top;
+    return true;
+}
+
+void Redactor::apply(cv::Mat& frame, const InferenceResult& result) {
+    if (!enabled() || frame.empty() || frame.depth() != CV_8U || frame.channels() > 4) {
+        return;
+    }
+    for (int i = 0; i < result.detections.count; i++) {
+        const object_detect_result_t& detection = result.detections.results[i];
+        if (detection.prop <= 0.0f || detection.cls_id < 0 ||
+            std::find(config.class_ids.begin(), config.class_ids.end(), detection.cls_id) == config.class_ids.end()) {
+            continue;
+        }
+        int x, y, w, h;
+        if (!regionOf(detection.box, config.padding, frame.cols, frame.rows, x, y, w, h)) {
+            continue;
+        }
+        // Coarse enough to hide a face at any distance: about 8 blocks across
+        int strength = config.strength > 0 ? config.strength : std::max(4, std::min(w, h) / 8);
+        if (config.mode == RedactionMode::Pixelate) {
+            pixelateRegion(frame.data, frame.step[0], frame.channels(), x, y, w, h, strength);
+        } else {
+            blurRegion(frame.data, frame.step[0], frame.channels(), x, y, w, h, strength, scratch);
+        }
+    }
+}
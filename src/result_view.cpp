@@ -0,0 +1,90 @@
+#include "result_view.h"
+#include "inference.h"
+#include "utils.h"
+
+#include <cstring>
+#include <string_view>
+
+// Same result as getClassNameById(), without copying the name
+static std::string_view classNameById(int class_id, const std::unordered_map<std::string, int>& class_mapping) {
+    for (const auto& [name, id] : class_mapping) {
+        if (id == class_id) {
+            return name;
+        }
+    }
+    return "unknown";
+}
+
+// Index of name in the view's class names, adding it with a zero count if new
+static size_t classIndex(ResultView& view, std::string_view name) {
+    for (size_t i = 0; i < view.class_names.size(); i++) {
+        if (view.class_names[i] == name) {
+            return i;
+        }
+    }
+    view.class_names.emplace_back(name);
+    view.class_counts.push_back(0);
+    return view.class_names.size() - 1;
+}
+
+void ResultView::build(const InferenceResult& result) {
+    selected.clear();
+    listed.clear();
+    above_threshold = 0;
+    people = 0;
+    class_names.clear();
+    class_counts.clear();
+
+    // A fresh view for each frame, so size it once up front
+    selected.reserve(result.detections.count);
+    listed.reserve(result.detections.count);
+    class_names.reserve(result.selected_classes.size() + 1);
+    class_counts.reserve(result.selected_classes.size() + 1);
+
+    // Every selected class gets an entry, even with no detections
+    if (result.selected_classes.empty()) {
+        // If no classes specified, "person" is the default
+        classIndex(*this, "person");
+    } else {
+        for (int class_id : result.selected_classes) {
+            classIndex(*this, classNameById(class_id, result.class_mapping));
+        }
+    }
+    selected_names = class_names.size();
+
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        bool above = detection.prop >= result.confidence_threshold;
+
+        if (detection.cls_id == 0 && above) {
+            people++;
+        }
+
+        // Skip invalid detections
+        if (detection.prop <= 0.0f || detection.cls_id < 0) {
+            continue;
+        }
+        if (above) {
+            above_threshold++;
+        }
+        if (!isClassSelected(detection.cls_id, result.selected_classes)) {
+            continue;
+        }
+
+        listed.push_back(i);
+        if (above) {
+            selected.push_back(i);
+            class_counts[classIndex(*this, std::string_view(detection.name, strnlen(detection.name, sizeof(detection.name))))]++;
+        }
+    }
+}
+
+const ResultView& InferenceResult::view() const {
+    if (view_cache) {
+        std::call_once(view_cache->once, [this] { view_cache->view.build(*this); });
+        return view_cache->view;
+    }
+    thread_local ResultView scratch;
+    scratch.build(*this);
+    return scratch;
+}
@@ -0,0 +1,175 @@
+#include "rolling_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+RollingWindow::RollingWindow(double seconds, size_t class_count)
+    : bucket_ms(std::max<uint64_t>(1, static_cast<uint64_t>(seconds * 1000.0 / BUCKETS))),
+      class_count(class_count),
+      cells(BUCKETS * class_count),
+      bucket_frames(BUCKETS),
+      totals(class_count) {
+}
+
+// Exact to 15, then 4 bins for each doubling to 127, then one for the rest
+int RollingWindow::bin(unsigned count) {
+    if (count < 16) {
+        return count;
+    }
+    if (count < 32) {
+        return 16 + (count - 16) / 4;
+    }
+    if (count < 64) {
+        return 20 + (count - 32) / 8;
+    }
+    if (count < 128) {
+        return 24 + (count - 64) / 16;
+    }
+    return 28;
+}
+
+int RollingWindow::binStart(int bin) {
+    if (bin < 16) {
+        return bin;
+    }
+    if (bin < 20) {
+        return 16 + (bin - 16) * 4;
+    }
+    if (bin < 24) {
+        return 32 + (bin - 20) * 8;
+    }
+    if (bin < 28) {
+        return 64 + (bin - 24) * 16;
+    }
+    return 128;
+}
+
+void RollingWindow::advance(uint64_t bucket) {
+    if (!started) {
+        newest = bucket;
+        started = true;
+        return;
+    }
+    // Late frames (a clock stepped back) count in the newest bucket
+    if (bucket <= newest) {
+        return;
+    }
+
+    uint64_t steps = std::min<uint64_t>(bucket - newest, BUCKETS);
+    for (uint64_t step = 1; step <= steps; step++) {
+        size_t slot = (newest + step) % BUCKETS;
+        Cell* slot_cells = &cells[slot * class_count];
+        for (size_t c = 0; c < class_count; c++) {
+            Cell& cell = slot_cells[c];
+            Totals& total = totals[c];
+            total.sum -= cell.sum;
+            total.occupied -= cell.occupied;
+            for (int b = 0; b < BINS; b++) {
+                total.histogram[b] -= cell.histogram[b];
+            }
+            cell = Cell();
+        }
+        total_frames -= bucket_frames[slot];
+        bucket_frames[slot] = 0;
+    }
+    newest = bucket;
+}
+
+void RollingWindow::add(uint64_t timestamp_ms, const uint16_t* counts) {
+    advance(timestamp_ms / bucket_ms);
+
+    size_t slot = newest % BUCKETS;
+    Cell* slot_cells = &cells[slot * class_count];
+    for (size_t c = 0; c < class_count; c++) {
+        uint16_t count = counts[c];
+        int b = bin(count);
+        Cell& cell = slot_cells[c];
+        cell.sum += count;
+        cell.occupied += count > 0;
+        cell.max = std::max(cell.max, count);
+        cell.histogram[b]++;
+
+        Totals& total = totals[c];
+        total.sum += count;
+        total.occupied += count > 0;
+        total.histogram[b]++;
+    }
+    bucket_frames[slot]++;
+    total_frames++;
+}
+
+RollingWindow::ClassStats RollingWindow::stats(size_t class_index) const {
+    ClassStats stats;
+    if (total_frames == 0 || class_index >= class_count) {
+        return stats;
+    }
+    const Totals& total = totals[class_index];
+    stats.mean = static_cast<double>(total.sum) / total_frames;
+    stats.occupancy = static_cast<double>(total.occupied) / total_frames;
+    for (int slot = 0; slot < BUCKETS; slot++) {
+        stats.max = std::max<int>(stats.max, cells[slot * class_count + class_index].max);
+    }
+
+    // Smallest count at or above the rank, to the resolution of its bin
+    auto percentile = [&](double fraction) {
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total_frames)));
+        uint64_t seen = 0;
+        for (int b = 0; b < BINS; b++) {
+            seen += total.histogram[b];
+            if (seen >= rank) {
+                return std::min(binStart(b), stats.max);
+            }
+        }
+        return stats.max;
+    };
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    return stats;
+}
+
+bool parseRollingWindows(const std::string& text, std::vector<double>& seconds) {
+    std::vector<double> parsed;
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        char* end;
+        double value = strtod(item.c_str(), &end);
+        std::string unit(end);
+        if (unit == "h") {
+            value *= 3600;
+        } else if (unit == "m") {
+            value *= 60;
+        } else if (!unit.empty() && unit != "s") {
+            value = 0;
+        }
+        if (end == item.c_str() || value < 1.0) {
+            std::cerr << "Invalid window '" << item << "' (expected e.g. 10s, 1m or 1h, at least 1s)" << std::endl;
+            return false;
+        }
+        parsed.push_back(value);
+    }
+    if (parsed.empty()) {
+        std::cerr << "No windows in '" << text << "'" << std::endl;
+        return false;
+    }
+    seconds = parsed;
+    return true;
+}
+
+std::string rollingWindowName(double seconds) {
+    char name[32];
+    long whole = std::lround(seconds);
+    if (std::fabs(seconds - whole) > 1e-9) {
+        snprintf(name, sizeof(name), "%gs", seconds);
+    } else if (whole % 3600 == 0) {
+        snprintf(name, sizeof(name), "%ldh", whole / 3600);
+    } else if (whole % 60 == 0) {
+        snprintf(name, sizeof(name), "%ldm", whole / 60);
+    } else {
+        snprintf(name, sizeof(name), "%lds", whole);
+    }
+    return name;
+}
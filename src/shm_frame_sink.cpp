@@ -0,0 +1,124 @@
+#include "frame_writer.h"
+#include "shm_frame.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+bool parseShmFrameFormat(const std::string& text, ShmFrameFormat& format) {
+    if (text == "rgb") {
+        format = ShmFrameFormat::RGB24;
+    } else if (text == "nv12") {
+        format = ShmFrameFormat::NV12;
+    } else if (text == "jpeg") {
+        format = ShmFrameFormat::JPEG;
+    } else {
+        std::cerr << "Unknown frame format " << text << " (expected rgb, nv12 or jpeg)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ShmFrameSink::ShmFrameSink(const std::string& name, ShmFrameFormat format)
+    : name(name), format(format), open(false), width(0), height(0) {
+    memset(&ring, 0, sizeof(ring));
+}
+
+ShmFrameSink::~ShmFrameSink() {
+    if (open) {
+        shm_ring_close(&ring);
+    }
+}
+
+bool ShmFrameSink::resize(int frame_width, int frame_height) {
+    if (open) {
+        shm_ring_close(&ring);  // Readers see it closed and reopen the new one
+        open = false;
+    }
+    width = frame_width;
+    height = frame_height;
+
+    // A JPEG is assumed to be no larger than the raw RGB frame
+    size_t image_size = format == ShmFrameFormat::NV12 ? static_cast<size_t>(width) * height * 3 / 2
+                                                       : static_cast<size_t>(width) * height * 3;
+    int ret = shm_ring_create(&ring, name.c_str(), sizeof(shm_frame_info_t) + image_size, SHM_FRAME_SLOTS);
+    if (ret != 0) {
+        std::cerr << "Failed to create shared memory frames " << name << ": "
+                  << (ret == SHM_RING_ERR_SYSTEM ? strerror(errno) : "invalid size") << std::endl;
+        return false;
+    }
+    open = true;
+    return true;
+}
+
+void ShmFrameSink::publish(DecoratedFrame& frame) {
+    const cv::Mat& bgr = frame.bgr();
+    if (bgr.empty() || bgr.type() != CV_8UC3) {
+        return;
+    }
+    if (format == ShmFrameFormat::NV12 && (bgr.cols % 2 || bgr.rows % 2)) {
+        if (width != bgr.cols || height != bgr.rows) {
+            std::cerr << "NV12 frames need even dimensions, not " << bgr.cols << "x" << bgr.rows << std::endl;
+            width = bgr.cols;
+            height = bgr.rows;
+        }
+        return;
+    }
+    if ((!open || width != bgr.cols || height != bgr.rows) && !resize(bgr.cols, bgr.rows)) {
+        return;
+    }
+
+    uint8_t* slot = static_cast<uint8_t*>(shm_ring_begin(&ring));
+    shm_frame_info_t* info = reinterpret_cast<shm_frame_info_t*>(slot);
+    uint8_t* image = slot + sizeof(shm_frame_info_t);
+    memset(info, 0, sizeof(*info));
+    info->width = width;
+    info->height = height;
+
+    switch (format) {
+    case ShmFrameFormat::RGB24: {
+        cv::Mat rgb(height, width, CV_8UC3, image);
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+        info->format = SHM_FRAME_RGB24;
+        info->stride = width * 3;
+        info->data_size = info->stride * height;
+        break;
+    }
+    case ShmFrameFormat::NV12: {
+        // Y goes straight into the slot; the U and V planes are interleaved
+        cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+        size_t luma = static_cast<size_t>(width) * height;
+        memcpy(image, i420.data, luma);
+        const uint8_t* u = i420.data + luma;
+        const uint8_t* v = u + luma / 4;
+        uint8_t* uv = image + luma;
+        for (size_t i = 0; i < luma / 4; i++) {
+            uv[2 * i] = u[i];
+            uv[2 * i + 1] = v[i];
+        }
+        info->format = SHM_FRAME_NV12;
+        info->stride = width;
+        info->data_size = luma * 3 / 2;
+        break;
+    }
+    case ShmFrameFormat::JPEG: {
+        const std::vector<uchar>& jpeg = frame.jpeg();
+        if (jpeg.empty()) {
+            return;  // Encoding failed; the slot is reused by the next frame
+        }
+        if (jpeg.size() > ring.header->slot_size - sizeof(shm_frame_info_t)) {
+            // Warn once; a scene that encodes this large tends to stay that way
+            if (too_large_drops++ == 0) {
+                std::cerr << "JPEG frame of " << jpeg.size() << " bytes does not fit " << name
+                          << "; dropping frames that do not fit" << std::endl;
+            }
+            return;  // The slot stays locked and is reused by the next frame
+        }
+        memcpy(image, jpeg.data(), jpeg.size());
+        info->format = SHM_FRAME_JPEG;
+        info->data_size = jpeg.size();
+        break;
+    }
+    }
+
+    shm_ring_commit(&ring, sizeof(shm_frame_info_t) + info->data_size);
+}
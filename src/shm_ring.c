@@ -0,0 +1,339 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shm_ring.h"
+
+// A reader gives up after being lapped by the writer this many times in a row
+#define MAX_READ_ATTEMPTS 100000
+
+static size_t slot_stride(const shm_ring_header_t* header)
+{
+    return (sizeof(shm_ring_slot_t) + header->slot_size + 63) & ~(size_t)63;
+}
+
+static shm_ring_slot_t* slot_at(const shm_ring_t* ring, uint64_t sequence)
+{
+    const shm_ring_header_t* header = ring->header;
+    size_t index = (size_t)((sequence - 1) % header->slot_count);
+    return (shm_ring_slot_t*)((uint8_t*)header + sizeof(shm_ring_header_t) + index * slot_stride(header));
+}
+
+static int futex(uint32_t* word, int op, uint32_t value, const struct timespec* timeout)
+{
+    return (int)syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
+
+int shm_ring_create(shm_ring_t* ring, const char* name, uint32_t slot_size, uint32_t slot_count)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (slot_size == 0 || slot_count == 0) {
+        errno = EINVAL;
+        return SHM_RING_ERR_SYSTEM;
+    }
+
+    // A fresh segment, so readers of a previous writer see it closed rather than rewritten
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return SHM_RING_ERR_SYSTEM;
+    }
+
+    shm_ring_header_t layout = {0};
+    layout.slot_size = slot_size;
+    size_t size = sizeof(shm_ring_header_t) + (size_t)slot_count * slot_stride(&layout);
+    if (ftruncate(fd, (off_t)size) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return SHM_RING_ERR_SYSTEM;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return SHM_RING_ERR_SYSTEM;
+    }
+
+    // The new segment is zero filled; the magic goes last so readers never see a partial header
+    shm_ring_header_t* header = (shm_ring_header_t*)base;
+    header->version = SHM_RING_VERSION;
+    header->slot_size = slot_size;
+    header->slot_count = slot_count;
+    header->writer_pid = (uint32_t)getpid();
+    __atomic_store_n(&header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+    ring->header = header;
+    ring->size = size;
+    ring->writable = 1;
+    return 0;
+}
+
+void* shm_ring_begin(shm_ring_t* ring)
+{
+    shm_ring_header_t* header = ring->header;
+    if (!ring->writable) {
+        errno = EBADF;
+        return NULL;
+    }
+
+    shm_ring_slot_t* slot = slot_at(ring, header->write_count + 1);  // Only the writer changes write_count
+    if (!(slot->lock & 1)) {
+        __atomic_store_n(&slot->lock, slot->lock + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+    return slot + 1;
+}
+
+int shm_ring_commit(shm_ring_t* ring, size_t length)
+{
+    shm_ring_header_t* header = ring->header;
+    if (!ring->writable) {
+        errno = EBADF;
+        return SHM_RING_ERR_SYSTEM;
+    }
+    uint64_t sequence = header->write_count + 1;
+    shm_ring_slot_t* slot = slot_at(ring, sequence);
+    if (!(slot->lock & 1)) {
+        errno = EINVAL;  // No shm_ring_begin()
+        return SHM_RING_ERR_SYSTEM;
+    }
+    if (length > header->slot_size) {
+        return SHM_RING_ERR_TOO_LARGE;  // The slot stays locked for the next begin
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->timestamp_ns, (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->length, (uint32_t)length, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->lock, slot->lock + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&header->write_count, sequence, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&header->futex, 1, __ATOMIC_RELEASE);
+    futex(&header->futex, FUTEX_WAKE, INT_MAX, NULL);
+    return 0;
+}
+
+int shm_ring_publish(shm_ring_t* ring, const void* data, size_t length)
+{
+    if (ring->writable && length > ring->header->slot_size) {
+        return SHM_RING_ERR_TOO_LARGE;
+    }
+    void* slot_data = shm_ring_begin(ring);
+    if (!slot_data) {
+        return SHM_RING_ERR_SYSTEM;
+    }
+    memcpy(slot_data, data, length);
+    return shm_ring_commit(ring, length);
+}
+
+int shm_ring_open(shm_ring_t* ring, const char* name)
+{
+    memset(ring, 0, sizeof(*ring));
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return SHM_RING_ERR_SYSTEM;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return SHM_RING_ERR_SYSTEM;
+    }
+    if ((size_t)st.st_size < sizeof(shm_ring_header_t)) {
+        close(fd);
+        return SHM_RING_ERR_FORMAT;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return SHM_RING_ERR_SYSTEM;
+    }
+
+    shm_ring_header_t* header = (shm_ring_header_t*)base;
+    ring->header = header;
+    ring->size = (size_t)st.st_size;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC || header->version > SHM_RING_VERSION ||
+        header->slot_count == 0 ||
+        sizeof(shm_ring_header_t) + (size_t)header->slot_count * slot_stride(header) > ring->size) {
+        shm_ring_close(ring);
+        return SHM_RING_ERR_FORMAT;
+    }
+
+    ring->next = __atomic_load_n(&header->write_count, __ATOMIC_ACQUIRE) + 1;
+    return 0;
+}
+
+void shm_ring_close(shm_ring_t* ring)
+{
+    if (!ring->header) {
+        return;
+    }
+    if (ring->writable) {
+        __atomic_store_n(&ring->header->closed, 1, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&ring->header->futex, 1, __ATOMIC_RELEASE);
+        futex(&ring->header->futex, FUTEX_WAKE, INT_MAX, NULL);
+    }
+    munmap(ring->header, ring->size);
+    memset(ring, 0, sizeof(*ring));
+}
+
+// Copy message `sequence` (at most write_count) if the slot still holds it.
+// Returns the length, SHM_RING_ERR_OVERRUN if the slot was reused, or
+// another error. A published slot is only written again for a newer
+// message, so a locked or changed slot means it was overwritten.
+static int read_slot(const shm_ring_t* ring, uint64_t sequence, void* buffer, size_t capacity,
+                     uint64_t* read_sequence)
+{
+    const shm_ring_slot_t* slot = slot_at(ring, sequence);
+    uint64_t before = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+        return SHM_RING_ERR_OVERRUN;
+    }
+    uint64_t slot_sequence = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+    uint32_t length = __atomic_load_n(&slot->length, __ATOMIC_RELAXED);
+    if (slot_sequence != sequence || length > ring->header->slot_size) {
+        return SHM_RING_ERR_OVERRUN;
+    }
+    if (length > capacity) {
+        return SHM_RING_ERR_TOO_LARGE;
+    }
+    memcpy(buffer, slot + 1, length);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->lock, __ATOMIC_RELAXED) != before) {
+        return SHM_RING_ERR_OVERRUN;
+    }
+    if (read_sequence) {
+        *read_sequence = sequence;
+    }
+    return (int)length;
+}
+
+int shm_ring_read_latest(shm_ring_t* ring, void* buffer, size_t capacity, uint64_t* sequence)
+{
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        uint64_t newest = __atomic_load_n(&ring->header->write_count, __ATOMIC_ACQUIRE);
+        if (newest == 0) {
+            return __atomic_load_n(&ring->header->closed, __ATOMIC_ACQUIRE) ? SHM_RING_ERR_CLOSED : 0;
+        }
+        int ret = read_slot(ring, newest, buffer, capacity, sequence);
+        if (ret != SHM_RING_ERR_OVERRUN) {
+            return ret;
+        }
+        // The writer lapped the ring during the read; take the new newest
+    }
+    return SHM_RING_ERR_BUSY;
+}
+
+int shm_ring_peek_latest(shm_ring_t* ring, const void** data, uint64_t* sequence)
+{
+    const shm_ring_header_t* header = ring->header;
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        uint64_t newest = __atomic_load_n(&header->write_count, __ATOMIC_ACQUIRE);
+        if (newest == 0) {
+            return __atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) ? SHM_RING_ERR_CLOSED : 0;
+        }
+        const shm_ring_slot_t* slot = slot_at(ring, newest);
+        uint64_t lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+        uint32_t length = __atomic_load_n(&slot->length, __ATOMIC_RELAXED);
+        if ((lock & 1) || __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != newest ||
+            length > header->slot_size) {
+            continue;  // Lapped since loading write_count
+        }
+        ring->peek_lock = lock;
+        ring->peek_slot = slot;
+        *data = slot + 1;
+        if (sequence) {
+            *sequence = newest;
+        }
+        return (int)length;
+    }
+    return SHM_RING_ERR_BUSY;
+}
+
+int shm_ring_peek_valid(const shm_ring_t* ring)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return ring->peek_slot && __atomic_load_n(&ring->peek_slot->lock, __ATOMIC_RELAXED) == ring->peek_lock;
+}
+
+int shm_ring_read_next(shm_ring_t* ring, void* buffer, size_t capacity, uint64_t* sequence)
+{
+    shm_ring_header_t* header = ring->header;
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        uint64_t newest = __atomic_load_n(&header->write_count, __ATOMIC_ACQUIRE);
+        if (ring->next > newest) {
+            return __atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) ? SHM_RING_ERR_CLOSED : 0;
+        }
+
+        // Keep one slot of margin: the writer may be filling the oldest one
+        uint64_t oldest = newest >= header->slot_count ? newest - header->slot_count + 2 : 1;
+        if (ring->next < oldest) {
+            ring->next = oldest;
+            return SHM_RING_ERR_OVERRUN;
+        }
+
+        int ret = read_slot(ring, ring->next, buffer, capacity, sequence);
+        if (ret == SHM_RING_ERR_OVERRUN) {
+            continue;  // Overwritten during the read; the next pass reports it
+        }
+        if (ret >= 0) {
+            ring->next++;
+        }
+        return ret;
+    }
+    return SHM_RING_ERR_BUSY;
+}
+
+int shm_ring_wait(shm_ring_t* ring, uint64_t sequence, int timeout_ms)
+{
+    shm_ring_header_t* header = ring->header;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms >= 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    for (;;) {
+        // Read the futex word first: a publish after this changes it and the wait returns at once
+        uint32_t word = __atomic_load_n(&header->futex, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->write_count, __ATOMIC_ACQUIRE) > sequence) {
+            return 0;
+        }
+        if (__atomic_load_n(&header->closed, __ATOMIC_ACQUIRE)) {
+            return SHM_RING_ERR_CLOSED;
+        }
+
+        struct timespec remaining;
+        const struct timespec* timeout = NULL;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += 1000000000L;
+            }
+            if (remaining.tv_sec < 0) {
+                return SHM_RING_ERR_TIMEOUT;
+            }
+            timeout = &remaining;
+        }
+        if (futex(&header->futex, FUTEX_WAIT, word, timeout) < 0 && errno != EAGAIN && errno != EINTR) {
+            return errno == ETIMEDOUT ? SHM_RING_ERR_TIMEOUT : SHM_RING_ERR_SYSTEM;
+        }
+    }
+}
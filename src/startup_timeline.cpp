@@ -0,0 +1,83 @@
+#include "startup_timeline.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+
+static double sinceBootMs() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0) {
+        return -1;
+    }
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Field 22 of /proc/self/stat is the process start time in clock ticks since boot
+static double processStartSinceBootMs() {
+    std::ifstream stat("/proc/self/stat");
+    std::string line;
+    if (!std::getline(stat, line)) {
+        return -1;
+    }
+    // The command name may contain spaces, so count fields after its ')'
+    size_t end = line.rfind(')');
+    if (end == std::string::npos) {
+        return -1;
+    }
+    std::istringstream fields(line.substr(end + 2));
+    std::string field;
+    unsigned long long start_ticks = 0;
+    for (int i = 3; i <= 22 && fields >> field; i++) {
+        if (i == 22) {
+            start_ticks = std::stoull(field);
+        }
+    }
+    long ticks_per_second = sysconf(_SC_CLK_TCK);
+    if (start_ticks == 0 || ticks_per_second <= 0) {
+        return -1;
+    }
+    return start_ticks * 1000.0 / ticks_per_second;
+}
+
+StartupTimeline& StartupTimeline::instance() {
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+StartupTimeline::StartupTimeline()
+    : origin(std::chrono::steady_clock::now()),
+      process_start_since_boot_ms(processStartSinceBootMs()),
+      origin_since_boot_ms(sinceBootMs()) {
+}
+
+double StartupTimeline::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void StartupTimeline::mark(const std::string& event) {
+    double ms = elapsedMs();
+    std::lock_guard<std::mutex> lock(mutex);
+    events.emplace_back(event, ms);
+    printf("Startup +%.1f ms: %s\n", ms, event.c_str());
+}
+
+void StartupTimeline::report() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (reported) {
+        return;
+    }
+    reported = true;
+
+    printf("Startup timeline:\n");
+    if (process_start_since_boot_ms >= 0 && origin_since_boot_ms >= 0) {
+        printf("  process started %.1f s after boot, main() reached %.1f ms later\n",
+               process_start_since_boot_ms / 1000.0, origin_since_boot_ms - process_start_since_boot_ms);
+    }
+    double previous = 0;
+    for (const auto& event : events) {
+        printf("  +%8.1f ms (%+8.1f ms)  %s\n", event.second, event.second - previous, event.first.c_str());
+        previous = event.second;
+    }
+}
@@ -0,0 +1,196 @@
+#include "tiling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+
+// Containment ratio above which a same-class box is treated as a seam fragment
+static const float SEAM_CONTAINMENT_THRESHOLD = 0.8f;
+static const int REPORT_INTERVAL_SECONDS = 30;
+
+bool parseTileGrid(const std::string& spec, TileConfig& config) {
+    int cols = 0;
+    int rows = 0;
+    char trailing = 0;
+    if (sscanf(spec.c_str(), "%dx%d%c", &cols, &rows, &trailing) != 2 || cols < 1 || rows < 1) {
+        return false;
+    }
+    config.cols = cols;
+    config.rows = rows;
+    return true;
+}
+
+static void tileSpan(int length, int count, float overlap, std::vector<std::pair<int, int>>& spans) {
+    spans.clear();
+    if (count <= 1) {
+        spans.emplace_back(0, length - 1);
+        return;
+    }
+
+    // count tiles of size t overlapping by overlap*t cover t * (count - (count-1)*overlap)
+    int tile = static_cast<int>(std::ceil(length / (count - (count - 1) * overlap)));
+    tile = std::min(tile, length);
+    float step = static_cast<float>(length - tile) / (count - 1);
+    for (int i = 0; i < count; i++) {
+        int start = static_cast<int>(std::lround(i * step));
+        spans.emplace_back(start, start + tile - 1);
+    }
+}
+
+std::vector<image_rect_t> computeTiles(int width, int height, const TileConfig& config) {
+    float overlap = std::clamp(config.overlap, 0.0f, 0.9f);
+    std::vector<std::pair<int, int>> xs;
+    std::vector<std::pair<int, int>> ys;
+    tileSpan(width, config.cols, overlap, xs);
+    tileSpan(height, config.rows, overlap, ys);
+
+    std::vector<image_rect_t> tiles;
+    tiles.reserve(xs.size() * ys.size());
+    for (const auto& y : ys) {
+        for (const auto& x : xs) {
+            tiles.push_back(image_rect_t{x.first, y.first, x.second, y.second});
+        }
+    }
+    return tiles;
+}
+
+static float boxArea(const box_rect_t& b) {
+    return static_cast<float>(std::max(0, b.right - b.left + 1)) * std::max(0, b.bottom - b.top + 1);
+}
+
+static bool overlapsKept(const box_rect_t& a, const box_rect_t& b, float nms_threshold) {
+    int w = std::min(a.right, b.right) - std::max(a.left, b.left) + 1;
+    int h = std::min(a.bottom, b.bottom) - std::max(a.top, b.top) + 1;
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+    float inter = static_cast<float>(w) * h;
+    float area_a = boxArea(a);
+    float area_b = boxArea(b);
+    float iou = inter / (area_a + area_b - inter);
+    float containment = inter / std::max(1.0f, std::min(area_a, area_b));
+    return iou > nms_threshold || containment > SEAM_CONTAINMENT_THRESHOLD;
+}
+
+void mergeDetections(const std::vector<object_detect_result_list>& parts, float nms_threshold,
+                     object_detect_result_list* merged) {
+    std::vector<const object_detect_result_t*> candidates;
+    for (const auto& part : parts) {
+        for (int i = 0; i < part.count; i++) {
+            candidates.push_back(&part.results[i]);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const object_detect_result_t* a, const object_detect_result_t* b) { return a->prop > b->prop; });
+
+    memset(merged, 0, sizeof(*merged));
+    for (const auto* candidate : candidates) {
+        if (merged->count >= OBJ_NUMB_MAX_SIZE) {
+            break;
+        }
+        bool suppressed = false;
+        for (int k = 0; k < merged->count && !suppressed; k++) {
+            const auto& kept = merged->results[k];
+            suppressed = kept.cls_id == candidate->cls_id && overlapsKept(kept.box, candidate->box, nms_threshold);
+        }
+        if (!suppressed) {
+            merged->results[merged->count++] = *candidate;
+        }
+    }
+}
+
+static int countAbove(const object_detect_result_list& list, float threshold) {
+    int n = 0;
+    for (int i = 0; i < list.count; i++) {
+        if (list.results[i].prop >= threshold) {
+            n++;
+        }
+    }
+    return n;
+}
+
+TiledInference::TiledInference(const TileConfig& config, int max_parallel)
+    : config(config), workers(std::max(1, max_parallel)), last_report(std::chrono::steady_clock::now()) {
+    printf("Tiled inference enabled: %dx%d grid, %.0f%% overlap%s\n", config.cols, config.rows,
+           config.overlap * 100.0f, config.full_frame_pass ? ", plus full-frame pass" : "");
+}
+
+int TiledInference::run(NpuContextPool& pool, image_buffer_t* img, object_detect_result_list* results,
+                        float conf_threshold) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<image_rect_t> tiles = computeTiles(img->width, img->height, config);
+    size_t passes = tiles.size() + (config.full_frame_pass ? 1 : 0);
+    std::vector<object_detect_result_list> parts(passes);
+    std::vector<std::future<int>> pending;
+    pending.reserve(passes);
+
+    // The full-frame pass goes first so its timing, the baseline cost for the report,
+    // is not inflated by waiting for a free context
+    double full_ms = 0.0;
+    if (config.full_frame_pass) {
+        size_t i = tiles.size();
+        pending.push_back(workers.submit([&pool, img, &parts, &full_ms, i, conf_threshold]() {
+            auto t0 = std::chrono::steady_clock::now();
+            int ret = pool.infer(img, &parts[i], conf_threshold);
+            full_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            return ret;
+        }));
+    }
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        pending.push_back(workers.submit([&pool, img, &parts, &tiles, i, conf_threshold]() {
+            return pool.infer(img, &parts[i], conf_threshold, &tiles[i]);
+        }));
+    }
+
+    int ret = 0;
+    for (auto& f : pending) {
+        int r = f.get();
+        if (r != 0) {
+            printf("Tile inference fail! ret=%d\n", r);
+            ret = r;
+        }
+    }
+
+    mergeDetections(parts, NMS_THRESH, results);
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    frames++;
+    tiles_per_frame = static_cast<int>(tiles.size());
+    tiled_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    merged_detections += countAbove(*results, conf_threshold);
+    if (config.full_frame_pass) {
+        full_frame_ms += full_ms;
+        full_frame_detections += countAbove(parts.back(), conf_threshold);
+    }
+    if (std::chrono::steady_clock::now() - last_report >= std::chrono::seconds(REPORT_INTERVAL_SECONDS)) {
+        report();
+    }
+    return ret;
+}
+
+void TiledInference::report() {
+    if (frames == 0) {
+        return;
+    }
+    double avg_ms = tiled_ms / frames;
+    double merged_per_frame = static_cast<double>(merged_detections) / frames;
+    printf("Tiling report: %d frames, %d tiles%s, %.1f ms/frame (%.1f fps), %.2f detections/frame\n", frames,
+           tiles_per_frame, config.full_frame_pass ? " + full frame" : "", avg_ms, 1000.0 / avg_ms, merged_per_frame);
+    if (config.full_frame_pass && full_frame_ms > 0.0) {
+        double full_avg_ms = full_frame_ms / frames;
+        double full_per_frame = static_cast<double>(full_frame_detections) / frames;
+        double gain = full_per_frame > 0.0 ? (merged_per_frame / full_per_frame - 1.0) * 100.0 : 0.0;
+        printf("Tiling report: full frame alone %.1f ms/frame, %.2f detections/frame -> cost x%.2f, recall %+.2f/frame (%+.0f%%)\n",
+               full_avg_ms, full_per_frame, avg_ms / full_avg_ms, merged_per_frame - full_per_frame, gain);
+    }
+
+    frames = 0;
+    tiled_ms = 0.0;
+    full_frame_ms = 0.0;
+    full_frame_detections = 0;
+    merged_detections = 0;
+    last_report = std::chrono::steady_clock::now();
+}
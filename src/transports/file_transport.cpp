@@ -1,83 +1,171 @@
 #include "transport.h"
-#include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <unistd.h>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
 
-FileTransport::FileTransport(const std::string& filepath) 
-    : filepath(filepath), enabled(true) {
+bool parseFileDurability(const std::string& text, FileDurability& durability) {
+    if (text == "auto") {
+        durability = FileDurability::Auto;
+    } else if (text == "none") {
+        durability = FileDurability::None;
+    } else if (text == "rename") {
+        durability = FileDurability::OnRename;
+    } else if (text == "periodic") {
+        durability = FileDurability::Periodic;
+    } else {
+        std::cerr << "Unknown file durability " << text << " (expected auto, none, rename or periodic)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* fileDurabilityName(FileDurability durability) {
+    switch (durability) {
+    case FileDurability::Auto:
+        return "auto";
+    case FileDurability::None:
+        return "none";
+    case FileDurability::OnRename:
+        return "rename";
+    case FileDurability::Periodic:
+        return "periodic";
+    }
+    return "unknown";
+}
+
+FileTransport::FileTransport(const std::string& filepath, FileDurability durability, double sync_interval_seconds)
+    : filepath(filepath), dir_fd(-1), durability_mode(durability),
+      sync_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(sync_interval_seconds))),
+      use_tmpfile(false), enabled(true) {
     // Ensure the directory exists
     std::filesystem::path path(filepath);
     std::filesystem::path dir = path.parent_path();
-    
+
     if (!dir.empty() && !std::filesystem::exists(dir)) {
         std::error_code ec;
         if (!std::filesystem::create_directories(dir, ec)) {
             std::cerr << "Failed to create directory: " << dir << " - " << ec.message() << std::endl;
             enabled = false;
+            return;
+        }
+    }
+
+    // Every message is written and renamed relative to the directory
+    name = path.filename();
+    temp_name = name + ".tmp";
+    dir_fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        std::cerr << "Failed to open directory: " << dir << " - " << strerror(errno) << std::endl;
+        enabled = false;
+        return;
+    }
+
+    // Nothing on tmpfs survives a power cut, so syncing it only costs time
+    struct statfs fs;
+    bool volatile_fs = fstatfs(dir_fd, &fs) == 0 && (fs.f_type == TMPFS_MAGIC || fs.f_type == RAMFS_MAGIC);
+    if (durability_mode == FileDurability::Auto) {
+        durability_mode = volatile_fs ? FileDurability::None : FileDurability::OnRename;
+    }
+    use_tmpfile = !volatile_fs;
+}
+
+FileTransport::~FileTransport() {
+    if (dir_fd >= 0) {
+        ::close(dir_fd);
+    }
+}
+
+int FileTransport::openTemp() {
+    if (use_tmpfile) {
+        int fd = ::openat(dir_fd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            return fd;
         }
+        // Not supported by this kernel or filesystem
+        std::cerr << "O_TMPFILE unavailable in the directory of " << filepath << " (" << strerror(errno)
+                  << "); using a named temp file" << std::endl;
+        use_tmpfile = false;
     }
+    return ::openat(dir_fd, temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
 }
 
 bool FileTransport::send(const std::string& data) {
     if (!enabled) {
         return false;
     }
-    
-    try {
-        // Write atomically by using a temporary file and then renaming
-        std::string temp_filepath = filepath + ".tmp";
-        
-        {
-            std::ofstream file(temp_filepath, std::ios::out | std::ios::trunc);
-            if (!file.is_open()) {
-                std::cerr << "Failed to open temp file: " << temp_filepath << std::endl;
-                return false;
-            }
-            
-            file << data;
-            file.flush();
-            
-            if (file.fail()) {
-                std::cerr << "Failed to write to temp file: " << temp_filepath << std::endl;
-                return false;
-            }
-            
-            // Close the file to ensure all C++ buffers are flushed
-            file.close();
-            
-            // Reopen to get file descriptor and fsync
-            int fd = ::open(temp_filepath.c_str(), O_RDONLY);
-            if (fd != -1) {
-                if (::fsync(fd) != 0) {
-                    std::cerr << "Failed to fsync file: " << strerror(errno) << std::endl;
-                    ::close(fd);
-                    return false;
-                }
-                ::close(fd);
-            }
-        } // File closed here
-        
-        // Atomic rename
-        std::error_code ec;
-        std::filesystem::rename(temp_filepath, filepath, ec);
-        if (ec) {
-            std::cerr << "Failed to rename temp file: " << ec.message() << std::endl;
-            // Try to clean up temp file
-            std::filesystem::remove(temp_filepath, ec);
+
+    auto now = std::chrono::steady_clock::now();
+    bool sync = durability_mode == FileDurability::OnRename ||
+                (durability_mode == FileDurability::Periodic && now - last_sync >= sync_interval);
+
+    int fd = openTemp();
+    if (fd < 0) {
+        std::cerr << "Failed to open temp file for " << filepath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::pwrite(fd, data.data() + written, data.size() - written, written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            std::cerr << "Failed to write temp file for " << filepath << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            return false;
+        }
+        written += n;
+    }
+
+    if (sync && ::fsync(fd) != 0) {
+        std::cerr << "Failed to fsync file: " << strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    if (use_tmpfile) {
+        // Give the unnamed file the temp name; a temp left by a crash is replaced
+        char proc_path[64];
+        snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+        int ret = ::linkat(AT_FDCWD, proc_path, dir_fd, temp_name.c_str(), AT_SYMLINK_FOLLOW);
+        if (ret != 0 && errno == EEXIST) {
+            ::unlinkat(dir_fd, temp_name.c_str(), 0);
+            ret = ::linkat(AT_FDCWD, proc_path, dir_fd, temp_name.c_str(), AT_SYMLINK_FOLLOW);
+        }
+        if (ret != 0) {
+            std::cerr << "Failed to link temp file for " << filepath << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            use_tmpfile = false;  // e.g. no /proc; the next message uses a named temp file
             return false;
         }
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Exception in FileTransport::send: " << e.what() << std::endl;
+    }
+    ::close(fd);
+
+    // Atomic rename
+    if (::renameat(dir_fd, temp_name.c_str(), dir_fd, name.c_str()) != 0) {
+        std::cerr << "Failed to rename temp file: " << strerror(errno) << std::endl;
+        ::unlinkat(dir_fd, temp_name.c_str(), 0);
         return false;
     }
+
+    // The rename itself is durable once the directory is synced
+    if (sync && durability_mode == FileDurability::Periodic) {
+        if (::fsync(dir_fd) != 0) {
+            std::cerr << "Failed to fsync directory: " << strerror(errno) << std::endl;
+        }
+        last_sync = now;
+    }
+    return true;
 }
 
 bool FileTransport::isConnected() const {
     return enabled;
-}
\ No newline at end of file
+}
@@ -0,0 +1,230 @@
+#include "transport.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// Segment file names sort in time order: history-YYYYMMDD-HHMMSS-mmm.odh (UTC)
+static const char SEGMENT_PREFIX[] = "history-";
+static const char SEGMENT_SUFFIX[] = ".odh";
+
+static bool isSegmentName(const std::string& name) {
+    return name.size() > sizeof(SEGMENT_PREFIX) + sizeof(SEGMENT_SUFFIX) - 2 &&
+           name.compare(0, sizeof(SEGMENT_PREFIX) - 1, SEGMENT_PREFIX) == 0 &&
+           name.compare(name.size() - (sizeof(SEGMENT_SUFFIX) - 1), std::string::npos, SEGMENT_SUFFIX) == 0;
+}
+
+static std::string segmentName(uint64_t timestamp_ms) {
+    time_t seconds = static_cast<time_t>(timestamp_ms / 1000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char name[64];
+    size_t length = strftime(name, sizeof(name), "history-%Y%m%d-%H%M%S", &utc);
+    snprintf(name + length, sizeof(name) - length, "-%03d%s", static_cast<int>(timestamp_ms % 1000), SEGMENT_SUFFIX);
+    return name;
+}
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+HistoryTransport::HistoryTransport(const std::string& directory, const HistoryLayout& layout,
+                                   const HistoryConfig& config)
+    : directory(directory), config(config), layout_names(layout.class_names),
+      box_capacity(static_cast<uint16_t>(std::clamp(layout.box_capacity, 0, HISTORY_MAX_BOXES))),
+      record_size(0), period_ms(0), fd(-1), segment_size(0), segment_period(0), last_timestamp_ms(0), enabled(true) {
+    if (layout_names.empty() || layout_names.size() > HISTORY_MAX_CLASSES) {
+        std::cerr << "History needs between 1 and " << HISTORY_MAX_CLASSES << " classes" << std::endl;
+        enabled = false;
+        return;
+    }
+    for (const auto& name : layout_names) {
+        class_names.push_back(name.c_str());
+    }
+    record_size = history_record_size(static_cast<uint16_t>(class_names.size()), box_capacity);
+
+    // Room for at least a few segments, each with room for some records
+    size_t header_size = history_header_size(static_cast<uint16_t>(class_names.size()));
+    this->config.segment_bytes = std::max(std::min(config.segment_bytes, config.budget_bytes / 4),
+                                          header_size + 64 * record_size);
+    period_ms = static_cast<uint64_t>(std::max(config.segment_seconds, 1.0) * 1000.0);
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec || !fs::is_directory(directory)) {
+        std::cerr << "Failed to create history directory " << directory << ": " << ec.message() << std::endl;
+        enabled = false;
+        return;
+    }
+    enforceBudget();
+}
+
+HistoryTransport::~HistoryTransport() {
+    commit();
+    closeSegment();
+}
+
+bool HistoryTransport::startSegment(uint64_t timestamp_ms) {
+    // Names are unique to the millisecond; a clash (a restart within the same
+    // millisecond, or a clock stepped back) takes the next free one
+    uint64_t name_ms = timestamp_ms;
+    for (int attempt = 0; attempt < 1000 && fd < 0; attempt++, name_ms++) {
+        segment_path = (fs::path(directory) / segmentName(name_ms)).string();
+        fd = ::open(segment_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            break;
+        }
+    }
+    if (fd < 0) {
+        std::cerr << "Failed to create history segment " << segment_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    std::vector<char> header(history_header_size(static_cast<uint16_t>(class_names.size())));
+    history_header_init(header.data(), class_names.data(), static_cast<uint16_t>(class_names.size()),
+                        box_capacity, timestamp_ms);
+    if (!writeAll(fd, header.data(), header.size())) {
+        std::cerr << "Failed to write history segment " << segment_path << ": " << strerror(errno) << std::endl;
+        closeSegment();
+        ::unlink(segment_path.c_str());
+        return false;
+    }
+    segment_size = header.size();
+    segment_period = timestamp_ms / period_ms;
+
+    // The new name is durable with the first commit
+    ::fdatasync(fd);
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+
+    enforceBudget();
+    return true;
+}
+
+void HistoryTransport::closeSegment() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void HistoryTransport::enforceBudget() {
+    std::vector<std::pair<std::string, uintmax_t>> segments;
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        std::error_code size_ec;
+        uintmax_t size = it->file_size(size_ec);
+        if (isSegmentName(name) && !size_ec) {
+            segments.emplace_back(name, size);
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+
+    // Keep room for the current segment to grow to its limit
+    uintmax_t total = config.segment_bytes;
+    for (const auto& segment : segments) {
+        total += segment.second;
+    }
+    std::string current = fs::path(segment_path).filename().string();
+    for (const auto& segment : segments) {
+        if (total <= config.budget_bytes) {
+            break;
+        }
+        // After the clock steps back the current segment need not sort last
+        if (segment.first == current) {
+            continue;
+        }
+        if (::unlink((fs::path(directory) / segment.first).c_str()) == 0) {
+            total -= segment.second;
+        } else {
+            std::cerr << "Failed to delete history segment " << segment.first << ": " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+bool HistoryTransport::send(const std::string& data) {
+    if (!enabled) {
+        return false;
+    }
+    if (data.size() != record_size) {
+        std::cerr << "History record of " << data.size() << " bytes, expected " << record_size << std::endl;
+        return false;
+    }
+
+    uint64_t timestamp_ms;
+    memcpy(&timestamp_ms, data.data(), sizeof(timestamp_ms));
+    // Readers binary search a segment by time, so a clock stepped back starts
+    // a new one rather than append a record older than the last
+    bool stepped_back = fd >= 0 && timestamp_ms < last_timestamp_ms;
+    if (stepped_back) {
+        std::cerr << "History clock stepped back " << (last_timestamp_ms - timestamp_ms)
+                  << " ms, starting a new segment" << std::endl;
+    }
+    if (fd < 0 || stepped_back || timestamp_ms / period_ms != segment_period ||
+        segment_size + record_size > config.segment_bytes) {
+        commit();
+        closeSegment();
+        if (!startSegment(timestamp_ms)) {
+            return false;
+        }
+    }
+
+    pending.append(data);
+    segment_size += record_size;
+    last_timestamp_ms = timestamp_ms;
+
+    auto now = std::chrono::steady_clock::now();
+    if (pending.size() >= config.commit_bytes ||
+        now - last_commit >= std::chrono::duration<double>(config.commit_seconds)) {
+        return commit();
+    }
+    return true;
+}
+
+bool HistoryTransport::commit() {
+    if (pending.empty() || fd < 0) {
+        return true;
+    }
+    last_commit = std::chrono::steady_clock::now();
+
+    bool ok = writeAll(fd, pending.data(), pending.size());
+    if (!ok) {
+        // Drop the group rather than leave a partial record that would shift
+        // every record appended after it
+        std::cerr << "Failed to write history to " << segment_path << ": " << strerror(errno) << std::endl;
+        segment_size -= pending.size();
+        if (::ftruncate(fd, static_cast<off_t>(segment_size)) != 0) {
+            closeSegment();  // Start a fresh segment with the next record
+        }
+    } else if (::fdatasync(fd) != 0) {
+        std::cerr << "Failed to sync history to " << segment_path << ": " << strerror(errno) << std::endl;
+    }
+    pending.clear();
+    return ok;
+}
+
+bool HistoryTransport::isConnected() const {
+    return enabled;
+}
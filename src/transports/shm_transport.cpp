@@ -0,0 +1,42 @@
+#include "transport.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+ShmRingTransport::ShmRingTransport(const std::string& name, uint32_t slot_size, uint32_t slot_count)
+    : name(name), open(false) {
+    int ret = shm_ring_create(&ring, name.c_str(), slot_size, slot_count);
+    if (ret != 0) {
+        std::cerr << "Failed to create shared memory ring " << name << ": "
+                  << (ret == SHM_RING_ERR_SYSTEM ? strerror(errno) : "invalid size") << std::endl;
+        return;
+    }
+    open = true;
+}
+
+ShmRingTransport::~ShmRingTransport() {
+    if (open) {
+        shm_ring_close(&ring);
+    }
+}
+
+bool ShmRingTransport::send(const std::string& data) {
+    if (!open) {
+        return false;
+    }
+    int ret = shm_ring_publish(&ring, data.data(), data.size());
+    if (ret == SHM_RING_ERR_TOO_LARGE) {
+        // Every message of this sink is about this size, so warn once and
+        // leave the count to the publisher's report
+        if (too_large_drops++ == 0) {
+            std::cerr << "Message of " << data.size() << " bytes does not fit a slot of " << name
+                      << "; dropping messages that do not fit" << std::endl;
+        }
+        return true;
+    }
+    return ret == 0;
+}
+
+bool ShmRingTransport::isConnected() const {
+    return open;
+}
@@ -1,14 +1,52 @@
 #include "transport.h"
+#include "udp_fragment.h"
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
-UDPTransport::UDPTransport(const std::string& ip, int port) 
-    : sockfd(-1), connected(false) {
-    setupSocket(ip, port);
+bool parseUDPDestinations(const std::string& list, std::vector<UDPDestination>& destinations) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string entry = list.substr(start, end - start);
+        size_t colon = entry.rfind(':');
+        int port = colon == std::string::npos ? 0 : atoi(entry.c_str() + colon + 1);
+        struct in_addr addr;
+        if (colon == std::string::npos || port < 1 || port > 65535 ||
+            inet_pton(AF_INET, entry.substr(0, colon).c_str(), &addr) != 1) {
+            printf("Error: invalid UDP destination '%s' (expected ip:port)\n", entry.c_str());
+            return false;
+        }
+        destinations.push_back({entry.substr(0, colon), port});
+        start = end + 1;
+    }
+    return true;
+}
+
+UDPTransport::UDPTransport(const std::string& ip, int port)
+    : UDPTransport(std::vector<UDPDestination>{{ip, port}}) {
+}
+
+UDPTransport::UDPTransport(const std::vector<UDPDestination>& destinations, size_t fragment_size, int multicast_ttl)
+    : sockfd(-1),
+      fragment_size(fragment_size == 0 ? 0 : std::clamp<size_t>(fragment_size, UDP_FRAG_HEADER_SIZE + 1, MAX_DATAGRAM)),
+      connected(false),
+      // Differs between runs, so receivers do not mix fragments across restarts
+      next_message_id(static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count())) {
+    setupSocket(destinations, multicast_ttl);
 }
 
 UDPTransport::~UDPTransport() {
@@ -17,32 +55,141 @@ UDPTransport::~UDPTransport() {
     }
 }
 
-void UDPTransport::setupSocket(const std::string& ip, int port) {
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+void UDPTransport::setupSocket(const std::vector<UDPDestination>& destinations, int multicast_ttl) {
+    sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd < 0) {
         std::cerr << "UDP Socket creation failed" << std::endl;
         return;
     }
 
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family = AF_INET;
-    servaddr.sin_port = htons(port);  
-    servaddr.sin_addr.s_addr = inet_addr(ip.c_str());
-    
-    connected = true;
+    bool multicast = false;
+    for (const auto& destination : destinations) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(destination.port);
+        if (inet_pton(AF_INET, destination.ip.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "Invalid UDP destination address: " << destination.ip << std::endl;
+            continue;
+        }
+        multicast |= IN_MULTICAST(ntohl(addr.sin_addr.s_addr));
+        addresses.push_back(addr);
+    }
+
+    if (multicast) {
+        unsigned char ttl = static_cast<unsigned char>(std::clamp(multicast_ttl, 0, 255));
+        if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) {
+            perror("setsockopt IP_MULTICAST_TTL");
+        }
+    }
+
+    connected = !addresses.empty();
 }
 
 bool UDPTransport::send(const std::string& data) {
-    if (!connected || sockfd < 0) {
+    if (!isConnected()) {
+        return false;
+    }
+
+    // Unfragmented: one plain datagram. Fragmented: every datagram has a
+    // header, so receivers never mistake a payload for a fragment.
+    size_t fragments = 0;
+    if (fragment_size > 0) {
+        const size_t fragment_payload = fragment_size - UDP_FRAG_HEADER_SIZE;
+        fragments = std::max<size_t>((data.size() + fragment_payload - 1) / fragment_payload, 1);
+    }
+    if (fragments > UDP_FRAG_MAX_FRAGMENTS || data.size() > UINT32_MAX ||
+        (fragment_size == 0 && data.size() > MAX_DATAGRAM)) {
+        std::cerr << "UDP message of " << data.size() << " bytes is too large to send" << std::endl;
+        errors++;
         return false;
     }
-    
-    ssize_t sent = sendto(sockfd, data.c_str(), data.length(), 0,
-                         (struct sockaddr*)&servaddr, sizeof(servaddr));
-    
-    return sent == static_cast<ssize_t>(data.length());
+
+    size_t parts = std::max<size_t>(fragments, 1);
+    size_t count = parts * addresses.size();
+    datagrams.resize(count);
+    iovecs.resize(count * 2);
+    headers.resize(fragments * UDP_FRAG_HEADER_SIZE);
+    uint32_t message_id = next_message_id++;
+    size_t bytes = 0;
+
+    size_t n = 0;
+    for (size_t part = 0; part < parts; part++) {
+        const char* chunk = data.data();
+        size_t chunk_size = data.size();
+        uint8_t* header = nullptr;
+        if (fragments > 0) {
+            const size_t fragment_payload = fragment_size - UDP_FRAG_HEADER_SIZE;
+            size_t offset = part * fragment_payload;
+            chunk += offset;
+            chunk_size = std::min(fragment_payload, data.size() - offset);
+            header = headers.data() + part * UDP_FRAG_HEADER_SIZE;
+            udp_frag_header_t fields = {message_id, static_cast<uint16_t>(part), static_cast<uint16_t>(fragments),
+                                        static_cast<uint32_t>(offset), static_cast<uint32_t>(data.size())};
+            udp_frag_write_header(header, &fields);
+        }
+
+        for (auto& address : addresses) {
+            struct iovec* iov = &iovecs[n * 2];
+            int iov_count = 0;
+            if (header) {
+                iov[iov_count++] = {header, UDP_FRAG_HEADER_SIZE};
+            }
+            iov[iov_count++] = {const_cast<char*>(chunk), chunk_size};
+
+            struct msghdr& msg = datagrams[n].msg_hdr;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &address;
+            msg.msg_namelen = sizeof(address);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iov_count;
+            n++;
+        }
+    }
+
+    size_t next = 0;
+    size_t delivered = 0;
+    size_t failed = 0;
+    while (next < count) {
+        int ret = sendmmsg(sockfd, datagrams.data() + next, count - next, MSG_DONTWAIT);
+        if (ret > 0) {
+            for (size_t i = next; i < next + ret; i++) {
+                bytes += datagrams[i].msg_len;
+            }
+            next += ret;
+            delivered += ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            eagain_drops += count - next;
+            break;
+        }
+        // Skip the datagram that failed (e.g. no route to one destination)
+        errors++;
+        failed++;
+        next++;
+    }
+
+    messages_sent++;
+    datagrams_sent += delivered;
+    bytes_sent += bytes;
+    // Datagrams dropped for a full buffer are counted by dropped(), not failures
+    return failed == 0;
 }
 
 bool UDPTransport::isConnected() const {
     return connected && sockfd >= 0;
-}
\ No newline at end of file
+}
+
+UDPTransportStats UDPTransport::stats() const {
+    UDPTransportStats stats;
+    stats.messages = messages_sent;
+    stats.datagrams = datagrams_sent;
+    stats.bytes = bytes_sent;
+    stats.eagain_drops = eagain_drops;
+    stats.errors = errors;
+    return stats;
+}
@@ -0,0 +1,103 @@
+#include <string.h>
+
+#include "udp_fragment.h"
+
+static void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+void udp_frag_write_header(uint8_t* out, const udp_frag_header_t* header)
+{
+    out[0] = 'U';
+    out[1] = 'F';
+    out[2] = UDP_FRAG_VERSION;
+    out[3] = 0;
+    put_u32(out + 4, header->message_id);
+    put_u16(out + 8, header->index);
+    put_u16(out + 10, header->count);
+    put_u32(out + 12, header->offset);
+    put_u32(out + 16, header->total_size);
+}
+
+int udp_frag_read_header(const uint8_t* data, size_t size, udp_frag_header_t* header)
+{
+    if (size < UDP_FRAG_HEADER_SIZE || data[0] != 'U' || data[1] != 'F' || data[2] != UDP_FRAG_VERSION) {
+        return UDP_FRAG_ERR_NOT_FRAGMENT;
+    }
+
+    header->message_id = get_u32(data + 4);
+    header->index = get_u16(data + 8);
+    header->count = get_u16(data + 10);
+    header->offset = get_u32(data + 12);
+    header->total_size = get_u32(data + 16);
+
+    size_t payload = size - UDP_FRAG_HEADER_SIZE;
+    if (header->count == 0 || header->count > UDP_FRAG_MAX_FRAGMENTS || header->index >= header->count ||
+        header->offset > header->total_size || payload > header->total_size - header->offset) {
+        return UDP_FRAG_ERR_MALFORMED;
+    }
+    return 0;
+}
+
+void udp_reassembler_init(udp_reassembler_t* reassembler, uint8_t* buffer, size_t capacity)
+{
+    memset(reassembler, 0, sizeof(*reassembler));
+    reassembler->buffer = buffer;
+    reassembler->capacity = capacity;
+}
+
+int udp_reassemble(udp_reassembler_t* reassembler, const uint8_t* data, size_t size)
+{
+    udp_frag_header_t header;
+    int ret = udp_frag_read_header(data, size, &header);
+    if (ret != 0) {
+        return ret;
+    }
+    if (header.total_size > reassembler->capacity) {
+        return UDP_FRAG_ERR_TOO_LARGE;
+    }
+
+    // A fragment of another message abandons the current one
+    if (!reassembler->active || header.message_id != reassembler->message_id) {
+        reassembler->active = 1;
+        reassembler->message_id = header.message_id;
+        reassembler->total_size = header.total_size;
+        reassembler->count = header.count;
+        reassembler->received = 0;
+        memset(reassembler->have, 0, sizeof(reassembler->have));
+    } else if (header.total_size != reassembler->total_size || header.count != reassembler->count) {
+        return UDP_FRAG_ERR_MALFORMED;
+    }
+
+    uint8_t bit = (uint8_t)(1 << (header.index % 8));
+    if (reassembler->have[header.index / 8] & bit) {
+        return 0;  // Duplicate
+    }
+    memcpy(reassembler->buffer + header.offset, data + UDP_FRAG_HEADER_SIZE, size - UDP_FRAG_HEADER_SIZE);
+    reassembler->have[header.index / 8] |= bit;
+    reassembler->received++;
+
+    if (reassembler->received < reassembler->count) {
+        return 0;
+    }
+    reassembler->active = 0;
+    return (int)reassembler->total_size;
+}
@@ -17,6 +17,8 @@
 #include <string.h>
 #include <math.h>
 
+#include <algorithm>
+
 #include "common.h"
 #include "file_utils.h"
 #include "image_utils.h"
@@ -37,19 +39,29 @@ int init_yolox_model(const char *model_path, rknn_app_context_t *app_ctx)
 {
     int ret;
     int model_len = 0;
-    char *model;
+    void *model = NULL;
     rknn_context ctx = 0;
 
-    // Load RKNN Model
-    model_len = read_data_from_file(model_path, &model);
-    if (model == NULL)
+    // Load RKNN Model. Mapping skips copying the whole file into the heap
+    // first; fall back to reading it where mmap is not possible.
+    model_len = map_data_from_file(model_path, &model);
+    if (model_len > 0)
     {
-        printf("load_model fail!\n");
-        return -1;
+        ret = rknn_init(&ctx, model, model_len, 0, NULL);
+        unmap_data(model, model_len);
+    }
+    else
+    {
+        char *data = NULL;
+        model_len = read_data_from_file(model_path, &data);
+        if (model_len < 0 || data == NULL)
+        {
+            printf("load_model fail!\n");
+            return -1;
+        }
+        ret = rknn_init(&ctx, data, model_len, 0, NULL);
+        free(data);
     }
-
-    ret = rknn_init(&ctx, model, model_len, 0, NULL);
-    free(model);
     if (ret < 0)
     {
         printf("rknn_init fail! ret=%d\n", ret);
@@ -130,6 +142,33 @@ int init_yolox_model(const char *model_path, rknn_app_context_t *app_ctx)
     return 0;
 }
 
+int dup_yolox_model(rknn_app_context_t *src_ctx, rknn_app_context_t *dst_ctx, rknn_core_mask core_mask)
+{
+    rknn_context ctx = 0;
+    int ret = rknn_dup_context(&src_ctx->rknn_ctx, &ctx);
+    if (ret < 0) {
+        printf("rknn_dup_context fail! ret=%d\n", ret);
+        return -1;
+    }
+
+    if (core_mask != RKNN_NPU_CORE_AUTO) {
+        // Only RK3588/RK3576 have more than one core; elsewhere the runtime rejects the mask
+        ret = rknn_set_core_mask(ctx, core_mask);
+        if (ret < 0) {
+            printf("rknn_set_core_mask(%d) not supported, ret=%d\n", core_mask, ret);
+        }
+    }
+
+    *dst_ctx = *src_ctx;
+    dst_ctx->rknn_ctx = ctx;
+    dst_ctx->input_attrs = (rknn_tensor_attr *)malloc(src_ctx->io_num.n_input * sizeof(rknn_tensor_attr));
+    memcpy(dst_ctx->input_attrs, src_ctx->input_attrs, src_ctx->io_num.n_input * sizeof(rknn_tensor_attr));
+    dst_ctx->output_attrs = (rknn_tensor_attr *)malloc(src_ctx->io_num.n_output * sizeof(rknn_tensor_attr));
+    memcpy(dst_ctx->output_attrs, src_ctx->output_attrs, src_ctx->io_num.n_output * sizeof(rknn_tensor_attr));
+
+    return 0;
+}
+
 int release_yolox_model(rknn_app_context_t *app_ctx)
 {    
     if (app_ctx->input_attrs != NULL)
@@ -150,7 +189,8 @@ int release_yolox_model(rknn_app_context_t *app_ctx)
     return 0;
 }
 
-int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results, float conf_threshold) {
+int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results, float conf_threshold,
+                          image_rect_t *src_box) {
     int ret;
     image_buffer_t dst_img;
     letterbox_t letter_box;
@@ -181,7 +221,7 @@ int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, obje
     }
 
     // letterbox - maintain aspect ratio when resizing
-    ret = convert_image_with_letterbox(img, &dst_img, &letter_box, bg_color);
+    ret = convert_image_with_letterbox_roi(img, src_box, &dst_img, &letter_box, bg_color);
     if (ret < 0) {
         printf("convert_image_with_letterbox fail! ret=%d\n", ret);
         goto out;
@@ -223,6 +263,17 @@ int inference_yolox_model(rknn_app_context_t *app_ctx, image_buffer_t *img, obje
     // Post Process
     post_process(app_ctx, outputs, &letter_box, box_conf_threshold, nms_threshold, od_results);
 
+    // Boxes come back relative to the region; shift them into image coordinates
+    if (src_box != NULL) {
+        for (int i = 0; i < od_results->count; i++) {
+            box_rect_t *box = &od_results->results[i].box;
+            box->left = std::min(box->left + src_box->left, src_box->right);
+            box->top = std::min(box->top + src_box->top, src_box->bottom);
+            box->right = std::min(box->right + src_box->left, src_box->right);
+            box->bottom = std::min(box->bottom + src_box->top, src_box->bottom);
+        }
+    }
+
     // Remember to release rknn output
     rknn_outputs_release(app_ctx->rknn_ctx, app_ctx->io_num.n_output, outputs);
 
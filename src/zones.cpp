@@ -0,0 +1,201 @@
+#include "zones.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+bool loadZones(const std::string& path, ZoneConfig& config) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open zones file: " << path << std::endl;
+        return false;
+    }
+    json root = json::parse(file, nullptr, false);
+    if (root.is_discarded() || !root.is_object() || !root.contains("zones") || !root["zones"].is_array()) {
+        std::cerr << "Error: " << path << " is not a JSON object with a \"zones\" array" << std::endl;
+        return false;
+    }
+
+    ZoneConfig loaded;
+    std::string anchor = root.value("anchor", "bottom-center");
+    if (anchor == "bottom-center") {
+        loaded.anchor = ZoneAnchor::BottomCenter;
+    } else if (anchor == "center") {
+        loaded.anchor = ZoneAnchor::Center;
+    } else {
+        std::cerr << "Error: Unknown zone anchor " << anchor << " (expected bottom-center or center)" << std::endl;
+        return false;
+    }
+
+    for (const auto& entry : root["zones"]) {
+        Zone zone;
+        if (entry.is_object() && entry.contains("name") && entry["name"].is_string()) {
+            zone.name = entry["name"];
+        }
+        if (zone.name.empty()) {
+            std::cerr << "Error: Every zone in " << path << " needs a name" << std::endl;
+            return false;
+        }
+        for (const auto& existing : loaded.zones) {
+            if (existing.name == zone.name) {
+                std::cerr << "Error: Zone " << zone.name << " is defined twice" << std::endl;
+                return false;
+            }
+        }
+        if (entry.contains("points") && entry["points"].is_array()) {
+            for (const auto& point : entry["points"]) {
+                if (!point.is_array() || point.size() != 2 || !point[0].is_number() || !point[1].is_number()) {
+                    zone.points.clear();
+                    break;
+                }
+                zone.points.emplace_back(point[0].get<float>(), point[1].get<float>());
+            }
+        }
+        if (zone.points.size() < 3) {
+            std::cerr << "Error: Zone " << zone.name << " needs at least 3 [x, y] points" << std::endl;
+            return false;
+        }
+        loaded.zones.push_back(std::move(zone));
+    }
+    if (loaded.zones.empty() || loaded.zones.size() > ZoneMap::MAX_ZONES) {
+        std::cerr << "Error: " << path << " must define between 1 and " << ZoneMap::MAX_ZONES << " zones"
+                  << std::endl;
+        return false;
+    }
+    config = std::move(loaded);
+    return true;
+}
+
+bool ZoneMap::contains(const Zone& zone, float x, float y) {
+    bool inside = false;
+    const auto& points = zone.points;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+        auto [xi, yi] = points[i];
+        auto [xj, yj] = points[j];
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+ZoneMap::ZoneMap(const ZoneConfig& config)
+    : zones(config.zones.begin(), config.zones.begin() + std::min(config.zones.size(), MAX_ZONES)),
+      anchor(config.anchor) {
+    if (zones.empty()) {
+        return;
+    }
+
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (const auto& zone : zones) {
+        for (auto [x, y] : zone.points) {
+            min_x = std::min(min_x, x);
+            min_y = std::min(min_y, y);
+            max_x = std::max(max_x, x);
+            max_y = std::max(max_y, y);
+        }
+    }
+    origin_x = min_x;
+    origin_y = min_y;
+
+    // Cells of at least a pixel, as many as the limit allows
+    float width = max_x - min_x;
+    float height = max_y - min_y;
+    cell_size = std::max(1.0f, std::sqrt(width * height / MAX_CELLS));
+    while (true) {
+        cols = static_cast<int>(width / cell_size) + 1;
+        rows = static_cast<int>(height / cell_size) + 1;
+        if (static_cast<size_t>(cols) * rows <= MAX_CELLS) {
+            break;
+        }
+        cell_size *= 1.05f;
+    }
+    cells.assign(static_cast<size_t>(cols) * rows, Cell());
+
+    for (size_t z = 0; z < zones.size(); z++) {
+        rasterize(z);
+    }
+}
+
+void ZoneMap::rasterize(size_t zone_index) {
+    const auto& points = zones[zone_index].points;
+    uint64_t bit = 1ull << zone_index;
+    auto column = [&](float x) { return std::clamp(static_cast<int>(std::floor((x - origin_x) / cell_size)), 0, cols - 1); };
+    auto row = [&](float y) { return std::clamp(static_cast<int>(std::floor((y - origin_y) / cell_size)), 0, rows - 1); };
+
+    // Every cell an edge passes through: in each row the edge spans, the
+    // columns between where it enters and leaves the row
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+        auto [x0, y0] = points[j];
+        auto [x1, y1] = points[i];
+        if (y0 > y1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        for (int r = row(y0); r <= row(y1); r++) {
+            float top = std::max(y0, origin_y + r * cell_size);
+            float bottom = std::min(y1, origin_y + (r + 1) * cell_size);
+            float xa = x0, xb = x1;
+            if (y1 > y0) {
+                xa = x0 + (x1 - x0) * (top - y0) / (y1 - y0);
+                xb = x0 + (x1 - x0) * (bottom - y0) / (y1 - y0);
+            }
+            for (int c = column(std::min(xa, xb)); c <= column(std::max(xa, xb)); c++) {
+                cells[static_cast<size_t>(r) * cols + c].edge |= bit;
+            }
+        }
+    }
+
+    // Cells without an edge are entirely inside or outside: fill the spans
+    // between crossings of each row's center line
+    std::vector<float> crossings;
+    for (int r = 0; r < rows; r++) {
+        float y = origin_y + (r + 0.5f) * cell_size;
+        crossings.clear();
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            auto [xi, yi] = points[i];
+            auto [xj, yj] = points[j];
+            if ((yi > y) != (yj > y)) {
+                crossings.push_back((xj - xi) * (y - yi) / (yj - yi) + xi);
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            // Cells whose centers lie between the two crossings
+            int first = static_cast<int>(std::ceil((crossings[k] - origin_x) / cell_size - 0.5f));
+            int last = static_cast<int>(std::ceil((crossings[k + 1] - origin_x) / cell_size - 0.5f)) - 1;
+            for (int c = std::max(first, 0); c <= std::min(last, cols - 1); c++) {
+                Cell& cell = cells[static_cast<size_t>(r) * cols + c];
+                if (!(cell.edge & bit)) {
+                    cell.inside |= bit;
+                }
+            }
+        }
+    }
+}
+
+uint64_t ZoneMap::zonesAt(float x, float y) const {
+    float fx = (x - origin_x) / cell_size;
+    float fy = (y - origin_y) / cell_size;
+    if (cells.empty() || !(fx >= 0.0f && fy >= 0.0f && fx < cols && fy < rows)) {
+        return 0;
+    }
+    const Cell& cell = cells[static_cast<size_t>(fy) * cols + static_cast<size_t>(fx)];
+    uint64_t result = cell.inside;
+    for (uint64_t edge = cell.edge; edge; edge &= edge - 1) {
+        int z = __builtin_ctzll(edge);
+        if (contains(zones[z], x, y)) {
+            result |= 1ull << z;
+        }
+    }
+    return result;
+}
+
+uint64_t ZoneMap::zonesOf(const box_rect_t& box) const {
+    float x = (box.left + box.right) * 0.5f;
+    float y = anchor == ZoneAnchor::BottomCenter ? static_cast<float>(box.bottom) : (box.top + box.bottom) * 0.5f;
+    return zonesAt(x, y);
+}
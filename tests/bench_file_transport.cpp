@@ -0,0 +1,107 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Include headers
+#include "transport.h"
+
+// Messages per second written to a file for each FileTransport durability
+// policy, against the previous implementation (ofstream, close, reopen to
+// fsync, rename) in each directory given.
+//   bench_file_transport [seconds per run] [directory...]
+// Defaults: 1 second, /dev/shm (tmpfs) and the current directory.
+
+namespace fs = std::filesystem;
+
+// FileTransport::send() before the rewrite
+static bool legacySend(const std::string& filepath, const std::string& data) {
+    std::string temp_filepath = filepath + ".tmp";
+    {
+        std::ofstream file(temp_filepath, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << data;
+        file.flush();
+        file.close();
+        int fd = ::open(temp_filepath.c_str(), O_RDONLY);
+        if (fd != -1) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp_filepath, filepath, ec);
+    return !ec;
+}
+
+static double run(double seconds, const std::function<bool()>& send) {
+    long messages = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+    auto now = start;
+    while (now < end) {
+        if (!send()) {
+            return 0.0;
+        }
+        messages++;
+        now = std::chrono::steady_clock::now();
+    }
+    return messages / std::chrono::duration<double>(now - start).count();
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    std::vector<std::string> dirs;
+    for (int i = 2; i < argc; i++) {
+        dirs.push_back(argv[i]);
+    }
+    if (dirs.empty()) {
+        dirs = {"/dev/shm", fs::current_path().string()};
+    }
+
+    // A typical full JSON message with a few detections
+    std::string message = "{\"detection_count\":4,\"detections\":[";
+    for (int i = 0; i < 4; i++) {
+        message += std::string(i ? "," : "") +
+                   "{\"class\":\"person\",\"confidence\":0.87,\"box\":{\"left\":120,\"top\":48,\"right\":260,\"bottom\":410}}";
+    }
+    message += "],\"timestamp\":1746732409}";
+
+    printf("%zu-byte messages, %.1f s per run\n\n", message.size(), seconds);
+    printf("%-30s %-12s %-8s %12s\n", "directory", "policy", "method", "messages/s");
+    for (const auto& dir : dirs) {
+        std::string path = (fs::path(dir) / ("bench-results-" + std::to_string(getpid()) + ".json")).string();
+
+        double rate = run(seconds, [&] { return legacySend(path, message); });
+        printf("%-30s %-12s %-8s %12.0f\n", dir.c_str(), "legacy", "ofstream", rate);
+
+        for (FileDurability durability : {FileDurability::Auto, FileDurability::None, FileDurability::Periodic,
+                                          FileDurability::OnRename}) {
+            FileTransport transport(path, durability, 1.0);
+            if (!transport.isConnected()) {
+                printf("%-30s cannot write\n", dir.c_str());
+                break;
+            }
+            rate = run(seconds, [&] { return transport.send(message); });
+            std::string policy = fileDurabilityName(durability);
+            if (durability == FileDurability::Auto) {
+                policy += std::string("=") + fileDurabilityName(transport.durability());
+            }
+            printf("%-30s %-12s %-8s %12.0f\n", dir.c_str(), policy.c_str(),
+                   transport.usesTmpfile() ? "tmpfile" : "named", rate);
+        }
+        fs::remove(path);
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+// Include headers
+#include "detection_wire.h"
+#include "publisher.h"
+#include "inference.h"
+#include "reference_formatters.h"
+
+// Count every heap allocation made while formatting
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// A busy frame: a crowd plus a few other classes
+static InferenceResult makeResult(int detections) {
+    static const char* names[] = {"person", "car", "dog", "bicycle"};
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.class_mapping = {{"person", 0}, {"bicycle", 1}, {"car", 2}, {"dog", 16}};
+    result.selected_classes = {0, 2, 16};
+    result.confidence_threshold = 0.3f;
+    result.timestamp = std::chrono::system_clock::now();
+    result.detections.count = detections;
+    for (int i = 0; i < detections; i++) {
+        auto& detection = result.detections.results[i];
+        int c = i % 4;
+        detection.cls_id = c == 0 ? 0 : c == 1 ? 2 : c == 2 ? 16 : 1;
+        detection.prop = 0.25f + 0.7f * (i % 10) / 10.0f;
+        detection.box = {10 * i, 20 + i, 10 * i + 64, 180 + i};
+        strncpy(detection.name, names[c], sizeof(detection.name) - 1);
+    }
+    return result;
+}
+
+static void bench(const char* name, const std::function<size_t()>& format) {
+    const int iterations = 200000;
+    for (int i = 0; i < 1000; i++) {
+        format();  // Let reused buffers reach their final size
+    }
+
+    size_t bytes = 0;
+    long allocations_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        bytes += format();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double allocations_per_message = static_cast<double>(allocations.load() - allocations_before) / iterations;
+
+    printf("  %-34s %10.0f msg/s  %6.2f allocs/msg  %5zu bytes/msg\n", name, iterations / seconds,
+           allocations_per_message, bytes / iterations);
+}
+
+int main() {
+    for (int detections : {1, 12, 50}) {
+        InferenceResult result = makeResult(detections);
+        printf("%d detections per frame:\n", detections);
+
+        FullJsonMessageFormatter full_json;
+        SelectiveJsonMessageFormatter selective_json;
+        SelectiveBSMessageFormatter selective_bs;
+        std::string buffer;
+
+        bench("FullJson (json tree + dump)", [&] { return reference::fullJson(result, false).size(); });
+        bench("FullJson (streaming, reused buffer)", [&] {
+            full_json.formatInto(result, buffer);
+            return buffer.size();
+        });
+        bench("SelectiveJson (json tree + dump)", [&] { return reference::selectiveJson(result, {}).size(); });
+        bench("SelectiveJson (streaming)", [&] {
+            selective_json.formatInto(result, buffer);
+            return buffer.size();
+        });
+        bench("SelectiveBS (streaming)", [&] {
+            selective_bs.formatInto(result, buffer);
+            return buffer.size();
+        });
+
+        // Binary wire format, sender and receiver side
+        BinaryMessageFormatter binary_key;
+        BinaryMessageFormatter binary_delta(30);
+        bench("Binary, key frames only", [&] {
+            result.frame_id++;
+            binary_key.formatInto(result, buffer);
+            return buffer.size();
+        });
+        bench("Binary, delta frames (keyframe 30)", [&] {
+            result.frame_id++;
+            binary_delta.formatInto(result, buffer);
+            return buffer.size();
+        });
+        std::string full_json_message = full_json.formatMessage(result);
+        bench("Receive FullJson (json::parse)", [&] {
+            nlohmann::json parsed = nlohmann::json::parse(full_json_message);
+            return parsed["detections"].size() > 0 ? full_json_message.size() : 0;
+        });
+        std::string binary_message = binary_key.formatMessage(result);
+        wire_decoder_t decoder;
+        wire_frame_t decoded;
+        bench("Receive binary (wire_decode)", [&] {
+            wire_decoder_init(&decoder);
+            wire_decode(&decoder, reinterpret_cast<const uint8_t*>(binary_message.data()), binary_message.size(),
+                        &decoded);
+            return decoded.box_count > 0 ? binary_message.size() : 0;
+        });
+
+        // One frame fanned out to every sink: a shared view walks the detections once
+        std::vector<std::shared_ptr<MessageFormatter>> sinks = {
+            std::make_shared<JsonMessageFormatter>(), std::make_shared<SelectiveJsonMessageFormatter>(),
+            std::make_shared<SelectiveBSMessageFormatter>(), std::make_shared<FullJsonMessageFormatter>(),
+            std::make_shared<FacesJsonMessageFormatter>(), std::make_shared<FacesBSMessageFormatter>(),
+            std::make_shared<BSVariableMessageFormatter>()};
+        auto fanOut = [&](bool share_view) {
+            InferenceResult frame = result;
+            if (share_view) {
+                frame.shareView();
+            }
+            size_t bytes = 0;
+            for (const auto& sink : sinks) {
+                sink->formatInto(frame, buffer);
+                bytes += buffer.size();
+            }
+            return bytes;
+        };
+        bench("7 sinks, one pass per sink", [&] { return fanOut(false); });
+        bench("7 sinks, shared result view", [&] { return fanOut(true); });
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+// Include headers
+#include "history_log.h"
+#include "history_query.h"
+#include "transport.h"
+
+// Append rate of the history log, then per-minute and per-hour query times
+// over everything written (page cache warm, as on a device that just wrote it).
+//   bench_history_log [records] [directory]
+// Defaults: 5 million records (58 days at 1 Hz) of person and car counts,
+// in the current directory.
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    long records = argc > 1 ? atol(argv[1]) : 5000000;
+    fs::path dir = fs::path(argc > 2 ? argv[2] : fs::current_path().string()) /
+                   ("bench-history-" + std::to_string(getpid()));
+
+    HistoryLayout layout;
+    layout.class_ids = {0, 2};
+    layout.class_names = {"person", "car"};
+    HistoryConfig config;
+    config.budget_bytes = 4ull << 30;
+    config.segment_bytes = 64ull << 20;
+    config.segment_seconds = 86400;
+    config.commit_bytes = 1 << 20;
+
+    std::string record(history_record_size(2, 0), '\0');
+    history_record_t* header = reinterpret_cast<history_record_t*>(record.data());
+    uint16_t* counts = reinterpret_cast<uint16_t*>(header + 1);
+    uint64_t start_ms = 1792238400000ull;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        HistoryTransport transport(dir.string(), layout, config);
+        for (long i = 0; i < records; i++) {
+            header->timestamp_ms = start_ms + i * 1000;
+            header->frame_id = static_cast<uint32_t>(i);
+            counts[0] = static_cast<uint16_t>((i / 600) % 7);
+            counts[1] = static_cast<uint16_t>(i % 3 == 0);
+            header->detections = counts[0] + counts[1];
+            if (!transport.send(record)) {
+                printf("Cannot write history to %s\n", dir.c_str());
+                fs::remove_all(dir);
+                return 1;
+            }
+        }
+    }
+    double write_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto segments = listHistorySegments(dir.string());
+    uintmax_t bytes = 0;
+    for (const auto& segment : segments) {
+        bytes += fs::file_size(segment);
+    }
+    printf("%ld records (%zu bytes each) in %zu segments, %.1f MB: %.0f records/s appended\n\n", records,
+           record.size(), segments.size(), bytes / 1e6, records / write_s);
+
+    printf("%-8s %10s %10s %12s\n", "bucket", "buckets", "ms", "records/s");
+    for (uint64_t bucket_ms : {60000ull, 3600000ull}) {
+        HistoryQuery query;
+        query.bucket_ms = bucket_ms;
+        HistoryResult result;
+        double best_ms = 1e9;
+        for (int run = 0; run < 3; run++) {
+            start = std::chrono::steady_clock::now();
+            queryHistory(segments, query, result);
+            best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(
+                                            std::chrono::steady_clock::now() - start).count());
+        }
+        printf("%-8s %10zu %10.1f %12.0f\n", bucket_ms == 60000 ? "minute" : "hour", result.buckets.size(), best_ms,
+               result.records / (best_ms / 1000.0));
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
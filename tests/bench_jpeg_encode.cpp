@@ -0,0 +1,140 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "frame_writer.h"
+#include "inference.h"
+
+// Cost of a decorated frame at each output size: the JPEG encoding alone,
+// then the whole of DecoratedFrameWriter::writeFrame() (scale, draw, convert
+// and encode) for a busy 1080p capture, at each chroma subsampling.
+//   bench_jpeg_encode [frames per run] [quality]
+// Defaults: 50 frames at quality 95.
+
+static const int CAPTURE_WIDTH = 1920;
+static const int CAPTURE_HEIGHT = 1080;
+
+// Encodes each frame as the file and preview sinks would, and keeps its size
+class EncodingSink : public FrameSink {
+public:
+    size_t bytes = 0;
+    void publish(DecoratedFrame& frame) override { bytes = frame.jpeg().size(); }
+};
+
+// Something closer to a camera frame than noise: gradients, edges and grain
+static cv::Mat sceneFrame() {
+    cv::Mat rgb(CAPTURE_HEIGHT, CAPTURE_WIDTH, CV_8UC3);
+    uint32_t seed = 12345;
+    for (int y = 0; y < rgb.rows; y++) {
+        uint8_t* row = rgb.ptr<uint8_t>(y);
+        for (int x = 0; x < rgb.cols; x++) {
+            seed = seed * 1103515245 + 12345;
+            int grain = static_cast<int>((seed >> 16) & 15) - 8;
+            int block = ((x / 160) + (y / 120)) % 3;
+            row[x * 3] = static_cast<uint8_t>(std::clamp(x * 255 / rgb.cols + grain + block * 20, 0, 255));
+            row[x * 3 + 1] = static_cast<uint8_t>(std::clamp(y * 255 / rgb.rows + grain, 0, 255));
+            row[x * 3 + 2] = static_cast<uint8_t>(std::clamp(128 + block * 40 + grain, 0, 255));
+        }
+    }
+    return rgb;
+}
+
+static InferenceResult busyResult() {
+    InferenceResult result;
+    const char* names[] = {"person", "car", "bicycle", "traffic light"};
+    result.detections.count = 30;
+    for (int i = 0; i < 30; i++) {
+        object_detect_result& detection = result.detections.results[i];
+        detection.cls_id = i % 4;
+        detection.prop = 0.5f + i * 0.015f;
+        strncpy(detection.name, names[i % 4], sizeof(detection.name) - 1);
+        detection.name[sizeof(detection.name) - 1] = '\0';
+        detection.box = {40 + i * 60, 100 + (i % 5) * 150, 90 + i * 60, 400 + (i % 5) * 120};
+    }
+    result.confidence_threshold = 0.5f;
+    return result;
+}
+
+static const char* subsamplingName(JpegSubsampling subsampling) {
+    return subsampling == JpegSubsampling::S444 ? "4:4:4" : subsampling == JpegSubsampling::S422 ? "4:2:2" : "4:2:0";
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 50;
+    int quality = argc > 2 ? atoi(argv[2]) : 95;
+    if (frames < 1 || quality < 1 || quality > 100) {
+        printf("Usage: bench_jpeg_encode [frames per run] [quality 1-100]\n");
+        return 1;
+    }
+
+    const cv::Mat source = sceneFrame();
+    const InferenceResult result = busyResult();
+    const cv::Size sizes[] = {{1920, 1080}, {1280, 720}, {960, 540}, {640, 360}};
+    const JpegSubsampling samplings[] = {JpegSubsampling::S420, JpegSubsampling::S422, JpegSubsampling::S444};
+
+    printf("%d frames per run, quality %d, 30 boxes on a %dx%d capture\n\n", frames, quality, CAPTURE_WIDTH,
+           CAPTURE_HEIGHT);
+    printf("%-10s %-6s %10s %12s %12s\n", "size", "chroma", "KB/frame", "encode ms", "writeFrame ms");
+
+    for (const cv::Size& size : sizes) {
+        cv::Mat bgr;
+        cv::resize(source, bgr, size, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(bgr, bgr, cv::COLOR_RGB2BGR);
+
+        for (JpegSubsampling subsampling : samplings) {
+            // The encoding alone
+            std::vector<uchar> jpeg;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; i++) {
+                if (!encodeJpeg(bgr, quality, jpeg, subsampling)) {
+                    printf("Encoding failed\n");
+                    return 1;
+                }
+            }
+            double encode_ms =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+            // The whole decorated path; copying the capture is not counted
+            FrameOutputConfig output;
+            output.width = size.width;
+            output.height = size.height;
+            output.jpeg_quality = quality;
+            output.subsampling = subsampling;
+            DecoratedFrameWriter writer("");
+            writer.setOutput(output);
+            auto sink = std::make_shared<EncodingSink>();
+            writer.addSink(sink);
+
+            // writeFrame() logs every box it draws; keep that out of the table
+            fflush(stdout);
+            int saved_stdout = dup(STDOUT_FILENO);
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+            double write_ms = 0.0;
+            cv::Mat frame;
+            for (int i = 0; i < frames; i++) {
+                source.copyTo(frame);
+                start = std::chrono::steady_clock::now();
+                writer.writeFrame(frame, result);
+                write_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            fflush(stdout);
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+            close(null_fd);
+
+            printf("%4dx%-5d %-6s %10.1f %12.2f %12.2f\n", size.width, size.height, subsamplingName(subsampling),
+                   jpeg.size() / 1024.0, encode_ms, write_ms / frames);
+        }
+    }
+    return 0;
+}
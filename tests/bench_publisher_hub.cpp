@@ -0,0 +1,159 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+// Include headers
+#include "publisher.h"
+#include "publisher_hub.h"
+#include "inference.h"
+#include "transport.h"
+
+// CPU use of the whole process, publishers and producer alike, with a thread
+// per sink against one hub thread for all of them. Sinks send the selective
+// JSON counts over UDP to a local port nobody listens on.
+//   bench_publisher_hub [seconds per run]
+
+static const int SINK_COUNTS[] = {1, 4, 16, 32, 64};
+static const double SINK_RATE = 10.0;
+static const int UDP_PORT = 45999;
+
+struct Usage {
+    double cpu_seconds;
+    long context_switches;
+};
+
+static Usage usage() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return {ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6,
+            ru.ru_nvcsw + ru.ru_nivcsw};
+}
+
+// Camera rate results with a few people in them
+static void produce(ThreadSafeQueue<InferenceResult>& queue, std::atomic<bool>& stop) {
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t frame = 1; !stop; frame++) {
+        InferenceResult result;
+        memset(&result.detections, 0, sizeof(result.detections));
+        result.timestamp = std::chrono::system_clock::now();
+        result.confidence_threshold = 0.5f;
+        result.class_mapping = {{"person", 0}, {"car", 2}};
+        result.selected_classes = {0, 2};
+        result.frame_id = frame;
+        result.detections.count = 4;
+        for (int i = 0; i < 4; i++) {
+            auto& detection = result.detections.results[i];
+            detection.box = {100 * i, 50, 100 * i + 80, 250};
+            detection.prop = 0.9f;
+            detection.cls_id = i % 2 ? 2 : 0;
+            strncpy(detection.name, i % 2 ? "car" : "person", sizeof(detection.name) - 1);
+        }
+        result.shareView();
+        queue.push(std::move(result));
+        next += std::chrono::microseconds(33333);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+struct Run {
+    Usage used;
+    long sent;
+};
+
+static Run runThreads(int sinks, double seconds) {
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    std::atomic<bool> stop{false};
+    std::vector<std::unique_ptr<Publisher>> publishers;
+    for (int i = 0; i < sinks; i++) {
+        publishers.push_back(std::make_unique<Publisher>(
+            std::make_shared<UDPTransport>("127.0.0.1", UDP_PORT), queue, running,
+            std::make_shared<SelectiveJsonMessageFormatter>(), SINK_RATE, "sink " + std::to_string(i)));
+    }
+
+    Usage before = usage();
+    std::thread producer(produce, std::ref(queue), std::ref(stop));
+    std::vector<std::thread> threads;
+    for (auto& publisher : publishers) {
+        threads.emplace_back(std::ref(*publisher));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    stop = true;
+    queue.signalShutdown();
+    producer.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Usage after = usage();
+
+    long sent = 0;
+    for (auto& publisher : publishers) {
+        sent += publisher->stats().sent;
+    }
+    return {{after.cpu_seconds - before.cpu_seconds, after.context_switches - before.context_switches}, sent};
+}
+
+static Run runHub(int sinks, double seconds) {
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    std::atomic<bool> stop{false};
+    PublisherHub hub(queue, running);
+    std::vector<PublishSink*> hub_sinks;
+    for (int i = 0; i < sinks; i++) {
+        hub_sinks.push_back(&hub.addSink(std::make_shared<UDPTransport>("127.0.0.1", UDP_PORT),
+                    std::make_shared<SelectiveJsonMessageFormatter>(), SINK_RATE, "sink " + std::to_string(i)));
+    }
+
+    Usage before = usage();
+    std::thread producer(produce, std::ref(queue), std::ref(stop));
+    std::thread thread(std::ref(hub));
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    stop = true;
+    queue.signalShutdown();
+    producer.join();
+    thread.join();
+    Usage after = usage();
+
+    long sent = 0;
+    for (auto* sink : hub_sinks) {
+        sent += sink->stats().sent;
+    }
+    return {{after.cpu_seconds - before.cpu_seconds, after.context_switches - before.context_switches}, sent};
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+
+    // The final per-sink statistics would drown the table
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("freopen");
+    }
+    std::vector<std::string> rows;
+    for (int sinks : SINK_COUNTS) {
+        Run threads = runThreads(sinks, seconds);
+        Run hub = runHub(sinks, seconds);
+        char row[256];
+        snprintf(row, sizeof(row), "%5d  %12.1f  %10.0f  %8ld  %8.1f  %10.0f  %8ld\n", sinks,
+                 100.0 * threads.used.cpu_seconds / seconds, threads.used.context_switches / seconds,
+                 static_cast<long>(threads.sent / seconds), 100.0 * hub.used.cpu_seconds / seconds,
+                 hub.used.context_switches / seconds, static_cast<long>(hub.sent / seconds));
+        rows.push_back(row);
+    }
+
+    fprintf(stderr, "%.0f Hz sinks, 30 fps results, %.1f s per run\n", SINK_RATE, seconds);
+    fprintf(stderr, "sinks  threads CPU%%  switches/s     msg/s  hub CPU%%  switches/s     msg/s\n");
+    for (auto& row : rows) {
+        fputs(row.c_str(), stderr);
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// Include headers
+#include "transport.h"
+#include "udp_fragment.h"
+
+// Send throughput to local receivers: UDPTransport (one non-blocking socket,
+// one sendmmsg() per message) against one blocking sendto() per datagram
+// and destination, as the transport did before. Both send the same
+// datagrams, fragments included.
+//   bench_udp_transport [messages per run]
+
+static const size_t MAX_DATAGRAM = UDPTransport::DEFAULT_FRAGMENT_SIZE;
+
+// Counts what arrives on one local port
+class Receiver {
+public:
+    Receiver() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        int size = 8 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        struct timeval timeout = {0, 100000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            perror("bind");
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this] { run(); });
+    }
+    ~Receiver() {
+        stop = true;
+        thread.join();
+        close(fd);
+    }
+
+    int port;
+    std::atomic<long> datagrams{0};
+
+private:
+    void run() {
+        const int batch = 64;
+        std::vector<char> buffers(batch * 2048);
+        struct mmsghdr messages[batch];
+        struct iovec iovecs[batch];
+        while (!stop) {
+            for (int i = 0; i < batch; i++) {
+                iovecs[i] = {&buffers[i * 2048], 2048};
+                memset(&messages[i], 0, sizeof(messages[i]));
+                messages[i].msg_hdr.msg_iov = &iovecs[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int n = recvmmsg(fd, messages, batch, 0, nullptr);
+            if (n > 0) {
+                datagrams += n;
+            }
+        }
+    }
+
+    int fd;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+};
+
+// The transport as it was: a blocking sendto() per datagram and destination
+class SendtoSender {
+public:
+    explicit SendtoSender(const std::vector<UDPDestination>& destinations) {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        for (const auto& destination : destinations) {
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(destination.port);
+            inet_pton(AF_INET, destination.ip.c_str(), &addr.sin_addr);
+            addresses.push_back(addr);
+        }
+    }
+    ~SendtoSender() { close(fd); }
+
+    void send(const std::string& data) {
+        const size_t payload = MAX_DATAGRAM - UDP_FRAG_HEADER_SIZE;
+        uint16_t count = static_cast<uint16_t>(std::max<size_t>((data.size() + payload - 1) / payload, 1));
+        std::vector<char> datagram(MAX_DATAGRAM);
+        for (uint16_t index = 0; index < count; index++) {
+            size_t offset = index * payload;
+            size_t size = std::min(payload, data.size() - offset);
+            udp_frag_header_t header = {message_id, index, count, static_cast<uint32_t>(offset),
+                                        static_cast<uint32_t>(data.size())};
+            udp_frag_write_header(reinterpret_cast<uint8_t*>(datagram.data()), &header);
+            memcpy(datagram.data() + UDP_FRAG_HEADER_SIZE, data.data() + offset, size);
+            for (auto& addr : addresses) {
+                sendto(fd, datagram.data(), UDP_FRAG_HEADER_SIZE + size, 0, reinterpret_cast<struct sockaddr*>(&addr),
+                       sizeof(addr));
+            }
+        }
+        message_id++;
+    }
+
+private:
+    int fd;
+    std::vector<struct sockaddr_in> addresses;
+    uint32_t message_id = 0;
+};
+
+static double cpuSeconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+struct Result {
+    double messages_per_second;
+    double cpu_us_per_message;
+    double received_fraction;
+    long eagain_drops;
+};
+
+template<typename Send>
+static Result run(std::vector<std::unique_ptr<Receiver>>& receivers, long expected_per_message, int messages,
+                  Send send) {
+    long before = 0;
+    for (auto& receiver : receivers) {
+        before += receiver->datagrams;
+    }
+    double cpu_start = cpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < messages; i++) {
+        send();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = cpuSeconds() - cpu_start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Let the receivers catch up
+
+    long received = -before;
+    for (auto& receiver : receivers) {
+        received += receiver->datagrams;
+    }
+    return {messages / seconds, 1e6 * cpu / messages,
+            static_cast<double>(received) / (static_cast<double>(expected_per_message) * messages), 0};
+}
+
+int main(int argc, char** argv) {
+    int messages = argc > 1 ? atoi(argv[1]) : 20000;
+
+    printf("%d messages per run; max datagram %zu bytes\n", messages, MAX_DATAGRAM);
+    printf("dests  bytes  datagrams  | sendto msg/s  us/msg  recv%%  | sendmmsg msg/s  us/msg  recv%%  EAGAIN\n");
+    for (int destinations : {1, 4, 8}) {
+        for (size_t size : {200, 4000, 16000}) {
+            std::vector<std::unique_ptr<Receiver>> receivers;
+            std::vector<UDPDestination> list;
+            for (int i = 0; i < destinations; i++) {
+                receivers.push_back(std::make_unique<Receiver>());
+                list.push_back({"127.0.0.1", receivers.back()->port});
+            }
+            std::string payload(size, 'x');
+            long fragments = (size + MAX_DATAGRAM - UDP_FRAG_HEADER_SIZE - 1) / (MAX_DATAGRAM - UDP_FRAG_HEADER_SIZE);
+            long per_message = fragments * destinations;
+
+            SendtoSender sendto_sender(list);
+            Result baseline = run(receivers, per_message, messages, [&] { sendto_sender.send(payload); });
+
+            UDPTransport transport(list, MAX_DATAGRAM);
+            Result batched = run(receivers, per_message, messages, [&] { transport.send(payload); });
+            batched.eagain_drops = transport.stats().eagain_drops;
+
+            printf("%5d  %5zu  %9ld  | %12.0f  %6.2f  %5.1f  | %14.0f  %6.2f  %5.1f  %6ld\n", destinations, size,
+                   per_message, baseline.messages_per_second, baseline.cpu_us_per_message,
+                   100.0 * baseline.received_fraction, batched.messages_per_second, batched.cpu_us_per_message,
+                   100.0 * batched.received_fraction, batched.eagain_drops);
+        }
+    }
+    return 0;
+}
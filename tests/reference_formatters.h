@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "publisher.h"
+#include "utils.h"
+
+// The formatters as they were before streaming, built on nlohmann::json.
+// The streaming formatters must reproduce their output byte for byte.
+namespace reference {
+
+inline std::string json(const InferenceResult& result) {
+    ::json j;
+    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    std::unordered_map<std::string, int> class_counts;
+    if (result.selected_classes.empty()) {
+        class_counts["person"] = 0;
+    } else {
+        for (int class_id : result.selected_classes) {
+            class_counts[getClassNameById(class_id, result.class_mapping)] = 0;
+        }
+    }
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if ((detection.prop <= 0.0f || detection.cls_id < 0 || detection.prop < result.confidence_threshold) ||
+            !isClassSelected(detection.cls_id, result.selected_classes)) {
+            continue;
+        }
+        std::string class_name = std::string(detection.name);
+        if (class_counts.find(class_name) != class_counts.end()) {
+            class_counts[class_name]++;
+        }
+    }
+    for (const auto& [class_name, count] : class_counts) {
+        j[class_name] = count;
+    }
+    return j.dump();
+}
+
+inline std::unordered_map<std::string, int> selectiveCounts(const InferenceResult& result,
+                                                     const std::unordered_map<std::string, std::string>& mapping) {
+    auto map = [&mapping](const std::string& name) {
+        auto it = mapping.find(name);
+        return it != mapping.end() ? it->second : name;
+    };
+    std::unordered_map<std::string, int> class_counts;
+    if (result.selected_classes.empty()) {
+        class_counts["person"] = 0;
+    } else {
+        for (int class_id : result.selected_classes) {
+            class_counts[map(getClassNameById(class_id, result.class_mapping))] = 0;
+        }
+    }
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if (detection.prop <= 0.0f || detection.cls_id < 0 || detection.prop < result.confidence_threshold ||
+            !isClassSelected(detection.cls_id, result.selected_classes)) {
+            continue;
+        }
+        std::string mapped_name = map(std::string(detection.name));
+        if (class_counts.find(mapped_name) != class_counts.end()) {
+            class_counts[mapped_name]++;
+        }
+    }
+    return class_counts;
+}
+
+inline std::string selectiveJson(const InferenceResult& result, const std::unordered_map<std::string, std::string>& mapping) {
+    ::json j;
+    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    for (const auto& [class_name, count] : selectiveCounts(result, mapping)) {
+        j[class_name] = count;
+    }
+    return j.dump();
+}
+
+// Fields of the BrightScript message; their order was unordered_map order
+inline std::multiset<std::string> selectiveBSFields(const InferenceResult& result,
+                                             const std::unordered_map<std::string, std::string>& mapping) {
+    std::multiset<std::string> fields;
+    for (const auto& [class_name, count] : selectiveCounts(result, mapping)) {
+        fields.insert(class_name + ":" + std::to_string(count));
+    }
+    fields.insert("timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp)));
+    return fields;
+}
+
+inline std::string fullJson(const InferenceResult& result, bool suppress_empty) {
+    ::json j;
+    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    ::json detections = ::json::array();
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if ((detection.prop <= 0.0f || detection.cls_id < 0) ||
+            !isClassSelected(detection.cls_id, result.selected_classes)) {
+            continue;
+        }
+        ::json det;
+        det["class_id"] = detection.cls_id;
+        det["class_name"] = std::string(detection.name);
+        det["confidence"] = detection.prop;
+        det["bbox"] = {
+            {"left", detection.box.left},
+            {"top", detection.box.top},
+            {"right", detection.box.right},
+            {"bottom", detection.box.bottom}
+        };
+        detections.push_back(det);
+    }
+    j["detections"] = detections;
+    j["detection_count"] = detections.size();
+    if (suppress_empty && detections.empty()) {
+        return "";
+    }
+    return j.dump();
+}
+
+inline int people(const InferenceResult& result) {
+    int people_count = 0;
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if (detection.cls_id == 0 && detection.prop >= result.confidence_threshold) {
+            people_count++;
+        }
+    }
+    return people_count;
+}
+
+inline std::string facesJson(const InferenceResult& result) {
+    ::json j;
+    j["faces_in_frame_total"] = people(result);
+    j["faces_attending"] = people(result);
+    j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    return j.dump();
+}
+
+inline std::string facesBS(const InferenceResult& result) {
+    return "faces_in_frame_total:" + std::to_string(people(result)) + "!!" +
+           "faces_attending:" + std::to_string(people(result)) + "!!" +
+           "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
+}
+
+inline std::string bsVariable(const InferenceResult& result) {
+    int valid_count = 0;
+    for (int i = 0; i < result.detections.count; ++i) {
+        const auto& detection = result.detections.results[i];
+        if (detection.prop >= result.confidence_threshold && detection.prop > 0.0f && detection.cls_id >= 0) {
+            valid_count++;
+        }
+    }
+    return "detection_count:" + std::to_string(valid_count) + "!!" +
+           "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
+}
+
+}  // namespace reference
@@ -0,0 +1,298 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "clip_recorder.h"
+#include "inference.h"
+#include "test_fixtures.h"
+
+namespace fs = std::filesystem;
+
+// A stand-in JPEG: SOI, a baseline SOF0 with the frame size, the frame
+// number as data, EOI. Enough for the recorder, which never decodes.
+static std::vector<uchar> fakeJpeg(int width, int height, uint32_t frame, size_t size = 2000) {
+    std::vector<uchar> jpeg = {0xFF, 0xD8, 0xFF, 0xC0, 0x00, 0x11, 0x08,
+                               static_cast<uchar>(height >> 8), static_cast<uchar>(height),
+                               static_cast<uchar>(width >> 8), static_cast<uchar>(width)};
+    jpeg.resize(size - 2 - (frame & 1), 0x55);  // Odd sizes too, for AVI padding
+    memcpy(&jpeg[20], &frame, sizeof(frame));
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+// Runs a recorder on its own thread, handing it one frame at a time
+class RecorderRun {
+public:
+    explicit RecorderRun(const ClipConfig& config) : recorder(config, running), thread(std::ref(recorder)) {}
+    ~RecorderRun() { stop(); }
+
+    void record(const std::vector<uchar>& jpeg, const InferenceResult& result) {
+        long before = recorder.stats().frames;
+        recorder.record(jpeg, result);
+        while (recorder.stats().frames == before) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void stop() {
+        running = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::atomic<bool> running{true};
+    ClipRecorder recorder;
+    std::thread thread;
+};
+
+static std::vector<fs::path> filesEndingWith(const fs::path& dir, const std::string& suffix) {
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static uint32_t readU32(const std::string& data, size_t offset) {
+    uint32_t value;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+void testTriggers() {
+    std::cout << "Testing trigger parsing..." << std::endl;
+
+    std::vector<ClipTrigger> triggers;
+    assert(parseClipTriggers("person>0,car>=2,any<=3,person==4,car<1", triggers));
+    assert(triggers.size() == 5);
+    assert(triggers[0].class_name == "person" && triggers[0].op == ClipTrigger::Op::Greater && triggers[0].value == 0);
+    assert(triggers[1].class_name == "car" && triggers[1].op == ClipTrigger::Op::AtLeast && triggers[1].value == 2);
+    assert(triggers[2].op == ClipTrigger::Op::AtMost && triggers[3].op == ClipTrigger::Op::Equal);
+    assert(triggers[4].op == ClipTrigger::Op::Less);
+    assert(triggers[0].holds(1) && !triggers[0].holds(0) && triggers[1].holds(2) && !triggers[4].holds(1));
+
+    assert(!parseClipTriggers("person", triggers));
+    assert(!parseClipTriggers(">0", triggers));
+    assert(!parseClipTriggers("person>x", triggers));
+    assert(!parseClipTriggers("person>1x", triggers));
+    assert(!parseClipTriggers("", triggers));
+    assert(triggers.size() == 5);  // Unchanged by failures
+
+    ClipFormat format;
+    assert(parseClipFormat("frames", format) && format == ClipFormat::Frames && !parseClipFormat("mp4", format));
+
+    std::cout << "✓ Trigger test passed" << std::endl;
+}
+
+void testAviClip() {
+    std::cout << "Testing a clip with pre-roll and post-roll..." << std::endl;
+
+    ClipConfig config;
+    config.directory = testDirectory("clips", "avi").string();
+    config.pre_seconds = 2.0;
+    config.post_seconds = 3.0;
+    std::vector<std::vector<uchar>> sent;
+    {
+        RecorderRun run(config);
+        // 25 s at 20 fps: a person from 10 s to 12 s, briefly gone at 11 s
+        for (uint32_t frame = 1; frame <= 500; frame++) {
+            uint64_t t = START_MS + frame * 50;
+            int people = t >= START_MS + 10000 && t < START_MS + 12000 && (t < START_MS + 11000 || t >= START_MS + 11100)
+                             ? 2
+                             : 0;
+            sent.push_back(fakeJpeg(1280, 720, frame));
+            run.record(sent.back(), makeResult(frame, t, people));
+        }
+        run.stop();
+        assert(run.recorder.stats().clips == 1 && run.recorder.stats().frames == 500);
+    }
+
+    auto sidecars = filesEndingWith(config.directory, ".json");
+    auto videos = filesEndingWith(config.directory, ".avi");
+    assert(sidecars.size() == 1 && videos.size() == 1);
+    assert(videos[0].filename() == "clip-20261017-120010-000.avi");
+
+    // Frames from 2 s before the first trigger to 3 s after the triggers last
+    // held: frames 160 to 299
+    std::ifstream sidecar_file(sidecars[0]);
+    auto sidecar = nlohmann::json::parse(sidecar_file);
+    assert(sidecar["trigger"] == "person>0" && sidecar["video"] == videos[0].filename().string());
+    assert(sidecar["started"] == START_MS + 10000 && sidecar["ended"] == START_MS + 14950);
+    auto results = sidecar["results"];
+    assert(results.size() == 140 && sidecar["frames"] == 140 && sidecar["fps"] == 20.0);
+    assert(results[0]["frame"] == 160 && results[0]["timestamp"] == START_MS + 8000);
+    assert(results[40]["detections"].size() == 2 && results[40]["detections"][0]["class"] == "person");
+    assert(results[40]["detections"][1]["box"] == nlohmann::json({10, 20, 15, 40}));
+    assert(results[139]["frame"] == 299 && results[139]["detections"].empty());
+
+    // The AVI holds those frames, each indexed
+    std::ifstream video_file(videos[0], std::ios::binary);
+    std::string avi((std::istreambuf_iterator<char>(video_file)), std::istreambuf_iterator<char>());
+    assert(avi.compare(0, 4, "RIFF") == 0 && avi.compare(8, 4, "AVI ") == 0);
+    assert(readU32(avi, 4) == avi.size() - 8);
+    assert(readU32(avi, 32) == 50000);                              // Microseconds per frame
+    assert(readU32(avi, 48) == 140);                                // Frames
+    assert(readU32(avi, 64) == 1280 && readU32(avi, 68) == 720);
+    assert(avi.compare(108, 8, "vidsMJPG") == 0 && readU32(avi, 132) == 20000);
+    size_t movi = 220;
+    assert(avi.compare(movi, 4, "movi") == 0);
+    size_t index = movi + readU32(avi, movi - 4);
+    assert(avi.compare(index, 4, "idx1") == 0 && readU32(avi, index + 4) == 140 * 16);
+    for (uint32_t i = 0; i < 140; i++) {
+        size_t entry = index + 8 + i * 16;
+        size_t chunk = movi + readU32(avi, entry + 8);
+        uint32_t size = readU32(avi, entry + 12);
+        assert(avi.compare(entry, 4, "00dc") == 0 && avi.compare(chunk, 4, "00dc") == 0);
+        assert(readU32(avi, chunk + 4) == size);
+        const auto& expected = sent[159 + i];
+        assert(size == expected.size() && memcmp(avi.data() + chunk + 8, expected.data(), size) == 0);
+    }
+
+    fs::remove_all(config.directory);
+    std::cout << "✓ AVI clip test passed" << std::endl;
+}
+
+void testFramesAndBudget() {
+    std::cout << "Testing frame directories, limits and the disk budget..." << std::endl;
+
+    ClipConfig config;
+    config.directory = testDirectory("clips", "frames").string();
+    config.format = ClipFormat::Frames;
+    config.pre_seconds = 1.0;
+    config.post_seconds = 1.0;
+    config.max_seconds = 4.0;
+    config.memory_bytes = 10 * 2000;  // Room for 10 frames of pre-roll, not 20
+    config.budget_bytes = 150 * 2000;
+    {
+        RecorderRun run(config);
+        // Three events, 20 s apart, each lasting 6 s: cut at 4 s and
+        // continued in a second clip
+        for (uint32_t frame = 1; frame <= 1200; frame++) {
+            uint64_t t = START_MS + frame * 50;
+            int people = (frame / 400) < 3 && frame % 400 >= 100 && frame % 400 < 220 ? 1 : 0;
+            run.record(fakeJpeg(640, 480, frame), makeResult(frame, t, people));
+        }
+        run.stop();
+        assert(run.recorder.stats().clips == 6);
+    }
+
+    // About 90 and 70 frames each, so only the newest clip fits in the budget:
+    // the continuation of the last event, from the frame the cap cut at
+    // (981) to 1 s after the person left (1039), after a pre-roll cut by memory
+    auto sidecars = filesEndingWith(config.directory, ".json");
+    assert(sidecars.size() == 1);
+    std::ifstream sidecar_file(sidecars[0]);
+    auto sidecar = nlohmann::json::parse(sidecar_file);
+    assert(sidecar["started"] == START_MS + 981 * 50);
+    auto results = sidecar["results"];
+    int frames = sidecar["frames"];
+    assert(results.back()["frame"] == 1039);
+    assert(frames > 59 && frames <= 59 + 10 && results[frames - 59]["frame"] == 981);
+    fs::path directory = fs::path(config.directory) / sidecar["video"].get<std::string>();
+    assert(fs::is_directory(directory));
+    char last[16];
+    snprintf(last, sizeof(last), "%06d.jpg", frames);
+    assert(fs::exists(directory / "000001.jpg") && fs::exists(directory / last));
+    snprintf(last, sizeof(last), "%06d.jpg", frames + 1);
+    assert(!fs::exists(directory / last));
+
+    fs::remove_all(config.directory);
+    std::cout << "✓ Frames and budget test passed" << std::endl;
+}
+
+void testClockStep() {
+    std::cout << "Testing a wall clock that steps back..." << std::endl;
+
+    ClipConfig config;
+    config.directory = testDirectory("clips", "step").string();
+    config.pre_seconds = 1.0;
+    config.post_seconds = 1.0;
+    {
+        RecorderRun run(config);
+        // A person from frame 20 on; at frame 60 the clock steps back 30 s
+        for (uint32_t frame = 1; frame <= 100; frame++) {
+            uint64_t t = START_MS + frame * 50 - (frame >= 60 ? 30000 : 0);
+            run.record(fakeJpeg(640, 480, frame), makeResult(frame, t, frame >= 20 ? 1 : 0));
+        }
+        run.stop();
+        assert(run.recorder.stats().clips == 2);
+    }
+
+    // The second clip starts at the step, without pre-roll from the old time base
+    auto sidecars = filesEndingWith(config.directory, ".json");
+    assert(sidecars.size() == 2);
+    std::ifstream sidecar_file(sidecars[0]);  // Named by the earlier, stepped-back time
+    auto sidecar = nlohmann::json::parse(sidecar_file);
+    assert(sidecar["started"] == START_MS + 60 * 50 - 30000);
+    assert(sidecar["frames"] == 41 && sidecar["results"][0]["frame"] == 60);
+
+    fs::remove_all(config.directory);
+    std::cout << "✓ Clock step test passed" << std::endl;
+}
+
+void testPublish() {
+    std::cout << "Testing frames encoded on the recording thread..." << std::endl;
+
+    ClipConfig config;
+    config.directory = testDirectory("clips", "publish").string();
+    config.pre_seconds = 1.0;
+    config.post_seconds = 0.5;
+    std::atomic<bool> running{true};
+    ClipRecorder recorder(config, running);
+    std::thread thread(std::ref(recorder));
+
+    cv::Mat bgr(480, 640, CV_8UC3, cv::Scalar(40, 120, 200));
+    double publish_us = 0;
+    for (uint32_t frame = 1; frame <= 60; frame++) {
+        InferenceResult result = makeResult(frame, START_MS + frame * 50, frame >= 30 && frame < 35 ? 1 : 0);
+        DecoratedFrame decorated(bgr, &result);
+        auto start = std::chrono::steady_clock::now();
+        recorder.publish(decorated);
+        publish_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    running = false;
+    thread.join();
+    std::cout << "  " << publish_us / 60 << " us per publish of a 640x480 frame" << std::endl;
+    assert(recorder.stats().clips == 1);
+
+    auto videos = filesEndingWith(config.directory, ".avi");
+    assert(videos.size() == 1);
+    std::ifstream video_file(videos[0], std::ios::binary);
+    std::string avi((std::istreambuf_iterator<char>(video_file)), std::istreambuf_iterator<char>());
+    assert(readU32(avi, 64) == 640 && readU32(avi, 68) == 480);
+    assert(static_cast<uchar>(avi[232]) == 0xFF && static_cast<uchar>(avi[233]) == 0xD8);
+
+    fs::remove_all(config.directory);
+    std::cout << "✓ Publish test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running clip recorder tests..." << std::endl;
+
+    testTriggers();
+    testAviClip();
+    testFramesAndBudget();
+    testClockStep();
+    testPublish();
+
+    std::cout << "\n✅ All clip recorder tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "crop_sink.h"
+#include "inference.h"
+#include "shm_ring.h"
+#include "test_fixtures.h"
+
+namespace fs = std::filesystem;
+
+static std::vector<std::string> cropFiles(const fs::path& dir) {
+    std::vector<std::string> names;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        names.push_back(entry.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void testRateLimiter() {
+    std::cout << "Testing per-class rate limits..." << std::endl;
+
+    CropRateLimiter limiter(2.0, 3.0);
+    // A quiet class starts with its burst
+    assert(limiter.take(0, START_MS));
+    assert(limiter.take(0, START_MS));
+    assert(limiter.take(0, START_MS));
+    assert(!limiter.take(0, START_MS));
+    // Other classes have their own buckets
+    assert(limiter.take(2, START_MS));
+
+    // Two crops a second: one more after 500 ms, none before
+    assert(!limiter.take(0, START_MS + 400));
+    assert(limiter.take(0, START_MS + 600));
+    assert(!limiter.take(0, START_MS + 600));
+
+    // Saved up to the burst at most
+    assert(limiter.take(0, START_MS + 60000));
+    assert(limiter.take(0, START_MS + 60000));
+    assert(limiter.take(0, START_MS + 60000));
+    assert(!limiter.take(0, START_MS + 60000));
+
+    // A clock stepping back earns nothing
+    assert(!limiter.take(0, START_MS));
+
+    std::cout << "✓ Per-class rate limits test passed" << std::endl;
+}
+
+void testCropRect() {
+    std::cout << "Testing padded crop rectangles..." << std::endl;
+
+    // 15% of 100 x 200 on each side
+    cv::Rect rect = CropSink::cropRect({100, 100, 200, 300}, 0.15f, 640, 480);
+    assert(rect.x == 85 && rect.y == 70 && rect.width == 130 && rect.height == 260);
+
+    // Clipped to the frame
+    rect = CropSink::cropRect({0, 400, 50, 479}, 0.5f, 640, 480);
+    assert(rect.x == 0 && rect.y == 360 && rect.width == 75 && rect.height == 120);
+
+    // No padding
+    rect = CropSink::cropRect({10, 20, 30, 60}, 0.0f, 640, 480);
+    assert(rect.x == 10 && rect.y == 20 && rect.width == 20 && rect.height == 40);
+
+    // Outside the frame
+    assert(CropSink::cropRect({700, 10, 800, 50}, 0.1f, 640, 480).area() == 0);
+
+    std::cout << "✓ Padded crop rectangles test passed" << std::endl;
+}
+
+void testDirectory() {
+    std::cout << "Testing crops written to a directory..." << std::endl;
+
+    fs::path dir = testDirectory("crops", "directory");
+    CropConfig config;
+    config.directory = dir.string();
+    config.padding = 0.0f;
+    config.max_edge = 64;
+    config.rate_per_class = 1.0;
+    config.burst = 2.0;
+    config.max_files = 2;
+
+    // A frame with a red person and a blue car
+    cv::Mat rgb(480, 640, CV_8UC3, cv::Scalar(0, 0, 0));
+    rgb(cv::Rect(100, 100, 100, 200)).setTo(cv::Scalar(255, 0, 0));
+    rgb(cv::Rect(300, 200, 40, 20)).setTo(cv::Scalar(0, 0, 255));
+
+    {
+        CropSink sink(config);
+        InferenceResult result = makeResult(1, START_MS);
+        addDetection(result, {100, 100, 200, 300}, 0, "person");
+        addDetection(result, {300, 200, 340, 220}, 2, "car");
+        addDetection(result, {10, 10, 20, 20}, 0, "person", 0.3f);  // Below the threshold
+        addDetection(result, {10, 10, 20, 20}, 1, "bicycle");       // Not selected
+        sink.publishRaw(rgb, result);
+        sink.drain();
+
+        std::vector<std::string> names = cropFiles(dir);
+        assert(names.size() == 2);
+        assert(names[0] == "crop-20261017-120000-000-1-0-person.jpg");
+        assert(names[1] == "crop-20261017-120000-000-1-1-car.jpg");
+
+        // Downsized to fit 64 pixels, still BGR on disk
+        cv::Mat person = cv::imread((dir / names[0]).string());
+        assert(person.cols == 32 && person.rows == 64);
+        cv::Vec3b center = person.at<cv::Vec3b>(32, 16);
+        assert(center[2] > 200 && center[0] < 50);
+        // Small enough to keep its size
+        cv::Mat car = cv::imread((dir / names[1]).string());
+        assert(car.cols == 40 && car.rows == 20);
+        center = car.at<cv::Vec3b>(10, 20);
+        assert(center[0] > 200 && center[2] < 50);
+
+        // A crowded frame is held to the burst, one person more
+        InferenceResult crowded = makeResult(2, START_MS + 10);
+        for (int i = 0; i < 20; i++) {
+            addDetection(crowded, {10 * i, 10, 10 * i + 8, 30}, 0, "person");
+        }
+        sink.publishRaw(rgb, crowded);
+        sink.drain();
+        CropSink::Stats stats = sink.stats();
+        assert(stats.written == 3);
+        assert(stats.limited == 19);
+        assert(stats.failed == 0);
+
+        // Only the newest max_files are kept
+        names = cropFiles(dir);
+        assert(names.size() == 2);
+        assert(names[0] == "crop-20261017-120000-000-1-1-car.jpg");
+        assert(names[1] == "crop-20261017-120000-010-2-0-person.jpg");
+    }
+
+    // Crops left by an earlier run count towards the limit
+    {
+        CropSink sink(config);
+        InferenceResult result = makeResult(3, START_MS + 5000);
+        addDetection(result, {300, 200, 340, 220}, 2, "car");
+        sink.publishRaw(rgb, result);
+        sink.drain();
+        std::vector<std::string> names = cropFiles(dir);
+        assert(names.size() == 2);
+        assert(names[0] == "crop-20261017-120000-010-2-0-person.jpg");
+        assert(names[1] == "crop-20261017-120005-000-3-0-car.jpg");
+    }
+
+    fs::remove_all(dir);
+    std::cout << "✓ Crops written to a directory test passed" << std::endl;
+}
+
+void testSharedMemory() {
+    std::cout << "Testing crops published to shared memory..." << std::endl;
+
+    std::string name = "/crops-test-" + std::to_string(getpid());
+    CropConfig config;
+    config.shm_name = name;
+    config.padding = 0.1f;
+    config.max_edge = 96;
+
+    cv::Mat rgb(480, 640, CV_8UC3, cv::Scalar(0, 255, 0));
+    CropSink sink(config);
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+    InferenceResult result = makeResult(7, START_MS);
+    addDetection(result, {200, 100, 300, 150}, 2, "car", 0.8f);
+    sink.publishRaw(rgb, result);
+    sink.drain();
+
+    std::vector<char> buffer(256 * 1024);
+    int length = shm_ring_read_next(&reader, buffer.data(), buffer.size(), nullptr);
+    assert(length > static_cast<int>(sizeof(CropHeader)));
+    CropHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    assert(header.magic == CROP_HEADER_MAGIC);
+    assert(header.jpeg_size == length - sizeof(CropHeader));
+    assert(header.frame_id == 7 && header.timestamp_ms == START_MS);
+    assert(header.cls_id == 2 && strcmp(header.class_name, "car") == 0);
+    assert(header.left == 200 && header.top == 100 && header.right == 300 && header.bottom == 150);
+    assert(std::abs(header.confidence - 0.8f) < 1e-6f);
+
+    // 120 x 60 with padding, downsized to 96 x 48
+    std::vector<uchar> jpeg(buffer.begin() + sizeof(CropHeader), buffer.begin() + length);
+    cv::Mat crop = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+    assert(crop.cols == 96 && crop.rows == 48);
+
+    shm_ring_close(&reader);
+    std::cout << "✓ Crops published to shared memory test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running crop sink tests..." << std::endl;
+
+    testRateLimiter();
+    testCropRect();
+    testDirectory();
+    testSharedMemory();
+
+    std::cout << "\n✅ All crop sink tests passed!" << std::endl;
+    return 0;
+}
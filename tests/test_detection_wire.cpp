@@ -0,0 +1,240 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Include headers
+#include "detection_wire.h"
+#include "publisher.h"
+#include "inference.h"
+
+static void assertSameBoxes(const wire_frame_t& expected, const wire_frame_t& actual) {
+    assert(actual.model_id == expected.model_id);
+    assert(actual.sequence == expected.sequence);
+    assert(actual.timestamp_us == expected.timestamp_us);
+    assert(actual.box_count == expected.box_count);
+    for (int i = 0; i < expected.box_count; i++) {
+        const wire_box_t& a = expected.boxes[i];
+        const wire_box_t& b = actual.boxes[i];
+        assert(a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom);
+        assert(a.class_id == b.class_id);
+        assert(std::fabs(a.confidence - b.confidence) <= 0.5f / 65535.0f + 1e-7f);
+    }
+}
+
+static void randomBoxes(std::mt19937& rng, wire_frame_t& frame, int count) {
+    std::uniform_int_distribution<int> coord_dist(0, 1920);
+    std::uniform_real_distribution<float> prop_dist(0.0f, 1.0f);
+    frame.box_count = count;
+    for (int i = 0; i < count; i++) {
+        frame.boxes[i] = {coord_dist(rng), coord_dist(rng), coord_dist(rng), coord_dist(rng), prop_dist(rng),
+                          static_cast<int>(rng() % 80)};
+    }
+}
+
+void testKeyFrameRoundTrip() {
+    std::cout << "Testing key frame round trip..." << std::endl;
+
+    std::mt19937 rng(1);
+    wire_frame_t frame = {};
+    frame.model_id = 3;
+    frame.sequence = 0x123456789aULL;
+    frame.timestamp_us = 1746732409123456ULL;
+    randomBoxes(rng, frame, 20);
+    frame.boxes[0].confidence = 1.0f;
+    frame.boxes[1].confidence = 0.0f;
+
+    wire_encoder_t encoder;
+    wire_encoder_init(&encoder, 0);
+    uint8_t message[WIRE_MAX_MESSAGE_SIZE];
+    int size = wire_encode(&encoder, &frame, message, sizeof(message));
+    assert(size == WIRE_HEADER_SIZE + 20 * WIRE_KEY_BOX_SIZE);
+
+    wire_decoder_t decoder;
+    wire_decoder_init(&decoder);
+    wire_frame_t decoded;
+    assert(wire_decode(&decoder, message, size, &decoded) == 0);
+    assert(!decoded.is_delta);
+    assertSameBoxes(frame, decoded);
+
+    // Coordinates beyond 16 bits are clamped
+    frame.box_count = 1;
+    frame.boxes[0].left = -40000;
+    frame.boxes[0].right = 40000;
+    size = wire_encode(&encoder, &frame, message, sizeof(message));
+    assert(wire_decode(&decoder, message, size, &decoded) == 0);
+    assert(decoded.boxes[0].left == -32768 && decoded.boxes[0].right == 32767);
+
+    std::cout << "✓ Key frame round trip test passed" << std::endl;
+}
+
+void testDeltaStream() {
+    std::cout << "Testing delta frames..." << std::endl;
+
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> jitter(-3, 3);
+    std::uniform_int_distribution<int> count_change(-2, 2);
+
+    wire_encoder_t encoder;
+    wire_encoder_init(&encoder, 10);
+    wire_decoder_t decoder;
+    wire_decoder_init(&decoder);
+
+    wire_frame_t frame = {};
+    randomBoxes(rng, frame, 12);
+    uint8_t message[WIRE_MAX_MESSAGE_SIZE];
+    wire_frame_t decoded;
+    size_t key_bytes = 0, delta_bytes = 0;
+    int key_frames = 0, delta_frames = 0;
+    for (int n = 0; n < 300; n++) {
+        // Boxes drift a few pixels; objects come and go; frames are skipped
+        frame.sequence += 1 + rng() % 3;
+        frame.timestamp_us += 33333;
+        int count = std::max(0, std::min(WIRE_MAX_BOXES, frame.box_count + count_change(rng)));
+        for (int i = frame.box_count; i < count; i++) {
+            frame.boxes[i] = {100, 100, 200, 300, 0.5f, 0};
+        }
+        frame.box_count = count;
+        for (int i = 0; i < frame.box_count; i++) {
+            frame.boxes[i].left += jitter(rng);
+            frame.boxes[i].top += jitter(rng);
+            frame.boxes[i].right += jitter(rng);
+            frame.boxes[i].bottom += jitter(rng);
+        }
+
+        int size = wire_encode(&encoder, &frame, message, sizeof(message));
+        assert(size > 0);
+        assert(wire_decode(&decoder, message, size, &decoded) == 0);
+        assertSameBoxes(frame, decoded);
+        (decoded.is_delta ? delta_bytes : key_bytes) += size - WIRE_HEADER_SIZE;
+        (decoded.is_delta ? delta_frames : key_frames) += decoded.box_count;
+    }
+
+    // One key frame every 10 messages; small moves take about 8 bytes a box
+    assert(key_frames > 0 && delta_frames > 0);
+    assert(delta_bytes * key_frames < key_bytes * delta_frames);
+
+    // A model swap forces a key frame
+    frame.model_id++;
+    frame.sequence++;
+    int size = wire_encode(&encoder, &frame, message, sizeof(message));
+    assert(wire_decode(&decoder, message, size, &decoded) == 0);
+    assert(!decoded.is_delta);
+
+    std::cout << "✓ Delta frame test passed" << std::endl;
+}
+
+void testLostMessage() {
+    std::cout << "Testing recovery from a lost message..." << std::endl;
+
+    std::mt19937 rng(3);
+    wire_encoder_t encoder;
+    wire_encoder_init(&encoder, 4);
+    wire_decoder_t decoder;
+    wire_decoder_init(&decoder);
+
+    wire_frame_t frame = {};
+    randomBoxes(rng, frame, 5);
+    uint8_t message[WIRE_MAX_MESSAGE_SIZE];
+    wire_frame_t decoded;
+    std::vector<int> results;
+    for (int n = 0; n < 8; n++) {
+        frame.sequence++;
+        frame.boxes[0].left++;
+        int size = wire_encode(&encoder, &frame, message, sizeof(message));
+        if (n == 1) {
+            continue;  // Dropped on the way
+        }
+        results.push_back(wire_decode(&decoder, message, size, &decoded));
+        if (results.back() == 0) {
+            assertSameBoxes(frame, decoded);
+        }
+    }
+
+    // Key frames at messages 0 and 4; 2 and 3 refer to the lost message
+    assert((results == std::vector<int>{0, WIRE_ERR_NO_BASE, WIRE_ERR_NO_BASE, 0, 0, 0, 0}));
+
+    std::cout << "✓ Lost message test passed" << std::endl;
+}
+
+void testMalformedMessages() {
+    std::cout << "Testing malformed messages..." << std::endl;
+
+    std::mt19937 rng(4);
+    wire_encoder_t encoder;
+    wire_encoder_init(&encoder, 0);
+    wire_frame_t frame = {};
+    randomBoxes(rng, frame, 3);
+    uint8_t message[WIRE_MAX_MESSAGE_SIZE];
+    int size = wire_encode(&encoder, &frame, message, sizeof(message));
+
+    wire_decoder_t decoder;
+    wire_decoder_init(&decoder);
+    wire_frame_t decoded;
+    assert(wire_decode(&decoder, message, WIRE_HEADER_SIZE - 1, &decoded) == WIRE_ERR_TRUNCATED);
+    assert(wire_decode(&decoder, message, size - 1, &decoded) == WIRE_ERR_TRUNCATED);
+
+    message[2] = WIRE_VERSION + 1;
+    assert(wire_decode(&decoder, message, size, &decoded) == WIRE_ERR_VERSION);
+    message[0] = '{';
+    assert(wire_decode(&decoder, message, size, &decoded) == WIRE_ERR_MAGIC);
+
+    // Nothing decoded yet, so a delta frame has no base
+    wire_encoder_init(&encoder, 5);
+    wire_encode(&encoder, &frame, message, sizeof(message));
+    frame.sequence++;
+    size = wire_encode(&encoder, &frame, message, sizeof(message));
+    assert(message[3] & WIRE_FLAG_DELTA);
+    assert(wire_decode(&decoder, message, size, &decoded) == WIRE_ERR_NO_BASE);
+
+    std::cout << "✓ Malformed message test passed" << std::endl;
+}
+
+void testBinaryFormatter() {
+    std::cout << "Testing BinaryMessageFormatter..." << std::endl;
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.class_mapping = {{"person", 0}, {"car", 2}};
+    result.selected_classes = {0};
+    result.confidence_threshold = 0.5f;
+    result.timestamp = std::chrono::system_clock::time_point(std::chrono::microseconds(1746732409654321LL));
+    result.frame_id = 42;
+    result.model_id = 1;
+    result.detections.count = 3;
+    result.detections.results[0] = {{10, 20, 110, 220}, 0.9f, 0, "person"};
+    result.detections.results[1] = {{30, 40, 130, 240}, 0.8f, 2, "car"};     // Not selected
+    result.detections.results[2] = {{50, 60, 150, 260}, 0.4f, 0, "person"};  // Listed below threshold, as in FullJson
+
+    BinaryMessageFormatter formatter;
+    std::string message = formatter.formatMessage(result);
+
+    wire_decoder_t decoder;
+    wire_decoder_init(&decoder);
+    wire_frame_t decoded;
+    assert(wire_decode(&decoder, reinterpret_cast<const uint8_t*>(message.data()), message.size(), &decoded) == 0);
+    assert(decoded.sequence == 42 && decoded.model_id == 1);
+    assert(decoded.timestamp_us == 1746732409654321ULL);
+    assert(decoded.box_count == 2);
+    assert(decoded.boxes[0].left == 10 && decoded.boxes[0].bottom == 220 && decoded.boxes[0].class_id == 0);
+    assert(decoded.boxes[1].left == 50 && std::fabs(decoded.boxes[1].confidence - 0.4f) < 1e-4f);
+
+    std::cout << "✓ BinaryMessageFormatter test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running detection wire format tests..." << std::endl;
+
+    testKeyFrameRoundTrip();
+    testDeltaStream();
+    testLostMessage();
+    testMalformedMessages();
+    testBinaryFormatter();
+
+    std::cout << "\n✅ All detection wire format tests passed!" << std::endl;
+    return 0;
+}
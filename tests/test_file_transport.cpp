@@ -0,0 +1,151 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+// Include headers
+#include "transport.h"
+
+namespace fs = std::filesystem;
+
+static std::string readFile(const fs::path& path) {
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static bool isVolatile(const fs::path& dir) {
+    struct statfs info;
+    return statfs(dir.c_str(), &info) == 0 && (info.f_type == TMPFS_MAGIC || info.f_type == RAMFS_MAGIC);
+}
+
+// A fresh directory under `base`
+static fs::path testDir(const fs::path& base, const char* test) {
+    fs::path dir = base / ("file-transport-" + std::to_string(getpid()) + "-" + test);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+static size_t fileCount(const fs::path& dir) {
+    size_t count = 0;
+    for (auto it = fs::directory_iterator(dir); it != fs::directory_iterator(); ++it) {
+        count++;
+    }
+    return count;
+}
+
+void testDurabilityParsing() {
+    std::cout << "Testing durability parsing..." << std::endl;
+
+    FileDurability durability;
+    assert(parseFileDurability("none", durability) && durability == FileDurability::None);
+    assert(parseFileDurability("rename", durability) && durability == FileDurability::OnRename);
+    assert(parseFileDurability("periodic", durability) && durability == FileDurability::Periodic);
+    assert(parseFileDurability("auto", durability) && durability == FileDurability::Auto);
+    assert(!parseFileDurability("always", durability));
+    assert(std::string(fileDurabilityName(FileDurability::Periodic)) == "periodic");
+
+    std::cout << "✓ Durability parsing test passed" << std::endl;
+}
+
+// Write, replace and check nothing else is left in the directory
+static void checkReplace(const fs::path& base, const char* test, FileDurability durability) {
+    fs::path dir = testDir(base, test);
+    fs::path path = dir / "results.json";
+    {
+        FileTransport transport(path.string(), durability, 0.05);
+        assert(transport.isConnected());
+        if (durability == FileDurability::Auto) {
+            FileDurability expected = isVolatile(dir) ? FileDurability::None : FileDurability::OnRename;
+            assert(transport.durability() == expected);
+            assert(transport.usesTmpfile() == !isVolatile(dir));
+        }
+
+        assert(transport.send("{\"person\":1}"));
+        assert(readFile(path) == "{\"person\":1}");
+        assert(transport.send("{\"person\":12,\"car\":3}"));
+        assert(readFile(path) == "{\"person\":12,\"car\":3}");
+        assert(transport.send("{}"));
+        assert(readFile(path) == "{}");  // Shorter messages leave no old bytes
+        assert(fileCount(dir) == 1);
+
+        // A temp file left by a crash is replaced
+        std::ofstream(dir / "results.json.tmp") << "stale";
+        assert(transport.send("{\"person\":2}"));
+        assert(readFile(path) == "{\"person\":2}");
+        assert(fileCount(dir) == 1);
+    }
+    fs::remove_all(dir);
+}
+
+void testReplace() {
+    std::cout << "Testing atomic replacement..." << std::endl;
+
+    checkReplace(fs::current_path(), "auto", FileDurability::Auto);
+    checkReplace(fs::current_path(), "none", FileDurability::None);
+    checkReplace(fs::current_path(), "periodic", FileDurability::Periodic);
+    if (fs::exists("/dev/shm")) {
+        checkReplace("/dev/shm", "auto", FileDurability::Auto);
+    }
+
+    // Missing directories are created; an unusable path disables the transport
+    fs::path dir = testDir(fs::current_path(), "nested");
+    FileTransport nested((dir / "a" / "b" / "results.json").string());
+    assert(nested.isConnected() && nested.send("{}"));
+    fs::remove_all(dir);
+    FileTransport invalid("/proc/objdet-test/results.json");
+    assert(!invalid.isConnected() && !invalid.send("{}"));
+
+    std::cout << "✓ Atomic replacement test passed" << std::endl;
+}
+
+void testNoTornReads() {
+    std::cout << "Testing concurrent readers..." << std::endl;
+
+    fs::path dir = testDir(fs::current_path(), "torn");
+    fs::path path = dir / "results.json";
+    FileTransport transport(path.string(), FileDurability::None);
+    assert(transport.send(std::string(100, 'a')));
+
+    // Every message is one character repeated, with varying length
+    std::atomic<bool> stop{false};
+    std::atomic<long> reads{0};
+    std::thread reader([&] {
+        while (!stop) {
+            std::string contents = readFile(path);
+            assert(!contents.empty());
+            assert(contents.find_first_not_of(contents[0]) == std::string::npos);
+            reads++;
+        }
+    });
+    for (int i = 0; i < 2000; i++) {
+        assert(transport.send(std::string(100 + i * 37 % 5000, static_cast<char>('a' + i % 26))));
+    }
+    stop = true;
+    reader.join();
+    std::cout << "  " << reads << " consistent reads" << std::endl;
+    assert(reads > 0);
+    fs::remove_all(dir);
+
+    std::cout << "✓ Concurrent reader test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running file transport tests..." << std::endl;
+
+    testDurabilityParsing();
+    testReplace();
+    testNoTornReads();
+
+    std::cout << "\n✅ All file transport tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+#include "inference.h"
+
+// Fixtures shared by the tests that feed results through sinks and formatters
+
+// 2026-10-17 12:00:00 UTC
+static const uint64_t START_MS = 1792238400000ull;
+
+// An empty directory for one test, under the working directory and unique to the process
+inline std::filesystem::path testDirectory(const std::string& prefix, const std::string& test) {
+    std::filesystem::path dir = std::filesystem::current_path() / (prefix + "-" + std::to_string(getpid()) + "-" + test);
+    std::filesystem::remove_all(dir);
+    return dir;
+}
+
+inline void addDetection(InferenceResult& result, box_rect_t box, int cls_id, const char* name, float prop = 0.9f) {
+    object_detect_result_t& detection = result.detections.results[result.detections.count++];
+    detection.box = box;
+    detection.prop = prop;
+    detection.cls_id = cls_id;
+    snprintf(detection.name, sizeof(detection.name), "%s", name);
+}
+
+// A result selecting people and cars, with that many of each detected
+inline InferenceResult makeResult(uint64_t frame, uint64_t timestamp_ms, int people = 0, int cars = 0) {
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(timestamp_ms));
+    result.confidence_threshold = 0.5f;
+    result.class_mapping = {{"person", 0}, {"car", 2}};
+    result.selected_classes = {0, 2};
+    result.frame_id = frame;
+    for (int i = 0; i < people; i++) {
+        addDetection(result, {10 * i, 20, 10 * i + 5, 40}, 0, "person", 0.9f);
+    }
+    for (int i = 0; i < cars; i++) {
+        addDetection(result, {0, 0, 10, 10}, 2, "car", 0.8f);
+    }
+    return result;
+}
@@ -0,0 +1,246 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Include headers
+#include "heatmap.h"
+#include "publisher.h"
+
+static bool near(float a, float b) {
+    return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::fabs(b));
+}
+
+static uint32_t bigEndian(const std::string& data, size_t offset) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data()) + offset;
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+void testBoxesAgainstBruteForce() {
+    std::cout << "Testing box footprints against a cell-by-cell count..." << std::endl;
+
+    HeatmapConfig config;
+    config.cols = 40;
+    config.rows = 24;
+    config.frame_width = 1280;
+    config.frame_height = 720;
+    Heatmap heatmap(config);
+
+    std::vector<float> expected(config.cols * config.rows, 0.0f);
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> x(0, 1279), y(0, 719), size(0, 400);
+    for (int frame = 0; frame < 200; frame++) {
+        std::vector<box_rect_t> boxes(rng() % 20);
+        for (auto& box : boxes) {
+            box.left = x(rng);
+            box.top = y(rng);
+            box.right = std::min(box.left + size(rng), 1280);
+            box.bottom = std::min(box.top + size(rng), 720);
+
+            // The columns and rows the box overlaps, or the one it starts in
+            // when it has no width or height
+            std::vector<int> columns, rows;
+            for (int c = 0; c < config.cols; c++) {
+                if (box.left < (c + 1) * 32 && box.right > c * 32) {
+                    columns.push_back(c);
+                }
+            }
+            for (int r = 0; r < config.rows; r++) {
+                if (box.top < (r + 1) * 30 && box.bottom > r * 30) {
+                    rows.push_back(r);
+                }
+            }
+            if (columns.empty()) {
+                columns.push_back(box.left / 32);
+            }
+            if (rows.empty()) {
+                rows.push_back(box.top / 30);
+            }
+            for (int r : rows) {
+                for (int c : columns) {
+                    expected[r * config.cols + c] += 1.0f;
+                }
+            }
+        }
+        heatmap.add(1000 + frame * 33, boxes.data(), boxes.size());
+    }
+
+    std::vector<float> values;
+    heatmap.values(values);
+    for (size_t i = 0; i < values.size(); i++) {
+        assert(values[i] == expected[i]);
+    }
+    assert(heatmap.timestamp() == 1000 + 199 * 33);
+
+    std::cout << "✓ Brute force comparison passed" << std::endl;
+}
+
+void testCentersAndDecay() {
+    std::cout << "Testing center footprints and decay..." << std::endl;
+
+    HeatmapConfig config;
+    config.cols = 4;
+    config.rows = 2;
+    config.frame_width = 400;
+    config.frame_height = 200;
+    config.footprint = HeatmapFootprint::Center;
+    config.half_life_seconds = 10.0;
+    Heatmap heatmap(config);
+
+    box_rect_t box = {250, 0, 290, 150};  // Center (270, 75): column 2, row 0
+    heatmap.add(0, &box, 1);
+    heatmap.add(10000, nullptr, 0);
+    std::vector<float> values;
+    heatmap.values(values);
+    assert(near(values[2], 0.5f));
+    heatmap.add(20000, &box, 1);
+    heatmap.values(values);
+    assert(near(values[2], 1.25f));
+    for (size_t i = 0; i < values.size(); i++) {
+        assert(i == 2 || values[i] == 0.0f);
+    }
+
+    // A steady footprint for long enough to rescale many times tends to the
+    // sum of the geometric series: 1 / (1 - 2^(-frame time / half-life))
+    config.half_life_seconds = 1.0;
+    Heatmap steady(config);
+    uint64_t t = 0;
+    for (int frame = 0; frame < 30 * 600; frame++, t += 33) {
+        steady.add(t, &box, 1);
+    }
+    steady.values(values);
+    assert(near(values[2], static_cast<float>(1.0 / (1.0 - std::pow(2.0, -0.033)))));
+
+    std::cout << "✓ Center and decay test passed" << std::endl;
+}
+
+void testExport() {
+    std::cout << "Testing PNG and raw export..." << std::endl;
+
+    HeatmapConfig config;
+    config.cols = 8;
+    config.rows = 4;
+    config.frame_width = 800;
+    config.frame_height = 400;
+    Heatmap heatmap(config);
+    box_rect_t boxes[2] = {{0, 0, 200, 100}, {100, 0, 300, 100}};  // Columns 0-1 and 1-2, row 0
+    heatmap.add(1746732409000ull, boxes, 2);
+
+    std::string png;
+    heatmap.encode(HeatmapFormat::PNG, png);
+    assert(png.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0);
+    assert(bigEndian(png, 16) == 8 && bigEndian(png, 20) == 4);
+
+    std::string raw;
+    heatmap.encode(HeatmapFormat::Raw, raw);
+    assert(raw.size() == sizeof(HeatmapRawHeader) + 32 * sizeof(float));
+    HeatmapRawHeader header;
+    memcpy(&header, raw.data(), sizeof(header));
+    assert(header.magic == HEATMAP_RAW_MAGIC && header.cols == 8 && header.rows == 4);
+    assert(header.timestamp_ms == 1746732409000ull);
+    float values[32];
+    memcpy(values, raw.data() + sizeof(header), sizeof(values));
+    assert(values[0] == 1.0f && values[1] == 2.0f && values[2] == 1.0f && values[3] == 0.0f && values[8] == 0.0f);
+
+    HeatmapFormat format;
+    HeatmapFootprint footprint;
+    assert(parseHeatmapFormat("raw", format) && format == HeatmapFormat::Raw && !parseHeatmapFormat("jpg", format));
+    assert(parseHeatmapFootprint("center", footprint) && footprint == HeatmapFootprint::Center);
+    assert(!parseHeatmapFootprint("feet", footprint));
+
+    std::cout << "✓ Export test passed" << std::endl;
+}
+
+void testFormatter() {
+    std::cout << "Testing the heatmap formatter..." << std::endl;
+
+    HeatmapConfig config;
+    config.cols = 4;
+    config.rows = 1;
+    config.frame_width = 400;
+    config.frame_height = 100;
+    HeatmapFormatter formatter(config, HeatmapFormat::Raw);
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.timestamp = std::chrono::system_clock::from_time_t(1746732409);
+    result.confidence_threshold = 0.5f;
+    result.class_mapping = {{"person", 0}, {"car", 2}};
+    result.selected_classes = {0};
+    result.frame_id = 1;
+    result.detections.count = 3;
+    result.detections.results[0] = {{10, 10, 50, 90}, 0.9f, 0, "person"};    // Column 0
+    result.detections.results[1] = {{110, 10, 150, 90}, 0.3f, 0, "person"};  // Below the threshold
+    result.detections.results[2] = {{210, 10, 250, 90}, 0.9f, 2, "car"};     // Not selected
+    formatter.observe(result);
+    formatter.observe(result);  // Offered twice, counted once
+
+    std::string message;
+    formatter.formatInto(result, message);
+    float values[4];
+    memcpy(values, message.data() + sizeof(HeatmapRawHeader), sizeof(values));
+    assert(values[0] == 1.0f && values[1] == 0.0f && values[2] == 0.0f && values[3] == 0.0f);
+
+    // Boxes are placed by the frame size the result carries, not the configured one
+    result.frame_id = 2;
+    result.frame_width = 200;
+    result.frame_height = 50;
+    result.detections.count = 1;
+    result.detections.results[0] = {{160, 10, 190, 40}, 0.9f, 0, "person"};  // Column 3 of a 200-wide frame
+    formatter.observe(result);
+    formatter.formatInto(result, message);
+    memcpy(values, message.data() + sizeof(HeatmapRawHeader), sizeof(values));
+    assert(values[0] == 1.0f && values[1] == 0.0f && values[2] == 0.0f && values[3] == 1.0f);
+
+    std::cout << "✓ Formatter test passed" << std::endl;
+}
+
+void testCost() {
+    std::cout << "Testing the cost of 128 boxes per frame..." << std::endl;
+
+    HeatmapConfig config;  // 96x54 over 1080p
+    config.half_life_seconds = 600;
+    Heatmap heatmap(config);
+    std::mt19937 rng(5);
+    std::vector<box_rect_t> boxes(128);
+    for (auto& box : boxes) {
+        box.left = rng() % 1800;
+        box.top = rng() % 900;
+        box.right = box.left + 40 + rng() % 300;
+        box.bottom = box.top + 80 + rng() % 400;
+    }
+
+    const int frames = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        heatmap.add(frame * 33ull, boxes.data(), boxes.size());
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+    std::cout << "  " << us << " us per frame, 96x54 grid" << std::endl;
+    assert(us < 1000.0);
+
+    std::string png;
+    start = std::chrono::steady_clock::now();
+    heatmap.encode(HeatmapFormat::PNG, png);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << ms << " ms per PNG export, " << png.size() << " bytes" << std::endl;
+
+    std::cout << "✓ Cost test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running heatmap tests..." << std::endl;
+
+    testBoxesAgainstBruteForce();
+    testCentersAndDecay();
+    testExport();
+    testFormatter();
+    testCost();
+
+    std::cout << "\n✅ All heatmap tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Include headers
+#include "history_log.h"
+#include "history_query.h"
+#include "publisher.h"
+#include "transport.h"
+#include "test_fixtures.h"
+
+namespace fs = std::filesystem;
+
+static HistoryLayout layout(int box_capacity = 0) {
+    HistoryLayout layout;
+    layout.class_ids = {0, 2};
+    layout.class_names = {"person", "car"};
+    layout.box_capacity = box_capacity;
+    return layout;
+}
+
+// Frame ids from the timestamp, cars in odd places, and two detections
+// that no record counts
+static InferenceResult historyResult(uint64_t timestamp_ms, int people, int cars) {
+    InferenceResult result = makeResult(timestamp_ms / 1000, timestamp_ms, people);
+    result.class_mapping["dog"] = 16;
+    result.selected_classes.push_back(16);
+    for (int i = 0; i < cars; i++) {
+        addDetection(result, {-5, 0, 70000, 30}, 2, "car", 0.75f);
+    }
+    // Not in the layout, and below the threshold
+    addDetection(result, {0, 0, 10, 10}, 16, "dog", 0.9f);
+    addDetection(result, {0, 0, 10, 10}, 0, "person", 0.2f);
+    return result;
+}
+
+void testRecordFormat() {
+    std::cout << "Testing history record format..." << std::endl;
+
+    assert(history_record_size(2, 0) == 24);
+    assert(history_record_size(2, 2) == 48);
+    assert(history_header_size(2) == sizeof(history_header_t) + 64);
+
+    HistoryRecordFormatter formatter(layout(2));
+    std::string record;
+    formatter.formatInto(historyResult(START_MS + 250, 3, 1), record);
+    assert(record.size() == history_record_size(2, 2));
+
+    const history_record_t* header = reinterpret_cast<const history_record_t*>(record.data());
+    assert(header->timestamp_ms == START_MS + 250);
+    assert(header->frame_id == static_cast<uint32_t>((START_MS + 250) / 1000));
+    assert(header->detections == 5);  // The dog is selected, just not counted
+    assert(header->box_count == 2);
+    const uint16_t* counts = history_record_counts(header);
+    assert(counts[0] == 3 && counts[1] == 1);
+    const history_box_t* boxes = history_record_boxes(header, 2);
+    assert(boxes[0].left == 0 && boxes[0].bottom == 40 && boxes[0].class_index == 0);
+    assert(boxes[0].confidence == static_cast<uint16_t>(0.9f * 65535.0f + 0.5f));
+
+    // Coordinates are clamped to 16 bits
+    HistoryRecordFormatter cars(layout(4));
+    cars.formatInto(historyResult(START_MS, 0, 1), record);
+    boxes = history_record_boxes(reinterpret_cast<const history_record_t*>(record.data()), 2);
+    assert(boxes[0].left == -5 && boxes[0].right == INT16_MAX && boxes[0].class_index == 1);
+
+    std::cout << "✓ Record format test passed" << std::endl;
+}
+
+void testAppendAndQuery() {
+    std::cout << "Testing appending, rotation and queries..." << std::endl;
+
+    fs::path dir = testDirectory("history", "query");
+    HistoryConfig config;
+    config.segment_seconds = 3600;
+    {
+        HistoryTransport transport(dir.string(), layout(), config);
+        HistoryRecordFormatter formatter(layout());
+        std::string record;
+        // Two hours at 1 Hz: people = minute of the hour % 4, a car in the first hour only
+        for (uint64_t second = 0; second < 7200; second++) {
+            formatter.formatInto(historyResult(START_MS + second * 1000, (second / 60) % 4, second < 3600), record);
+            assert(transport.send(record));
+        }
+    }
+    auto segments = listHistorySegments(dir.string());
+    assert(segments.size() == 2);  // One per hour
+    assert(fs::path(segments[0]).filename() == "history-20261017-120000-000.odh");
+
+    HistoryResult result;
+    HistoryQuery query;
+    assert(queryHistory(segments, query, result));
+    assert(result.records == 7200 && result.segments == 2);
+    assert(result.class_names == std::vector<std::string>({"person", "car"}));
+    assert(result.buckets.size() == 2);
+    assert(result.buckets[0].start_ms == START_MS && result.buckets[0].records == 3600);
+    assert(result.buckets[0].classes[0].sum == 3600 * 6 / 4 && result.buckets[0].classes[0].max == 3);
+    assert(result.buckets[0].classes[0].occupied == 2700);
+    assert(result.buckets[0].classes[1].occupied == 3600 && result.buckets[1].classes[1].sum == 0);
+
+    // Per-minute buckets over a time range
+    query.bucket_ms = 60000;
+    query.from_ms = START_MS + 90 * 1000;
+    query.to_ms = START_MS + 3600 * 1000 + 30 * 1000;
+    assert(queryHistory(segments, query, result));
+    assert(result.records == 3600 - 90 + 30);
+    assert(result.buckets.size() == 60);
+    assert(result.buckets.front().start_ms == START_MS + 60000 && result.buckets.front().records == 30);
+    assert(result.buckets.front().classes[0].max == 1);
+    assert(result.buckets.back().start_ms == START_MS + 3600000 && result.buckets.back().records == 30);
+
+    // A partial record left by a crash is ignored
+    {
+        std::ofstream tail(segments[1], std::ios::app | std::ios::binary);
+        tail << "torn";
+    }
+    query = HistoryQuery();
+    assert(queryHistory(segments, query, result) && result.records == 7200);
+
+    fs::remove_all(dir);
+    std::cout << "✓ Append and query test passed" << std::endl;
+}
+
+void testGroupCommit() {
+    std::cout << "Testing group commit..." << std::endl;
+
+    fs::path dir = testDirectory("history", "commit");
+    HistoryConfig config;
+    config.commit_seconds = 3600;
+    config.commit_bytes = 10 * history_record_size(2, 0);
+    HistoryTransport transport(dir.string(), layout(), config);
+    HistoryRecordFormatter formatter(layout());
+    std::string record;
+
+    // The first record is written at once, then in groups of ten
+    auto fileRecords = [&] {
+        return (fs::file_size(transport.segmentPath()) - history_header_size(2)) / history_record_size(2, 0);
+    };
+    for (int i = 0; i < 15; i++) {
+        formatter.formatInto(historyResult(START_MS + i * 1000, 1, 0), record);
+        assert(transport.send(record));
+    }
+    assert(fileRecords() == 11);
+    assert(transport.commit());
+    assert(fileRecords() == 15);
+
+    // Records of the wrong size are refused
+    assert(!transport.send("short"));
+
+    fs::remove_all(dir);
+    std::cout << "✓ Group commit test passed" << std::endl;
+}
+
+void testBudget() {
+    std::cout << "Testing size rotation and the disk budget..." << std::endl;
+
+    fs::path dir = testDirectory("history", "budget");
+    HistoryConfig config;
+    config.budget_bytes = 64 * 1024;
+    config.segment_bytes = 8 * 1024;
+    config.commit_bytes = 0;
+    uint64_t written = 0;
+    {
+        HistoryTransport transport(dir.string(), layout(4), config);
+        HistoryRecordFormatter formatter(layout(4));
+        std::string record;
+        for (uint64_t i = 0; i < 5000; i++) {
+            formatter.formatInto(historyResult(START_MS + i * 10, 2, 1), record);
+            assert(transport.send(record));
+            written++;
+
+            uintmax_t total = 0;
+            if (i % 500 == 0) {
+                for (const auto& segment : listHistorySegments(dir.string())) {
+                    assert(fs::file_size(segment) <= config.segment_bytes);
+                    total += fs::file_size(segment);
+                }
+                assert(total <= config.budget_bytes);
+            }
+        }
+    }
+
+    // Only the newest records are kept, without gaps
+    auto segments = listHistorySegments(dir.string());
+    assert(segments.size() > 1 && segments.size() <= 8);
+    HistoryResult result;
+    HistoryQuery query;
+    query.bucket_ms = 1000ull * 3600 * 24;
+    assert(queryHistory(segments, query, result));
+    assert(result.records < written && result.records >= config.budget_bytes / 2 / history_record_size(2, 4));
+    history_segment_t last;
+    assert(history_segment_map(&last, segments.back().c_str()) == 0);
+    assert(history_segment_record(&last, last.record_count - 1)->timestamp_ms == START_MS + (written - 1) * 10);
+    history_segment_unmap(&last);
+
+    fs::remove_all(dir);
+    std::cout << "✓ Budget test passed" << std::endl;
+}
+
+void testClockStep() {
+    std::cout << "Testing a clock stepped back..." << std::endl;
+
+    fs::path dir = testDirectory("history", "step");
+    {
+        HistoryTransport transport(dir.string(), layout(), HistoryConfig());
+        HistoryRecordFormatter formatter(layout());
+        std::string record;
+        // A minute at 1 Hz, then back 30 s within the same hour, then back to the first segment's name
+        for (uint64_t second = 0; second < 60; second++) {
+            formatter.formatInto(historyResult(START_MS + second * 1000, 1, 0), record);
+            assert(transport.send(record));
+        }
+        for (uint64_t second = 30; second < 90; second++) {
+            formatter.formatInto(historyResult(START_MS + second * 1000, 1, 0), record);
+            assert(transport.send(record));
+        }
+        for (uint64_t second = 0; second < 10; second++) {
+            formatter.formatInto(historyResult(START_MS + second * 1000, 1, 0), record);
+            assert(transport.send(record));
+        }
+    }
+
+    // Every segment is in time order on its own
+    auto segments = listHistorySegments(dir.string());
+    assert(segments.size() == 3);
+    assert(fs::path(segments[0]).filename() == "history-20261017-120000-000.odh");
+    assert(fs::path(segments[1]).filename() == "history-20261017-120000-001.odh");
+    assert(fs::path(segments[2]).filename() == "history-20261017-120030-000.odh");
+    for (const auto& path : segments) {
+        history_segment_t segment;
+        assert(history_segment_map(&segment, path.c_str()) == 0);
+        for (uint64_t i = 1; i < segment.record_count; i++) {
+            assert(history_segment_record(&segment, i - 1)->timestamp_ms <
+                   history_segment_record(&segment, i)->timestamp_ms);
+        }
+        history_segment_unmap(&segment);
+    }
+
+    // Queries find the records of every segment
+    HistoryResult result;
+    HistoryQuery query;
+    query.bucket_ms = 60000;
+    assert(queryHistory(segments, query, result));
+    assert(result.records == 130 && result.buckets.size() == 2);
+    assert(result.buckets[0].records == 100 && result.buckets[1].records == 30);
+    query.from_ms = START_MS + 45 * 1000;
+    assert(queryHistory(segments, query, result));
+    assert(result.records == 15 + 45);
+
+    fs::remove_all(dir);
+    std::cout << "✓ Clock step test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running history log tests..." << std::endl;
+
+    testRecordFormat();
+    testAppendAndQuery();
+    testGroupCommit();
+    testBudget();
+    testClockStep();
+
+    std::cout << "\n✅ All history log tests passed!" << std::endl;
+    return 0;
+}
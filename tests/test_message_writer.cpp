@@ -0,0 +1,140 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Include headers
+#include "publisher.h"
+#include "inference.h"
+#include "message_writer.h"
+#include "reference_formatters.h"
+#include "utils.h"
+
+static std::multiset<std::string> splitFields(const std::string& message) {
+    std::multiset<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = message.find("!!", start);
+        fields.insert(message.substr(start, end - start));
+        if (end == std::string::npos) {
+            return fields;
+        }
+        start = end + 2;
+    }
+}
+
+// Names that exercise escaping alongside ordinary COCO labels
+static const std::vector<std::string> CLASS_NAMES = {
+    "person", "bicycle", "car", "dog", "timestamp", "say \"cheese\"", "back\\slash", "tab\there", "bell\x07", "caf\xc3\xa9"};
+
+static InferenceResult randomResult(std::mt19937& rng) {
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    for (size_t i = 0; i < CLASS_NAMES.size(); i++) {
+        result.class_mapping[CLASS_NAMES[i]] = static_cast<int>(i);
+    }
+
+    std::uniform_int_distribution<int> count_dist(0, 40);
+    std::uniform_int_distribution<int> class_dist(-1, static_cast<int>(CLASS_NAMES.size()) - 1);
+    std::uniform_int_distribution<int> coord_dist(-20, 4000);
+    std::uniform_real_distribution<float> prop_dist(-0.1f, 1.0f);
+    result.detections.count = count_dist(rng);
+    for (int i = 0; i < result.detections.count; i++) {
+        auto& detection = result.detections.results[i];
+        detection.cls_id = class_dist(rng);
+        detection.prop = (i % 7 == 0) ? 0.0f : prop_dist(rng);
+        detection.box = {coord_dist(rng), coord_dist(rng), coord_dist(rng), coord_dist(rng)};
+        const std::string& name = detection.cls_id >= 0 ? CLASS_NAMES[detection.cls_id] : CLASS_NAMES[0];
+        strncpy(detection.name, name.c_str(), sizeof(detection.name) - 1);
+    }
+
+    std::uniform_int_distribution<int> selected_dist(0, 3);
+    int selected = selected_dist(rng);
+    for (int i = 0; i < selected; i++) {
+        result.selected_classes.push_back(class_dist(rng) + 1);
+    }
+    result.confidence_threshold = std::uniform_real_distribution<float>(0.0f, 0.9f)(rng);
+    result.timestamp = std::chrono::system_clock::from_time_t(1746732409 + rng() % 100000);
+    return result;
+}
+
+void testNumberFormatting() {
+    std::cout << "Testing number formatting against json::dump..." << std::endl;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    std::vector<double> values = {0.0, -0.0, 1.0, 0.5, 1e-5, 1e21, 123456789.0, 0.1f, 0.87f, 1.0 / 3.0};
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(dist(rng));
+    }
+
+    std::string out;
+    for (double value : values) {
+        out.clear();
+        MessageWriter(out).number(value);
+        assert(out == ::json(value).dump());
+    }
+
+    for (long long value : {0LL, -1LL, 42LL, 1746732409LL, -9223372036854775807LL - 1}) {
+        out.clear();
+        MessageWriter(out).integer(value);
+        assert(out == ::json(value).dump());
+    }
+
+    std::cout << "✓ Number formatting test passed" << std::endl;
+}
+
+void testFormattersMatchReference() {
+    std::cout << "Testing streaming formatters against the json-based output..." << std::endl;
+
+    std::unordered_map<std::string, std::string> faces_mapping = {{"person", "faces"}};
+    JsonMessageFormatter json_formatter;
+    SelectiveJsonMessageFormatter selective_json;
+    SelectiveJsonMessageFormatter selective_json_mapped(faces_mapping);
+    SelectiveBSMessageFormatter selective_bs;
+    FullJsonMessageFormatter full_json;
+    FullJsonMessageFormatter full_json_suppress(true);
+    FacesJsonMessageFormatter faces_json;
+    FacesBSMessageFormatter faces_bs;
+    BSVariableMessageFormatter bs_variable;
+
+    std::mt19937 rng(2024);
+    std::string buffer;
+    for (int i = 0; i < 2000; i++) {
+        InferenceResult result = randomResult(rng);
+
+        assert(json_formatter.formatMessage(result) == reference::json(result));
+        assert(selective_json.formatMessage(result) == reference::selectiveJson(result, {}));
+        assert(selective_json_mapped.formatMessage(result) == reference::selectiveJson(result, faces_mapping));
+        assert(full_json.formatMessage(result) == reference::fullJson(result, false));
+        assert(full_json_suppress.formatMessage(result) == reference::fullJson(result, true));
+        assert(faces_json.formatMessage(result) == reference::facesJson(result));
+        assert(faces_bs.formatMessage(result) == reference::facesBS(result));
+        assert(bs_variable.formatMessage(result) == reference::bsVariable(result));
+
+        // Classes now follow the selected order rather than hash order
+        std::string bs = selective_bs.formatMessage(result);
+        assert(splitFields(bs) == reference::selectiveBSFields(result, {}));
+        assert(bs.compare(bs.rfind("!!") == std::string::npos ? 0 : bs.rfind("!!") + 2, 10, "timestamp:") == 0);
+
+        // Reusing one buffer gives the same output
+        full_json.formatInto(result, buffer);
+        assert(buffer == reference::fullJson(result, false));
+    }
+
+    std::cout << "✓ Streaming formatter test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running message writer tests..." << std::endl;
+
+    testNumberFormatting();
+    testFormattersMatchReference();
+
+    std::cout << "\n✅ All message writer tests passed!" << std::endl;
+    return 0;
+}
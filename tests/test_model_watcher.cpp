@@ -0,0 +1,92 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include headers
+#include "model_watcher.h"
+
+namespace fs = std::filesystem;
+
+static std::mutex swaps_mutex;
+static std::vector<std::string> swaps;
+
+static void writeFile(const fs::path& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    file << contents;
+}
+
+// Wait for the debounced callback to fire
+static bool waitForSwaps(size_t count) {
+    for (int i = 0; i < 40; i++) {
+        {
+            std::lock_guard<std::mutex> lock(swaps_mutex);
+            if (swaps.size() >= count) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+void testModelWatcherTriggers() {
+    std::cout << "Testing model watcher triggers..." << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "test_model_watcher";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path model = dir / "model.rknn";
+    fs::path other_model = dir / "other.rknn";
+    fs::path control = dir / "model-control";
+    writeFile(model, "v1");
+    writeFile(other_model, "v2");
+
+    std::atomic<bool> running{true};
+    ModelWatcher watcher(model, control, true, running, [](const std::string& path) {
+        std::lock_guard<std::mutex> lock(swaps_mutex);
+        swaps.push_back(path);
+        return true;
+    });
+    std::thread watcher_thread(std::ref(watcher));
+
+    // Rewriting the model file in place
+    writeFile(model, "v1-updated");
+    assert(waitForSwaps(1));
+    assert(swaps[0] == model.string());
+
+    // Writing a new path to the control file
+    writeFile(control, other_model.string() + "\n");
+    assert(waitForSwaps(2));
+    assert(swaps[1] == other_model.string());
+
+    // Explicit reload (SIGHUP) reloads the model now in use
+    watcher.requestReload();
+    assert(waitForSwaps(3));
+    assert(swaps[2] == other_model.string());
+
+    // Unrelated files in the directory are ignored
+    writeFile(dir / "notes.txt", "hello");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+    assert(swaps.size() == 3);
+
+    running = false;
+    watcher_thread.join();
+    fs::remove_all(dir);
+
+    std::cout << "✓ Model watcher trigger test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running model watcher tests..." << std::endl;
+
+    testModelWatcherTriggers();
+
+    std::cout << "\n✅ All model watcher tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+// Include headers
+#include "overlay.h"
+
+static const OverlayColor GREEN = {0, 255, 0};
+static const OverlayColor RED = {255, 0, 0};
+
+struct RGBImage {
+    int width, height;
+    std::vector<uint8_t> pixels;
+
+    RGBImage(int w, int h, uint8_t fill) : width(w), height(h), pixels(static_cast<size_t>(w) * h * 3, fill) {}
+    OverlayImage view() { return {pixels.data(), width, height, static_cast<size_t>(width) * 3, OverlayFormat::RGB24}; }
+    const uint8_t* at(int x, int y) const { return &pixels[(static_cast<size_t>(y) * width + x) * 3]; }
+};
+
+struct NV12Image {
+    int width, height;
+    std::vector<uint8_t> pixels;
+
+    NV12Image(int w, int h) : width(w), height(h), pixels(static_cast<size_t>(w) * h * 3 / 2, 128) {}
+    OverlayImage view() { return {pixels.data(), width, height, static_cast<size_t>(width), OverlayFormat::NV12}; }
+    uint8_t luma(int x, int y) const { return pixels[static_cast<size_t>(y) * width + x]; }
+    const uint8_t* chroma(int cx, int cy) const {
+        return &pixels[static_cast<size_t>(width) * height + static_cast<size_t>(cy) * width + cx * 2];
+    }
+};
+
+static bool isColor(const uint8_t* pixel, OverlayColor color) {
+    return pixel[0] == color.c0 && pixel[1] == color.c1 && pixel[2] == color.c2;
+}
+
+void testGlyphs() {
+    std::cout << "Testing the glyph atlas..." << std::endl;
+
+    OverlayRenderer renderer(20);
+    assert(renderer.glyphHeight() == 20 && renderer.glyphWidth() == 10);
+    assert(renderer.textWidth(4) == 40);
+    assert(renderer.labelWidth("person") == 12 * 10);
+
+    // A space draws nothing, a letter something
+    RGBImage image(40, 20, 0);
+    OverlayImage view = image.view();
+    renderer.drawText(view, " ", 0, 0, GREEN);
+    assert(std::all_of(image.pixels.begin(), image.pixels.end(), [](uint8_t v) { return v == 0; }));
+    renderer.drawText(view, "W", 0, 0, GREEN);
+    int covered = 0;
+    for (int y = 0; y < 20; y++) {
+        for (int x = 0; x < 40; x++) {
+            const uint8_t* pixel = image.at(x, y);
+            assert(pixel[0] == 0 && pixel[2] == 0);
+            // Only inside the first glyph cell
+            if (pixel[1] != 0) {
+                assert(x < 10);
+                covered++;
+            }
+        }
+    }
+    assert(covered > 20);
+
+    // Other sizes, including larger than the font
+    for (int height : {8, 13, 48, 80}) {
+        OverlayRenderer sized(height);
+        RGBImage canvas(sized.textWidth(3), sized.glyphHeight(), 0);
+        OverlayImage canvas_view = canvas.view();
+        sized.drawText(canvas_view, "A8g", 0, 0, RED);
+        assert(std::any_of(canvas.pixels.begin(), canvas.pixels.end(), [](uint8_t v) { return v != 0; }));
+    }
+
+    std::cout << "✓ Glyph atlas test passed" << std::endl;
+}
+
+void testLabels() {
+    std::cout << "Testing cached labels against plain text..." << std::endl;
+
+    OverlayRenderer renderer(20);
+    for (float confidence : {0.87f, 0.5f, 0.054f, 1.0f, 0.996f}) {
+        char text[64];
+        snprintf(text, sizeof(text), "traffic light: %.2f", confidence);
+
+        RGBImage label(200, 40, 90);
+        RGBImage expected(200, 40, 90);
+        OverlayImage label_view = label.view();
+        OverlayImage expected_view = expected.view();
+        // Twice, so the second comes from the cached prefix
+        renderer.drawLabel(label_view, "traffic light", confidence, 3, 5, GREEN);
+        label = RGBImage(200, 40, 90);
+        label_view = label.view();
+        renderer.drawLabel(label_view, "traffic light", confidence, 3, 5, GREEN);
+        renderer.drawText(expected_view, text, 3, 5, GREEN);
+        assert(label.pixels == expected.pixels);
+    }
+
+    // Labels partly outside the image are clipped, not drawn out of bounds
+    RGBImage small(30, 12, 0);
+    OverlayImage small_view = small.view();
+    renderer.drawLabel(small_view, "person", 0.9f, -15, -6, RED);
+    renderer.drawLabel(small_view, "person", 0.9f, 20, 4, RED);
+    renderer.drawLabel(small_view, "person", 0.9f, 500, 500, RED);
+
+    std::cout << "✓ Cached labels test passed" << std::endl;
+}
+
+void testBoxes() {
+    std::cout << "Testing boxes drawn as spans..." << std::endl;
+
+    OverlayRenderer renderer(20);
+    RGBImage image(64, 48, 50);
+    OverlayImage view = image.view();
+    renderer.drawBox(view, {10, 8, 40, 30}, GREEN, 2);
+
+    for (int y = 0; y < 48; y++) {
+        for (int x = 0; x < 64; x++) {
+            bool inside_outer = x >= 10 && x <= 40 && y >= 8 && y <= 30;
+            bool inside_inner = x >= 12 && x <= 38 && y >= 10 && y <= 28;
+            bool edge = inside_outer && !inside_inner;
+            const uint8_t* pixel = image.at(x, y);
+            if (edge) {
+                assert(isColor(pixel, GREEN));
+            } else {
+                assert(pixel[0] == 50 && pixel[1] == 50 && pixel[2] == 50);
+            }
+        }
+    }
+
+    // Clipped at the image edges: only the edges inside are drawn
+    RGBImage clipped(32, 32, 0);
+    OverlayImage clipped_view = clipped.view();
+    renderer.drawBox(clipped_view, {-5, -5, 20, 20}, RED, 3);
+    assert(!isColor(clipped.at(0, 0), RED));
+    assert(isColor(clipped.at(19, 0), RED));
+    assert(isColor(clipped.at(0, 19), RED));
+    assert(!isColor(clipped.at(21, 21), RED));
+    renderer.drawBox(clipped_view, {-5, -5, 100, 100}, RED, 3);
+    assert(!isColor(clipped.at(0, 0), RED) && !isColor(clipped.at(31, 31), RED));
+    // Thicker than the box: filled
+    renderer.drawBox(clipped_view, {10, 10, 13, 13}, GREEN, 4);
+    assert(isColor(clipped.at(11, 12), GREEN));
+
+    std::cout << "✓ Boxes drawn as spans test passed" << std::endl;
+}
+
+void testNV12() {
+    std::cout << "Testing NV12 targets..." << std::endl;
+
+    OverlayRenderer renderer(20);
+    NV12Image image(64, 48);
+    OverlayImage view = image.view();
+    renderer.drawBox(view, {10, 8, 41, 31}, RED, 2);
+
+    // BT.601 full range red
+    assert(image.luma(10, 8) == 77 && image.luma(41, 31) == 77);
+    assert(image.luma(20, 20) == 128);
+    const uint8_t* uv = image.chroma(5, 4);
+    assert(uv[0] == 85 && uv[1] == 255);
+    uv = image.chroma(10, 10);
+    assert(uv[0] == 128 && uv[1] == 128);
+
+    // Text covers the same luma pixels as on an RGB image
+    NV12Image text(80, 24);
+    RGBImage reference(80, 24, 0);
+    OverlayImage text_view = text.view();
+    OverlayImage reference_view = reference.view();
+    renderer.drawLabel(text_view, "car", 0.42f, 1, 2, {255, 255, 255});
+    renderer.drawLabel(reference_view, "car", 0.42f, 1, 2, {255, 255, 255});
+    int changed = 0, covered = 0;
+    for (int y = 0; y < 24; y++) {
+        for (int x = 0; x < 80; x++) {
+            // Faintest coverage may round away on the mid-gray luma
+            assert(text.luma(x, y) == 128 || reference.at(x, y)[0] != 0);
+            changed += text.luma(x, y) != 128;
+            covered += reference.at(x, y)[0] != 0;
+        }
+    }
+    assert(changed > 0 && changed * 20 >= covered * 19);
+    bool tinted = false;
+    // White has no colour, so the chroma stays neutral
+    for (int cy = 0; cy < 12; cy++) {
+        for (int cx = 0; cx < 40; cx++) {
+            tinted = tinted || text.chroma(cx, cy)[0] != 128 || text.chroma(cx, cy)[1] != 128;
+        }
+    }
+    assert(!tinted);
+
+    std::cout << "✓ NV12 targets test passed" << std::endl;
+}
+
+void testCost() {
+    std::cout << "Testing overlay cost for a busy frame..." << std::endl;
+
+    // 1080p RGB, 30 labelled boxes, as the frame writer draws them
+    RGBImage image(1920, 1080, 0);
+    OverlayImage view = image.view();
+    OverlayRenderer renderer(20);
+    const char* names[] = {"person", "car", "bicycle", "traffic light"};
+    const int frames = 100;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < 30; i++) {
+            box_rect_t box = {40 + i * 60, 100 + (i % 5) * 150, 90 + i * 60, 400 + (i % 5) * 120};
+            renderer.drawBox(view, box, GREEN, 2);
+            renderer.drawLabel(view, names[i % 4], 0.5f + i * 0.01f, box.left, box.top - 24, GREEN);
+        }
+    }
+    double per_frame = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                       frames;
+    std::cout << "  30 boxes and labels: " << per_frame << " us per frame" << std::endl;
+
+    std::cout << "✓ Overlay cost test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running overlay renderer tests..." << std::endl;
+
+    testGlyphs();
+    testLabels();
+    testBoxes();
+    testNV12();
+    testCost();
+
+    std::cout << "\n✅ All overlay renderer tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "frame_writer.h"
+#include "preview_server.h"
+
+// A plain HTTP client, like curl, on a loopback socket
+class HttpClient {
+public:
+    HttpClient(int port, const std::string& path, int receive_buffer = 0) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        assert(fd >= 0);
+        if (receive_buffer > 0) {
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+        }
+        struct timeval timeout = {2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        assert(connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0);
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nUser-Agent: curl/8.0\r\n\r\n";
+        assert(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()));
+    }
+    ~HttpClient() { close(fd); }
+
+    // Read until `delimiter` is buffered; false on timeout or close
+    bool readUntil(const std::string& delimiter) {
+        while (buffered.find(delimiter) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readBytes(size_t count) {
+        while (buffered.size() < count) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string headers() {
+        assert(readUntil("\r\n\r\n"));
+        size_t end = buffered.find("\r\n\r\n") + 4;
+        std::string head = buffered.substr(0, end);
+        buffered.erase(0, end);
+        return head;
+    }
+
+    // The next part of an MJPEG stream; empty on timeout
+    std::string nextPart() {
+        if (!readUntil("\r\n\r\n")) {
+            return "";
+        }
+        std::string head = headers();
+        assert(head.compare(0, 9, "--frame\r\n") == 0);
+        assert(head.find("Content-Type: image/jpeg") != std::string::npos);
+        size_t length = std::stoul(head.substr(head.find("Content-Length: ") + 16));
+        assert(readBytes(length + 2));
+        std::string jpeg = buffered.substr(0, length);
+        assert(buffered.compare(length, 2, "\r\n") == 0);
+        buffered.erase(0, length + 2);
+        return jpeg;
+    }
+
+    // Everything until the server closes the connection
+    std::string readToEnd() {
+        while (fill()) {
+        }
+        return buffered;
+    }
+
+private:
+    bool fill() {
+        char chunk[65536];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffered.append(chunk, n);
+        return true;
+    }
+
+    int fd;
+    std::string buffered;
+};
+
+static bool isJpeg(const std::string& data) {
+    return data.size() > 2 && static_cast<unsigned char>(data[0]) == 0xFF &&
+           static_cast<unsigned char>(data[1]) == 0xD8;
+}
+
+static void waitForClients(PreviewServer& server, long count) {
+    for (int i = 0; i < 200 && server.stats().clients != count; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(server.stats().clients == count);
+}
+
+// Publish a noisy frame, which encodes to a large JPEG
+static void publishFrame(PreviewServer& server, const cv::Mat& bgr) {
+    DecoratedFrame frame(bgr);
+    server.publish(frame);
+}
+
+void testAddressParsing() {
+    std::cout << "Testing preview address parsing..." << std::endl;
+
+    PreviewConfig config;
+    assert(parsePreviewAddress("8090", config) && config.address == "127.0.0.1" && config.port == 8090);
+    assert(parsePreviewAddress("0.0.0.0:8081", config) && config.address == "0.0.0.0" && config.port == 8081);
+    assert(!parsePreviewAddress("localhost:8080", config));
+    assert(!parsePreviewAddress("127.0.0.1:99999", config));
+    assert(!parsePreviewAddress("", config));
+
+    std::cout << "✓ Address parsing test passed" << std::endl;
+}
+
+void testStreaming() {
+    std::cout << "Testing MJPEG streaming, snapshots and slow clients..." << std::endl;
+
+    std::atomic<bool> running{true};
+    PreviewConfig config;
+    config.port = 0;
+    config.fps = 1000;
+    PreviewServer server(config, running);
+    std::thread serverThread(std::ref(server));
+    for (int i = 0; i < 200 && server.port() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(server.port() > 0);
+
+    cv::Mat bgr(480, 640, CV_8UC3);
+    cv::randu(bgr, cv::Scalar(0, 0, 0), cv::Scalar(255, 255, 255));
+
+    // Nothing is encoded without clients
+    publishFrame(server, bgr);
+    assert(server.stats().frames_encoded == 0);
+
+    // Unknown paths
+    {
+        HttpClient missing(server.port(), "/missing");
+        assert(missing.readToEnd().compare(0, 22, "HTTP/1.0 404 Not Found") == 0);
+    }
+
+    HttpClient fast(server.port(), "/");
+    std::string head = fast.headers();
+    assert(head.compare(0, 15, "HTTP/1.0 200 OK") == 0);
+    assert(head.find("multipart/x-mixed-replace; boundary=frame") != std::string::npos);
+
+    // A client that never reads, with a small receive buffer
+    HttpClient slow(server.port(), "/", 4096);
+    waitForClients(server, 2);
+
+    const int frames = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        publishFrame(server, bgr);
+        std::string jpeg = fast.nextPart();
+        assert(isJpeg(jpeg));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << frames << " frames in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+              << " ms with a stalled client" << std::endl;
+    assert(elapsed < std::chrono::seconds(5));
+    assert(server.stats().frames_encoded == frames);
+
+    // The slow client gets a frame it started, then the newest; the rest are skipped
+    int received = 0;
+    slow.headers();
+    while (isJpeg(slow.nextPart())) {
+        received++;
+    }
+    std::cout << "  slow client received " << received << " of " << frames << " frames" << std::endl;
+    assert(received >= 1 && received < frames);
+    assert(server.stats().frames_skipped > 0);
+
+    // A snapshot is one plain JPEG response, from the next frame
+    HttpClient snapshot(server.port(), "/snapshot.jpg");
+    waitForClients(server, 3);
+    publishFrame(server, bgr);
+    std::string response = snapshot.readToEnd();
+    size_t body = response.find("\r\n\r\n") + 4;
+    assert(response.find("Content-Type: image/jpeg") < body);
+    assert(isJpeg(response.substr(body)));
+    waitForClients(server, 2);
+
+    running = false;
+    serverThread.join();
+
+    std::cout << "✓ Streaming test passed" << std::endl;
+}
+
+void testScaledPreview() {
+    std::cout << "Testing scaled preview frames..." << std::endl;
+
+    std::atomic<bool> running{true};
+    PreviewConfig config;
+    config.port = 0;
+    config.fps = 1000;
+    config.width = 320;
+    config.height = 180;
+    PreviewServer server(config, running);
+    std::thread serverThread(std::ref(server));
+    for (int i = 0; i < 200 && server.port() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    HttpClient client(server.port(), "/stream.mjpg");
+    client.headers();
+    waitForClients(server, 1);
+
+    cv::Mat bgr(720, 1280, CV_8UC3, cv::Scalar(30, 60, 90));
+    publishFrame(server, bgr);
+    std::string jpeg = client.nextPart();
+    cv::Mat decoded = cv::imdecode(std::vector<uchar>(jpeg.begin(), jpeg.end()), cv::IMREAD_COLOR);
+    assert(decoded.cols == 320 && decoded.rows == 180);
+
+    // Other shapes fit within the preview size, and are never scaled up
+    const int shapes[][4] = {{960, 720, 240, 180}, {160, 120, 160, 120}};
+    for (const auto& shape : shapes) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        publishFrame(server, cv::Mat(shape[1], shape[0], CV_8UC3, cv::Scalar(30, 60, 90)));
+        jpeg = client.nextPart();
+        decoded = cv::imdecode(std::vector<uchar>(jpeg.begin(), jpeg.end()), cv::IMREAD_COLOR);
+        assert(decoded.cols == shape[2] && decoded.rows == shape[3]);
+    }
+
+    // The frame rate limit drops frames that come too soon
+    config.fps = 1;
+    running = false;
+    serverThread.join();
+
+    std::atomic<bool> running_slow{true};
+    PreviewServer limited(config, running_slow);
+    std::thread limitedThread(std::ref(limited));
+    for (int i = 0; i < 200 && limited.port() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    HttpClient viewer(limited.port(), "/");
+    waitForClients(limited, 1);
+    for (int i = 0; i < 10; i++) {
+        publishFrame(limited, bgr);
+    }
+    assert(limited.stats().frames_encoded == 1);
+    running_slow = false;
+    limitedThread.join();
+
+    std::cout << "✓ Scaled preview test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running preview server tests..." << std::endl;
+
+    testAddressParsing();
+    testStreaming();
+    testScaledPreview();
+
+    std::cout << "\n✅ All preview server tests passed!" << std::endl;
+    return 0;
+}
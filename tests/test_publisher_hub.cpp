@@ -0,0 +1,215 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include headers
+#include "publisher.h"
+#include "publisher_hub.h"
+#include "inference.h"
+#include "transport.h"
+
+// Records what was sent
+class RecordingTransport : public Transport {
+public:
+    bool send(const std::string& data) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(data);
+        return true;
+    }
+    bool isConnected() const override { return true; }
+
+    std::vector<std::string> sent() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+// Sends the frame id
+class FrameIdFormatter : public MessageFormatter {
+public:
+    std::string formatMessage(const InferenceResult& result) override {
+        return std::to_string(result.frame_id);
+    }
+};
+
+// Pushes a new result every period, with `people` people, until stopped
+class Producer {
+public:
+    Producer(ThreadSafeQueue<InferenceResult>& queue, std::chrono::milliseconds period, int people = 0)
+        : thread([this, &queue, period, people] {
+              for (uint64_t frame = 1; !stop; frame++) {
+                  InferenceResult result;
+                  memset(&result.detections, 0, sizeof(result.detections));
+                  result.timestamp = std::chrono::system_clock::now();
+                  result.confidence_threshold = 0.5f;
+                  result.class_mapping = {{"person", 0}};
+                  result.selected_classes = {0};
+                  result.frame_id = frame;
+                  result.detections.count = people;
+                  for (int i = 0; i < people; i++) {
+                      result.detections.results[i] = {{100 * i, 50, 100 * i + 80, 250}, 0.9f, 0, "person"};
+                  }
+                  latest = frame;
+                  queue.push(std::move(result));
+                  std::this_thread::sleep_for(period);
+              }
+          }) {}
+    ~Producer() {
+        stop = true;
+        thread.join();
+    }
+
+    std::atomic<uint64_t> latest{0};
+
+private:
+    std::atomic<bool> stop{false};
+    std::thread thread;
+};
+
+void testSinkRates() {
+    std::cout << "Testing per-sink rates on one thread..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    PublisherHub hub(queue, running);
+    const double rates[] = {5.0, 10.0, 20.0};
+    std::vector<std::shared_ptr<RecordingTransport>> transports;
+    std::vector<PublishSink*> sinks;
+    for (double rate : rates) {
+        transports.push_back(std::make_shared<RecordingTransport>());
+        sinks.push_back(&hub.addSink(transports.back(), std::make_shared<FrameIdFormatter>(), rate,
+                                     "sink " + std::to_string(rate)));
+    }
+    assert(hub.size() == 3);
+
+    std::thread thread(std::ref(hub));
+    {
+        Producer producer(queue, std::chrono::milliseconds(5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1020));
+
+        // Each send carries a recent result
+        auto sent = transports[2]->sent();
+        assert(!sent.empty());
+        assert(producer.latest - std::stoull(sent.back()) < 20);
+    }
+    running = false;
+    queue.signalShutdown();
+    thread.join();
+
+    // Deadlines at 0, 1/rate, ... up to 1 s
+    for (size_t i = 0; i < sinks.size(); i++) {
+        PublishStats stats = sinks[i]->stats();
+        std::cout << "  " << rates[i] << " Hz: sent " << stats.sent << ", lateness max " << stats.lateness_max_ms
+                  << " ms" << std::endl;
+        long expected = static_cast<long>(rates[i]) + 1;
+        assert(stats.sent + stats.stale >= expected - 1 && stats.sent + stats.stale <= expected + 1);
+        assert(static_cast<long>(transports[i]->sent().size()) == stats.sent);
+    }
+
+    std::cout << "✓ Per-sink rate test passed" << std::endl;
+}
+
+void testMixedPolicies() {
+    std::cout << "Testing periodic and on-change sinks together..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    PublisherHub hub(queue, running);
+    auto periodic = std::make_shared<RecordingTransport>();
+    auto on_change = std::make_shared<RecordingTransport>();
+    hub.addSink(periodic, std::make_shared<SelectiveJsonMessageFormatter>(), 20.0, "periodic");
+    ChangePolicy policy;
+    policy.enabled = true;
+    policy.heartbeat_seconds = 60.0;
+    hub.addSink(on_change, std::make_shared<SelectiveJsonMessageFormatter>(), 20.0, "on change")
+        .setChangePolicy(policy);
+
+    std::thread thread(std::ref(hub));
+    {
+        Producer producer(queue, std::chrono::milliseconds(10), 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    running = false;
+    queue.signalShutdown();
+    thread.join();
+
+    // The same scene every frame: one message on change, about ten periodic
+    assert(periodic->sent().size() >= 8);
+    auto sent = on_change->sent();
+    assert(sent.size() == 1);
+    assert(sent.front().find("\"person\":2") != std::string::npos);
+
+    std::cout << "✓ Mixed policy test passed" << std::endl;
+}
+
+void testShutdownWakesHub() {
+    std::cout << "Testing shutdown while the hub sleeps..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    PublisherHub hub(queue, running);
+    hub.addSink(std::make_shared<RecordingTransport>(), std::make_shared<FrameIdFormatter>(), 0.1, "slow");
+
+    std::thread thread(std::ref(hub));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // The next deadline is ten seconds away; shutdown must not wait for it
+    auto start = std::chrono::steady_clock::now();
+    running = false;
+    queue.signalShutdown();
+    thread.join();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(elapsed < std::chrono::milliseconds(200));
+
+    std::cout << "✓ Shutdown test passed" << std::endl;
+}
+
+void testManySinks() {
+    std::cout << "Testing many sinks..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    std::atomic<bool> running{true};
+    PublisherHub hub(queue, running);
+    std::vector<std::shared_ptr<RecordingTransport>> transports;
+    for (int i = 0; i < 48; i++) {
+        transports.push_back(std::make_shared<RecordingTransport>());
+        hub.addSink(transports.back(), std::make_shared<SelectiveBSMessageFormatter>(), 10.0 + i % 3,
+                    "sink " + std::to_string(i));
+    }
+
+    std::thread thread(std::ref(hub));
+    {
+        Producer producer(queue, std::chrono::milliseconds(5), 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    running = false;
+    queue.signalShutdown();
+    thread.join();
+
+    for (auto& transport : transports) {
+        assert(transport->sent().size() >= 4);
+    }
+
+    std::cout << "✓ Many sinks test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running publisher hub tests..." << std::endl;
+
+    testSinkRates();
+    testMixedPolicies();
+    testShutdownWakesHub();
+    testManySinks();
+
+    std::cout << "\n✅ All publisher hub tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include headers
+#include "publisher.h"
+#include "inference.h"
+#include "transport.h"
+
+// Records what was sent
+class RecordingTransport : public Transport {
+public:
+    bool send(const std::string& data) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(data);
+        return true;
+    }
+    bool isConnected() const override { return true; }
+
+    std::vector<std::string> sent() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::string> messages;
+};
+
+// Sends the frame id, taking a fixed time to format
+class SlowFormatter : public MessageFormatter {
+public:
+    explicit SlowFormatter(int format_ms) : format_ms(format_ms) {}
+    std::string formatMessage(const InferenceResult& result) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(format_ms));
+        return std::to_string(result.frame_id);
+    }
+
+private:
+    int format_ms;
+};
+
+// People in the frame, by frame number
+using Scene = std::function<int(uint64_t frame)>;
+
+// Pushes a new result every period until stopped
+class Producer {
+public:
+    Producer(ThreadSafeQueue<InferenceResult>& queue, std::chrono::milliseconds period, Scene scene = nullptr)
+        : thread([this, &queue, period, scene] {
+              for (uint64_t frame = 1; !stop; frame++) {
+                  InferenceResult result;
+                  memset(&result.detections, 0, sizeof(result.detections));
+                  result.timestamp = std::chrono::system_clock::now();
+                  result.confidence_threshold = 0.5f;
+                  result.class_mapping = {{"person", 0}};
+                  result.selected_classes = {0};
+                  result.frame_id = frame;
+                  result.detections.count = scene ? scene(frame) : 0;
+                  for (int i = 0; i < result.detections.count; i++) {
+                      result.detections.results[i] = {{100 * i, 50, 100 * i + 80, 250}, 0.9f, 0, "person"};
+                  }
+                  latest = frame;
+                  queue.push(std::move(result));
+                  std::this_thread::sleep_for(period);
+              }
+          }) {}
+    ~Producer() {
+        stop = true;
+        thread.join();
+    }
+
+    std::atomic<uint64_t> latest{0};
+
+private:
+    std::atomic<bool> stop{false};
+    std::thread thread;
+};
+
+static PublishStats runPublisher(ThreadSafeQueue<InferenceResult>& queue, std::shared_ptr<RecordingTransport> transport,
+                                 std::shared_ptr<MessageFormatter> formatter, double rate,
+                                 std::chrono::milliseconds duration, const ChangePolicy& policy = {}) {
+    std::atomic<bool> running{true};
+    Publisher publisher(transport, queue, running, formatter, rate, "test");
+    publisher.setChangePolicy(policy);
+    std::thread thread(std::ref(publisher));
+    std::this_thread::sleep_for(duration);
+    running = false;
+    queue.signalShutdown();
+    thread.join();
+    return publisher.stats();
+}
+
+void testRateHoldsDespiteSlowFormatting() {
+    std::cout << "Testing deadline scheduling with slow formatting..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    Producer producer(queue, std::chrono::milliseconds(5));
+    auto transport = std::make_shared<RecordingTransport>();
+
+    // 20 Hz with 30 ms of formatting: sleeping a full period after each
+    // send would only reach 1000 / (50 + 30) = 12.5 Hz
+    PublishStats stats = runPublisher(queue, transport, std::make_shared<SlowFormatter>(30), 20.0,
+                                      std::chrono::milliseconds(2000));
+    std::cout << "  sent " << stats.sent << ", " << stats.rate << " msg/s, lateness max " << stats.lateness_max_ms
+              << " ms, age max " << stats.age_max_ms << " ms" << std::endl;
+    assert(stats.sent >= 36 && stats.sent <= 42);
+    assert(stats.rate > 17.0);
+    assert(static_cast<long>(transport->sent().size()) == stats.sent);
+
+    std::cout << "✓ Deadline scheduling test passed" << std::endl;
+}
+
+void testFractionalRate() {
+    std::cout << "Testing fractional rate..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    Producer producer(queue, std::chrono::milliseconds(10));
+    auto transport = std::make_shared<RecordingTransport>();
+
+    // 2.5 Hz for 1.1 s: deadlines at 0, 400 and 800 ms
+    PublishStats stats = runPublisher(queue, transport, std::make_shared<SlowFormatter>(0), 2.5,
+                                      std::chrono::milliseconds(1100));
+    assert(stats.sent + stats.stale == 3);
+
+    std::cout << "✓ Fractional rate test passed" << std::endl;
+}
+
+void testLatestResultWins() {
+    std::cout << "Testing latest-wins reads..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    auto first = std::make_shared<RecordingTransport>();
+    auto second = std::make_shared<RecordingTransport>();
+    std::atomic<bool> running{true};
+    Publisher publisher_a(first, queue, running, std::make_shared<SlowFormatter>(0), 10.0, "a");
+    Publisher publisher_b(second, queue, running, std::make_shared<SlowFormatter>(0), 10.0, "b");
+
+    std::thread thread_a(std::ref(publisher_a));
+    std::thread thread_b(std::ref(publisher_b));
+    {
+        Producer producer(queue, std::chrono::milliseconds(2));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        // Each send carries a result at most a few frames old
+        auto sent = first->sent();
+        assert(!sent.empty());
+        uint64_t newest = producer.latest;
+        assert(newest - std::stoull(sent.back()) < 60);
+    }
+
+    // Once results stop, the same result is not sent again
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    size_t sent_a = first->sent().size();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(first->sent().size() == sent_a);
+    assert(publisher_a.stats().stale >= 2);
+
+    running = false;
+    queue.signalShutdown();
+    thread_a.join();
+    thread_b.join();
+
+    // Both publishers see the results; neither starves the other
+    assert(first->sent().size() >= 4 && second->sent().size() >= 4);
+
+    std::cout << "✓ Latest-wins test passed" << std::endl;
+}
+
+void testChangeKeys() {
+    std::cout << "Testing change keys..." << std::endl;
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.class_mapping = {{"person", 0}, {"car", 2}};
+    result.selected_classes = {0, 2};
+    result.confidence_threshold = 0.5f;
+    result.timestamp = std::chrono::system_clock::now();
+    result.detections.count = 2;
+    result.detections.results[0] = {{100, 50, 180, 250}, 0.9f, 0, "person"};
+    result.detections.results[1] = {{300, 60, 500, 200}, 0.8f, 2, "car"};
+
+    SelectiveJsonMessageFormatter counts;
+    FullJsonMessageFormatter boxes;
+    uint64_t count_key = counts.changeKey(result);
+    uint64_t box_key = boxes.changeKey(result);
+
+    // A later frame with the same content and a new timestamp is unchanged
+    result.timestamp += std::chrono::seconds(5);
+    result.detections.results[0].prop = 0.85f;
+    result.detections.results[0].box.left += 2;  // Jitter within the grid
+    assert(counts.changeKey(result) == count_key);
+    assert(boxes.changeKey(result) == box_key);
+
+    // A box moving changes the boxes but not the counts
+    result.detections.results[1].box.left += 100;
+    result.detections.results[1].box.right += 100;
+    assert(counts.changeKey(result) == count_key);
+    assert(boxes.changeKey(result) != box_key);
+
+    // One fewer car changes both
+    result.detections.count = 1;
+    assert(counts.changeKey(result) != count_key);
+    assert(boxes.changeKey(result) != box_key);
+
+    std::cout << "✓ Change key test passed" << std::endl;
+}
+
+void testOnChangeHeartbeat() {
+    std::cout << "Testing on-change publishing with heartbeats..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    Producer producer(queue, std::chrono::milliseconds(10), [](uint64_t) { return 2; });
+    auto transport = std::make_shared<RecordingTransport>();
+
+    // Nothing changes: the first message, then one heartbeat every 300 ms
+    ChangePolicy policy;
+    policy.enabled = true;
+    policy.heartbeat_seconds = 0.3;
+    PublishStats stats = runPublisher(queue, transport, std::make_shared<SelectiveJsonMessageFormatter>(), 20.0,
+                                      std::chrono::milliseconds(1000), policy);
+    std::cout << "  sent " << stats.sent << ", avoided " << stats.avoided << std::endl;
+    assert(stats.sent >= 3 && stats.sent <= 5);
+    assert(stats.avoided >= 14);
+    assert(transport->sent().front().find("\"person\":2") != std::string::npos);
+
+    std::cout << "✓ On-change heartbeat test passed" << std::endl;
+}
+
+void testOnChangeSendsChanges() {
+    std::cout << "Testing on-change publishing of changes..." << std::endl;
+
+    ThreadSafeQueue<InferenceResult> queue(1);
+    // The count steps every 20 frames (200 ms); heartbeat far away
+    Producer producer(queue, std::chrono::milliseconds(10),
+                      [](uint64_t frame) { return static_cast<int>(frame / 20 % 4); });
+    auto transport = std::make_shared<RecordingTransport>();
+
+    ChangePolicy policy;
+    policy.enabled = true;
+    policy.heartbeat_seconds = 60.0;
+    PublishStats stats = runPublisher(queue, transport, std::make_shared<SelectiveBSMessageFormatter>(), 20.0,
+                                      std::chrono::milliseconds(1050), policy);
+
+    // One message per step, each sent within a frame or two of the change
+    std::cout << "  sent " << stats.sent << ", change delay max " << stats.lateness_max_ms << " ms" << std::endl;
+    assert(stats.sent >= 5 && stats.sent <= 7);
+    auto sent = transport->sent();
+    for (size_t i = 1; i < sent.size(); i++) {
+        assert(sent[i].substr(0, sent[i].find("!!")) != sent[i - 1].substr(0, sent[i - 1].find("!!")));
+    }
+
+    std::cout << "✓ On-change send test passed" << std::endl;
+}
+
+void testOnChangeHysteresis() {
+    std::cout << "Testing on-change hysteresis..." << std::endl;
+
+    // One person, with a single frame of two every 10 frames
+    Scene flicker = [](uint64_t frame) { return frame % 10 == 5 ? 2 : 1; };
+    ChangePolicy policy;
+    policy.enabled = true;
+    policy.heartbeat_seconds = 60.0;
+
+    {
+        ThreadSafeQueue<InferenceResult> queue(1);
+        Producer producer(queue, std::chrono::milliseconds(10), flicker);
+        auto transport = std::make_shared<RecordingTransport>();
+        PublishStats stats = runPublisher(queue, transport, std::make_shared<SelectiveJsonMessageFormatter>(), 20.0,
+                                          std::chrono::milliseconds(600), policy);
+        assert(stats.sent >= 8);  // Every flicker and its recovery
+    }
+
+    policy.hysteresis = 2;
+    {
+        ThreadSafeQueue<InferenceResult> queue(1);
+        Producer producer(queue, std::chrono::milliseconds(10), flicker);
+        auto transport = std::make_shared<RecordingTransport>();
+        PublishStats stats = runPublisher(queue, transport, std::make_shared<SelectiveJsonMessageFormatter>(), 20.0,
+                                          std::chrono::milliseconds(600), policy);
+        assert(stats.sent == 1);
+        assert(transport->sent().front().find("\"person\":1") != std::string::npos);
+    }
+
+    std::cout << "✓ On-change hysteresis test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running publisher scheduling tests..." << std::endl;
+
+    testRateHoldsDespiteSlowFormatting();
+    testFractionalRate();
+    testLatestResultWins();
+    testChangeKeys();
+    testOnChangeHeartbeat();
+    testOnChangeSendsChanges();
+    testOnChangeHysteresis();
+
+    std::cout << "\n✅ All publisher scheduling tests passed!" << std::endl;
+    return 0;
+}
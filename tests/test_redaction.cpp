@@ -0,0 +1,232 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "inference.h"
+#include "redaction.h"
+
+static std::vector<uint8_t> randomImage(int width, int height, int channels, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * channels);
+    for (auto& value : image) {
+        value = static_cast<uint8_t>(rng());
+    }
+    return image;
+}
+
+// Straightforward box blur with the edge pixels of the region repeated
+static std::vector<uint8_t> referenceBlur(const std::vector<uint8_t>& image, int width, int channels,
+                                         int x, int y, int w, int h, int radius) {
+    std::vector<uint8_t> out = image;
+    int n = 2 * radius + 1;
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            for (int c = 0; c < channels; c++) {
+                uint32_t sum = 0;
+                for (int dy = -radius; dy <= radius; dy++) {
+                    int sy = y + std::clamp(j + dy, 0, h - 1);
+                    for (int dx = -radius; dx <= radius; dx++) {
+                        int sx = x + std::clamp(i + dx, 0, w - 1);
+                        sum += image[(static_cast<size_t>(sy) * width + sx) * channels + c];
+                    }
+                }
+                out[(static_cast<size_t>(y + j) * width + x + i) * channels + c] =
+                    static_cast<uint8_t>((sum + n * n / 2) / (n * n));
+            }
+        }
+    }
+    return out;
+}
+
+static bool outsideUnchanged(const std::vector<uint8_t>& before, const std::vector<uint8_t>& after,
+                             int width, int height, int channels, int x, int y, int w, int h) {
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            if (i >= x && i < x + w && j >= y && j < y + h) {
+                continue;
+            }
+            size_t k = (static_cast<size_t>(j) * width + i) * channels;
+            if (memcmp(&before[k], &after[k], channels) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void testPixelate() {
+    std::cout << "Testing pixelation..." << std::endl;
+
+    const int width = 64, height = 48, channels = 3;
+    std::vector<uint8_t> before = randomImage(width, height, channels, 1);
+    std::vector<uint8_t> image = before;
+    // 21 x 15 in blocks of 8: partial blocks at the right and bottom
+    int x = 5, y = 7, w = 21, h = 15, block = 8;
+    pixelateRegion(image.data(), width * channels, channels, x, y, w, h, block);
+
+    for (int by = 0; by < h; by += block) {
+        for (int bx = 0; bx < w; bx += block) {
+            int rows = std::min(block, h - by), cols = std::min(block, w - bx);
+            for (int c = 0; c < channels; c++) {
+                uint32_t sum = 0;
+                for (int j = 0; j < rows; j++) {
+                    for (int i = 0; i < cols; i++) {
+                        sum += before[((y + by + j) * width + x + bx + i) * channels + c];
+                    }
+                }
+                uint8_t mean = static_cast<uint8_t>((sum + rows * cols / 2) / (rows * cols));
+                for (int j = 0; j < rows; j++) {
+                    for (int i = 0; i < cols; i++) {
+                        assert(image[((y + by + j) * width + x + bx + i) * channels + c] == mean);
+                    }
+                }
+            }
+        }
+    }
+    assert(outsideUnchanged(before, image, width, height, channels, x, y, w, h));
+
+    std::cout << "✓ Pixelation test passed" << std::endl;
+}
+
+void testBlur() {
+    std::cout << "Testing box blur against a direct sum..." << std::endl;
+
+    std::vector<uint32_t> scratch;
+    for (int channels : {1, 3, 4}) {
+        const int width = 80, height = 60;
+        std::vector<uint8_t> before = randomImage(width, height, channels, 2 + channels);
+        // Radii below, at and beyond the region size
+        for (int radius : {1, 3, 9, 25}) {
+            std::vector<uint8_t> image = before;
+            int x = 11, y = 4, w = 37, h = 19;
+            blurRegion(image.data(), width * channels, channels, x, y, w, h, radius, scratch);
+            std::vector<uint8_t> expected = referenceBlur(before, width, channels, x, y, w, h, radius);
+            for (size_t k = 0; k < image.size(); k++) {
+                assert(std::abs(static_cast<int>(image[k]) - static_cast<int>(expected[k])) <= 1);
+            }
+            assert(outsideUnchanged(before, image, width, height, channels, x, y, w, h));
+        }
+    }
+
+    // A flat region stays flat
+    std::vector<uint8_t> flat(32 * 32 * 3, 77);
+    blurRegion(flat.data(), 32 * 3, 3, 0, 0, 32, 32, 6, scratch);
+    assert(std::all_of(flat.begin(), flat.end(), [](uint8_t value) { return value == 77; }));
+
+    std::cout << "✓ Box blur test passed" << std::endl;
+}
+
+void testRegion() {
+    std::cout << "Testing redacted regions..." << std::endl;
+
+    int x, y, w, h;
+    assert(Redactor::regionOf({100, 100, 200, 300}, 0.1f, 640, 480, x, y, w, h));
+    assert(x == 90 && y == 80 && w == 120 && h == 240);
+    // Clipped to the frame
+    assert(Redactor::regionOf({600, 400, 700, 500}, 0.0f, 640, 480, x, y, w, h));
+    assert(x == 600 && y == 400 && w == 40 && h == 80);
+    // Outside it
+    assert(!Redactor::regionOf({650, 10, 700, 50}, 0.0f, 640, 480, x, y, w, h));
+
+    RedactionMode mode = RedactionMode::Pixelate;
+    assert(parseRedactionMode("blur", mode) && mode == RedactionMode::Blur);
+    assert(parseRedactionMode("pixelate", mode) && mode == RedactionMode::Pixelate);
+    assert(!parseRedactionMode("mosaic", mode));
+
+    std::cout << "✓ Redacted regions test passed" << std::endl;
+}
+
+void testRedactor() {
+    std::cout << "Testing redaction of detections in a frame..." << std::endl;
+
+    cv::Mat frame(120, 160, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat before = frame.clone();
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.confidence_threshold = 0.5f;
+    result.selected_classes = {2};  // People are redacted even when not selected
+    result.detections.results[result.detections.count++] = {{10, 10, 50, 90}, 0.2f, 0, "person"};
+    result.detections.results[result.detections.count++] = {{100, 20, 140, 60}, 0.9f, 2, "car"};
+
+    RedactionConfig config;
+    config.class_ids = {0};
+    config.padding = 0.0f;
+    config.strength = 8;
+    Redactor redactor(config);
+    assert(redactor.enabled());
+    redactor.apply(frame, result);
+
+    // The person's box is pixelated, the car and the rest untouched
+    cv::Mat diff;
+    cv::absdiff(frame, before, diff);
+    cv::Mat changed;
+    cv::cvtColor(diff, changed, cv::COLOR_BGR2GRAY);
+    cv::Rect person(10, 10, 40, 80);
+    assert(cv::countNonZero(changed(person)) > person.area() / 2);
+    assert(cv::countNonZero(changed) == cv::countNonZero(changed(person)));
+    cv::Vec3b corner = frame.at<cv::Vec3b>(10, 10);
+    assert(frame.at<cv::Vec3b>(17, 17) == corner);
+
+    // Nothing configured, nothing changed
+    Redactor off{RedactionConfig()};
+    assert(!off.enabled());
+    cv::Mat copy = before.clone();
+    off.apply(copy, result);
+    cv::absdiff(copy, before, diff);
+    assert(cv::sum(diff)[0] == 0);
+
+    std::cout << "✓ Redaction of detections in a frame test passed" << std::endl;
+}
+
+void testCost() {
+    std::cout << "Testing that cost follows the redacted area..." << std::endl;
+
+    // A 1080p frame, one 200 x 400 person
+    const int width = 1920, height = 1080, channels = 3;
+    std::vector<uint8_t> image = randomImage(width, height, channels, 9);
+    std::vector<uint32_t> scratch;
+    const int runs = 50;
+
+    auto time = [&](int radius) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            if (radius == 0) {
+                pixelateRegion(image.data(), width * channels, channels, 800, 300, 200, 400, 25);
+            } else {
+                blurRegion(image.data(), width * channels, channels, 800, 300, 200, 400, radius, scratch);
+            }
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+    };
+    double pixelate = time(0);
+    double small_radius = time(4);
+    double large_radius = time(50);
+    std::cout << "  200x400 region: pixelate " << pixelate << " us, blur radius 4 " << small_radius
+              << " us, radius 50 " << large_radius << " us" << std::endl;
+
+    // The blur's cost per pixel does not grow with the radius
+    assert(large_radius < small_radius * 3 + 50);
+
+    std::cout << "✓ Cost follows the redacted area test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running redaction tests..." << std::endl;
+
+    testPixelate();
+    testBlur();
+    testRegion();
+    testRedactor();
+    testCost();
+
+    std::cout << "\n✅ All redaction tests passed!" << std::endl;
+    return 0;
+}
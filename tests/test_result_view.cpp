@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include headers
+#include "publisher.h"
+#include "inference.h"
+#include "result_view.h"
+#include "test_fixtures.h"
+
+// One detection of each kind the view has to sort out, all in the same box
+static InferenceResult mixedResult() {
+    InferenceResult result = makeResult(0, 1746732409000ull);
+    result.class_mapping = {{"person", 0}, {"bicycle", 1}, {"car", 2}, {"dog", 16}};
+    result.selected_classes = {2, 0};
+
+    const box_rect_t box = {10, 20, 110, 220};
+    addDetection(result, box, 0, "person", 0.9f);   // 0: selected, above threshold
+    addDetection(result, box, 0, "person", 0.3f);   // 1: selected, below threshold
+    addDetection(result, box, 2, "car", 0.7f);      // 2: selected, above threshold
+    addDetection(result, box, 16, "dog", 0.8f);     // 3: not selected, above threshold
+    addDetection(result, box, -1, "person", 0.9f);  // 4: invalid class
+    addDetection(result, box, 2, "car", 0.0f);      // 5: invalid score
+    return result;
+}
+
+void testAggregates() {
+    std::cout << "Testing result view aggregates..." << std::endl;
+
+    InferenceResult result = mixedResult();
+    const ResultView& view = result.view();
+
+    assert((view.selected == std::vector<int>{0, 2}));
+    assert((view.listed == std::vector<int>{0, 1, 2}));
+    assert(view.above_threshold == 3);
+    assert(view.people == 1);
+
+    // Selected classes first, in selected order
+    assert(view.selected_names == 2);
+    assert(view.class_names[0] == "car" && view.class_counts[0] == 1);
+    assert(view.class_names[1] == "person" && view.class_counts[1] == 1);
+
+    // No selection: everything is selected, "person" is listed by default
+    result.selected_classes.clear();
+    const ResultView& all = result.view();
+    assert((all.selected == std::vector<int>{0, 2, 3}));
+    assert(all.selected_names == 1 && all.class_names[0] == "person");
+    assert(all.class_names.size() == 3);
+
+    std::cout << "✓ Result view aggregates test passed" << std::endl;
+}
+
+void testSharedBetweenCopies() {
+    std::cout << "Testing result view sharing..." << std::endl;
+
+    InferenceResult result = mixedResult();
+    result.shareView();
+    InferenceResult copy = result;
+    InferenceResult moved = std::move(copy);
+
+    // Every copy and thread sees the one view computed on first access
+    std::vector<const ResultView*> seen(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < seen.size(); i++) {
+        threads.emplace_back([&, i] { seen[i] = &(i % 2 ? result : moved).view(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const ResultView* view : seen) {
+        assert(view == seen[0]);
+    }
+    assert((seen[0]->selected == std::vector<int>{0, 2}));
+
+    std::cout << "✓ Result view sharing test passed" << std::endl;
+}
+
+void testFormattersUseView() {
+    std::cout << "Testing formatters with a shared view..." << std::endl;
+
+    InferenceResult plain = mixedResult();
+    InferenceResult shared = mixedResult();
+    shared.shareView();
+
+    std::vector<std::shared_ptr<MessageFormatter>> formatters = {
+        std::make_shared<JsonMessageFormatter>(),
+        std::make_shared<SelectiveJsonMessageFormatter>(),
+        std::make_shared<SelectiveJsonMessageFormatter>(std::unordered_map<std::string, std::string>{{"car", "person"}}),
+        std::make_shared<SelectiveBSMessageFormatter>(),
+        std::make_shared<FullJsonMessageFormatter>(),
+        std::make_shared<FacesJsonMessageFormatter>(),
+        std::make_shared<FacesBSMessageFormatter>(),
+        std::make_shared<BSVariableMessageFormatter>()};
+    for (const auto& formatter : formatters) {
+        assert(formatter->formatMessage(plain) == formatter->formatMessage(shared));
+    }
+
+    assert(formatters[0]->formatMessage(shared) == "{\"car\":1,\"person\":1,\"timestamp\":1746732409}");
+    assert(formatters[2]->formatMessage(shared) == "{\"person\":2,\"timestamp\":1746732409}");
+    assert(formatters[3]->formatMessage(shared) == "car:1!!person:1!!timestamp:1746732409");
+    assert(formatters[7]->formatMessage(shared) == "detection_count:3!!timestamp:1746732409");
+
+    std::cout << "✓ Shared view formatter test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running result view tests..." << std::endl;
+
+    testAggregates();
+    testSharedBetweenCopies();
+    testFormattersUseView();
+
+    std::cout << "\n✅ All result view tests passed!" << std::endl;
+    return 0;
+}
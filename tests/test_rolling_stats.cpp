@@ -0,0 +1,168 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Include headers
+#include "publisher.h"
+#include "rolling_stats.h"
+#include "test_fixtures.h"
+
+// Counts every allocation, to check that updates allocate nothing
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void testBins() {
+    std::cout << "Testing histogram bins..." << std::endl;
+
+    for (unsigned count = 0; count < 1000; count++) {
+        int bin = RollingWindow::bin(count);
+        assert(bin >= 0 && bin < RollingWindow::BINS);
+        assert(RollingWindow::binStart(bin) <= static_cast<int>(count));
+        assert(bin + 1 == RollingWindow::BINS || RollingWindow::binStart(bin + 1) > static_cast<int>(count));
+    }
+    assert(RollingWindow::bin(15) == 15 && RollingWindow::bin(16) == 16 && RollingWindow::bin(127) == 27);
+
+    std::vector<double> windows;
+    assert(parseRollingWindows("10s,1m,15m,1h,90", windows));
+    assert(windows == std::vector<double>({10, 60, 900, 3600, 90}));
+    assert(!parseRollingWindows("10x", windows) && !parseRollingWindows("0.5s", windows));
+    assert(rollingWindowName(10) == "10s" && rollingWindowName(60) == "1m" && rollingWindowName(900) == "15m");
+    assert(rollingWindowName(3600) == "1h" && rollingWindowName(90) == "90s");
+
+    std::cout << "✓ Bins test passed" << std::endl;
+}
+
+void testAgainstBruteForce() {
+    std::cout << "Testing rolling statistics against a full recount..." << std::endl;
+
+    // 30 fps for 3 minutes with a 60 s window, with gaps
+    const uint64_t start_ms = 1792238400000ull;
+    RollingWindow window(60, 1);
+    std::mt19937 rng(42);
+    std::vector<std::pair<uint64_t, uint16_t>> frames;
+    uint64_t t = start_ms;
+    for (int i = 0; i < 30 * 180; i++) {
+        t += rng() % 50 == 0 ? 2000 : 33;
+        uint16_t count = static_cast<uint16_t>(rng() % 8 == 0 ? 0 : rng() % 12);
+        frames.push_back({t, count});
+        window.add(t, &count);
+
+        if (i % 97 == 0) {
+            // The window holds every frame from the bucket 59 buckets back
+            uint64_t bucket_ms = 1000;
+            uint64_t first = (t / bucket_ms - (RollingWindow::BUCKETS - 1)) * bucket_ms;
+            std::vector<uint16_t> in_window;
+            for (const auto& frame : frames) {
+                if (frame.first >= first) {
+                    in_window.push_back(frame.second);
+                }
+            }
+            assert(window.frames() == in_window.size());
+
+            RollingWindow::ClassStats stats = window.stats(0);
+            double sum = 0;
+            int occupied = 0;
+            for (uint16_t count : in_window) {
+                sum += count;
+                occupied += count > 0;
+            }
+            std::sort(in_window.begin(), in_window.end());
+            assert(std::abs(stats.mean - sum / in_window.size()) < 1e-9);
+            assert(std::abs(stats.occupancy - static_cast<double>(occupied) / in_window.size()) < 1e-9);
+            assert(stats.max == in_window.back());
+            // Counts below 16 are exact
+            assert(stats.p50 == in_window[(in_window.size() + 1) / 2 - 1]);
+            assert(stats.p95 == in_window[static_cast<size_t>(std::ceil(0.95 * in_window.size())) - 1]);
+        }
+    }
+
+    // Everything expires after a long gap
+    uint16_t zero = 0;
+    window.add(t + 3600 * 1000, &zero);
+    assert(window.frames() == 1 && window.stats(0).max == 0);
+
+    std::cout << "✓ Brute force comparison passed" << std::endl;
+}
+
+void testFormatter() {
+    std::cout << "Testing the analytics formatter..." << std::endl;
+
+    AnalyticsMessageFormatter formatter({10, 60});
+    const uint64_t start_ms = 1792238400000ull;
+    uint64_t frame = 1;
+
+    // 20 s at 10 fps: 2 people for the first 10 s, then none; a car throughout
+    for (; frame <= 200; frame++) {
+        InferenceResult result = makeResult(frame, start_ms + frame * 100, frame <= 100 ? 2 : 0, 1);
+        formatter.observe(result);
+        formatter.observe(result);  // Offered twice, counted once
+    }
+    InferenceResult last = makeResult(frame - 1, start_ms + (frame - 1) * 100, 0, 1);
+    std::string message;
+    formatter.formatInto(last, message);
+
+    auto parsed = nlohmann::json::parse(message);
+    assert(parsed["timestamp"] == (start_ms + 20000) / 1000);
+    auto person_10s = parsed["person"]["10s"];
+    assert(person_10s["max"] == 0 && person_10s["occupancy"] == 0.0);
+    auto person_1m = parsed["person"]["1m"];
+    assert(person_1m["frames"] == 200 && person_1m["max"] == 2 && person_1m["mean"] == 1.0);
+    assert(person_1m["occupancy"] == 0.5 && person_1m["p50"] == 0 && person_1m["p95"] == 2);
+    assert(parsed["car"]["1m"]["occupancy"] == 1.0 && parsed["car"]["1m"]["p50"] == 1);
+
+    // Updates and messages allocate nothing once set up
+    InferenceResult next = makeResult(frame, start_ms + frame * 100, 3, 1);
+    next.view();  // Per-thread view storage, sized on first use
+    formatter.observe(next);
+    formatter.formatInto(next, message);
+    long before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    const int updates = 100000;
+    for (int i = 1; i <= updates; i++) {
+        next.frame_id = frame + i;
+        next.timestamp += std::chrono::milliseconds(33);
+        formatter.observe(next);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / updates;
+    formatter.formatInto(next, message);
+    assert(allocations == before);
+    std::cout << "  " << ns << " ns per update, 2 classes x 2 windows (view included)" << std::endl;
+
+    std::cout << "✓ Analytics formatter test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running rolling statistics tests..." << std::endl;
+
+    testBins();
+    testAgainstBruteForce();
+    testFormatter();
+
+    std::cout << "\n✅ All rolling statistics tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <opencv2/opencv.hpp>
+
+// Include headers
+#include "frame_writer.h"
+#include "inference.h"
+#include "shm_frame.h"
+#include "shm_ring.h"
+
+static std::string frameName(const char* test) {
+    return "/objdet-test-frames-" + std::to_string(getpid()) + "-" + test;
+}
+
+// A BGR frame with a distinct colour in each quadrant
+static cv::Mat testFrame(int width, int height) {
+    cv::Mat frame(height, width, CV_8UC3, cv::Scalar(255, 0, 0));
+    frame(cv::Rect(width / 2, 0, width / 2, height / 2)).setTo(cv::Scalar(0, 255, 0));
+    frame(cv::Rect(0, height / 2, width / 2, height / 2)).setTo(cv::Scalar(0, 0, 255));
+    return frame;
+}
+
+static const shm_frame_info_t* latestFrame(shm_ring_t& reader, uint64_t* sequence = nullptr) {
+    const void* data = nullptr;
+    int len = shm_ring_peek_latest(&reader, &data, sequence);
+    assert(len >= static_cast<int>(sizeof(shm_frame_info_t)));
+    const shm_frame_info_t* info = static_cast<const shm_frame_info_t*>(data);
+    assert(sizeof(shm_frame_info_t) + info->data_size == static_cast<size_t>(len));
+    return info;
+}
+
+void testRGB() {
+    std::cout << "Testing RGB frames..." << std::endl;
+
+    std::string name = frameName("rgb");
+    ShmFrameSink sink(name, ShmFrameFormat::RGB24);
+    cv::Mat bgr = testFrame(64, 48);
+    DecoratedFrame frame(bgr);
+    sink.publish(frame);
+
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    sink.publish(frame);
+
+    uint64_t sequence = 0;
+    const shm_frame_info_t* info = latestFrame(reader, &sequence);
+    assert(sequence == 2);
+    assert(info->format == SHM_FRAME_RGB24 && info->width == 64 && info->height == 48);
+    assert(info->stride == 64 * 3 && info->data_size == 64 * 48 * 3);
+
+    // The red bottom left quadrant, in R G B order
+    const uint8_t* image = reinterpret_cast<const uint8_t*>(info + 1);
+    const uint8_t* pixel = image + 40 * info->stride + 3 * 3;
+    assert(pixel[0] == 255 && pixel[1] == 0 && pixel[2] == 0);
+    assert(shm_ring_peek_valid(&reader));
+
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ RGB frame test passed" << std::endl;
+}
+
+void testNV12() {
+    std::cout << "Testing NV12 frames..." << std::endl;
+
+    std::string name = frameName("nv12");
+    ShmFrameSink sink(name, ShmFrameFormat::NV12);
+    cv::Mat bgr = testFrame(64, 48);
+    DecoratedFrame frame(bgr);
+    sink.publish(frame);
+
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    sink.publish(frame);
+    const shm_frame_info_t* info = latestFrame(reader);
+    assert(info->format == SHM_FRAME_NV12 && info->stride == 64);
+    assert(info->data_size == 64 * 48 * 3 / 2);
+
+    // Converting back gives the original colours
+    cv::Mat nv12(48 * 3 / 2, 64, CV_8UC1, const_cast<shm_frame_info_t*>(info) + 1);
+    cv::Mat back;
+    cv::cvtColor(nv12, back, cv::COLOR_YUV2BGR_NV12);
+    cv::Vec3b top_left = back.at<cv::Vec3b>(10, 10);
+    cv::Vec3b bottom_left = back.at<cv::Vec3b>(40, 10);
+    assert(top_left[0] > 200 && top_left[2] < 50);
+    assert(bottom_left[2] > 200 && bottom_left[0] < 50);
+
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ NV12 frame test passed" << std::endl;
+}
+
+void testJPEGAndResize() {
+    std::cout << "Testing JPEG frames and size changes..." << std::endl;
+
+    std::string name = frameName("jpeg");
+    ShmFrameSink sink(name, ShmFrameFormat::JPEG);
+    cv::Mat small = testFrame(64, 48);
+    DecoratedFrame small_frame(small);
+    sink.publish(small_frame);
+
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    sink.publish(small_frame);
+    const shm_frame_info_t* info = latestFrame(reader);
+    assert(info->format == SHM_FRAME_JPEG && info->stride == 0);
+
+    // The encoding is shared with every other user of the frame
+    assert(info->data_size == small_frame.jpeg().size());
+    std::vector<uchar> jpeg(reinterpret_cast<const uchar*>(info + 1),
+                            reinterpret_cast<const uchar*>(info + 1) + info->data_size);
+    cv::Mat decoded = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+    assert(decoded.cols == 64 && decoded.rows == 48);
+
+    // A new size replaces the ring; the old reader sees it closed
+    cv::Mat large = testFrame(128, 96);
+    DecoratedFrame large_frame(large);
+    sink.publish(large_frame);
+    const void* data = nullptr;
+    assert(shm_ring_peek_latest(&reader, &data, nullptr) > 0);  // Still the last small frame
+    assert(shm_ring_wait(&reader, 2, 0) == SHM_RING_ERR_CLOSED);
+    shm_ring_close(&reader);
+
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    sink.publish(large_frame);
+    info = latestFrame(reader);
+    assert(info->width == 128 && info->height == 96);
+
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ JPEG frame test passed" << std::endl;
+}
+
+void testWriterSinks() {
+    std::cout << "Testing DecoratedFrameWriter sinks without a file..." << std::endl;
+
+    std::string name = frameName("writer");
+    auto sink = std::make_shared<ShmFrameSink>(name, ShmFrameFormat::RGB24);
+    DecoratedFrameWriter writer("", false);
+    writer.addSink(sink);
+
+    InferenceResult result;
+    result.detections.count = 0;
+    result.confidence_threshold = 0.5f;
+    cv::Mat rgb(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb, result);
+
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    cv::Mat rgb2(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb2, result);
+    const shm_frame_info_t* info = latestFrame(reader);
+    const uint8_t* pixel = reinterpret_cast<const uint8_t*>(info + 1);
+    assert(pixel[0] == 10 && pixel[1] == 20 && pixel[2] == 30);
+
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    ShmFrameFormat format;
+    assert(parseShmFrameFormat("nv12", format) && format == ShmFrameFormat::NV12);
+    assert(!parseShmFrameFormat("yuyv", format));
+
+    std::cout << "✓ DecoratedFrameWriter sink test passed" << std::endl;
+}
+
+// Keeps the size and first box of the last decorated frame
+class ResultSink : public FrameSink {
+public:
+    int width = 0;
+    int height = 0;
+    box_rect_t box = {};
+    void publish(DecoratedFrame& frame) override {
+        width = frame.bgr().cols;
+        height = frame.bgr().rows;
+        box = frame.result()->detections.results[0].box;
+    }
+};
+
+void testScaledOutput() {
+    std::cout << "Testing decorated frames at a smaller output size..." << std::endl;
+
+    std::string name = frameName("scaled");
+    auto sink = std::make_shared<ShmFrameSink>(name, ShmFrameFormat::RGB24);
+    DecoratedFrameWriter writer("", false);
+    FrameOutputConfig output;
+    output.width = 32;
+    output.height = 24;
+    writer.setOutput(output);
+    writer.addSink(sink);
+
+    // A box in capture coordinates, drawn at half size
+    InferenceResult result;
+    result.detections.count = 1;
+    result.confidence_threshold = 0.5f;
+    result.detections.results[0].cls_id = 0;
+    result.detections.results[0].prop = 0.9f;
+    strcpy(result.detections.results[0].name, "person");
+    result.detections.results[0].box = {8, 30, 56, 46};
+    cv::Mat rgb(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb, result);
+
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    cv::Mat rgb2(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb2, result);
+    const shm_frame_info_t* info = latestFrame(reader);
+    assert(info->width == 32 && info->height == 24);
+    const uint8_t* image = reinterpret_cast<const uint8_t*>(info + 1);
+    const uint8_t* corner = image + 23 * info->stride + 28 * 3;
+    assert(corner[0] == 0 && corner[1] == 255 && corner[2] == 0);
+    const uint8_t* inside = image + 21 * info->stride + 14 * 3;
+    assert(inside[0] == 10 && inside[1] == 20 && inside[2] == 30);
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    // Sinks get the boxes in the scaled frame's pixels
+    auto recorder = std::make_shared<ResultSink>();
+    writer.addSink(recorder);
+    cv::Mat rgb5(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb5, result);
+    assert(recorder->width == 32 && recorder->height == 24);
+    assert(recorder->box.left == 4 && recorder->box.top == 15 && recorder->box.right == 28 &&
+           recorder->box.bottom == 23);
+    assert(result.detections.results[0].box.left == 8);
+
+    // The aspect ratio is kept: 64x48 fits 40x40 as 40x30
+    output.width = 40;
+    output.height = 40;
+    writer.setOutput(output);
+    cv::Mat rgb6(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb6, result);
+    assert(recorder->width == 40 && recorder->height == 30);
+    assert(recorder->box.left == 5 && recorder->box.bottom == 28);
+    shm_unlink(name.c_str());
+
+    // Frames are never scaled up
+    output.width = 128;
+    output.height = 96;
+    writer.setOutput(output);
+    cv::Mat rgb3(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb3, result);
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+    cv::Mat rgb4(48, 64, CV_8UC3, cv::Scalar(10, 20, 30));
+    writer.writeFrame(rgb4, result);
+    info = latestFrame(reader);
+    assert(info->width == 64 && info->height == 48);
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    // Each subsampling decodes to the same size
+    JpegSubsampling subsampling;
+    assert(parseJpegSubsampling("444", subsampling) && subsampling == JpegSubsampling::S444);
+    assert(parseJpegSubsampling("422", subsampling) && subsampling == JpegSubsampling::S422);
+    assert(!parseJpegSubsampling("411", subsampling));
+    cv::Mat bgr = testFrame(64, 48);
+    std::vector<uchar> jpeg_420, jpeg_444;
+    assert(encodeJpeg(bgr, 90, jpeg_420) && encodeJpeg(bgr, 90, jpeg_444, JpegSubsampling::S444));
+    assert(jpeg_444.size() > jpeg_420.size());
+    cv::Mat decoded = cv::imdecode(jpeg_444, cv::IMREAD_COLOR);
+    assert(decoded.cols == 64 && decoded.rows == 48);
+    FrameOutputConfig low;
+    low.jpeg_quality = 20;
+    DecoratedFrame frame(bgr, nullptr, low);
+    assert(!frame.jpeg().empty() && frame.jpeg().size() < jpeg_420.size());
+
+    std::cout << "✓ Scaled output test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running shared memory frame tests..." << std::endl;
+
+    testRGB();
+    testNV12();
+    testJPEGAndResize();
+    testWriterSinks();
+    testScaledOutput();
+
+    std::cout << "\n✅ All shared memory frame tests passed!" << std::endl;
+    return 0;
+}
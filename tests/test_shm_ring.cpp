@@ -0,0 +1,258 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Include headers
+#include "shm_ring.h"
+#include "transport.h"
+
+static std::string ringName(const char* test) {
+    return "/objdet-test-" + std::to_string(getpid()) + "-" + test;
+}
+
+static bool publish(shm_ring_t& ring, const std::string& message) {
+    return shm_ring_publish(&ring, message.data(), message.size()) == 0;
+}
+
+static std::string readLatest(shm_ring_t& ring, uint64_t* sequence = nullptr) {
+    char buffer[256];
+    int len = shm_ring_read_latest(&ring, buffer, sizeof(buffer), sequence);
+    assert(len >= 0);
+    return std::string(buffer, len);
+}
+
+void testLatestAndHistory() {
+    std::cout << "Testing latest and in-order reads..." << std::endl;
+
+    std::string name = ringName("history");
+    shm_ring_t writer;
+    assert(shm_ring_create(&writer, name.c_str(), 64, 4) == 0);
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+    char buffer[64];
+    assert(shm_ring_read_latest(&reader, buffer, sizeof(buffer), nullptr) == 0);
+    assert(shm_ring_read_next(&reader, buffer, sizeof(buffer), nullptr) == 0);
+
+    assert(publish(writer, "one"));
+    assert(publish(writer, "two"));
+    uint64_t sequence = 0;
+    assert(readLatest(reader, &sequence) == "two" && sequence == 2);
+
+    // In order from the first message after opening
+    int len = shm_ring_read_next(&reader, buffer, sizeof(buffer), &sequence);
+    assert(std::string(buffer, len) == "one" && sequence == 1);
+    len = shm_ring_read_next(&reader, buffer, sizeof(buffer), &sequence);
+    assert(std::string(buffer, len) == "two" && sequence == 2);
+    assert(shm_ring_read_next(&reader, buffer, sizeof(buffer), nullptr) == 0);
+
+    // Falling more than the ring behind skips to the oldest message kept
+    for (int i = 3; i <= 10; i++) {
+        assert(publish(writer, "message " + std::to_string(i)));
+    }
+    assert(shm_ring_read_next(&reader, buffer, sizeof(buffer), nullptr) == SHM_RING_ERR_OVERRUN);
+    len = shm_ring_read_next(&reader, buffer, sizeof(buffer), &sequence);
+    assert(len > 0 && sequence == 8);
+    assert(std::string(buffer, len) == "message 8");
+
+    // Too large for a slot, or for the reader's buffer
+    assert(shm_ring_publish(&writer, std::string(65, 'x').data(), 65) == SHM_RING_ERR_TOO_LARGE);
+    assert(shm_ring_read_latest(&reader, buffer, 3, nullptr) == SHM_RING_ERR_TOO_LARGE);
+
+    // A reader sees the writer go away
+    shm_ring_close(&writer);
+    assert(shm_ring_wait(&reader, 10, 1000) == SHM_RING_ERR_CLOSED);
+    shm_ring_close(&reader);
+    shm_unlink(name.c_str());
+
+    shm_ring_t missing;
+    assert(shm_ring_open(&missing, "/objdet-test-missing") == SHM_RING_ERR_SYSTEM);
+
+    std::cout << "✓ Latest and in-order read test passed" << std::endl;
+}
+
+void testWait() {
+    std::cout << "Testing futex wake-ups..." << std::endl;
+
+    std::string name = ringName("wait");
+    shm_ring_t writer;
+    assert(shm_ring_create(&writer, name.c_str(), 64, 4) == 0);
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+    auto start = std::chrono::steady_clock::now();
+    assert(shm_ring_wait(&reader, 0, 50) == SHM_RING_ERR_TIMEOUT);
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    std::thread publisher([&writer] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        publish(writer, "wake");
+    });
+    start = std::chrono::steady_clock::now();
+    assert(shm_ring_wait(&reader, 0, 5000) == 0);
+    assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+    publisher.join();
+    assert(readLatest(reader) == "wake");
+
+    // Already newer: no wait
+    assert(shm_ring_wait(&reader, 0, 5000) == 0);
+
+    shm_ring_close(&reader);
+    shm_ring_close(&writer);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ Futex wake-up test passed" << std::endl;
+}
+
+void testNoTornReads() {
+    std::cout << "Testing concurrent reads for torn messages..." << std::endl;
+
+    std::string name = ringName("torn");
+    shm_ring_t writer;
+    assert(shm_ring_create(&writer, name.c_str(), 4096, 2) == 0);
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+    // Every message is one byte repeated, with a length that varies
+    std::atomic<bool> stop{false};
+    std::thread publisher([&writer, &stop] {
+        std::vector<char> message(4096);
+        for (uint64_t n = 0; !stop; n++) {
+            size_t length = 100 + n * 37 % 3900;
+            memset(message.data(), static_cast<char>('a' + n % 26), length);
+            shm_ring_publish(&writer, message.data(), length);
+        }
+    });
+
+    std::vector<char> buffer(4096);
+    long reads = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (std::chrono::steady_clock::now() < end) {
+        int len = shm_ring_read_latest(&reader, buffer.data(), buffer.size(), nullptr);
+        assert(len >= 0);
+        for (int i = 1; i < len; i++) {
+            assert(buffer[i] == buffer[0]);
+        }
+        reads++;
+    }
+    stop = true;
+    publisher.join();
+    std::cout << "  " << reads << " consistent reads" << std::endl;
+    assert(reads > 1000);
+
+    shm_ring_close(&reader);
+    shm_ring_close(&writer);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ Torn read test passed" << std::endl;
+}
+
+void testInPlace() {
+    std::cout << "Testing in-place writes and zero-copy reads..." << std::endl;
+
+    std::string name = ringName("inplace");
+    shm_ring_t writer;
+    assert(shm_ring_create(&writer, name.c_str(), 64, 3) == 0);
+    shm_ring_t reader;
+    assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+    const void* data = nullptr;
+    assert(shm_ring_peek_latest(&reader, &data, nullptr) == 0);
+    assert(shm_ring_commit(&writer, 1) == SHM_RING_ERR_SYSTEM);  // No begin
+
+    // Not visible until committed
+    char* slot = static_cast<char*>(shm_ring_begin(&writer));
+    assert(slot);
+    memcpy(slot, "frame 1", 7);
+    assert(shm_ring_peek_latest(&reader, &data, nullptr) == 0);
+    assert(shm_ring_commit(&writer, 7) == 0);
+
+    uint64_t sequence = 0;
+    int len = shm_ring_peek_latest(&reader, &data, &sequence);
+    assert(len == 7 && sequence == 1);
+    assert(std::string(static_cast<const char*>(data), len) == "frame 1");
+
+    // The peeked slot survives the next slot_count - 1 frames, not more
+    assert(publish(writer, "frame 2"));
+    assert(publish(writer, "frame 3"));
+    assert(shm_ring_peek_valid(&reader));
+    slot = static_cast<char*>(shm_ring_begin(&writer));
+    assert(!shm_ring_peek_valid(&reader));
+    assert(shm_ring_commit(&writer, 0) == 0);
+    assert(!shm_ring_peek_valid(&reader));
+
+    len = shm_ring_peek_latest(&reader, &data, &sequence);
+    assert(len == 0 && sequence == 4 && shm_ring_peek_valid(&reader));
+
+    // Readers cannot write
+    assert(shm_ring_begin(&reader) == nullptr);
+
+    shm_ring_close(&reader);
+    shm_ring_close(&writer);
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ In-place test passed" << std::endl;
+}
+
+void testTransport() {
+    std::cout << "Testing ShmRingTransport..." << std::endl;
+
+    std::string name = ringName("transport");
+    {
+        ShmRingTransport transport(name, 1024, 8);
+        assert(transport.isConnected());
+        shm_ring_t reader;
+        assert(shm_ring_open(&reader, name.c_str()) == 0);
+
+        assert(transport.send("{\"person\":3,\"timestamp\":1746732409}"));
+        assert(readLatest(reader) == "{\"person\":3,\"timestamp\":1746732409}");
+        // Messages larger than a slot are dropped and counted
+        assert(transport.dropped() == 0);
+        assert(transport.send(std::string(2000, 'x')));
+        assert(transport.send(std::string(2000, 'x')));
+        assert(transport.dropped() == 2);
+        assert(readLatest(reader) == "{\"person\":3,\"timestamp\":1746732409}");
+        shm_ring_close(&reader);
+
+    }
+
+    // A restarted writer replaces the ring; readers of the old one see it closed
+    shm_ring_t old_reader;
+    {
+        ShmRingTransport transport(name, 1024, 8);
+        assert(shm_ring_open(&old_reader, name.c_str()) == 0);
+    }
+    assert(shm_ring_read_next(&old_reader, nullptr, 0, nullptr) == SHM_RING_ERR_CLOSED);
+    shm_ring_close(&old_reader);
+    {
+        ShmRingTransport restarted(name, 1024, 8);
+        shm_ring_t reader;
+        assert(shm_ring_open(&reader, name.c_str()) == 0);
+        assert(restarted.send("after restart"));
+        assert(readLatest(reader) == "after restart");
+        shm_ring_close(&reader);
+    }
+    shm_unlink(name.c_str());
+
+    std::cout << "✓ ShmRingTransport test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running shared memory ring tests..." << std::endl;
+
+    testLatestAndHistory();
+    testWait();
+    testNoTornReads();
+    testInPlace();
+    testTransport();
+
+    std::cout << "\n✅ All shared memory ring tests passed!" << std::endl;
+    return 0;
+}
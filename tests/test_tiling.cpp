@@ -0,0 +1,107 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+// Include headers
+#include "tiling.h"
+
+// Mock detection list helper
+object_detect_result_list createDetectionList(const std::vector<object_detect_result>& detections) {
+    object_detect_result_list list;
+    memset(&list, 0, sizeof(list));
+    for (const auto& detection : detections) {
+        list.results[list.count++] = detection;
+    }
+    return list;
+}
+
+object_detect_result createMockDetection(int cls_id, float prop, box_rect_t box) {
+    object_detect_result detection;
+    memset(&detection, 0, sizeof(detection));
+    detection.cls_id = cls_id;
+    detection.prop = prop;
+    detection.box = box;
+    return detection;
+}
+
+void testParseTileGrid() {
+    std::cout << "Testing tile grid parsing..." << std::endl;
+
+    TileConfig config;
+    assert(parseTileGrid("3x2", config));
+    assert(config.cols == 3 && config.rows == 2);
+    assert(config.enabled());
+
+    TileConfig untouched;
+    assert(!parseTileGrid("3", untouched));
+    assert(!parseTileGrid("0x2", untouched));
+    assert(!parseTileGrid("3x2x1", untouched));
+    assert(!untouched.enabled());
+
+    std::cout << "✓ Tile grid parsing test passed" << std::endl;
+}
+
+void testTilesCoverFrameWithOverlap() {
+    std::cout << "Testing tile layout..." << std::endl;
+
+    TileConfig config;
+    config.cols = 3;
+    config.rows = 2;
+    config.overlap = 0.2f;
+    auto tiles = computeTiles(1920, 1080, config);
+    assert(tiles.size() == 6);
+
+    // First tile starts at the origin, last tile ends on the frame edge
+    assert(tiles.front().left == 0 && tiles.front().top == 0);
+    assert(tiles.back().right == 1919 && tiles.back().bottom == 1079);
+
+    // Horizontal neighbours share roughly the configured overlap
+    int width = tiles[0].right - tiles[0].left + 1;
+    int shared = tiles[0].right - tiles[1].left + 1;
+    assert(shared > 0);
+    assert(shared >= static_cast<int>(width * 0.15f) && shared <= static_cast<int>(width * 0.25f));
+
+    // A 1x1 grid is the whole frame
+    TileConfig single;
+    auto whole = computeTiles(640, 480, single);
+    assert(whole.size() == 1);
+    assert(whole[0].left == 0 && whole[0].right == 639 && whole[0].bottom == 479);
+
+    std::cout << "✓ Tile layout test passed" << std::endl;
+}
+
+void testMergeSuppressesSeamDuplicates() {
+    std::cout << "Testing cross-tile merge..." << std::endl;
+
+    // The same person seen whole in one tile and cut by the seam in the next
+    auto left_tile = createDetectionList({createMockDetection(0, 0.9f, {600, 100, 700, 400})});
+    auto right_tile = createDetectionList({
+        createMockDetection(0, 0.6f, {640, 100, 700, 400}),   // seam fragment, contained in the full box
+        createMockDetection(0, 0.7f, {1200, 100, 1300, 400})  // a different person
+    });
+    // A car at the same place as the person is a different class and must survive
+    auto full_frame = createDetectionList({createMockDetection(2, 0.8f, {600, 100, 700, 400})});
+
+    object_detect_result_list merged;
+    mergeDetections({left_tile, right_tile, full_frame}, NMS_THRESH, &merged);
+
+    assert(merged.count == 3);
+    // Highest confidence first
+    assert(merged.results[0].prop == 0.9f && merged.results[0].box.left == 600);
+    assert(merged.results[1].cls_id == 2);
+    assert(merged.results[2].box.left == 1200);
+
+    std::cout << "✓ Cross-tile merge test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running tiling tests..." << std::endl;
+
+    testParseTileGrid();
+    testTilesCoverFrameWithOverlap();
+    testMergeSuppressesSeamDuplicates();
+
+    std::cout << "\n✅ All tiling tests passed!" << std::endl;
+    return 0;
+}
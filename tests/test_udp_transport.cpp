@@ -0,0 +1,220 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// Include headers
+#include "transport.h"
+#include "udp_fragment.h"
+
+// A UDP socket bound to a free local port
+class Receiver {
+public:
+    Receiver() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        assert(fd >= 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        assert(bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0);
+        socklen_t len = sizeof(addr);
+        getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        port = ntohs(addr.sin_port);
+        struct timeval timeout = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+    ~Receiver() { close(fd); }
+
+    // Empty on timeout
+    std::string receive() {
+        char buffer[65536];
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        return len > 0 ? std::string(buffer, len) : std::string();
+    }
+
+    // Reassemble fragments until a whole message arrives
+    std::string receiveMessage() {
+        std::vector<uint8_t> message(1 << 20);
+        udp_reassembler_t reassembler;
+        udp_reassembler_init(&reassembler, message.data(), message.size());
+        for (;;) {
+            std::string datagram = receive();
+            if (datagram.empty()) {
+                return "";
+            }
+            int ret = udp_reassemble(&reassembler, reinterpret_cast<const uint8_t*>(datagram.data()), datagram.size());
+            assert(ret >= 0);
+            if (ret > 0) {
+                return std::string(reinterpret_cast<char*>(message.data()), ret);
+            }
+        }
+    }
+
+    int port;
+
+private:
+    int fd;
+};
+
+static std::string randomPayload(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string payload(size, '\0');
+    for (auto& c : payload) {
+        c = static_cast<char>(rng());
+    }
+    return payload;
+}
+
+void testDestinationParsing() {
+    std::cout << "Testing destination parsing..." << std::endl;
+
+    std::vector<UDPDestination> destinations;
+    assert(parseUDPDestinations("127.0.0.1:5010,239.1.2.3:6000", destinations));
+    assert(destinations.size() == 2);
+    assert(destinations[0].ip == "127.0.0.1" && destinations[0].port == 5010);
+    assert(destinations[1].ip == "239.1.2.3" && destinations[1].port == 6000);
+
+    std::vector<UDPDestination> bad;
+    assert(!parseUDPDestinations("127.0.0.1", bad));
+    assert(!parseUDPDestinations("127.0.0.1:0", bad));
+    assert(!parseUDPDestinations("localhost:5000", bad));
+    assert(!parseUDPDestinations("127.0.0.1:5000,", bad));
+
+    // An invalid address no longer sends to 255.255.255.255
+    UDPTransport invalid("not-an-address", 5000);
+    assert(!invalid.isConnected());
+    assert(!invalid.send("x"));
+
+    std::cout << "✓ Destination parsing test passed" << std::endl;
+}
+
+void testMultipleDestinations() {
+    std::cout << "Testing multiple destinations..." << std::endl;
+
+    Receiver first, second;
+    UDPTransport transport({{"127.0.0.1", first.port}, {"127.0.0.1", second.port}});
+    assert(transport.isConnected());
+    assert(transport.send("{\"person\":2}"));
+    assert(transport.send("person:2!!timestamp:1"));
+
+    // Small messages go out unchanged
+    assert(first.receive() == "{\"person\":2}");
+    assert(first.receive() == "person:2!!timestamp:1");
+    assert(second.receive() == "{\"person\":2}");
+    assert(second.receive() == "person:2!!timestamp:1");
+
+    UDPTransportStats stats = transport.stats();
+    assert(stats.messages == 2 && stats.datagrams == 4);
+    assert(stats.eagain_drops == 0 && stats.errors == 0);
+    assert(transport.dropped() == 0);
+
+    // Unfragmented transports send large messages as one plain datagram,
+    // even one that looks like a fragment header
+    std::string large = randomPayload(20000, 4);
+    large.replace(0, 3, "UF\x01");
+    assert(transport.send(large));
+    assert(first.receive() == large);
+    assert(second.receive() == large);
+    assert(!transport.send(std::string(UDPTransport::MAX_DATAGRAM + 1, 'x')));
+    assert(transport.stats().errors == 1);
+
+    std::cout << "✓ Multiple destination test passed" << std::endl;
+}
+
+void testFragmentation() {
+    std::cout << "Testing fragmentation..." << std::endl;
+
+    Receiver first, second;
+    UDPTransport transport({{"127.0.0.1", first.port}, {"127.0.0.1", second.port}}, 1000);
+
+    // One fragment of one: still with a header
+    std::string fits = randomPayload(980, 1);
+    assert(transport.send(fits));
+    std::string datagram = first.receive();
+    assert(datagram.size() == 1000 && datagram.compare(UDP_FRAG_HEADER_SIZE, std::string::npos, fits) == 0);
+    assert(second.receiveMessage() == fits);
+
+    // A payload that starts like a header is not mistaken for one
+    std::string lookalike = randomPayload(300, 5);
+    lookalike.replace(0, 3, "UF\x01");
+    assert(transport.send(lookalike));
+    assert(first.receiveMessage() == lookalike);
+    assert(second.receiveMessage() == lookalike);
+
+    // 980 bytes of data per fragment
+    std::string large = randomPayload(10000, 2);
+    assert(transport.send(large));
+    assert(first.receiveMessage() == large);
+    assert(second.receiveMessage() == large);
+    assert(transport.stats().datagrams == 2 + 2 + 2 * 11);
+
+    std::cout << "✓ Fragmentation test passed" << std::endl;
+}
+
+void testReassembly() {
+    std::cout << "Testing reassembly order, duplicates and loss..." << std::endl;
+
+    std::string message = randomPayload(2500, 3);
+    auto fragment = [&message](uint32_t id, uint16_t index) {
+        const size_t chunk = 1000;
+        size_t offset = index * chunk;
+        size_t size = std::min(chunk, message.size() - offset);
+        std::vector<uint8_t> datagram(UDP_FRAG_HEADER_SIZE + size);
+        udp_frag_header_t header = {id, index, 3, static_cast<uint32_t>(offset), static_cast<uint32_t>(message.size())};
+        udp_frag_write_header(datagram.data(), &header);
+        memcpy(datagram.data() + UDP_FRAG_HEADER_SIZE, message.data() + offset, size);
+        return datagram;
+    };
+
+    std::vector<uint8_t> buffer(4096);
+    udp_reassembler_t reassembler;
+    udp_reassembler_init(&reassembler, buffer.data(), buffer.size());
+
+    // Out of order, with a duplicate
+    auto f2 = fragment(7, 2), f0 = fragment(7, 0), f1 = fragment(7, 1);
+    assert(udp_reassemble(&reassembler, f2.data(), f2.size()) == 0);
+    assert(udp_reassemble(&reassembler, f0.data(), f0.size()) == 0);
+    assert(udp_reassemble(&reassembler, f0.data(), f0.size()) == 0);
+    assert(udp_reassemble(&reassembler, f1.data(), f1.size()) == 2500);
+    assert(memcmp(buffer.data(), message.data(), message.size()) == 0);
+
+    // A lost fragment: the next message replaces the incomplete one
+    auto g0 = fragment(8, 0), h0 = fragment(9, 0), h1 = fragment(9, 1), h2 = fragment(9, 2);
+    assert(udp_reassemble(&reassembler, g0.data(), g0.size()) == 0);
+    assert(udp_reassemble(&reassembler, h0.data(), h0.size()) == 0);
+    assert(udp_reassemble(&reassembler, h1.data(), h1.size()) == 0);
+    assert(udp_reassemble(&reassembler, h2.data(), h2.size()) == 2500);
+
+    // Malformed and oversized fragments
+    auto bad = fragment(10, 2);
+    bad[12] = 0xff;  // Offset past the end
+    assert(udp_reassemble(&reassembler, bad.data(), bad.size()) == UDP_FRAG_ERR_MALFORMED);
+    udp_reassembler_t small;
+    udp_reassembler_init(&small, buffer.data(), 1000);
+    assert(udp_reassemble(&small, f0.data(), f0.size()) == UDP_FRAG_ERR_TOO_LARGE);
+    const uint8_t json[] = "{\"person\":1}";
+    assert(udp_reassemble(&reassembler, json, sizeof(json) - 1) == UDP_FRAG_ERR_NOT_FRAGMENT);
+
+    std::cout << "✓ Reassembly test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running UDP transport tests..." << std::endl;
+
+    testDestinationParsing();
+    testMultipleDestinations();
+    testFragmentation();
+    testReassembly();
+
+    std::cout << "\n✅ All UDP transport tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+// Include headers
+#include "publisher.h"
+#include "zones.h"
+
+static std::string writeZonesFile(const std::string& contents) {
+    std::string path = "zones-" + std::to_string(getpid()) + ".json";
+    std::ofstream(path) << contents;
+    return path;
+}
+
+// A star with `spikes` points, concave between them
+static Zone star(const std::string& name, float cx, float cy, float outer, float inner, int spikes) {
+    Zone zone{name, {}};
+    for (int i = 0; i < spikes * 2; i++) {
+        float angle = static_cast<float>(M_PI) * i / spikes;
+        float radius = i % 2 ? inner : outer;
+        zone.points.emplace_back(cx + radius * std::cos(angle), cy + radius * std::sin(angle));
+    }
+    return zone;
+}
+
+void testLoading() {
+    std::cout << "Testing zone file loading..." << std::endl;
+
+    ZoneConfig config;
+    std::string path = writeZonesFile(R"({"anchor": "center", "zones": [
+        {"name": "screen_a", "points": [[0, 400], [640, 400], [640, 1080], [0, 1080]]},
+        {"name": "screen_b", "points": [[640, 400], [1280, 400], [1280, 1080]]}]})");
+    assert(loadZones(path, config));
+    assert(config.anchor == ZoneAnchor::Center && config.zones.size() == 2);
+    assert(config.zones[1].name == "screen_b" && config.zones[1].points.size() == 3);
+
+    for (const char* invalid : {
+             "not json",
+             R"({"zones": []})",
+             R"({"zones": [{"name": "a", "points": [[0, 0], [1, 1]]}]})",
+             R"({"zones": [{"points": [[0, 0], [1, 1], [1, 0]]}]})",
+             R"({"zones": [{"name": "a", "points": [[0, 0], [1, 1], [1, 0]]}, {"name": "a", "points": [[0, 0], [1, 1], [1, 0]]}]})",
+             R"({"anchor": "top", "zones": [{"name": "a", "points": [[0, 0], [1, 1], [1, 0]]}]})"}) {
+        writeZonesFile(invalid);
+        assert(!loadZones(path, config));
+    }
+    assert(config.zones.size() == 2);  // Unchanged by failures
+    unlink(path.c_str());
+    assert(!loadZones(path, config));
+
+    std::cout << "✓ Loading test passed" << std::endl;
+}
+
+void testMaskMatchesExactTest() {
+    std::cout << "Testing the lookup mask against the exact test..." << std::endl;
+
+    // 48 overlapping concave zones over a 1080p frame
+    ZoneConfig config;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> x(0, 1920), y(0, 1080), radius(40, 300);
+    for (int i = 0; i < 48; i++) {
+        float outer = radius(rng);
+        config.zones.push_back(star("zone" + std::to_string(i), x(rng), y(rng), outer, outer * 0.4f, 3 + i % 6));
+    }
+    config.zones.push_back({"triangle", {{100, 100}, {1800, 200}, {900, 1000}}});
+    ZoneMap map(config);
+
+    long assigned = 0;
+    for (int i = 0; i < 1000000; i++) {
+        float px = x(rng) * 1.1f - 96, py = y(rng) * 1.1f - 54;
+        if (i % 4 == 0) {
+            // On whole pixels, as box anchors are
+            px = std::round(px);
+            py = std::round(py);
+        }
+        uint64_t expected = 0;
+        for (size_t z = 0; z < config.zones.size(); z++) {
+            if (ZoneMap::contains(config.zones[z], px, py)) {
+                expected |= 1ull << z;
+            }
+        }
+        assert(map.zonesAt(px, py) == expected);
+        assigned += expected != 0;
+    }
+    assert(assigned > 100000);
+
+    // Box anchors
+    ZoneConfig halves;
+    halves.zones = {{"left", {{0, 0}, {320, 0}, {320, 480}, {0, 480}}},
+                    {"right", {{320, 0}, {640, 0}, {640, 480}, {320, 480}}}};
+    ZoneMap feet(halves);
+    assert(feet.zonesOf({100, 10, 200, 300}) == 1);
+    assert(feet.zonesOf({300, 10, 500, 300}) == 2);   // Center x 400
+    assert(feet.zonesOf({100, 10, 200, 600}) == 0);   // Feet below the zones
+    halves.anchor = ZoneAnchor::Center;
+    assert(ZoneMap(halves).zonesOf({100, 10, 200, 600}) == 1);
+
+    std::cout << "✓ Mask test passed" << std::endl;
+}
+
+void testFormatter() {
+    std::cout << "Testing the zone formatter..." << std::endl;
+
+    ZoneConfig config;
+    config.zones = {{"screen_a", {{0, 0}, {320, 0}, {320, 480}, {0, 480}}},
+                    {"screen_b", {{320, 0}, {640, 0}, {640, 480}, {320, 480}}},
+                    {"both", {{0, 200}, {640, 200}, {640, 480}, {0, 480}}}};
+    auto zones = std::make_shared<ZoneMap>(config);
+    ZoneMessageFormatter formatter(zones);
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.timestamp = std::chrono::system_clock::from_time_t(1746732409);
+    result.confidence_threshold = 0.5f;
+    result.class_mapping = {{"person", 0}, {"car", 2}};
+    result.selected_classes = {0, 2};
+    result.detections.count = 5;
+    result.detections.results[0] = {{10, 10, 50, 100}, 0.9f, 0, "person"};    // screen_a
+    result.detections.results[1] = {{10, 10, 50, 300}, 0.9f, 0, "person"};    // screen_a, both
+    result.detections.results[2] = {{400, 10, 500, 300}, 0.8f, 2, "car"};     // screen_b, both
+    result.detections.results[3] = {{400, 10, 500, 300}, 0.3f, 0, "person"};  // Below the threshold
+    result.detections.results[4] = {{400, 10, 500, 900}, 0.9f, 0, "person"};  // Outside every zone
+
+    std::string message;
+    formatter.formatInto(result, message);
+    assert(message == "{\"zones\":{\"screen_a\":{\"person\":2,\"car\":0},\"screen_b\":{\"person\":0,\"car\":1},"
+                      "\"both\":{\"person\":1,\"car\":1}},\"timestamp\":1746732409}");
+    assert(!nlohmann::json::parse(message).is_discarded());
+
+    // Moving within a zone is not a change; moving between zones is
+    uint64_t key = formatter.changeKey(result);
+    result.detections.results[0].box = {60, 10, 100, 120};
+    assert(formatter.changeKey(result) == key);
+    result.detections.results[0].box = {360, 10, 400, 120};
+    assert(formatter.changeKey(result) != key);
+
+    // With no classes selected only people are counted, not every class
+    result.selected_classes.clear();
+    result.detections.results[0].box = {10, 10, 50, 100};
+    formatter.formatInto(result, message);
+    assert(message == "{\"zones\":{\"screen_a\":{\"person\":2},\"screen_b\":{\"person\":0},"
+                      "\"both\":{\"person\":1}},\"timestamp\":1746732409}");
+
+    std::cout << "✓ Formatter test passed" << std::endl;
+}
+
+void testCost() {
+    std::cout << "Testing the cost with dozens of zones and 128 boxes..." << std::endl;
+
+    ZoneConfig config;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> x(0, 1920), y(0, 1080);
+    for (int i = 0; i < 48; i++) {
+        config.zones.push_back(star("zone" + std::to_string(i), x(rng), y(rng), 250, 100, 5));
+    }
+    ZoneMessageFormatter formatter(std::make_shared<ZoneMap>(config));
+
+    InferenceResult result;
+    memset(&result.detections, 0, sizeof(result.detections));
+    result.timestamp = std::chrono::system_clock::now();
+    result.confidence_threshold = 0.5f;
+    result.class_mapping = {{"person", 0}};
+    result.selected_classes = {0};
+    result.detections.count = OBJ_NUMB_MAX_SIZE;
+    for (int i = 0; i < OBJ_NUMB_MAX_SIZE; i++) {
+        int left = static_cast<int>(x(rng)), top = static_cast<int>(y(rng));
+        result.detections.results[i] = {{left, top, left + 60, top + 150}, 0.9f, 0, "person"};
+    }
+    result.shareView();
+    std::string message;
+    formatter.formatInto(result, message);
+
+    const int frames = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        formatter.formatInto(result, message);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+    std::cout << "  " << us << " us per frame for 48 zones and 128 boxes, JSON included" << std::endl;
+    assert(us < 1000.0);
+
+    std::cout << "✓ Cost test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "Running zone tests..." << std::endl;
+
+    testLoading();
+    testMaskMatchesExactTest();
+    testFormatter();
+    testCost();
+
+    std::cout << "\n✅ All zone tests passed!" << std::endl;
+    return 0;
+}